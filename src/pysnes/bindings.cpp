@@ -1,6 +1,7 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/numpy.h>
+#include <algorithm>
 #include "snes.hpp"
 
 namespace py = pybind11;
@@ -12,6 +13,49 @@ PYBIND11_MODULE(pysnes_cpp, m) {
         .def("power_on", &SNES::power_on, "Power on the SNES (reset CPU and PPU).")
         .def("reset", &SNES::reset, "Reset the SNES (CPU, PPU, Cartridge, Bus).")
         .def("step", &SNES::step, "Execute one CPU instruction.")
+        .def("run", &SNES::run, py::arg("cycles"), py::call_guard<py::gil_scoped_release>(),
+             "Run until the given number of CPU cycles has elapsed. Returns the cycles executed.")
+        .def("run_instructions", &SNES::run_instructions, py::arg("count"), py::call_guard<py::gil_scoped_release>(),
+             "Execute the given number of CPU instructions. Returns the instructions executed.")
+        .def("save_state", [](SNES &snes) {
+            std::vector<uint8_t> state;
+            snes.save_state(state);
+            return py::bytes(reinterpret_cast<const char*>(state.data()), state.size());
+        }, "Snapshot the machine (CPU, WRAM, PPU, timing, controllers, SRAM) as bytes.")
+        .def("load_state", [](SNES &snes, py::bytes state) {
+            char *data = nullptr;
+            ssize_t size = 0;
+            PYBIND11_BYTES_AS_STRING_AND_SIZE(state.ptr(), &data, &size);
+            if (!snes.load_state(reinterpret_cast<const uint8_t*>(data), (size_t)size)) {
+                throw py::value_error("save state does not match this emulator build");
+            }
+        }, py::arg("state"), "Restore a snapshot from save_state(); the same ROM must be inserted.")
+        .def_property_readonly("state_size", &SNES::state_size,
+             "Size in bytes of a save state, including the inserted cartridge's SRAM.")
+        .def_property_readonly("rom_path", &SNES::get_rom_path, "Path of the inserted ROM, or empty.")
+        .def("get_cartridge_info", &SNES::get_cartridge_info,
+             "Detected cartridge header: title, mapper, speed, rom_size, sram_size and checksum.")
+        .def("get_io_registers", &SNES::get_io_registers,
+             "Mapped I/O registers by address: (name, readable, writable, side_effect_free).")
+        .def(py::pickle(
+            [](SNES &snes) {
+                std::vector<uint8_t> state;
+                snes.save_state(state);
+                return py::make_tuple(snes.get_rom_path(),
+                                      py::bytes(reinterpret_cast<const char*>(state.data()), state.size()));
+            },
+            [](py::tuple t) {
+                if (t.size() != 2) throw std::runtime_error("invalid SNES pickle");
+                auto snes = std::make_unique<SNES>();
+                std::string rom_path = t[0].cast<std::string>();
+                if (!rom_path.empty()) snes->insert_cartridge(rom_path);
+                snes->power_on();
+                std::string state = t[1].cast<std::string>();
+                if (!snes->load_state(reinterpret_cast<const uint8_t*>(state.data()), state.size())) {
+                    throw std::runtime_error("save state does not match this emulator build");
+                }
+                return snes;
+            }))
         .def("get_screen", [](SNES &snes) {
             auto &screen = snes.get_screen();
             constexpr ssize_t height = 224; // PPU::kScreenHeight
@@ -49,6 +93,85 @@ PYBIND11_MODULE(pysnes_cpp, m) {
                 py::cast(snes)
             );
         }, "Get the framebuffer as a (224, 256, 3) uint8 RGB array.")
+        .def("get_framebuffer", [](SNES &snes, const std::string &format, py::object out) {
+            using Array = py::array_t<uint8_t, py::array::c_style>;
+            const PixelFormat formats[] = {PixelFormat::kRgba8888, PixelFormat::kRgb888,
+                                           PixelFormat::kBgr888, PixelFormat::kGray8};
+            const PixelFormat *match = std::find_if(std::begin(formats), std::end(formats),
+                [&](PixelFormat f) { return format == pixel_format_name(f); });
+            if (match == std::end(formats)) {
+                throw py::value_error("format must be 'rgba', 'rgb', 'bgr' or 'gray'");
+            }
+            std::vector<ssize_t> shape = {224, 256};   // PPU::kScreenHeight, PPU::kScreenWidth
+            ssize_t channels = (ssize_t)pixel_format_bytes(*match);
+            if (channels > 1) shape.push_back(channels);
+            Array array;
+            if (out.is_none()) {
+                array = Array(shape);
+            } else if (py::isinstance<Array>(out)) {
+                array = out.cast<Array>();
+                if (array.size() != 224 * 256 * channels) {
+                    throw py::value_error("out must hold 224 * 256 pixels of the format");
+                }
+            } else {
+                throw py::type_error("out must be a C-contiguous uint8 numpy array");
+            }
+            snes.get_framebuffer(*match, array.mutable_data());
+            return array;
+        }, py::arg("format") = "rgb", py::arg("out") = py::none(),
+           "Get the screen at the current display brightness as uint8 'rgba', 'rgb', 'bgr' (224, 256, n) or "
+           "'gray' (224, 256). Writes into out instead of a new array when given.")
+        .def("set_idle_loop_skipping", &SNES::set_idle_loop_skipping, py::arg("enabled"),
+             "Enable or disable fast-forwarding of detected idle loops (disable for accuracy testing).")
+        .def("get_idle_loop_skipping", &SNES::get_idle_loop_skipping, "Whether idle-loop skipping is enabled.")
+        .def("get_idle_loop_stats", &SNES::get_idle_loop_stats,
+             "Idle-loop skip counters: dict with 'skips', 'cycles' and 'instructions'.")
+        .def("reset_idle_loop_stats", &SNES::reset_idle_loop_stats, "Reset the idle-loop skip counters.")
+        .def_property_readonly_static("trace_level", [](py::object) { return SNES::trace_level(); },
+             "Compile-time CPU trace level (0 = tracing compiled out).")
+        .def("get_trace", [](SNES &snes) {
+            auto bytes = snes.get_trace();
+            return py::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        }, "Get the CPU trace ring buffer as bytes of 32-byte records, oldest first.")
+        .def("dump_trace", &SNES::dump_trace, py::arg("path"), "Write the CPU trace records to a binary file.")
+        .def("clear_trace", &SNES::clear_trace, "Clear the CPU trace ring buffer.")
+        .def("set_trace_capacity", &SNES::set_trace_capacity, py::arg("records"),
+             "Resize the CPU trace ring buffer (clears it).")
+        .def("format_trace", &SNES::format_trace, "Get the CPU trace records as disassembled text lines.")
+        .def("disassemble", &SNES::disassemble, py::arg("addr"), py::arg("count"),
+             "Disassemble count instructions starting at the 24-bit address addr.")
+        .def("get_unimplemented_opcodes", &SNES::get_unimplemented_opcodes,
+             "Opcodes without a CPU handler: dict of '$XX MNEMONIC' to times executed.")
+        .def_property_readonly_static("profiling_available", [](py::object) { return SNES::profiling_available(); },
+             "Whether the execution profiler is compiled in (PYSNES_ENABLE_PROFILER).")
+        .def("get_profile", [](SNES &snes) {
+            py::dict profile;
+            for (const auto &entry : snes.get_profile()) {
+                py::array_t<uint64_t> counts(entry.second.size());
+                std::copy(entry.second.begin(), entry.second.end(), counts.mutable_data());
+                profile[py::str(entry.first)] = counts;
+            }
+            return profile;
+        }, "Execution profile as a dict of uint64 numpy arrays: opcode_count, opcode_cycles (by opcode), "
+           "mode_count, mode_cycles (by profile_mode_names) and bus_reads, bus_writes (by profile_region_names).")
+        .def("reset_profile", &SNES::reset_profile, "Zero the execution profile counters.")
+        .def_property_readonly_static("profile_mode_names", [](py::object) { return SNES::profile_mode_names(); },
+             "Addressing mode names indexing the mode_* profile arrays.")
+        .def_property_readonly_static("profile_region_names", [](py::object) { return SNES::profile_region_names(); },
+             "Bus region names indexing the bus_* profile arrays.")
+        .def("start_sampling", &SNES::start_sampling, py::arg("interval_cycles") = 1000,
+             "Sample PB:PC and the emulated call stack every interval_cycles CPU cycles.")
+        .def("stop_sampling", &SNES::stop_sampling, "Stop sampling; collected samples are kept.")
+        .def("reset_samples", &SNES::reset_samples, "Discard the collected samples.")
+        .def("load_symbols", &SNES::load_symbols, py::arg("path"),
+             "Load symbols from a ca65 .map or WLA-DX .sym file. Returns False if none were found.")
+        .def("clear_symbols", &SNES::clear_symbols, "Forget all loaded symbols.")
+        .def("resolve_symbol", &SNES::resolve_symbol, py::arg("addr"),
+             "Name a 24-bit address as symbol+offset, or $BB:AAAA without a symbol.")
+        .def("get_pc_samples", &SNES::get_pc_samples, "Samples per 24-bit PB:PC address.")
+        .def("get_flat_profile", &SNES::get_flat_profile, "Samples per function.")
+        .def("get_call_stack_profile", &SNES::get_call_stack_profile,
+             "Samples per call stack, folded as 'outer;inner;leaf' (flame graph input).")
         .def("set_controller_state", [](SNES &snes, int controller, uint8_t state) {
             // Controller is 1-based (1 or 2)
             snes.set_controller_state(controller, state);
@@ -2,56 +2,279 @@
 #include <cstdint>
 #include <array>
 #include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "cpu_profile.hpp"
+#include "mmio.hpp"
 
 class CPU;
 class PPU;
 class Cartridge;
 class Controller;
+class Scheduler;
+
+// One of the 8 DMA channels, $43x0-$43xB. Registers power on as $FF.
+struct DmaChannel {
+    uint8_t control = 0xFF;         // $43x0 DMAPx: direction, HDMA indirect, A step, mode
+    uint8_t b_address = 0xFF;       // $43x1 BBADx: $21xx register
+    uint16_t a_address = 0xFFFF;    // $43x2-3 A1TxL/H: DMA source, HDMA table start
+    uint8_t a_bank = 0xFF;          // $43x4 A1Bx
+    uint16_t count = 0xFFFF;        // $43x5-6 DASxL/H: byte count (0 = 64KB), HDMA indirect address
+    uint8_t indirect_bank = 0xFF;   // $43x7 DASBx
+    uint16_t table_address = 0xFFFF;// $43x8-9 A2AxL/H: HDMA table position
+    uint8_t line_counter = 0xFF;    // $43xA NTRLx
+    uint8_t unused = 0xFF;          // $43xB/$43xF
+    bool hdma_transfer = false;     // HDMA writes a unit on the next line
+    bool hdma_done = false;         // HDMA table ended for this frame
+};
+
+// Memory owned by the bus, trivially copyable for save states
+struct BusState {
+    // 128KB Work RAM (WRAM)
+    std::array<uint8_t, 128 * 1024> wram;
+    // Interrupt vectors
+    uint8_t interrupt_vector_low = 0x00;
+    uint8_t interrupt_vector_high = 0x00;
+    uint8_t memsel = 0;         // $420D bit 0: FastROM timing for banks $80-$FF
+    uint8_t hdmaen = 0;         // $420C: channels doing HDMA
+    uint32_t wram_port = 0;     // $2181-$2183 WMADD, 17 bits
+    // Multiplier/divider: $4202-$4206 in, $4214-$4217 out
+    uint8_t wrmpya = 0xFF;
+    uint16_t wrdiv = 0xFFFF;
+    uint16_t rddiv = 0;
+    uint16_t rdmpy = 0;
+    DmaChannel dma[8];
+};
+static_assert(std::is_trivially_copyable<BusState>::value, "save states copy BusState as bytes");
 
 // SNES Bus: connects CPU, PPU, WRAM, Cartridge, Controllers, etc.
-class Bus {
+class Bus : private BusState {
 public:
     Bus();
     ~Bus();
 
-    // 24-bit address space read/write
+    // 24-bit address space read/write. Defined below so that accesses to
+    // host-memory pages inline into the CPU; MMIO goes out of line.
     uint8_t read(uint32_t addr, bool readonly = false);
     void write(uint32_t addr, uint8_t data);
+    // Instruction-stream read: read() without the profiler's data count
+    uint8_t fetch(uint32_t addr);
 
     // Connect devices
     void connect_cpu(std::shared_ptr<CPU> cpu_);
     void connect_ppu(std::shared_ptr<PPU> ppu_);
     void connect_cartridge(std::shared_ptr<Cartridge> cart_);
     void connect_controller(int port, std::shared_ptr<Controller> ctrl_);
+    // Owner of the NMI/IRQ/timer registers ($4200, $4207-$420A, $4210-$4212);
+    // it also runs HDMA from the PPU timing
+    void connect_scheduler(Scheduler* scheduler_);
+    // Connecting the PPU and the scheduler installs their register tables;
+    // connecting null leaves their addresses as open bus.
+
+    // Registers currently mapped at $2100-$21FF and $4000-$43FF, for
+    // debuggers and tooling. io_register() is null for unmapped addresses;
+    // io_registers() lists the mapped ones in address order. A table shared
+    // by several channels is listed once per address it's mapped at.
+    const MmioRegister* io_register(uint16_t addr) const;
+    std::vector<std::pair<uint16_t, const MmioRegister*>> io_registers() const;
 
     // Reset bus and all devices
     void reset();
 
+    // Save states. Loading invalidates cached code on WRAM pages whose
+    // contents change.
+    void save_state(BusState& state) const { state = *this; }
+    void load_state(const BusState& state);
+
     // Add public getters for devices
     std::shared_ptr<CPU> get_cpu() const { return cpu; }
     std::shared_ptr<PPU> get_ppu() const { return ppu; }
     std::shared_ptr<Cartridge> get_cartridge() const { return cart; }
     std::shared_ptr<Controller> get_controller(int port) const { return (port >= 0 && port < 2) ? controllers[port] : nullptr; }
 
+    // Master clocks one access to addr takes: 6 (fast), 8 (slow) or 12
+    // (joypad ports). FastROM banks are fast once MEMSEL ($420D) is set.
+    int access_clocks(uint32_t addr) const;
+    bool get_memsel() const { return memsel != 0; }
+
+    // Code cache hooks. code_page() classifies the memory backing addr as a
+    // WRAM page (>= 0), cartridge ROM, or memory whose bytes can't be cached.
+    static constexpr int kRomCode = -1;
+    static constexpr int kNoCode = -2;
+    int code_page(uint32_t addr) const;
+    // Writes to a watched WRAM page are reported to the listener's block cache
+    void set_code_listener(CPU* listener) { code_listener = listener; }
+    CPU* get_code_listener() const { return code_listener; }
+    void watch_code_page(int page) { code_pages[page] = true; }
+    void unwatch_code_page(int page) { code_pages[page] = false; }
+
+    // Access counters by region; only updated when built with PYSNES_PROFILE
+    void set_profile(CPUProfile* profile_) { profile = profile_; }
+    CPUProfile* get_profile() const { return profile; }
+
+    // Host memory behind addr for bulk transfers, or null when the page goes
+    // through an MMIO handler. The pointer is valid to the end of addr's page.
+    const uint8_t* host_read(uint32_t addr) const;
+    uint8_t* host_write(uint32_t addr) const;
+    // Report length bytes stored through host_write() to the code cache
+    void host_written(const uint8_t* host, size_t length);
+
+    // DMA. Writing $420B runs the selected channels at once and stalls the
+    // CPU for the time they take. HDMA is driven by the scheduler: init at
+    // the start of each frame, one line's transfers at each H-blank. All
+    // return the master clocks used.
+    static constexpr int kDmaChannels = 8;
+    uint64_t run_dma(uint8_t channels);
+    uint64_t hdma_init();
+    uint64_t hdma_line();
+    const DmaChannel& get_dma_channel(int channel) const { return dma[channel & 7]; }
+
     // Interrupt vector setters for testing
     void set_interrupt_vector(uint8_t low, uint8_t high) {
         interrupt_vector_low = low;
         interrupt_vector_high = high;
     }
 
+    // Memory map: the 24-bit address space in 8KB pages. Each page either
+    // points straight at host memory or names the MMIO handler behind it.
+    static constexpr int kPageBits = 13;
+    static constexpr uint32_t kPageSize = 1u << kPageBits;
+    static constexpr uint32_t kPageMask = kPageSize - 1;
+    static constexpr int kPageCount = (1 << 24) >> kPageBits;   // 2048
+
+    enum MmioHandler : uint8_t {
+        kMmioOpenBus,       // Unmapped; reads 0, writes ignored
+        kMmioBBus,          // $2000-$3FFF: B bus registers at $2100-$21FF
+        kMmioCpuIo,         // $4000-$5FFF: joypad, CPU and DMA registers at $4000-$43FF
+        kMmioCartridge,     // Cartridge space the ROM can't back directly
+        kMmioVectors,       // $E000-$FFFF with no cartridge: interrupt vectors
+    };
+
 private:
-    // 128KB Work RAM (WRAM)
-    std::array<uint8_t, 128 * 1024> wram;
+    // Native blocks read the page tables and code page flags in place
+    friend class CPUJit;
+
+    // A null data pointer routes the page through its handler
+    struct ReadPage {
+        const uint8_t* data = nullptr;
+        MmioHandler handler = kMmioOpenBus;
+        uint8_t region = CPUProfile::kOpenBus;
+    };
+    struct WritePage {
+        uint8_t* data = nullptr;
+        MmioHandler handler = kMmioOpenBus;
+        uint8_t region = CPUProfile::kOpenBus;
+    };
+
+    void build_memory_map();
+    uint8_t mmio_read(MmioHandler handler, uint32_t addr, bool readonly);
+    void mmio_write(MmioHandler handler, uint32_t addr, uint8_t data);
+
+    // Register dispatch: one port per address of the B bus and the CPU's
+    // I/O area, filled from the devices' register tables
+    struct IoPort {
+        MmioRegister::ReadFn read;
+        MmioRegister::WriteFn write;
+        void* device;
+        const MmioRegister* info;   // Null where nothing is mapped
+    };
+    IoPort* io_port(uint16_t addr);
+    void map_registers(const MmioRegister* regs, size_t count, void* device, uint16_t offset = 0);
+    void unmap_registers(const MmioRegister* regs, size_t count, uint16_t offset = 0);
+    // Debugger reads (readonly) of registers with read side effects see open bus
+    uint8_t io_read(const IoPort& port, uint16_t addr, bool readonly) {
+        if (readonly && !(port.info && (port.info->flags & MmioRegister::kNoSideEffects))) {
+            return 0x00;
+        }
+        return port.read(port.device, addr);
+    }
+
+    std::array<IoPort, 0x100> b_ports;
+    std::array<IoPort, 0x400> cpu_ports;
+
+    // The bus's own registers: WRAM port, joypads, multiplier/divider, DMA
+    // control. The DMA channel registers are listed for channel 0 and
+    // mapped once per channel.
+    static constexpr int kRegisterCount = 18;
+    static constexpr int kDmaRegisterCount = 13;
+    static const MmioRegister kRegisters[kRegisterCount];
+    static const MmioRegister kDmaRegisters[kDmaRegisterCount];
+
+    // DMA internals (bus_dma.cpp)
+    static DmaChannel& dma_channel_of(void* device, uint16_t addr);
+    uint32_t dma_transfer(DmaChannel& channel);
+    uint32_t dma_bulk(DmaChannel& channel, uint32_t length, uint32_t done);
+    void hdma_load_entry(DmaChannel& channel);
+    uint8_t dma_read_a(uint32_t addr);
+    void dma_write_a(uint32_t addr, uint8_t data);
+    uint8_t read_b(uint8_t reg);
+    void write_b(uint8_t reg, uint8_t data);
+
+    std::array<ReadPage, kPageCount> read_map;
+    std::array<WritePage, kPageCount> write_map;
+
+    // Backing for unmapped pages, always zero
+    static const std::array<uint8_t, kPageSize> open_bus_page;
 
     // Devices
     std::shared_ptr<CPU> cpu;
     std::shared_ptr<PPU> ppu;
     std::shared_ptr<Cartridge> cart;
     std::array<std::shared_ptr<Controller>, 2> controllers;
+    Scheduler* scheduler = nullptr;
 
-    // Interrupt vectors
-    uint8_t interrupt_vector_low = 0x00;
-    uint8_t interrupt_vector_high = 0x00;
+    // WRAM pages holding cached code, one flag per 256 bytes
+    std::array<bool, 128 * 1024 / 256> code_pages{};
+    CPU* code_listener = nullptr;
+    void notify_code_write(uint32_t wram_offset);
+
+    CPUProfile* profile = nullptr;
 
-    // TODO: Add DMA, APU, etc.
+    // TODO: Add APU
 };
+
+inline uint8_t Bus::read(uint32_t addr, bool readonly) {
+    addr &= 0xFFFFFF;
+    const ReadPage& page = read_map[addr >> kPageBits];
+    PYSNES_PROFILE_ACCESS(profile, bus_reads, page.region);
+    if (page.data) {
+        return page.data[addr & kPageMask];
+    }
+    return mmio_read(page.handler, addr, readonly);
+}
+
+inline uint8_t Bus::fetch(uint32_t addr) {
+    addr &= 0xFFFFFF;
+    const ReadPage& page = read_map[addr >> kPageBits];
+    if (page.data) {
+        return page.data[addr & kPageMask];
+    }
+    return mmio_read(page.handler, addr, false);
+}
+
+inline void Bus::write(uint32_t addr, uint8_t data) {
+    addr &= 0xFFFFFF;
+    const WritePage& page = write_map[addr >> kPageBits];
+    PYSNES_PROFILE_ACCESS(profile, bus_writes, page.region);
+    if (page.data) {
+        uint8_t* host = page.data + (addr & kPageMask);
+        *host = data;
+        uintptr_t wram_offset = (uintptr_t)host - (uintptr_t)wram.data();
+        if (wram_offset < wram.size() && code_pages[wram_offset >> 8]) {
+            notify_code_write((uint32_t)wram_offset);
+        }
+        return;
+    }
+    mmio_write(page.handler, addr, data);
+}
+
+inline const uint8_t* Bus::host_read(uint32_t addr) const {
+    const ReadPage& page = read_map[(addr & 0xFFFFFF) >> kPageBits];
+    return page.data ? page.data + (addr & kPageMask) : nullptr;
+}
+
+inline uint8_t* Bus::host_write(uint32_t addr) const {
+    const WritePage& page = write_map[(addr & 0xFFFFFF) >> kPageBits];
+    return page.data ? page.data + (addr & kPageMask) : nullptr;
+}
@@ -1,18 +1,52 @@
 #pragma once
+#include <array>
 #include <cstdint>
 #include <string>
 #include <vector>
 
 class Cartridge {
   public:
+    enum class Mapper : uint8_t { LoROM, HiROM, ExHiROM };
+
+    // Internal header, found by scoring the candidates at $7FC0 (LoROM),
+    // $FFC0 (HiROM) and $40FFC0 (ExHiROM) of the image
+    struct Header {
+        std::string title;
+        Mapper mapper = Mapper::LoROM;
+        bool fast_rom = false;      // Map mode bit 4: banks $80+ run at 3.58MHz with MEMSEL
+        uint8_t map_mode = 0;       // $FFD5
+        uint8_t cart_type = 0;      // $FFD6
+        uint8_t rom_size = 0;       // $FFD7, log2(KB)
+        uint8_t sram_size = 0;      // $FFD8, log2(KB)
+        uint8_t region = 0;         // $FFD9
+        uint8_t version = 0;        // $FFDB
+        uint16_t complement = 0;    // $FFDC
+        uint16_t checksum = 0;      // $FFDE
+        uint32_t offset = 0x7FC0;   // Where the header was found
+        int score = 0;              // Detection score of the chosen candidate
+    };
+
+    // Cartridge memory behind each 8KB page of the CPU address space,
+    // resolved once at load. ROM offsets are already mirrored into the
+    // image; SRAM offsets are masked to the SRAM size on access.
+    static constexpr int kPageBits = 13;
+    static constexpr int kPageCount = (1 << 24) >> kPageBits;
+    enum class Area : uint8_t { None, Rom, Sram };
+    struct PageMapping {
+        Area area = Area::None;
+        uint32_t offset = 0;
+    };
+
     Cartridge(const std::string &rom_path);
     ~Cartridge();
 
     bool is_loaded();
 
-    // Communication with the main CPU bus
-    uint8_t cpu_read(uint16_t addr, bool bReadOnly = false);
-    void cpu_write(uint16_t addr, uint8_t data);
+    // Communication with the main CPU bus (24-bit addresses). The bus maps
+    // ROM and SRAM pages straight to host memory where it can; these are
+    // the fallback for what it can't (partial pages, SRAM under 8KB).
+    uint8_t cpu_read(uint32_t addr, bool bReadOnly = false);
+    void cpu_write(uint32_t addr, uint8_t data);
 
     // Communication with the PPU bus
     bool ppu_read(uint16_t addr, uint8_t &data);
@@ -20,7 +54,27 @@ class Cartridge {
 
     void reset();
 
+    const Header& header() const { return header_; }
+    Mapper mapper() const { return header_.mapper; }
+    const PageMapping& page_mapping(int page) const { return pages[page]; }
+
+    // Raw ROM image (copier header removed), for the bus memory map
+    const uint8_t* rom() const { return rom_data.data(); }
+    size_t rom_size() const { return rom_data.size(); }
+    // Battery/work RAM sized from the header; empty if the board has none
+    uint8_t* sram() { return sram_data.data(); }
+    size_t sram_size() const { return sram_data.size(); }
+
+    static const char* mapper_name(Mapper mapper);
+
   private:
+    void detect_header();
+    void build_page_map();
+    uint32_t mirror_rom(uint32_t offset) const;
+
     std::vector<uint8_t> rom_data;
+    std::vector<uint8_t> sram_data;
+    Header header_;
+    std::array<PageMapping, kPageCount> pages{};
     bool loaded = false;
 };
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Conversion of BGR555 framebuffer pixels (0bbbbbgggggrrrrr, bit 15
+// ignored) to 8-bit output formats. Channels widen as (c << 3) | (c >> 2)
+// and are then scaled by the INIDISP master brightness, 0-15, where 15 is
+// full intensity and 0 (or forced blank) is black.
+enum class PixelFormat : uint8_t {
+    kRgba8888,  // R, G, B, 255
+    kRgb888,
+    kBgr888,
+    kGray8,     // BT.601 luma of the scaled channels
+};
+
+size_t pixel_format_bytes(PixelFormat format);
+const char* pixel_format_name(PixelFormat format);
+
+// count pixels of src into dst, count * pixel_format_bytes(format) bytes.
+// Dispatches on simd_level().
+void convert_bgr555(const uint16_t* src, size_t count, PixelFormat format, int brightness, uint8_t* dst);
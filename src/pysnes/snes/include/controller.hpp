@@ -1,6 +1,12 @@
 #pragma once
 #include <cstdint>
 
+// Save state of a controller port
+struct ControllerState {
+    uint8_t buttons = 0x00;
+    uint8_t snapshot = 0x00;
+};
+
 class Controller {
   public:
     Controller();
@@ -11,6 +17,12 @@ class Controller {
 
     void reset();
 
+    void save_state(ControllerState& state) const { state = ControllerState{buttons, snapshot}; }
+    void load_state(const ControllerState& state) {
+        buttons = state.buttons;
+        snapshot = state.snapshot;
+    }
+
     uint8_t buttons = 0x00;
   private:
     uint8_t snapshot = 0x00;
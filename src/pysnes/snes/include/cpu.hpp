@@ -1,17 +1,23 @@
 #pragma once
+#include <array>
 #include <cstdint>
 #include <memory>
+#include <type_traits>
+#include "cpu_block_cache.hpp"
+#include "cpu_jit.hpp"
+#include "cpu_profile.hpp"
+#include "cpu_sampler.hpp"
+#include "cpu_trace.hpp"
 
 // Forward declarations
 class Bus;
 
-// 65816 CPU core for SNES
-class CPU {
-public:
-    // Constructor/Destructor
-    CPU();
-    ~CPU();
+enum class CPUHalt : uint8_t { None, Wait, Stop };
 
+// Architectural state of the CPU, kept trivially copyable so that a save
+// state is a plain copy. Everything else in CPU is derived from it (dispatch
+// table, code caches) or is diagnostics.
+struct CPUState {
     // Core CPU registers (65816 specific)
     uint16_t a = 0x0000;        // Accumulator (16-bit in native mode)
     uint16_t x = 0x0000;        // X index register (16-bit in native mode)
@@ -23,15 +29,49 @@ public:
     uint8_t pb = 0x00;          // Program Bank register
     uint8_t db = 0x00;          // Data Bank register
 
+    // State information
+    uint8_t cycles = 0;         // Cycles for current instruction
+    uint8_t opcode = 0;         // Current opcode (for debugging)
+    uint64_t cycle_count = 0;   // Cycles executed since reset
+    uint64_t instruction_count = 0; // Instructions executed since reset
+
+    CPUHalt halted = CPUHalt::None;
+};
+static_assert(std::is_trivially_copyable<CPUState>::value, "save states copy CPUState as bytes");
+
+// 65816 CPU core for SNES
+class CPU : public CPUState {
+public:
+    // Opcode handler signature used by the dispatch tables
+    using Handler = void (*)(CPU*);
+
+    // Constructor/Destructor
+    CPU();
+    ~CPU();
+
     // Bus connection
     void connect_bus(std::shared_ptr<Bus> b);
     std::shared_ptr<Bus> bus;   // Made public for instruction access
+    Bus* mem = nullptr;         // Non-owning alias of bus for memory accesses
 
     // Core execution
     void step();                // Execute one instruction
+    uint64_t run(uint64_t cycle_budget);        // Returns cycles executed
+    uint64_t run_instructions(uint64_t count);  // Returns instructions executed
+    // Run until cycle_count or instruction_count reaches its target
+    void run_until(uint64_t cycle_target, uint64_t instruction_target);
     void reset();               // Reset CPU state
     void irq();                 // Interrupt request
     void nmi();                 // Non-maskable interrupt
+    void update_dispatch();     // Re-select dispatch table after E/M/X change
+
+    // WAI/STP halt the core: step() does nothing and run_until() returns
+    // early until an interrupt (Wait) or a reset (Stop). The scheduler
+    // fast-forwards time while the CPU is halted.
+    using Halt = CPUHalt;
+    void halt(Halt state);
+    Halt get_halt() const { return halted; }
+    bool is_halted() const { return halted != Halt::None; }
 
     // Flag management
     enum FLAGS {
@@ -46,21 +86,184 @@ public:
         E = (1 << 8)            // Emulation flag
     };
 
-    void set_flag(FLAGS f, bool v);
-    bool get_flag(FLAGS f) const;
+    // N and Z are evaluated lazily: setZN() only records the result, and
+    // sync_flags() folds it into p. p is exact whenever control is outside
+    // step()/run_until(); inside, read flags through get_flag() and call
+    // sync_flags() before using p as a whole.
+    void set_flag(FLAGS f, bool v) {
+        if (f & (N | Z)) sync_flags();
+        if (v) {
+            p |= f;
+        } else {
+            p &= ~f;
+        }
+    }
+    bool get_flag(FLAGS f) const {
+        if (nz_pending) {
+            if (f == Z) return nz_result == 0;
+            if (f == N) return (nz_result & 0x8000) != 0;
+        }
+        return (p & f) != 0;
+    }
+    void sync_flags() {
+        if (nz_pending) {
+            p = (p & ~(N | Z)) | ((nz_result & 0x8000) ? N : 0) | (nz_result == 0 ? Z : 0);
+            nz_pending = false;
+        }
+    }
+    // Drop a pending N/Z result; used when p is about to be overwritten whole
+    void discard_flags() { nz_pending = false; }
 
-    // State information
-    uint8_t cycles = 0;         // Cycles for current instruction
-    uint8_t opcode = 0;         // Current opcode (for debugging)
+    // Save states. Call at an instruction boundary, outside step()/run_until().
+    // Loading keeps the code caches; WRAM code is invalidated by the bus.
+    void save_state(CPUState& state);
+    void load_state(const CPUState& state);
 
     // Debug/testing helpers
     uint8_t get_opcode() const { return opcode; }
 
+    // Execution trace ring buffer; filled only when built with
+    // PYSNES_TRACE_LEVEL > 0 (see cpu_trace.hpp)
+    CPUTrace& get_trace() { return trace; }
+    const CPUTrace& get_trace() const { return trace; }
+    void trace_event(uint8_t kind, uint8_t op, uint32_t arg);
+
+    // Execution profile; counted only when built with PYSNES_PROFILE
+    // (see cpu_profile.hpp). Bus accesses are counted on the connected bus.
+    CPUProfile& get_profile() { return profile; }
+    const CPUProfile& get_profile() const { return profile; }
+
+    // Sampling profiler fed with calls and returns (see cpu_sampler.hpp);
+    // the samples themselves are taken by the scheduler
+    void set_sampler(CPUSampler* sampler_) { sampler = sampler_; }
+    void note_call(uint32_t site) {        // After pushing the return address
+        if (sampler) sampler->on_call(site & 0xFFFFFF, stkp);
+    }
+    void note_return() {
+        if (sampler) sampler->on_return(stkp);
+    }
+
     // Helper functions (made public for instruction access)
-    void setZN(uint16_t value, bool is16);
+    void setZN(uint16_t value, bool is16) {
+        // 8-bit results move to the high byte so N is always bit 15
+        nz_result = is16 ? value : (uint16_t)(value << 8);
+        nz_pending = true;
+    }
     void validate_stack_pointer();
 
+    // Instructions that repeat in place (MVN/MVP) may retire several
+    // repetitions per call. repeat_budget() is how many, counting the current
+    // one, fit before the run's targets; charge_repeats() accounts the extra
+    // ones. Outside run_until() (and in traced builds) the budget is 1.
+    uint64_t repeat_budget(uint8_t cycles_each) const;
+    void charge_repeats(uint64_t count, uint8_t cycles_each);
+    // Cycles the CPU sits paused for DMA started by the current instruction
+    void stall(uint64_t stall_cycles);
+
+    // Fetch the next instruction-stream byte at pc. Replayed instructions
+    // take their operands from the block cache instead of the bus.
+    uint8_t fetch8() {
+        if (fetch_mode == FetchMode::Replay) {
+            pc++;
+            return *fetch_ptr++;
+        }
+        return fetch8_bus();
+    }
+
+    // Pre-decoded block cache
+    void set_block_cache_enabled(bool enabled);
+    bool get_block_cache_enabled() const { return block_cache_enabled; }
+    void invalidate_code_page(int page);    // WRAM page holding cached code was written
+    void flush_code_cache();
+
+    // JIT tier for hot blocks, used by run()/run_until() when the build
+    // enables it (PYSNES_ENABLE_JIT) and the block cache is on
+    static bool jit_available();
+    void set_jit_enabled(bool enabled);
+    bool get_jit_enabled() const { return jit_enabled; }
+    void set_jit_threshold(uint32_t entries) { jit_threshold = entries; }
+    size_t jit_code_size() const;
+
+    // Idle-loop skipping. A cached block that only polls memory and branches
+    // back to itself behaves the same on every pass until something outside
+    // the CPU changes, so run_until() adds whole passes up to its targets
+    // instead of executing them. Off by default when tracing or profiling
+    // is compiled in; skipped passes are not profiled.
+    struct IdleLoopStats {
+        uint64_t skips = 0;         // Times a loop was fast-forwarded
+        uint64_t cycles = 0;        // Cycles skipped
+        uint64_t instructions = 0;  // Instructions skipped
+    };
+    static constexpr size_t kMaxIdleLoopLength = 8;
+    void set_idle_skip_enabled(bool enabled) { idle_skip_enabled = enabled; }
+    bool get_idle_skip_enabled() const { return idle_skip_enabled; }
+    const IdleLoopStats& get_idle_stats() const { return idle_stats; }
+    void reset_idle_stats() { idle_stats = IdleLoopStats{}; }
+
+    // Executions of opcodes without a handler, per opcode
+    // (see CPUInstructions::is_implemented)
+    void note_unimplemented(uint8_t opcode) { unimplemented_counts[opcode]++; }
+    const std::array<uint64_t, 256>& get_unimplemented_counts() const { return unimplemented_counts; }
+    void reset_unimplemented_counts() { unimplemented_counts.fill(0); }
+
 private:
+    enum class FetchMode : uint8_t { Direct, Record, Replay };
+
+    void execute_instruction();
+    void interpret(uint32_t addr);
+    void record(uint32_t addr);
+    uint8_t fetch8_bus();
+    void watch_code(int page);
+    bool enter_native(CPUBlockCache::Block* block);
+    bool skip_idle_loop(CPUBlockCache::Block* block, bool looped);
+    bool idle_reads_stable(const CPUBlockCache::Block& block) const;
+
+    // Block cache state: the block being executed or recorded and the
+    // index of the next instruction in it
+    std::unique_ptr<CPUBlockCache> block_cache;
+    bool block_cache_enabled = true;
+    CPUBlockCache::Block* current_block = nullptr;
+    size_t block_index = 0;
+    bool recording = false;
+    FetchMode fetch_mode = FetchMode::Direct;
+    const uint8_t* fetch_ptr = nullptr;
+    CPUBlockCache::Instruction* record_insn = nullptr;
+    bool record_ok = false;
+
+    // JIT state; jit_run is only set while run_until() is executing
+#ifdef PYSNES_JIT
+    std::unique_ptr<CPUJit> jit;
+    bool jit_enabled = true;
+#else
+    bool jit_enabled = false;
+#endif
+    uint32_t jit_threshold = 32;
+    CPURunState* jit_run = nullptr;
+    // Counters of the run_until() call in progress
+    CPURunState* active_run = nullptr;
+
+    // Idle-loop detection: the last idle-shaped block entered and the run
+    // counters at that entry
+    bool idle_skip_enabled = PYSNES_TRACE_LEVEL == 0 && !PYSNES_PROFILE;
+    CPUBlockCache::Block* idle_block = nullptr;
+    uint64_t idle_entry_cycles = 0;
+    uint64_t idle_entry_instructions = 0;
+    IdleLoopStats idle_stats;
+
+    std::array<uint64_t, 256> unimplemented_counts{};
+
+    CPUTrace trace{PYSNES_TRACE_LEVEL > 0 ? CPUTrace::kDefaultCapacity : 1};
+    CPUProfile profile;
+    CPUSampler* sampler = nullptr;
+
+    // Active dispatch table for the current (E, M, X) width mode
+    const Handler* dispatch = nullptr;
+    uint8_t dispatch_mode = 0xFF;
+
+    // Last N/Z result, not yet folded into p
+    uint16_t nz_result = 0;
+    bool nz_pending = false;
+
     // Internal state
     uint32_t addr_abs = 0;      // Absolute address
     uint32_t addr_rel = 0;      // Relative address
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Forward declaration
+class CPU;
+
+// Pre-decoded basic blocks for the 65816 interpreter.
+// Blocks are keyed by (PB, PC, width mode) and hold, for each instruction,
+// the handler selected for that mode and the operand bytes it fetched, so
+// replaying an instruction skips the bus for the instruction stream.
+// Blocks built from WRAM are registered against the 256-byte WRAM pages
+// they were fetched from and dropped when one of those pages is written.
+class CPUBlockCache {
+public:
+    using Handler = void (*)(CPU*);
+
+    static constexpr size_t kMaxBlockLength = 64;
+    static constexpr int kWramPages = 512;  // 128KB / 256
+
+    struct Instruction {
+        uint32_t pc = 0;                // PC of the opcode
+        Handler handler = nullptr;
+        uint8_t opcode = 0;
+        uint8_t operand_count = 0;
+        uint8_t operands[3] = {0, 0, 0};
+    };
+
+    enum IdleShape : uint8_t { kIdleUnknown, kIdleNo, kIdleLoop };
+
+    struct Block {
+        uint8_t pb = 0;
+        uint32_t pc = 0;
+        uint8_t mode = 0;
+        bool valid = true;
+        uint32_t end_pc = 0;            // Fall-through PC after the last instruction
+        uint32_t entry_count = 0;       // Lookups that entered the block, for the JIT
+        void* native = nullptr;         // JIT translation, if any
+        uint8_t idle = kIdleUnknown;    // Idle-loop shape, classified on first use
+        std::vector<Instruction> instructions;
+    };
+
+    CPUBlockCache();
+
+    Block* find(uint8_t pb, uint32_t pc, uint8_t mode);
+    Block* create(uint8_t pb, uint32_t pc, uint8_t mode);
+
+    // Record that block holds code fetched from a WRAM page
+    void add_page(Block* block, int page);
+    // Drop every block holding code from a WRAM page
+    void invalidate_page(int page);
+    void flush();
+
+    // Free blocks that were invalidated while they could still be executing
+    void release_retired() {
+        if (!retired.empty()) retired.clear();
+    }
+
+    size_t size() const { return blocks.size(); }
+
+private:
+    static uint64_t key(uint8_t pb, uint32_t pc, uint8_t mode) {
+        return ((uint64_t)pb << 40) | ((uint64_t)pc << 8) | mode;
+    }
+    void retire(uint64_t k);
+
+    std::unordered_map<uint64_t, std::unique_ptr<Block>> blocks;
+    std::vector<std::vector<uint64_t>> page_blocks;
+    std::vector<std::unique_ptr<Block>> retired;
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "cpu_block_cache.hpp"
+
+class Bus;
+
+// Run totals for CPU::run_until. Native blocks fold the instructions they
+// execute into these, so the layout is fixed.
+struct CPURunState {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cycle_target = 0;
+    uint64_t instruction_target = 0;
+};
+
+#ifdef PYSNES_JIT
+
+// x86-64 translation of hot pre-decoded blocks.
+// A translated block calls each instruction's handler directly with its
+// operand pointer and PC preset, and inlines instructions that only touch
+// registers, so the dispatch loop, the block lookup and the per-instruction
+// replay checks disappear. Direct page and absolute loads and stores are
+// inlined too: they go straight to the host page the bus maps there, and
+// fall back to the handler for MMIO or a store into cached code. Between
+// instructions it stops when the run budget is spent, the block was
+// invalidated by a store, the width mode changed or a branch was taken,
+// leaving the CPU ready to continue in the interpreter. Cycle counts come
+// from the handlers or the opcode table they use, so they stay exact.
+class CPUJit {
+public:
+    // Byte offsets from a CPU object to the members native code touches
+    struct Layout {
+        int32_t pc = 0;
+        int32_t p = 0;
+        int32_t cycles = 0;
+        int32_t fetch_ptr = 0;
+        int32_t dispatch_mode = 0;
+        int32_t a = 0;
+        int32_t x = 0;
+        int32_t y = 0;
+        int32_t nz_result = 0;
+        int32_t nz_pending = 0;
+    };
+
+    // Runs the block from its first instruction and returns the index of
+    // the instruction after the last one executed. All but that last
+    // instruction are already counted in the run state.
+    using NativeBlock = uint32_t (*)(CPU*, CPURunState*);
+
+    static constexpr size_t kChunkSize = 1 << 20;
+    static constexpr size_t kMaxCodeSize = 32 << 20;
+
+    explicit CPUJit(const Layout& layout);
+    ~CPUJit();
+
+    CPUJit(const CPUJit&) = delete;
+    CPUJit& operator=(const CPUJit&) = delete;
+
+    // Returns nullptr once the code buffers are full. The code addresses
+    // the bus's page tables, so it must be dropped when the bus changes.
+    NativeBlock compile(const CPUBlockCache::Block& block, const Bus& bus);
+    // Free all native code; no translated block may be running
+    void reset();
+
+    size_t code_size() const { return code_bytes; }
+
+private:
+    struct Chunk {
+        uint8_t* base = nullptr;
+        size_t used = 0;
+    };
+
+    uint8_t* allocate(const std::vector<uint8_t>& code);
+
+    Layout layout;
+    std::vector<Chunk> chunks;
+    size_t code_bytes = 0;
+};
+
+#endif // PYSNES_JIT
@@ -0,0 +1,356 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+
+struct TraceRecord;
+
+// 65816 addressing modes as written in assembly. ImmediateM and ImmediateX
+// take a 16-bit operand when the M or X flag is clear.
+enum class AddrMode : uint8_t {
+    Implied,
+    Accumulator,
+    ImmediateM,
+    ImmediateX,
+    Immediate8,                 // REP, SEP, BRK, COP, WDM
+    Relative,
+    RelativeLong,
+    Direct,
+    DirectX,
+    DirectY,
+    DirectIndirect,
+    DirectIndirectX,
+    DirectIndirectY,
+    DirectIndirectLong,
+    DirectIndirectLongY,
+    Absolute,
+    AbsoluteX,
+    AbsoluteY,
+    AbsoluteLong,
+    AbsoluteLongX,
+    AbsoluteIndirect,
+    AbsoluteIndirectX,
+    AbsoluteIndirectLong,
+    StackRelative,
+    StackRelativeIndirectY,
+    BlockMove,
+};
+
+// One opcode. cycles is the base count this core charges; cycles_wide is
+// the count with a 16-bit register where the width matters (branches,
+// interrupts and block moves add their extra cycles at run time).
+struct OpcodeInfo {
+    const char* mnemonic;
+    AddrMode mode;
+    uint8_t cycles;
+    uint8_t cycles_wide;
+};
+
+// Mnemonic, addressing mode and cycles of every opcode
+constexpr std::array<OpcodeInfo, 256> build_opcode_table() {
+    using A = AddrMode;
+    std::array<OpcodeInfo, 256> t{};
+    t[0x00] = {"BRK", A::Immediate8, 7, 7};
+    t[0x01] = {"ORA", A::DirectIndirectX, 6, 7};
+    t[0x02] = {"COP", A::Immediate8, 7, 7};
+    t[0x03] = {"ORA", A::StackRelative, 4, 5};
+    t[0x04] = {"TSB", A::Direct, 5, 7};
+    t[0x05] = {"ORA", A::Direct, 3, 4};
+    t[0x06] = {"ASL", A::Direct, 5, 5};
+    t[0x07] = {"ORA", A::DirectIndirectLong, 6, 7};
+    t[0x08] = {"PHP", A::Implied, 3, 3};
+    t[0x09] = {"ORA", A::ImmediateM, 2, 3};
+    t[0x0A] = {"ASL", A::Accumulator, 2, 2};
+    t[0x0B] = {"PHD", A::Implied, 4, 4};
+    t[0x0C] = {"TSB", A::Absolute, 6, 8};
+    t[0x0D] = {"ORA", A::Absolute, 4, 5};
+    t[0x0E] = {"ASL", A::Absolute, 6, 6};
+    t[0x0F] = {"ORA", A::AbsoluteLong, 5, 6};
+    t[0x10] = {"BPL", A::Relative, 2, 2};
+    t[0x11] = {"ORA", A::DirectIndirectY, 6, 7};
+    t[0x12] = {"ORA", A::DirectIndirect, 5, 6};
+    t[0x13] = {"ORA", A::StackRelativeIndirectY, 7, 8};
+    t[0x14] = {"TRB", A::Direct, 5, 7};
+    t[0x15] = {"ORA", A::DirectX, 4, 5};
+    t[0x16] = {"ASL", A::DirectX, 6, 6};
+    t[0x17] = {"ORA", A::DirectIndirectLongY, 7, 8};
+    t[0x18] = {"CLC", A::Implied, 2, 2};
+    t[0x19] = {"ORA", A::AbsoluteY, 5, 6};
+    t[0x1A] = {"INC", A::Accumulator, 2, 2};
+    t[0x1B] = {"TCS", A::Implied, 2, 2};
+    t[0x1C] = {"TRB", A::Absolute, 6, 8};
+    t[0x1D] = {"ORA", A::AbsoluteX, 5, 6};
+    t[0x1E] = {"ASL", A::AbsoluteX, 7, 7};
+    t[0x1F] = {"ORA", A::AbsoluteLongX, 5, 6};
+    t[0x20] = {"JSR", A::Absolute, 6, 6};
+    t[0x21] = {"AND", A::DirectIndirectX, 6, 7};
+    t[0x22] = {"JSL", A::AbsoluteLong, 8, 8};
+    t[0x23] = {"AND", A::StackRelative, 4, 5};
+    t[0x24] = {"BIT", A::Direct, 3, 3};
+    t[0x25] = {"AND", A::Direct, 3, 4};
+    t[0x26] = {"ROL", A::Direct, 5, 5};
+    t[0x27] = {"AND", A::DirectIndirectLong, 6, 7};
+    t[0x28] = {"PLP", A::Implied, 4, 4};
+    t[0x29] = {"AND", A::ImmediateM, 2, 3};
+    t[0x2A] = {"ROL", A::Accumulator, 2, 2};
+    t[0x2B] = {"PLD", A::Implied, 5, 5};
+    t[0x2C] = {"BIT", A::Absolute, 4, 4};
+    t[0x2D] = {"AND", A::Absolute, 4, 5};
+    t[0x2E] = {"ROL", A::Absolute, 6, 6};
+    t[0x2F] = {"AND", A::AbsoluteLong, 5, 6};
+    t[0x30] = {"BMI", A::Relative, 2, 2};
+    t[0x31] = {"AND", A::DirectIndirectY, 6, 7};
+    t[0x32] = {"AND", A::DirectIndirect, 5, 6};
+    t[0x33] = {"AND", A::StackRelativeIndirectY, 7, 8};
+    t[0x34] = {"BIT", A::DirectX, 4, 5};
+    t[0x35] = {"AND", A::DirectX, 4, 5};
+    t[0x36] = {"ROL", A::DirectX, 6, 6};
+    t[0x37] = {"AND", A::DirectIndirectLongY, 7, 8};
+    t[0x38] = {"SEC", A::Implied, 2, 2};
+    t[0x39] = {"AND", A::AbsoluteY, 5, 6};
+    t[0x3A] = {"DEC", A::Accumulator, 2, 2};
+    t[0x3B] = {"TSC", A::Implied, 2, 2};
+    t[0x3C] = {"BIT", A::AbsoluteX, 4, 4};
+    t[0x3D] = {"AND", A::AbsoluteX, 5, 6};
+    t[0x3E] = {"ROL", A::AbsoluteX, 7, 7};
+    t[0x3F] = {"AND", A::AbsoluteLongX, 5, 6};
+    t[0x40] = {"RTI", A::Implied, 6, 6};
+    t[0x41] = {"EOR", A::DirectIndirectX, 6, 7};
+    t[0x42] = {"WDM", A::Immediate8, 2, 2};
+    t[0x43] = {"EOR", A::StackRelative, 4, 5};
+    t[0x44] = {"MVP", A::BlockMove, 7, 7};
+    t[0x45] = {"EOR", A::Direct, 3, 4};
+    t[0x46] = {"LSR", A::Direct, 5, 5};
+    t[0x47] = {"EOR", A::DirectIndirectLong, 6, 7};
+    t[0x48] = {"PHA", A::Implied, 3, 4};
+    t[0x49] = {"EOR", A::ImmediateM, 2, 3};
+    t[0x4A] = {"LSR", A::Accumulator, 2, 2};
+    t[0x4B] = {"PHK", A::Implied, 3, 3};
+    t[0x4C] = {"JMP", A::Absolute, 3, 3};
+    t[0x4D] = {"EOR", A::Absolute, 4, 5};
+    t[0x4E] = {"LSR", A::Absolute, 6, 6};
+    t[0x4F] = {"EOR", A::AbsoluteLong, 5, 6};
+    t[0x50] = {"BVC", A::Relative, 2, 2};
+    t[0x51] = {"EOR", A::DirectIndirectY, 6, 7};
+    t[0x52] = {"EOR", A::DirectIndirect, 5, 6};
+    t[0x53] = {"EOR", A::StackRelativeIndirectY, 7, 8};
+    t[0x54] = {"MVN", A::BlockMove, 7, 7};
+    t[0x55] = {"EOR", A::DirectX, 4, 5};
+    t[0x56] = {"LSR", A::DirectX, 6, 6};
+    t[0x57] = {"EOR", A::DirectIndirectLongY, 7, 8};
+    t[0x58] = {"CLI", A::Implied, 2, 2};
+    t[0x59] = {"EOR", A::AbsoluteY, 5, 6};
+    t[0x5A] = {"PHY", A::Implied, 3, 4};
+    t[0x5B] = {"TCD", A::Implied, 2, 2};
+    t[0x5C] = {"JML", A::AbsoluteLong, 4, 4};
+    t[0x5D] = {"EOR", A::AbsoluteX, 5, 6};
+    t[0x5E] = {"LSR", A::AbsoluteX, 7, 7};
+    t[0x5F] = {"EOR", A::AbsoluteLongX, 5, 6};
+    t[0x60] = {"RTS", A::Implied, 6, 6};
+    t[0x61] = {"ADC", A::DirectIndirectX, 6, 7};
+    t[0x62] = {"PER", A::RelativeLong, 6, 6};
+    t[0x63] = {"ADC", A::StackRelative, 4, 5};
+    t[0x64] = {"STZ", A::Direct, 3, 4};
+    t[0x65] = {"ADC", A::Direct, 3, 4};
+    t[0x66] = {"ROR", A::Direct, 5, 5};
+    t[0x67] = {"ADC", A::DirectIndirectLong, 6, 7};
+    t[0x68] = {"PLA", A::Implied, 4, 5};
+    t[0x69] = {"ADC", A::ImmediateM, 2, 3};
+    t[0x6A] = {"ROR", A::Accumulator, 2, 2};
+    t[0x6B] = {"RTL", A::Implied, 6, 6};
+    t[0x6C] = {"JMP", A::AbsoluteIndirect, 5, 5};
+    t[0x6D] = {"ADC", A::Absolute, 4, 5};
+    t[0x6E] = {"ROR", A::Absolute, 6, 6};
+    t[0x6F] = {"ADC", A::AbsoluteLong, 5, 6};
+    t[0x70] = {"BVS", A::Relative, 2, 2};
+    t[0x71] = {"ADC", A::DirectIndirectY, 6, 7};
+    t[0x72] = {"ADC", A::DirectIndirect, 5, 6};
+    t[0x73] = {"ADC", A::StackRelativeIndirectY, 7, 8};
+    t[0x74] = {"STZ", A::DirectX, 4, 5};
+    t[0x75] = {"ADC", A::DirectX, 4, 5};
+    t[0x76] = {"ROR", A::DirectX, 6, 6};
+    t[0x77] = {"ADC", A::DirectIndirectLongY, 7, 8};
+    t[0x78] = {"SEI", A::Implied, 2, 2};
+    t[0x79] = {"ADC", A::AbsoluteY, 5, 6};
+    t[0x7A] = {"PLY", A::Implied, 4, 5};
+    t[0x7B] = {"TDC", A::Implied, 2, 2};
+    t[0x7C] = {"JMP", A::AbsoluteIndirectX, 6, 6};
+    t[0x7D] = {"ADC", A::AbsoluteX, 5, 6};
+    t[0x7E] = {"ROR", A::AbsoluteX, 7, 7};
+    t[0x7F] = {"ADC", A::AbsoluteLongX, 5, 6};
+    t[0x80] = {"BRA", A::Relative, 3, 3};
+    t[0x81] = {"STA", A::DirectIndirectX, 6, 7};
+    t[0x82] = {"BRL", A::RelativeLong, 4, 4};
+    t[0x83] = {"STA", A::StackRelative, 4, 5};
+    t[0x84] = {"STY", A::Direct, 3, 4};
+    t[0x85] = {"STA", A::Direct, 3, 4};
+    t[0x86] = {"STX", A::Direct, 3, 4};
+    t[0x87] = {"STA", A::DirectIndirectLong, 6, 7};
+    t[0x88] = {"DEY", A::Implied, 2, 2};
+    t[0x89] = {"BIT", A::ImmediateM, 2, 3};
+    t[0x8A] = {"TXA", A::Implied, 2, 2};
+    t[0x8B] = {"PHB", A::Implied, 3, 3};
+    t[0x8C] = {"STY", A::Absolute, 4, 5};
+    t[0x8D] = {"STA", A::Absolute, 4, 5};
+    t[0x8E] = {"STX", A::Absolute, 4, 5};
+    t[0x8F] = {"STA", A::AbsoluteLong, 5, 6};
+    t[0x90] = {"BCC", A::Relative, 2, 2};
+    t[0x91] = {"STA", A::DirectIndirectY, 5, 6};
+    t[0x92] = {"STA", A::DirectIndirect, 5, 6};
+    t[0x93] = {"STA", A::StackRelativeIndirectY, 6, 7};
+    t[0x94] = {"STY", A::DirectX, 4, 5};
+    t[0x95] = {"STA", A::DirectX, 4, 5};
+    t[0x96] = {"STX", A::DirectY, 4, 5};
+    t[0x97] = {"STA", A::DirectIndirectLongY, 6, 7};
+    t[0x98] = {"TYA", A::Implied, 2, 2};
+    t[0x99] = {"STA", A::AbsoluteY, 4, 5};
+    t[0x9A] = {"TXS", A::Implied, 2, 2};
+    t[0x9B] = {"TXY", A::Implied, 2, 2};
+    t[0x9C] = {"STZ", A::Absolute, 4, 5};
+    t[0x9D] = {"STA", A::AbsoluteX, 4, 5};
+    t[0x9E] = {"STZ", A::AbsoluteX, 5, 6};
+    t[0x9F] = {"STA", A::AbsoluteLongX, 5, 6};
+    t[0xA0] = {"LDY", A::ImmediateX, 2, 3};
+    t[0xA1] = {"LDA", A::DirectIndirectX, 6, 7};
+    t[0xA2] = {"LDX", A::ImmediateX, 2, 3};
+    t[0xA3] = {"LDA", A::StackRelative, 4, 5};
+    t[0xA4] = {"LDY", A::Direct, 3, 4};
+    t[0xA5] = {"LDA", A::Direct, 3, 4};
+    t[0xA6] = {"LDX", A::Direct, 3, 4};
+    t[0xA7] = {"LDA", A::DirectIndirectLong, 6, 7};
+    t[0xA8] = {"TAY", A::Implied, 2, 2};
+    t[0xA9] = {"LDA", A::ImmediateM, 2, 3};
+    t[0xAA] = {"TAX", A::Implied, 2, 2};
+    t[0xAB] = {"PLB", A::Implied, 4, 4};
+    t[0xAC] = {"LDY", A::Absolute, 4, 5};
+    t[0xAD] = {"LDA", A::Absolute, 4, 5};
+    t[0xAE] = {"LDX", A::Absolute, 4, 5};
+    t[0xAF] = {"LDA", A::AbsoluteLong, 5, 6};
+    t[0xB0] = {"BCS", A::Relative, 2, 2};
+    t[0xB1] = {"LDA", A::DirectIndirectY, 5, 6};
+    t[0xB2] = {"LDA", A::DirectIndirect, 5, 6};
+    t[0xB3] = {"LDA", A::StackRelativeIndirectY, 6, 7};
+    t[0xB4] = {"LDY", A::DirectX, 4, 5};
+    t[0xB5] = {"LDA", A::DirectX, 4, 5};
+    t[0xB6] = {"LDX", A::DirectY, 4, 5};
+    t[0xB7] = {"LDA", A::DirectIndirectLongY, 6, 7};
+    t[0xB8] = {"CLV", A::Implied, 2, 2};
+    t[0xB9] = {"LDA", A::AbsoluteY, 4, 5};
+    t[0xBA] = {"TSX", A::Implied, 2, 2};
+    t[0xBB] = {"TYX", A::Implied, 2, 2};
+    t[0xBC] = {"LDY", A::AbsoluteX, 4, 5};
+    t[0xBD] = {"LDA", A::AbsoluteX, 4, 5};
+    t[0xBE] = {"LDX", A::AbsoluteY, 4, 5};
+    t[0xBF] = {"LDA", A::AbsoluteLongX, 5, 6};
+    t[0xC0] = {"CPY", A::ImmediateX, 2, 3};
+    t[0xC1] = {"CMP", A::DirectIndirectX, 6, 7};
+    t[0xC2] = {"REP", A::Immediate8, 3, 3};
+    t[0xC3] = {"CMP", A::StackRelative, 4, 4};
+    t[0xC4] = {"CPY", A::Direct, 3, 4};
+    t[0xC5] = {"CMP", A::Direct, 3, 4};
+    t[0xC6] = {"DEC", A::Direct, 5, 6};
+    t[0xC7] = {"CMP", A::DirectIndirectLong, 6, 7};
+    t[0xC8] = {"INY", A::Implied, 2, 2};
+    t[0xC9] = {"CMP", A::ImmediateM, 2, 3};
+    t[0xCA] = {"DEX", A::Implied, 2, 2};
+    t[0xCB] = {"WAI", A::Implied, 3, 3};
+    t[0xCC] = {"CPY", A::Absolute, 4, 5};
+    t[0xCD] = {"CMP", A::Absolute, 4, 5};
+    t[0xCE] = {"DEC", A::Absolute, 6, 7};
+    t[0xCF] = {"CMP", A::AbsoluteLong, 5, 5};
+    t[0xD0] = {"BNE", A::Relative, 2, 2};
+    t[0xD1] = {"CMP", A::DirectIndirectY, 6, 7};
+    t[0xD2] = {"CMP", A::DirectIndirect, 5, 6};
+    t[0xD3] = {"CMP", A::StackRelativeIndirectY, 7, 7};
+    t[0xD4] = {"PEI", A::DirectIndirect, 6, 6};
+    t[0xD5] = {"CMP", A::DirectX, 4, 5};
+    t[0xD6] = {"DEC", A::DirectX, 6, 7};
+    t[0xD7] = {"CMP", A::DirectIndirectLongY, 7, 8};
+    t[0xD8] = {"CLD", A::Implied, 2, 2};
+    t[0xD9] = {"CMP", A::AbsoluteY, 5, 6};
+    t[0xDA] = {"PHX", A::Implied, 3, 4};
+    t[0xDB] = {"STP", A::Implied, 3, 3};
+    t[0xDC] = {"JML", A::AbsoluteIndirectLong, 6, 6};
+    t[0xDD] = {"CMP", A::AbsoluteX, 5, 6};
+    t[0xDE] = {"DEC", A::AbsoluteX, 7, 8};
+    t[0xDF] = {"CMP", A::AbsoluteLongX, 5, 5};
+    t[0xE0] = {"CPX", A::ImmediateX, 2, 3};
+    t[0xE1] = {"SBC", A::DirectIndirectX, 6, 7};
+    t[0xE2] = {"SEP", A::Immediate8, 3, 3};
+    t[0xE3] = {"SBC", A::StackRelative, 4, 5};
+    t[0xE4] = {"CPX", A::Direct, 3, 4};
+    t[0xE5] = {"SBC", A::Direct, 3, 4};
+    t[0xE6] = {"INC", A::Direct, 5, 6};
+    t[0xE7] = {"SBC", A::DirectIndirectLong, 6, 7};
+    t[0xE8] = {"INX", A::Implied, 2, 2};
+    t[0xE9] = {"SBC", A::ImmediateM, 2, 3};
+    t[0xEA] = {"NOP", A::Implied, 2, 2};
+    t[0xEB] = {"XBA", A::Implied, 3, 3};
+    t[0xEC] = {"CPX", A::Absolute, 4, 5};
+    t[0xED] = {"SBC", A::Absolute, 4, 5};
+    t[0xEE] = {"INC", A::Absolute, 6, 7};
+    t[0xEF] = {"SBC", A::AbsoluteLong, 5, 6};
+    t[0xF0] = {"BEQ", A::Relative, 2, 2};
+    t[0xF1] = {"SBC", A::DirectIndirectY, 6, 7};
+    t[0xF2] = {"SBC", A::DirectIndirect, 5, 6};
+    t[0xF3] = {"SBC", A::StackRelativeIndirectY, 7, 8};
+    t[0xF4] = {"PEA", A::Absolute, 5, 5};
+    t[0xF5] = {"SBC", A::DirectX, 4, 5};
+    t[0xF6] = {"INC", A::DirectX, 6, 7};
+    t[0xF7] = {"SBC", A::DirectIndirectLongY, 7, 8};
+    t[0xF8] = {"SED", A::Implied, 2, 2};
+    t[0xF9] = {"SBC", A::AbsoluteY, 5, 6};
+    t[0xFA] = {"PLX", A::Implied, 4, 5};
+    t[0xFB] = {"XCE", A::Implied, 2, 2};
+    t[0xFC] = {"JSR", A::AbsoluteIndirectX, 8, 8};
+    t[0xFD] = {"SBC", A::AbsoluteX, 5, 6};
+    t[0xFE] = {"INC", A::AbsoluteX, 7, 8};
+    t[0xFF] = {"SBC", A::AbsoluteLongX, 5, 6};
+    return t;
+}
+
+// Opcode metadata shared by the dispatch tables, the disassembler and the
+// trace formatter
+class CPUOpcodes {
+public:
+    static constexpr std::array<OpcodeInfo, 256> kTable = build_opcode_table();
+
+    static constexpr int operand_length(AddrMode mode, bool m16, bool x16) {
+        switch (mode) {
+        case AddrMode::Implied:
+        case AddrMode::Accumulator:
+            return 0;
+        case AddrMode::ImmediateM:
+            return m16 ? 2 : 1;
+        case AddrMode::ImmediateX:
+            return x16 ? 2 : 1;
+        case AddrMode::RelativeLong:
+        case AddrMode::Absolute:
+        case AddrMode::AbsoluteX:
+        case AddrMode::AbsoluteY:
+        case AddrMode::AbsoluteIndirect:
+        case AddrMode::AbsoluteIndirectX:
+        case AddrMode::AbsoluteIndirectLong:
+        case AddrMode::BlockMove:
+            return 2;
+        case AddrMode::AbsoluteLong:
+        case AddrMode::AbsoluteLongX:
+            return 3;
+        default:
+            return 1;
+        }
+    }
+    // Instruction length in bytes, opcode included
+    static constexpr int length(uint8_t opcode, bool m16, bool x16) {
+        return 1 + operand_length(kTable[opcode].mode, m16, x16);
+    }
+
+    // One instruction as assembly text, e.g. "LDA $1234,X". bytes holds the
+    // opcode and its operands; pc (PB:PC of the opcode) resolves branch
+    // targets. m16/x16 give the register widths for immediate operands.
+    static std::string disassemble(const uint8_t* bytes, uint32_t pc, bool m16, bool x16);
+
+    // One trace record as a text line: address, bytes, disassembly and
+    // registers for instructions, the target for calls and returns
+    static std::string format_trace(const TraceRecord& record);
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "cpu_opcodes.hpp"
+
+// Compile-time profiler switch (set with -DPYSNES_PROFILE=1):
+//   0  profiling compiled out; the hooks below expand to nothing
+//   1  count executions and cycles per opcode and bus accesses per region
+#ifndef PYSNES_PROFILE
+#define PYSNES_PROFILE 0
+#endif
+
+// Execution counters for finding out what emulated code spends its time
+// on. Per addressing mode totals are folded from the per-opcode counters
+// when read. Bus counts are data accesses only; instruction fetches show
+// up in the opcode counts.
+struct CPUProfile {
+    enum Region : uint8_t {
+        kWram,
+        kRom,               // Cartridge space and the fallback vectors
+        kMmio,              // $2000-$5FFF registers
+        kOpenBus,
+        kRegionCount,
+    };
+    static constexpr int kModeCount = (int)AddrMode::BlockMove + 1;
+
+    std::array<uint64_t, 256> opcode_count{};
+    std::array<uint64_t, 256> opcode_cycles{};
+    std::array<uint64_t, kRegionCount> bus_reads{};
+    std::array<uint64_t, kRegionCount> bus_writes{};
+    uint8_t opcode = 0;     // Instruction in progress
+
+    void reset() { *this = CPUProfile{}; }
+
+    void retire(uint64_t count, uint64_t cycles) {
+        opcode_count[opcode] += count;
+        opcode_cycles[opcode] += cycles;
+    }
+
+    std::array<uint64_t, kModeCount> mode_count() const { return by_mode(opcode_count); }
+    std::array<uint64_t, kModeCount> mode_cycles() const { return by_mode(opcode_cycles); }
+
+    static const char* mode_name(int mode);
+    static const char* region_name(int region);
+
+private:
+    static std::array<uint64_t, kModeCount> by_mode(const std::array<uint64_t, 256>& per_opcode);
+};
+
+#if PYSNES_PROFILE
+#define PYSNES_PROFILE_OPCODE(cpu, op) ((cpu)->get_profile().opcode = (op))
+#define PYSNES_PROFILE_RETIRE(cpu, count, cycles) (cpu)->get_profile().retire((count), (cycles))
+#define PYSNES_PROFILE_ACCESS(profile, counters, region) \
+    do { if (profile) (profile)->counters[(region)]++; } while (0)
+#else
+#define PYSNES_PROFILE_OPCODE(cpu, op) ((void)0)
+#define PYSNES_PROFILE_RETIRE(cpu, count, cycles) ((void)0)
+#define PYSNES_PROFILE_ACCESS(profile, counters, region) ((void)0)
+#endif
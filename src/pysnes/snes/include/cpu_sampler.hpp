@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Symbols for emulated code, loaded from assembler output: ca65 linker
+// maps (the "Exports list by name" section) or WLA-DX .sym files
+// ("[labels]" section).
+class SymbolTable {
+public:
+    // Adds the file's symbols to the table; false if none could be read
+    bool load(const std::string& path);
+    void clear() { symbols.clear(); }
+    size_t size() const { return symbols.size(); }
+
+    // The closest symbol at or below addr in the same bank, e.g. "main" or
+    // "main+$12" with offset, or "$BB:AAAA" when there is none. Banks
+    // $80-$FF fall back to the symbols of their $00-$7F mirror.
+    std::string resolve(uint32_t addr, bool with_offset = true) const;
+
+private:
+    const std::pair<uint32_t, std::string>* find(uint32_t addr) const;
+
+    // Sorted by address
+    std::vector<std::pair<uint32_t, std::string>> symbols;
+};
+
+// Sampling profiler for emulated code. The scheduler calls sample() every
+// interval of CPU cycles with PB:PC; the CPU reports JSR/JSL and interrupt
+// entries and the returns that leave them, giving a shadow call stack that
+// is recorded with each sample. Frames hold the call site, so resolving
+// them names the calling functions.
+class CPUSampler {
+public:
+    static constexpr size_t kMaxDepth = 64;
+
+    // Frames live while the return address the call pushed is still on the
+    // stack, i.e. while S is at or below the value after the push, and no
+    // later call has pushed over it. Code that discards return addresses or
+    // returns through a pushed address so keeps the stack consistent.
+    void on_call(uint32_t site, uint16_t sp) {
+        while (!stack.empty() && stack.back().sp <= sp) {
+            stack.pop_back();
+        }
+        if (stack.size() < kMaxDepth) {
+            stack.push_back(Frame{site, sp});
+        }
+    }
+    void on_return(uint16_t sp) { unwind(sp); }
+
+    void sample(uint32_t pc, uint16_t sp);
+    void reset();                       // Forget the samples
+    void clear_call_stack() { stack.clear(); }   // CPU was reset
+
+    uint64_t sample_count() const { return samples; }
+    const std::unordered_map<uint32_t, uint64_t>& pc_histogram() const { return histogram; }
+
+    // Samples per function (symbol of the sampled PC)
+    std::map<std::string, uint64_t> flat_profile(const SymbolTable& symbols) const;
+    // Samples per call stack, folded outermost first as "main;update;leaf"
+    // (the function of each call site, then that of the sampled PC)
+    std::map<std::string, uint64_t> stack_profile(const SymbolTable& symbols) const;
+
+private:
+    struct Frame {
+        uint32_t site;
+        uint16_t sp;
+    };
+
+    void unwind(uint16_t sp) {
+        while (!stack.empty() && stack.back().sp < sp) {
+            stack.pop_back();
+        }
+    }
+
+    std::vector<Frame> stack;
+    uint64_t samples = 0;
+    std::unordered_map<uint32_t, uint64_t> histogram;
+    // Call sites outermost first, then the sampled PC
+    std::map<std::vector<uint32_t>, uint64_t> stacks;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compile-time trace level (set with -DPYSNES_TRACE_LEVEL=N):
+//   0  tracing compiled out; the hooks below expand to nothing
+//   1  one record per executed instruction
+//   2  also records events (subroutine calls and returns, helper logs)
+#ifndef PYSNES_TRACE_LEVEL
+#define PYSNES_TRACE_LEVEL 0
+#endif
+
+// Binary trace record. The layout is fixed (32 bytes, little endian) so
+// dumps can be read back directly, e.g. with numpy.frombuffer.
+struct TraceRecord {
+    enum Kind : uint8_t {
+        kInstruction = 0,   // About to execute opcode at pc; arg = operand bytes
+        kCall = 1,          // JSR/JSL; arg = target address
+        kReturn = 2,        // RTS/RTL; arg = return address
+        kLog = 3,           // CPUHelpers::log_instruction; arg = address
+    };
+
+    uint64_t cycles;        // CPU cycle count before the instruction
+    uint32_t pc;            // PB:PC, 24-bit
+    uint32_t arg;
+    uint8_t kind;
+    uint8_t opcode;
+    uint16_t a;
+    uint16_t x;
+    uint16_t y;
+    uint16_t sp;
+    uint16_t p;
+    uint16_t d;
+    uint8_t db;
+    uint8_t reserved;
+};
+static_assert(sizeof(TraceRecord) == 32, "TraceRecord layout is part of the dump format");
+
+// Fixed-size ring buffer of trace records; the oldest records are
+// overwritten once it is full.
+class CPUTrace {
+public:
+    static constexpr size_t kDefaultCapacity = 1 << 16;
+
+    explicit CPUTrace(size_t capacity = kDefaultCapacity);
+
+    void push(const TraceRecord& record) {
+        buffer[head] = record;
+        head = (head + 1 == buffer.size()) ? 0 : head + 1;
+        if (count < buffer.size()) count++;
+        total++;
+    }
+
+    void set_capacity(size_t capacity);    // Also clears the buffer
+    void clear();
+
+    size_t capacity() const { return buffer.size(); }
+    size_t size() const { return count; }
+    uint64_t total_records() const { return total; }
+
+    // Records currently held, oldest first
+    std::vector<TraceRecord> records() const;
+    // Same records as raw bytes, or written to a file
+    std::vector<uint8_t> dump() const;
+    bool dump(const std::string& path) const;
+
+private:
+    std::vector<TraceRecord> buffer;
+    size_t head = 0;
+    size_t count = 0;
+    uint64_t total = 0;
+};
+
+#if PYSNES_TRACE_LEVEL >= 1
+#define PYSNES_TRACE_INSTRUCTION(cpu, op) (cpu)->trace_event(TraceRecord::kInstruction, (op), 0)
+#else
+#define PYSNES_TRACE_INSTRUCTION(cpu, op) ((void)0)
+#endif
+
+#if PYSNES_TRACE_LEVEL >= 2
+#define PYSNES_TRACE_EVENT(cpu, kind, arg) (cpu)->trace_event((kind), 0, (arg))
+#else
+#define PYSNES_TRACE_EVENT(cpu, kind, arg) ((void)0)
+#endif
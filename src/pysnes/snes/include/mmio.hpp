@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// One memory-mapped register, as listed in a device's register table. The
+// bus installs the tables into flat per-address dispatch arrays for the B
+// bus ($2100-$21FF) and the CPU's I/O area ($4000-$43FF). Handlers get the
+// device the table was installed with and the full 16-bit address; a null
+// handler leaves that direction as open bus.
+struct MmioRegister {
+    using ReadFn = uint8_t (*)(void* device, uint16_t addr);
+    using WriteFn = void (*)(void* device, uint16_t addr, uint8_t data);
+
+    enum Flags : uint8_t {
+        kOpenBus = 0x01,        // Write-only: reads return open bus
+        kNoSideEffects = 0x02,  // Reading changes nothing, so debuggers may peek
+    };
+
+    uint16_t addr;
+    const char* name;
+    ReadFn read;
+    WriteFn write;
+    uint8_t flags;
+};
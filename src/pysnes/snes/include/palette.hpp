@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// The 256 CGRAM colors, already in each output format. The PPU updates an
+// entry whenever either of its CGRAM bytes is written, so renderers and
+// exporters look colors up instead of assembling and converting them per
+// pixel. 5-bit channels widen to 8 bits as (c << 3) | (c >> 2), so 31 maps
+// to 255.
+class Palette {
+public:
+    static constexpr int kColors = 256;
+
+    // Packed R, G, B, A in memory order (A = 255), as SNES::get_screen
+    static uint32_t to_rgba8888(uint16_t bgr555) {
+        uint32_t r = expand((bgr555 >> 0) & 0x1F);
+        uint32_t g = expand((bgr555 >> 5) & 0x1F);
+        uint32_t b = expand((bgr555 >> 10) & 0x1F);
+        return 0xFF000000u | (b << 16) | (g << 8) | r;
+    }
+    static uint8_t expand(uint32_t c) { return (uint8_t)((c << 3) | (c >> 2)); }
+
+    void set(int index, uint16_t bgr555) {
+        bgr555 &= 0x7FFF;
+        uint32_t rgba = to_rgba8888(bgr555);
+        bgr555_[index] = bgr555;
+        rgba8888_[index] = rgba;
+        rgb888_[index] = {(uint8_t)rgba, (uint8_t)(rgba >> 8), (uint8_t)(rgba >> 16)};
+    }
+    // Every entry from 512 bytes of CGRAM
+    void load(const uint8_t* cgram) {
+        for (int i = 0; i < kColors; ++i) {
+            set(i, cgram[2 * i] | (cgram[2 * i + 1] << 8));
+        }
+    }
+
+    uint16_t bgr555(uint8_t index) const { return bgr555_[index]; }
+    uint32_t rgba8888(uint8_t index) const { return rgba8888_[index]; }
+    const uint8_t* rgb888(uint8_t index) const { return rgb888_[index].data(); }
+
+    // Palette indices to colors, one pass per line or frame
+    void resolve(const uint8_t* indices, size_t count, uint16_t* out) const {
+        for (size_t i = 0; i < count; ++i) out[i] = bgr555_[indices[i]];
+    }
+    void resolve(const uint8_t* indices, size_t count, uint32_t* out) const {
+        for (size_t i = 0; i < count; ++i) out[i] = rgba8888_[indices[i]];
+    }
+    void resolve_rgb888(const uint8_t* indices, size_t count, uint8_t* out) const {
+        for (size_t i = 0; i < count; ++i, out += 3) {
+            const auto& rgb = rgb888_[indices[i]];
+            out[0] = rgb[0];
+            out[1] = rgb[1];
+            out[2] = rgb[2];
+        }
+    }
+
+private:
+    std::array<uint16_t, kColors> bgr555_{};
+    std::array<uint32_t, kColors> rgba8888_{};
+    std::array<std::array<uint8_t, 3>, kColors> rgb888_{};
+};
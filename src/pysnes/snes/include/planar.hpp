@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+
+// Planar to chunky conversion of 8x8 tiles with 1-8 bitplanes, in the
+// hardware's layout: planes are stored in pairs of 16 bytes, and row y of
+// a pair is bytes 2y (even plane) and 2y + 1 (odd plane). So plane p of
+// row y is byte 16 * (p / 2) + 2 * y + p % 2 of the tile, and 16 bytes per
+// started pair are read. Pixel x is bit 7 - x of the row's plane bytes, or
+// bit x when flipped horizontally. Output is one palette index byte per
+// pixel, left to right.
+
+// One row: 8 bytes of out
+void planar_to_chunky_row(const uint8_t* tile, int planes, int y, bool hflip, uint8_t* out);
+// The whole tile, row by row: 64 bytes of out. Dispatches on simd_level().
+void planar_to_chunky_tile(const uint8_t* tile, int planes, bool hflip, uint8_t* out);
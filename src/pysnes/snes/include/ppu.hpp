@@ -3,11 +3,61 @@
 #include <array>
 #include <vector>
 #include <string>
+#include <type_traits>
+#include "color.hpp"
+#include "mmio.hpp"
+#include "palette.hpp"
+#include "tile_cache.hpp"
 
 // SNES PPU (Picture Processing Unit) - Initial Skeleton
 // VRAM: 64KB, CGRAM: 512B, OAM: 544B
 class Bus; // Forward declaration
-class PPU {
+
+// Memory, registers and timing of the PPU, trivially copyable for save
+// states. The framebuffer is included so a restored frame in progress keeps
+// the lines already drawn.
+struct PPUState {
+    // --- PPU Memory ---
+    std::array<uint8_t, 64 * 1024> vram_;
+    std::array<uint8_t, 512> cgram_;
+    std::array<uint8_t, 544> oam_;
+
+    // --- Framebuffer ---
+    uint16_t framebuffer_[224][256] = {};     // [kScreenHeight][kScreenWidth]
+
+    // --- Timing State ---
+    int scanline_ = 0;
+    int dot_ = 0;
+    int frame_ = 0;
+    bool vblank_ = false;
+    bool hblank_ = false;
+
+    // --- Register State and Latches ---
+    uint16_t oam_addr_ = 0;
+    bool oam_priority_rotation_ = false;
+    bool oam_addr_msb_ = false;
+    bool oam_latch_low_ = true;
+    uint16_t vram_read_buffer_ = 0;
+    uint8_t cgram_read_buffer_ = 0;
+    uint8_t inidisp_ = 0;
+    uint8_t obsel_ = 0;
+    uint8_t bgmode_ = 0;
+    uint8_t mosaic_ = 0;
+    uint8_t bg_sc_[4] = {0};
+    uint8_t bg_nba_[2] = {0};
+    uint16_t bg_hofs_[4] = {0};
+    uint8_t bg_hofs_latch_[4] = {0};
+    bool bg_hofs_latch_state_[4] = {true, true, true, true};
+    uint16_t bg_vofs_[4] = {0};
+    uint8_t vmain_ = 0;
+    uint16_t vram_addr_ = 0;        // VMADD word address
+    uint16_t cgram_addr_ = 0;       // Byte index into CGRAM (CGADD * 2)
+    uint8_t tm_ = 0;
+    uint8_t ts_ = 0;
+};
+static_assert(std::is_trivially_copyable<PPUState>::value, "save states copy PPUState as bytes");
+
+class PPU : private PPUState {
 public:
     // --- Data Structures ---
     struct PixelInfo {
@@ -31,6 +81,8 @@ public:
     static constexpr int kScreenHeight = 224;
     static constexpr int kTotalScanlines = 262; // NTSC
     static constexpr int kDotsPerScanline = 341; // SNES typical
+    static_assert(sizeof(PPUState::framebuffer_) == sizeof(uint16_t) * kScreenHeight * kScreenWidth,
+                  "PPUState framebuffer matches the screen size");
 
     // --- Constructors/Destructors ---
     PPU();
@@ -50,12 +102,24 @@ public:
     // Register access
     uint8_t read_register(uint16_t addr);
     void write_register(uint16_t addr, uint8_t value);
+    // The implemented registers in $2100-$213F, sorted by address, for the
+    // bus's dispatch tables
+    static constexpr int kRegisterCount = 37;
+    static const MmioRegister* registers() { return kRegisters; }
     // Bus interface
     uint8_t cpu_read(uint16_t addr) { return read_register(addr); }
     void cpu_write(uint16_t addr, uint8_t data) { write_register(addr, data); }
+    // DMA fast paths: the same as writing each byte of data to the port in
+    // turn, without going through the register decode per byte.
+    // write_vram_words() alternates $2118/$2119, starting with $2118.
+    void write_vram_port(bool high, const uint8_t* data, size_t length);
+    void write_vram_words(const uint8_t* data, size_t length);
+    void write_cgram_port(const uint8_t* data, size_t length);
+    void write_oam_port(const uint8_t* data, size_t length);
 
     // --- Rendering and Timing API ---
     void step_dot();
+    void set_dot(int dot);
     void step_scanline();
     void step_frame();
     void render_full_scanline(int scanline);
@@ -66,6 +130,10 @@ public:
     void apply_mosaic_effect(int scanline);
     void apply_window_masking(int scanline);
     void render_mode0_background(int bg, int scanline, PixelInfo* out);
+    // One line of a BG at the given depth: per pixel the color index with
+    // the tilemap palette above it (palette << bpp, none for 8bpp), 0 where
+    // transparent
+    void render_bg_line(int bg, int scanline, TileCache::Depth depth, uint8_t* out);
     void render_mode7_background(int scanline);
     void render_scanline_stub();
     void render_sprite_stub();
@@ -77,6 +145,8 @@ public:
     uint8_t get_bgmode() const { return bgmode_; }
     SpriteAttr parse_sprite_attr(int index) const;
     uint16_t get_cgram_color(int index) const;
+    // CGRAM converted to the output formats, current with every write
+    const Palette& get_palette() const { return palette_; }
     std::vector<int> get_sprites_on_scanline(int scanline) const;
     PixelInfo get_pixel_info(int x, int scanline) const;
     uint16_t blend_colors(uint16_t color1, uint16_t color2, bool additive) const;
@@ -86,6 +156,11 @@ public:
     void export_framebuffer_ppm(const std::string& filename) const;
     const uint16_t* get_framebuffer_row(int y) const { return framebuffer_[y]; }
     std::vector<uint8_t> get_framebuffer_rgb() const;
+    // The whole frame in format, scaled by display_brightness(), into out
+    // (kScreenHeight * kScreenWidth * pixel_format_bytes(format) bytes)
+    void convert_framebuffer(PixelFormat format, uint8_t* out) const;
+    // INIDISP master brightness, 0 during forced blank
+    int display_brightness() const { return (inidisp_ & 0x80) ? 0 : inidisp_ & 0x0F; }
 
     // --- State Getters (for tests/inspection) ---
     bool get_vblank() const { return vblank_; }
@@ -96,44 +171,32 @@ public:
 
     void set_bus(Bus* bus) { bus_ = bus; }
 
+    // Save states
+    void save_state(PPUState& state) const { state = *this; }
+    void load_state(const PPUState& state) {
+        static_cast<PPUState&>(*this) = state;
+        tile_cache_.invalidate_all();
+        palette_.load(cgram_.data());
+    }
+
 private:
-    // --- PPU Memory ---
-    std::array<uint8_t, 64 * 1024> vram_;
-    std::array<uint8_t, 512> cgram_;
-    std::array<uint8_t, 544> oam_;
+    static const MmioRegister kRegisters[kRegisterCount];
+    static const MmioRegister* find_register(uint16_t addr);
+    static uint8_t read_status(void* device, uint16_t addr);
+    void write_hofs(int bg, uint8_t value);
 
-    // --- Framebuffer ---
-    uint16_t framebuffer_[kScreenHeight][kScreenWidth] = {};
+    // Data ports shared by the registers and the DMA fast paths
+    void vram_port_write(bool high, uint8_t value);
+    void oam_port_write(uint8_t value);
+    void vram_prefetch();
+    uint16_t vram_word_address() const;
+    uint16_t vram_increment() const;
 
-    // --- Timing State ---
-    int scanline_ = 0;
-    int dot_ = 0;
-    int frame_ = 0;
-    bool vblank_ = false;
-    bool hblank_ = false;
+    // Decoded VRAM tiles and converted CGRAM, kept in step by every write
+    TileCache tile_cache_;
+    Palette palette_;
+    void update_palette(int index);
 
-    // --- Register State and Latches ---
-    uint16_t oam_addr_ = 0;
-    bool oam_priority_rotation_ = false;
-    bool oam_addr_msb_ = false;
-    bool oam_latch_low_ = true;
-    uint16_t vram_read_buffer_ = 0;
-    uint8_t cgram_read_buffer_ = 0;
-    uint8_t inidisp_ = 0;
-    uint8_t obsel_ = 0;
-    uint8_t bgmode_ = 0;
-    uint8_t mosaic_ = 0;
-    uint8_t bg_sc_[4] = {0};
-    uint8_t bg_nba_[2] = {0};
-    uint16_t bg_hofs_[4] = {0};
-    uint8_t bg_hofs_latch_[4] = {0};
-    bool bg_hofs_latch_state_[4] = {true, true, true, true};
-    uint16_t bg_vofs_[4] = {0};
-    uint8_t vmain_ = 0;
-    uint16_t vram_addr_ = 0;
-    uint8_t cgram_addr_ = 0;
-    uint8_t tm_ = 0;
-    uint8_t ts_ = 0;
     // TODO: Add windowing, color math, mode 7, and status registers
     Bus* bus_ = nullptr;
 };
@@ -0,0 +1,118 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "mmio.hpp"
+
+class Bus;
+class CPU;
+class CPUSampler;
+class PPU;
+
+// Save state of the scheduler: the clock, the interrupt registers and the
+// pending events (sampling events are not saved)
+struct SchedulerState {
+    static constexpr int kMaxEvents = 8;
+
+    uint64_t clock = 0;
+    uint64_t line_start = 0;
+    uint64_t event_time[kMaxEvents] = {};
+    uint8_t event[kMaxEvents] = {};
+    uint8_t event_count = 0;
+    uint8_t nmitimen = 0;
+    uint16_t htime = 0x1FF;
+    uint16_t vtime = 0x1FF;
+    bool nmi_flag = false;
+    bool irq_flag = false;
+};
+
+// Master-clock scheduler. Time is counted in 21.477MHz master clocks; the
+// PPU advances one dot every 4 clocks and the CPU is approximated at 8
+// clocks per cycle (SlowROM speed). Instead of stepping the PPU after every
+// instruction, the CPU runs in one batch up to the next queued event
+// (render, H-blank, end of scanline, IRQ timer), which is then handled at
+// the instruction boundary where it fell due. While the CPU is halted by
+// WAI or STP, time jumps from one event to the next.
+class Scheduler {
+public:
+    static constexpr uint64_t kMasterClockHz = 21477272;
+    static constexpr int kClocksPerDot = 4;
+    static constexpr int kClocksPerCpuCycle = 8;
+    static constexpr int kClocksPerScanline = 1364;   // 341 dots
+    static constexpr uint64_t kClocksPerFrame = (uint64_t)kClocksPerScanline * 262;
+    static constexpr int kRenderDot = 22;              // First visible pixel
+    static constexpr int kHBlankDot = 301;             // Last 40 dots of the line
+
+    enum class Event : uint8_t {
+        kRenderScanline,    // Draw the current line with the registers as they are now
+        kHBlank,
+        kScanlineEnd,       // Next line; V-blank start raises NMI
+        kIrqTimer,          // H/V counter match from HTIME/VTIME
+        kSample,            // Record PB:PC with the sampling profiler
+    };
+
+    Scheduler(CPU& cpu, PPU& ppu);
+
+    // Bus whose HDMA runs at the start of each frame and in each H-blank;
+    // set by Bus::connect_scheduler()
+    void connect_bus(Bus* bus_) { bus = bus_; }
+
+    // Back to line 0, dot 0 with the interrupt registers cleared; call after
+    // resetting the PPU
+    void reset();
+
+    // Run until the CPU reaches either target (absolute cycle_count /
+    // instruction_count values), dispatching events on the way
+    void run_until(uint64_t cycle_target, uint64_t instruction_target);
+
+    uint64_t get_clock() const { return clock; }
+
+    void save_state(SchedulerState& state) const;
+    void load_state(const SchedulerState& state);
+
+    // Sample the CPU every interval_cycles CPU cycles; nullptr stops sampling
+    void set_sampler(CPUSampler* sampler, uint64_t interval_cycles);
+
+    // CPU registers owned by the scheduler, routed here by the bus
+    void write_nmitimen(uint8_t value);              // $4200
+    void write_timer(uint16_t addr, uint8_t value);  // $4207-$420A
+    uint8_t read_rdnmi();                            // $4210
+    uint8_t read_timeup();                           // $4211
+    uint8_t read_hvbjoy() const;                     // $4212
+    // The same registers as a table for the bus's dispatch
+    static constexpr int kRegisterCount = 8;
+    static const MmioRegister* registers() { return kRegisters; }
+
+private:
+    static const MmioRegister kRegisters[kRegisterCount];
+
+    struct Entry {
+        uint64_t time;
+        Event event;
+    };
+
+    void schedule(uint64_t time, Event event);
+    void cancel(Event event);
+    void dispatch(Event event);
+    void schedule_irq_timer();
+    bool can_wake() const;
+    void stall_cpu(uint64_t clocks);
+
+    CPU& cpu;
+    PPU& ppu;
+    Bus* bus = nullptr;
+
+    uint64_t clock = 0;         // Master clocks since reset
+    uint64_t line_start = 0;    // Clock at dot 0 of the current scanline
+    // Pending events, latest first so the next one is popped off the back
+    std::vector<Entry> queue;
+
+    uint8_t nmitimen = 0;
+    uint16_t htime = 0x1FF;
+    uint16_t vtime = 0x1FF;
+    bool nmi_flag = false;      // RDNMI bit 7
+    bool irq_flag = false;      // TIMEUP bit 7; holds /IRQ low until read
+
+    CPUSampler* sampler = nullptr;
+    uint64_t sample_interval = 0;   // Master clocks
+    uint64_t next_sample = 0;
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+// Instruction set used by the pixel kernels (tile decoding, color
+// conversion). With PYSNES_SIMD (x86-64 GCC/Clang builds, see
+// CMakeLists.txt) the SSE2 and AVX2 kernels are compiled with per-function
+// target attributes and picked at run time from what the CPU supports;
+// every other build runs the scalar kernels. All levels give bit-identical
+// results.
+enum class SimdLevel : uint8_t { kScalar, kSse2, kAvx2 };
+
+bool simd_supported(SimdLevel level);
+SimdLevel simd_best_level();
+
+// The level kernels dispatch to, the best one unless overridden (tests,
+// benchmarks). Returns false, changing nothing, if the CPU lacks it.
+SimdLevel simd_level();
+bool set_simd_level(SimdLevel level);
+
+const char* simd_level_name(SimdLevel level);
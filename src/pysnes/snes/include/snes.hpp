@@ -1,7 +1,11 @@
 #pragma once
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <tuple>
 #include <vector>
 #include <string>
+#include "color.hpp"
 
 class SNES {
   public:
@@ -12,10 +16,79 @@ class SNES {
     void power_on();
     void reset();
     void step();
+    // Batch execution with the PPU kept in step; avoids a call per instruction
+    uint64_t run(uint64_t cycles);             // Returns CPU cycles executed
+    uint64_t run_instructions(uint64_t count); // Returns instructions executed
+
+    // Save states: a version header followed by the CPU, bus (WRAM), PPU,
+    // scheduler and controller state blocks, then the cartridge SRAM. The
+    // ROM is not included; load into an SNES with the same ROM inserted.
+    // load_state() returns false and leaves the machine untouched if the
+    // buffer doesn't match this build's layout or the cartridge's SRAM size.
+    size_t state_size() const;
+    void save_state(std::vector<uint8_t> &buffer);
+    bool load_state(const uint8_t *data, size_t size);
+    bool load_state(const std::vector<uint8_t> &buffer) { return load_state(buffer.data(), buffer.size()); }
+    const std::string &get_rom_path() const;
+    // Detected header: title, mapper, speed, rom_size, sram_size (bytes)
+    // and checksum ("valid"/"invalid"); empty without a cartridge
+    std::map<std::string, std::string> get_cartridge_info() const;
+    // Mapped I/O registers ($2100-$21FF, $4000-$43FF) by address:
+    // (name, readable, writable, reads without side effects)
+    std::map<uint16_t, std::tuple<std::string, bool, bool, bool>> get_io_registers() const;
 
     std::vector<uint32_t>& get_screen();
     void set_controller_state(int controller_num, uint8_t state);
     std::vector<uint8_t> get_framebuffer_rgb();
+    // The screen in format, at the current INIDISP brightness, into out:
+    // 224 * 256 * pixel_format_bytes(format) bytes
+    void get_framebuffer(PixelFormat format, uint8_t* out);
+
+    // Idle-loop skipping (on unless tracing is compiled in). Stats count
+    // skips, cycles and instructions fast-forwarded since the last reset.
+    void set_idle_loop_skipping(bool enabled);
+    bool get_idle_loop_skipping();
+    std::map<std::string, uint64_t> get_idle_loop_stats();
+    void reset_idle_loop_stats();
+
+    // CPU trace ring buffer (empty unless built with PYSNES_TRACE_LEVEL > 0)
+    static int trace_level();
+    std::vector<uint8_t> get_trace();          // Raw 32-byte records, oldest first
+    bool dump_trace(const std::string &path);
+    void clear_trace();
+    void set_trace_capacity(size_t records);
+    std::vector<std::string> format_trace();    // Trace records as text lines
+
+    // count instructions from the 24-bit address addr, decoded with the
+    // current M/X widths and following REP/SEP along the way
+    std::vector<std::string> disassemble(uint32_t addr, size_t count);
+    // Opcodes the CPU has no handler for, keyed "$XX MNEMONIC", with how
+    // many times each has executed
+    std::map<std::string, uint64_t> get_unimplemented_opcodes();
+
+    // Execution profile (all zero unless built with PYSNES_ENABLE_PROFILER).
+    // Arrays: opcode_count/opcode_cycles (256), mode_count/mode_cycles
+    // (indexed like profile_mode_names()) and bus_reads/bus_writes (indexed
+    // like profile_region_names()).
+    static bool profiling_available();
+    std::map<std::string, std::vector<uint64_t>> get_profile();
+    void reset_profile();
+    static std::vector<std::string> profile_mode_names();
+    static std::vector<std::string> profile_region_names();
+
+    // Sampling profiler: records PB:PC and the JSR/JSL/interrupt call stack
+    // every interval_cycles CPU cycles while running. Symbols from ca65 .map
+    // or WLA-DX .sym files name the functions in the reports; unknown code
+    // shows as "$BB:AAAA".
+    void start_sampling(uint64_t interval_cycles);
+    void stop_sampling();
+    void reset_samples();
+    bool load_symbols(const std::string &path);  // Adds to the loaded symbols
+    void clear_symbols();
+    std::string resolve_symbol(uint32_t addr);
+    std::map<uint32_t, uint64_t> get_pc_samples();
+    std::map<std::string, uint64_t> get_flat_profile();         // Samples per function
+    std::map<std::string, uint64_t> get_call_stack_profile();   // "outer;inner;leaf" -> samples
 
   private:
     // This is the PIMPL pattern. All internal components
@@ -0,0 +1,46 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Decoded 8x8 background tiles, one palette index byte per pixel, for each
+// color depth. Tiles are numbered from the start of VRAM in units of their
+// own size (16, 32 or 64 bytes). The PPU marks the tiles under every VRAM
+// write dirty; a dirty tile is decoded again the next time it's drawn.
+//
+// Bitplanes are in the hardware's layout (see planar.hpp): rows of planes
+// 0/1 interleaved in the first 16 bytes, planes 2/3 in the next 16, and
+// so on.
+class TileCache {
+public:
+    enum Depth : uint8_t { k2bpp, k4bpp, k8bpp };
+    static constexpr int kDepths = 3;
+    static constexpr size_t kVramSize = 64 * 1024;
+    static constexpr size_t kTileBytes = 64;    // Decoded size
+
+    TileCache();
+
+    // The 64 indices of tile (wrapped to VRAM) row by row, left pixel first
+    const uint8_t* tile(const std::array<uint8_t, kVramSize>& vram, Depth depth, uint32_t tile) {
+        tile &= (kVramSize >> (4 + depth)) - 1;
+        if (dirty[depth][tile]) {
+            decode(vram, depth, tile);
+        }
+        return &pixels[depth][tile * kTileBytes];
+    }
+
+    // addr and length in VRAM bytes; ranges wrap at the end of VRAM
+    void invalidate(uint32_t addr) {
+        addr &= kVramSize - 1;
+        dirty[k2bpp][addr >> 4] = dirty[k4bpp][addr >> 5] = dirty[k8bpp][addr >> 6] = 1;
+    }
+    void invalidate(uint32_t addr, size_t length);
+    void invalidate_all();
+
+private:
+    void decode(const std::array<uint8_t, kVramSize>& vram, Depth depth, uint32_t tile);
+
+    std::vector<uint8_t> pixels[kDepths];
+    std::vector<uint8_t> dirty[kDepths];
+};
@@ -3,11 +3,112 @@
 #include "ppu.hpp"
 #include "cartridge.hpp"
 #include "controller.hpp"
+#include "scheduler.hpp"
+#include <algorithm>
 #include <cstring>
 
+const std::array<uint8_t, Bus::kPageSize> Bus::open_bus_page{};
+
+namespace {
+
+uint8_t open_bus_read(void*, uint16_t) { return 0x00; }
+void open_bus_write(void*, uint16_t, uint8_t) {}
+
+Bus* bus_of(void* device) { return static_cast<Bus*>(device); }
+
+} // namespace
+
+// The multiplier and divider results are ready at once; the hardware
+// takes 8 and 16 CPU cycles
+const MmioRegister Bus::kRegisters[Bus::kRegisterCount] = {
+    {0x2180, "WMDATA", [](void* d, uint16_t) -> uint8_t {
+        Bus* b = bus_of(d);
+        uint8_t value = b->wram[b->wram_port];
+        b->wram_port = (b->wram_port + 1) & 0x1FFFF;
+        return value;
+    }, [](void* d, uint16_t, uint8_t v) {
+        Bus* b = bus_of(d);
+        b->wram[b->wram_port] = v;
+        if (b->code_pages[b->wram_port >> 8]) b->notify_code_write(b->wram_port);
+        b->wram_port = (b->wram_port + 1) & 0x1FFFF;
+    }, 0},
+    {0x2181, "WMADDL", nullptr, [](void* d, uint16_t, uint8_t v) {
+        bus_of(d)->wram_port = (bus_of(d)->wram_port & 0x1FF00) | v;
+    }, MmioRegister::kOpenBus},
+    {0x2182, "WMADDM", nullptr, [](void* d, uint16_t, uint8_t v) {
+        bus_of(d)->wram_port = (bus_of(d)->wram_port & 0x100FF) | (v << 8);
+    }, MmioRegister::kOpenBus},
+    {0x2183, "WMADDH", nullptr, [](void* d, uint16_t, uint8_t v) {
+        bus_of(d)->wram_port = (bus_of(d)->wram_port & 0x0FFFF) | ((v & 0x01) << 16);
+    }, MmioRegister::kOpenBus},
+    {0x4016, "JOYSER0", [](void* d, uint16_t) -> uint8_t {
+        auto& c = bus_of(d)->controllers[0];
+        return c ? c->read() : 0x00;
+    }, [](void* d, uint16_t, uint8_t v) {
+        if (auto& c = bus_of(d)->controllers[0]) c->write(v);
+    }, 0},
+    {0x4017, "JOYSER1", [](void* d, uint16_t) -> uint8_t {
+        auto& c = bus_of(d)->controllers[1];
+        return c ? c->read() : 0x00;
+    }, [](void* d, uint16_t, uint8_t v) {
+        if (auto& c = bus_of(d)->controllers[1]) c->write(v);
+    }, 0},
+    {0x4202, "WRMPYA", nullptr, [](void* d, uint16_t, uint8_t v) { bus_of(d)->wrmpya = v; }, MmioRegister::kOpenBus},
+    {0x4203, "WRMPYB", nullptr, [](void* d, uint16_t, uint8_t v) {
+        Bus* b = bus_of(d);
+        b->rdmpy = b->wrmpya * v;
+        b->rddiv = v;
+    }, MmioRegister::kOpenBus},
+    {0x4204, "WRDIVL", nullptr, [](void* d, uint16_t, uint8_t v) {
+        bus_of(d)->wrdiv = (bus_of(d)->wrdiv & 0xFF00) | v;
+    }, MmioRegister::kOpenBus},
+    {0x4205, "WRDIVH", nullptr, [](void* d, uint16_t, uint8_t v) {
+        bus_of(d)->wrdiv = (bus_of(d)->wrdiv & 0x00FF) | (v << 8);
+    }, MmioRegister::kOpenBus},
+    {0x4206, "WRDIVB", nullptr, [](void* d, uint16_t, uint8_t v) {
+        // Division by zero gives $FFFF with the dividend as remainder
+        Bus* b = bus_of(d);
+        b->rddiv = v ? b->wrdiv / v : 0xFFFF;
+        b->rdmpy = v ? b->wrdiv % v : b->wrdiv;
+    }, MmioRegister::kOpenBus},
+    // DMA: the CPU waits while the channels run
+    {0x420B, "MDMAEN", nullptr, [](void* d, uint16_t, uint8_t v) {
+        Bus* b = bus_of(d);
+        uint64_t clocks = b->run_dma(v);
+        if (b->cpu && clocks) {
+            b->cpu->stall((clocks + Scheduler::kClocksPerCpuCycle - 1) / Scheduler::kClocksPerCpuCycle);
+        }
+    }, MmioRegister::kOpenBus},
+    // Channels enabled mid-frame wait for the next frame's init
+    {0x420C, "HDMAEN", nullptr, [](void* d, uint16_t, uint8_t v) {
+        Bus* b = bus_of(d);
+        for (int i = 0; i < kDmaChannels; ++i) {
+            if ((v & ~b->hdmaen) & (1 << i)) b->dma[i].hdma_done = true;
+        }
+        b->hdmaen = v;
+    }, MmioRegister::kOpenBus},
+    {0x420D, "MEMSEL", nullptr, [](void* d, uint16_t, uint8_t v) { bus_of(d)->memsel = v & 0x01; },
+     MmioRegister::kOpenBus},
+    {0x4214, "RDDIVL", [](void* d, uint16_t) -> uint8_t { return bus_of(d)->rddiv & 0xFF; }, nullptr,
+     MmioRegister::kNoSideEffects},
+    {0x4215, "RDDIVH", [](void* d, uint16_t) -> uint8_t { return bus_of(d)->rddiv >> 8; }, nullptr,
+     MmioRegister::kNoSideEffects},
+    {0x4216, "RDMPYL", [](void* d, uint16_t) -> uint8_t { return bus_of(d)->rdmpy & 0xFF; }, nullptr,
+     MmioRegister::kNoSideEffects},
+    {0x4217, "RDMPYH", [](void* d, uint16_t) -> uint8_t { return bus_of(d)->rdmpy >> 8; }, nullptr,
+     MmioRegister::kNoSideEffects},
+};
+
 Bus::Bus() {
     wram.fill(0);
     controllers.fill(nullptr);
+    b_ports.fill(IoPort{open_bus_read, open_bus_write, nullptr, nullptr});
+    cpu_ports.fill(IoPort{open_bus_read, open_bus_write, nullptr, nullptr});
+    map_registers(kRegisters, kRegisterCount, this);
+    for (int i = 0; i < kDmaChannels; ++i) {
+        map_registers(kDmaRegisters, kDmaRegisterCount, this, i * 0x10);
+    }
+    build_memory_map();
 }
 
 Bus::~Bus() {}
@@ -15,84 +116,233 @@ Bus::~Bus() {}
 void Bus::connect_cpu(std::shared_ptr<CPU> cpu_) { cpu = cpu_; }
 void Bus::connect_ppu(std::shared_ptr<PPU> ppu_) { 
     ppu = ppu_; 
-    if (ppu) ppu->set_bus(this);
+    if (ppu) {
+        ppu->set_bus(this);
+        map_registers(PPU::registers(), PPU::kRegisterCount, ppu.get());
+    } else {
+        unmap_registers(PPU::registers(), PPU::kRegisterCount);
+    }
+}
+void Bus::connect_cartridge(std::shared_ptr<Cartridge> cart_) {
+    cart = cart_;
+    build_memory_map();
+    // Cached code may have come from the previous cartridge
+    if (code_listener) code_listener->flush_code_cache();
 }
-void Bus::connect_cartridge(std::shared_ptr<Cartridge> cart_) { cart = cart_; }
 void Bus::connect_controller(int port, std::shared_ptr<Controller> ctrl_) {
     if (port >= 0 && port < 2) controllers[port] = ctrl_;
 }
+void Bus::connect_scheduler(Scheduler* scheduler_) {
+    scheduler = scheduler_;
+    if (scheduler) {
+        scheduler->connect_bus(this);
+        map_registers(Scheduler::registers(), Scheduler::kRegisterCount, scheduler);
+    } else {
+        unmap_registers(Scheduler::registers(), Scheduler::kRegisterCount);
+    }
+}
+
+Bus::IoPort* Bus::io_port(uint16_t addr) {
+    if ((addr & 0xFF00) == 0x2100) return &b_ports[addr & 0xFF];
+    if (addr >= 0x4000 && addr < 0x4400) return &cpu_ports[addr & 0x3FF];
+    return nullptr;
+}
+
+// offset moves the whole table, for the DMA channels
+void Bus::map_registers(const MmioRegister* regs, size_t count, void* device, uint16_t offset) {
+    for (size_t i = 0; i < count; ++i) {
+        if (IoPort* port = io_port(regs[i].addr + offset)) {
+            *port = IoPort{regs[i].read ? regs[i].read : open_bus_read,
+                           regs[i].write ? regs[i].write : open_bus_write, device, &regs[i]};
+        }
+    }
+}
+
+void Bus::unmap_registers(const MmioRegister* regs, size_t count, uint16_t offset) {
+    for (size_t i = 0; i < count; ++i) {
+        if (IoPort* port = io_port(regs[i].addr + offset)) {
+            *port = IoPort{open_bus_read, open_bus_write, nullptr, nullptr};
+        }
+    }
+}
+
+const MmioRegister* Bus::io_register(uint16_t addr) const {
+    IoPort* port = const_cast<Bus*>(this)->io_port(addr);
+    return port ? port->info : nullptr;
+}
+
+std::vector<std::pair<uint16_t, const MmioRegister*>> Bus::io_registers() const {
+    std::vector<std::pair<uint16_t, const MmioRegister*>> registers;
+    for (size_t i = 0; i < b_ports.size(); ++i) {
+        if (b_ports[i].info) registers.emplace_back((uint16_t)(0x2100 + i), b_ports[i].info);
+    }
+    for (size_t i = 0; i < cpu_ports.size(); ++i) {
+        if (cpu_ports[i].info) registers.emplace_back((uint16_t)(0x4000 + i), cpu_ports[i].info);
+    }
+    return registers;
+}
 
 void Bus::reset() {
     wram.fill(0);
+    memsel = 0;
+    hdmaen = 0;
+    wram_port = 0;
+    if (code_listener) code_listener->flush_code_cache();
     if (cpu) cpu->reset();
     if (ppu) ppu->reset();
     if (cart) cart->reset();
     for (auto &c : controllers) if (c) c->reset();
 }
 
-// 24-bit address space read
-uint8_t Bus::read(uint32_t addr, bool readonly) {
-    // Mirror $0000-$1FFF to WRAM (bank 0)
-    if (addr < 0x2000) {
-        return wram[addr];
+void Bus::load_state(const BusState& state) {
+    for (size_t page = 0; page < code_pages.size(); ++page) {
+        if (code_pages[page] && memcmp(&wram[page << 8], &state.wram[page << 8], 256) != 0) {
+            notify_code_write((uint32_t)(page << 8));
+        }
     }
-    // WRAM: $7E:0000–$7F:FFFF (128KB, mirrored)
-    if ((addr >= 0x7E0000 && addr <= 0x7FFFFF)) {
-        return wram[addr - 0x7E0000];
+    static_cast<BusState&>(*this) = state;
+}
+
+// Fill the page tables. Per bank ($00-$FF), by 8KB page:
+//   $7E-$7F          WRAM (128KB)
+//   $0000-$1FFF      WRAM mirror, in banks $00-$3F and $80-$BF
+//   $2000-$3FFF      B bus registers, in banks $00-$3F and $80-$BF
+//   $4000-$5FFF      CPU I/O registers, in the same banks
+//   everything else  the cartridge's mapping (see Cartridge::build_page_map);
+//                    without a cartridge only the vectors at $E000-$FFFF
+// ROM and SRAM pages point straight into the cartridge when they can be
+// backed whole: ROM images in multiples of 8KB, SRAM of 8KB or more.
+void Bus::build_memory_map() {
+    bool rom_direct = cart && cart->rom_size() % kPageSize == 0;
+    bool sram_direct = cart && cart->sram_size() >= kPageSize;
+
+    for (int page = 0; page < kPageCount; ++page) {
+        uint32_t addr = (uint32_t)page << kPageBits;
+        uint8_t bank = addr >> 16;
+        uint16_t offset = addr & 0xFFFF;
+        bool system_bank = (bank & 0x40) == 0;
+        ReadPage& r = read_map[page];
+        WritePage& w = write_map[page];
+        r = ReadPage{open_bus_page.data(), kMmioOpenBus, CPUProfile::kOpenBus};
+        w = WritePage{nullptr, kMmioOpenBus, CPUProfile::kOpenBus};
+
+        if (bank == 0x7E || bank == 0x7F) {
+            r.data = wram.data() + (addr - 0x7E0000);
+            w.data = wram.data() + (addr - 0x7E0000);
+            r.region = w.region = CPUProfile::kWram;
+        } else if (system_bank && offset < 0x2000) {
+            r.data = wram.data() + offset;
+            w.data = wram.data() + offset;
+            r.region = w.region = CPUProfile::kWram;
+        } else if (system_bank && offset >= 0x2000 && offset < 0x6000) {
+            MmioHandler handler = offset < 0x4000 ? kMmioBBus : kMmioCpuIo;
+            r = ReadPage{nullptr, handler, CPUProfile::kMmio};
+            w = WritePage{nullptr, handler, CPUProfile::kMmio};
+        } else if (cart) {
+            const Cartridge::PageMapping& m = cart->page_mapping(page);
+            if (m.area == Cartridge::Area::Rom) {
+                r = rom_direct ? ReadPage{cart->rom() + m.offset, kMmioOpenBus, CPUProfile::kRom}
+                               : ReadPage{nullptr, kMmioCartridge, CPUProfile::kRom};
+                w = WritePage{nullptr, kMmioCartridge, CPUProfile::kRom};
+            } else if (m.area == Cartridge::Area::Sram) {
+                uint8_t* sram = sram_direct ? cart->sram() + (m.offset & (cart->sram_size() - 1)) : nullptr;
+                r = ReadPage{sram, kMmioCartridge, CPUProfile::kRom};
+                w = WritePage{sram, kMmioCartridge, CPUProfile::kRom};
+            }
+        } else if (offset >= 0xE000) {
+            r = ReadPage{nullptr, kMmioVectors, CPUProfile::kRom};
+        }
+    }
+}
+
+// Standard timings: 6 clocks for most registers and, with MEMSEL set, ROM in
+// banks $80-$FF; 12 for the $4000-$41FF joypad ports; 8 for everything else
+int Bus::access_clocks(uint32_t addr) const {
+    uint8_t bank = (addr >> 16) & 0xFF;
+    uint16_t offset = addr & 0xFFFF;
+    if ((bank & 0x40) == 0 && offset < 0x8000) {
+        if (offset < 0x2000 || offset >= 0x6000) return 8;
+        if (offset >= 0x4000 && offset < 0x4200) return 12;
+        return 6;
     }
-    // PPU registers: $2100–$213F (mirrored every 0x10000)
-    if ((addr & 0xFFFF) >= 0x2100 && (addr & 0xFFFF) <= 0x213F) {
-        if (ppu) return ppu->cpu_read(addr & 0xFFFF);
+    return ((bank & 0x80) && memsel) ? 6 : 8;
+}
+
+uint8_t Bus::mmio_read(MmioHandler handler, uint32_t addr, bool readonly) {
+    uint16_t offset = addr & 0xFFFF;
+    switch (handler) {
+    case kMmioBBus:
+        if ((offset & 0xFF00) == 0x2100) return io_read(b_ports[offset & 0xFF], offset, readonly);
+        return 0x00;
+    case kMmioCpuIo:
+        if (offset < 0x4400) return io_read(cpu_ports[offset & 0x3FF], offset, readonly);
+        return 0x00;
+    case kMmioCartridge:
+        return cart->cpu_read(addr, readonly);
+    case kMmioVectors:
+        // Interrupt vectors: $FFFE-$FFFF (IRQ/BRK vector)
+        if (offset == 0xFFFE) return interrupt_vector_low;
+        if (offset == 0xFFFF) return interrupt_vector_high;
+        return 0x00;
+    case kMmioOpenBus:
+    default:
         return 0x00;
     }
-    // Cartridge ROM/RAM: $8000–$FFFF (LoROM/HiROM mapping simplified)
-    if (cart && (addr & 0xFFFF) >= 0x8000) {
-        // Mask to 16 bits for now; TODO: support full 24-bit mapping
-        return cart->cpu_read(addr & 0xFFFF, readonly);
-    }
-    // Controller ports: $4016, $4017
-    if ((addr & 0xFFFF) == 0x4016 && controllers[0]) return controllers[0]->read();
-    if ((addr & 0xFFFF) == 0x4017 && controllers[1]) return controllers[1]->read();
-    // Interrupt vectors: $FFFE-$FFFF (IRQ/BRK vector)
-    if ((addr & 0xFFFF) == 0xFFFE) return interrupt_vector_low;
-    if ((addr & 0xFFFF) == 0xFFFF) return interrupt_vector_high;
-    // Open bus for unmapped
-    return 0x00;
-}
-
-// 24-bit address space write
-void Bus::write(uint32_t addr, uint8_t data) {
-    // Mirror $0000-$1FFF to WRAM (bank 0)
-    if (addr < 0x2000) {
-        wram[addr] = data;
+}
+
+void Bus::mmio_write(MmioHandler handler, uint32_t addr, uint8_t data) {
+    uint16_t offset = addr & 0xFFFF;
+    switch (handler) {
+    case kMmioBBus:
+        if ((offset & 0xFF00) == 0x2100) {
+            const IoPort& port = b_ports[offset & 0xFF];
+            port.write(port.device, offset, data);
+        }
         return;
-    }
-    // WRAM: $7E:0000–$7F:FFFF (128KB, mirrored)
-    if ((addr >= 0x7E0000 && addr <= 0x7FFFFF)) {
-        wram[addr - 0x7E0000] = data;
+    case kMmioCpuIo:
+        if (offset < 0x4400) {
+            const IoPort& port = cpu_ports[offset & 0x3FF];
+            port.write(port.device, offset, data);
+        }
         return;
-    }
-    // PPU registers: $2100–$213F (mirrored every 0x10000)
-    if ((addr & 0xFFFF) >= 0x2100 && (addr & 0xFFFF) <= 0x213F) {
-        if (ppu) ppu->cpu_write(addr & 0xFFFF, data);
+    case kMmioCartridge:
+        cart->cpu_write(addr, data);
         return;
+    default:
+        // Ignore writes to unmapped
+        return;
+    }
+}
+
+// Classify the memory behind addr for the CPU block cache. Pages backed
+// by host memory have no read side effects; WRAM also needs watching.
+int Bus::code_page(uint32_t addr) const {
+    const ReadPage& page = read_map[(addr & 0xFFFFFF) >> kPageBits];
+    if (!page.data) {
+        return kNoCode;
+    }
+    uintptr_t host = (uintptr_t)(page.data + (addr & kPageMask));
+    uintptr_t base = (uintptr_t)wram.data();
+    if (host - base < wram.size()) {
+        return (int)((host - base) >> 8);
     }
-    // Cartridge ROM/RAM: $8000–$FFFF (LoROM/HiROM mapping simplified)
-    if (cart && (addr & 0xFFFF) >= 0x8000) {
-        // Mask to 16 bits for now; TODO: support full 24-bit mapping
-        cart->cpu_write(addr & 0xFFFF, data);
+    // Writable memory other than WRAM (SRAM) isn't watched
+    return write_map[(addr & 0xFFFFFF) >> kPageBits].data ? kNoCode : kRomCode;
+}
+
+void Bus::host_written(const uint8_t* host, size_t length) {
+    uintptr_t offset = (uintptr_t)host - (uintptr_t)wram.data();
+    if (offset >= wram.size() || length == 0) {
         return;
     }
-    // Controller ports: $4016, $4017
-    if ((addr & 0xFFFF) == 0x4016 && controllers[0]) { controllers[0]->write(data); return; }
-    if ((addr & 0xFFFF) == 0x4017 && controllers[1]) { controllers[1]->write(data); return; }
-    // Ignore writes to unmapped
+    size_t end = std::min(offset + length, wram.size());
+    for (size_t page = offset >> 8; page <= (end - 1) >> 8; ++page) {
+        if (code_pages[page]) notify_code_write((uint32_t)(page << 8));
+    }
 }
 
-// If you add new device types or features, add stubs here for future expansion.
-// Example: DMA, APU, etc.
-//
-// void Bus::connect_dma(std::shared_ptr<DMA> dma_) { /* TODO: implement DMA connection */ }
-// void Bus::connect_apu(std::shared_ptr<APU> apu_) { /* TODO: implement APU connection */ }
-//
-// Add more stubs as needed for full SNES hardware emulation.
+void Bus::notify_code_write(uint32_t wram_offset) {
+    int page = wram_offset >> 8;
+    code_pages[page] = false;
+    if (code_listener) code_listener->invalidate_code_page(page);
+}
@@ -0,0 +1,275 @@
+#include "bus.hpp"
+#include "ppu.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// B bus register offsets, by transfer mode, for the bytes of a unit.
+// General DMA cycles through them for as long as the count lasts.
+constexpr uint8_t kPatterns[8][4] = {
+    {0, 0, 0, 0}, {0, 1, 0, 1}, {0, 0, 0, 0}, {0, 0, 1, 1},
+    {0, 1, 2, 3}, {0, 1, 0, 1}, {0, 0, 0, 0}, {0, 0, 1, 1},
+};
+constexpr int kUnitLength[8] = {1, 2, 2, 4, 4, 4, 2, 4};
+
+// Master clocks: 8 per byte moved and per active channel, plus the time to
+// get back in step with the CPU clock (12-24, 16 at the 8-clock CPU cycle)
+constexpr uint64_t kByteClocks = 8;
+constexpr uint64_t kChannelClocks = 8;
+constexpr uint64_t kOverheadClocks = 16;
+
+// The A bus can't reach the B bus or the DMA registers themselves
+bool a_bus_blocked(uint32_t addr) {
+    uint16_t offset = addr & 0xFFFF;
+    if (addr & 0x400000) {
+        return false;
+    }
+    return (offset >= 0x2100 && offset <= 0x21FF) || (offset >= 0x4300 && offset <= 0x437F) ||
+           offset == 0x420B || offset == 0x420C;
+}
+
+} // namespace
+
+// $43x0-$43xF for channel 0; the bus maps the table once per channel
+const MmioRegister Bus::kDmaRegisters[Bus::kDmaRegisterCount] = {
+    {0x4300, "DMAPx", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).control; },
+     [](void* d, uint16_t a, uint8_t v) { dma_channel_of(d, a).control = v; }, MmioRegister::kNoSideEffects},
+    {0x4301, "BBADx", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).b_address; },
+     [](void* d, uint16_t a, uint8_t v) { dma_channel_of(d, a).b_address = v; }, MmioRegister::kNoSideEffects},
+    {0x4302, "A1TxL", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).a_address & 0xFF; },
+     [](void* d, uint16_t a, uint8_t v) {
+         DmaChannel& ch = dma_channel_of(d, a);
+         ch.a_address = (ch.a_address & 0xFF00) | v;
+     }, MmioRegister::kNoSideEffects},
+    {0x4303, "A1TxH", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).a_address >> 8; },
+     [](void* d, uint16_t a, uint8_t v) {
+         DmaChannel& ch = dma_channel_of(d, a);
+         ch.a_address = (ch.a_address & 0x00FF) | (v << 8);
+     }, MmioRegister::kNoSideEffects},
+    {0x4304, "A1Bx", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).a_bank; },
+     [](void* d, uint16_t a, uint8_t v) { dma_channel_of(d, a).a_bank = v; }, MmioRegister::kNoSideEffects},
+    {0x4305, "DASxL", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).count & 0xFF; },
+     [](void* d, uint16_t a, uint8_t v) {
+         DmaChannel& ch = dma_channel_of(d, a);
+         ch.count = (ch.count & 0xFF00) | v;
+     }, MmioRegister::kNoSideEffects},
+    {0x4306, "DASxH", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).count >> 8; },
+     [](void* d, uint16_t a, uint8_t v) {
+         DmaChannel& ch = dma_channel_of(d, a);
+         ch.count = (ch.count & 0x00FF) | (v << 8);
+     }, MmioRegister::kNoSideEffects},
+    {0x4307, "DASBx", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).indirect_bank; },
+     [](void* d, uint16_t a, uint8_t v) { dma_channel_of(d, a).indirect_bank = v; }, MmioRegister::kNoSideEffects},
+    {0x4308, "A2AxL", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).table_address & 0xFF; },
+     [](void* d, uint16_t a, uint8_t v) {
+         DmaChannel& ch = dma_channel_of(d, a);
+         ch.table_address = (ch.table_address & 0xFF00) | v;
+     }, MmioRegister::kNoSideEffects},
+    {0x4309, "A2AxH", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).table_address >> 8; },
+     [](void* d, uint16_t a, uint8_t v) {
+         DmaChannel& ch = dma_channel_of(d, a);
+         ch.table_address = (ch.table_address & 0x00FF) | (v << 8);
+     }, MmioRegister::kNoSideEffects},
+    {0x430A, "NTRLx", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).line_counter; },
+     [](void* d, uint16_t a, uint8_t v) { dma_channel_of(d, a).line_counter = v; }, MmioRegister::kNoSideEffects},
+    {0x430B, "UNUSEDx", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).unused; },
+     [](void* d, uint16_t a, uint8_t v) { dma_channel_of(d, a).unused = v; }, MmioRegister::kNoSideEffects},
+    {0x430F, "UNUSEDx", [](void* d, uint16_t a) -> uint8_t { return dma_channel_of(d, a).unused; },
+     [](void* d, uint16_t a, uint8_t v) { dma_channel_of(d, a).unused = v; }, MmioRegister::kNoSideEffects},
+};
+
+uint8_t Bus::dma_read_a(uint32_t addr) {
+    return a_bus_blocked(addr) ? 0x00 : read(addr);
+}
+
+void Bus::dma_write_a(uint32_t addr, uint8_t data) {
+    if (!a_bus_blocked(addr)) {
+        write(addr, data);
+    }
+}
+
+DmaChannel& Bus::dma_channel_of(void* device, uint16_t addr) {
+    return static_cast<Bus*>(device)->dma[(addr >> 4) & 0x07];
+}
+
+// B bus: $2100-$21FF, through the same ports as the CPU
+uint8_t Bus::read_b(uint8_t reg) {
+    const IoPort& port = b_ports[reg];
+    return port.read(port.device, 0x2100 | reg);
+}
+
+void Bus::write_b(uint8_t reg, uint8_t data) {
+    const IoPort& port = b_ports[reg];
+    port.write(port.device, 0x2100 | reg, data);
+}
+
+// $420B: the channels run in order, each to the end of its count
+uint64_t Bus::run_dma(uint8_t channels) {
+    if (!channels) {
+        return 0;
+    }
+    uint64_t clocks = kOverheadClocks;
+    for (int i = 0; i < kDmaChannels; ++i) {
+        if (channels & (1 << i)) {
+            clocks += kChannelClocks + dma_transfer(dma[i]) * kByteClocks;
+        }
+    }
+    return clocks;
+}
+
+// The registers move with the transfer: the A address steps and the count
+// runs down to 0. Returns the bytes moved.
+uint32_t Bus::dma_transfer(DmaChannel& ch) {
+    uint32_t length = ch.count ? ch.count : 0x10000;
+    const uint8_t* pattern = kPatterns[ch.control & 0x07];
+    bool to_a = (ch.control & 0x80) != 0;
+    int step = (ch.control & 0x08) ? 0 : (ch.control & 0x10) ? -1 : 1;
+    uint32_t done = 0;
+    while (done < length) {
+        if (!to_a && step == 1) {
+            uint32_t moved = dma_bulk(ch, length - done, done);
+            if (moved) {
+                done += moved;
+                continue;
+            }
+        }
+        uint32_t a = ((uint32_t)ch.a_bank << 16) | ch.a_address;
+        uint8_t b = ch.b_address + pattern[done & 3];
+        if (to_a) {
+            dma_write_a(a, read_b(b));
+        } else {
+            write_b(b, dma_read_a(a));
+        }
+        ch.a_address += step;
+        done++;
+    }
+    ch.count = 0;
+    return length;
+}
+
+// Host memory to a PPU data port or the WRAM port, copied in one go up to
+// the end of the source page. Returns the bytes moved, or 0 where the
+// transfer has to go a byte at a time.
+uint32_t Bus::dma_bulk(DmaChannel& ch, uint32_t length, uint32_t done) {
+    uint32_t a = ((uint32_t)ch.a_bank << 16) | ch.a_address;
+    const uint8_t* src = host_read(a);
+    if (!src) {
+        return 0;
+    }
+    uint32_t n = std::min({length, kPageSize - (a & kPageMask), 0x10000u - ch.a_address});
+    uint8_t mode = ch.control & 0x07;
+    bool one_register = mode == 0 || mode == 2 || mode == 6;
+
+    switch (ch.b_address) {
+    case 0x18:
+    case 0x19:
+        if (!ppu) return 0;
+        if (ch.b_address == 0x18 && (mode == 1 || mode == 5) && !(done & 1)) {
+            // $2118/$2119 pairs; keep whole pairs unless this is the end
+            if (n < length) n &= ~1u;
+            if (n == 0) return 0;
+            ppu->write_vram_words(src, n);
+        } else if (one_register) {
+            ppu->write_vram_port(ch.b_address == 0x19, src, n);
+        } else {
+            return 0;
+        }
+        break;
+    case 0x22:
+        if (!ppu || !one_register) return 0;
+        ppu->write_cgram_port(src, n);
+        break;
+    case 0x04:
+        if (!ppu || !one_register) return 0;
+        ppu->write_oam_port(src, n);
+        break;
+    case 0x80: {
+        // WRAM to its own port doesn't work on the hardware; leave that to
+        // the byte path
+        uintptr_t from = (uintptr_t)src - (uintptr_t)wram.data();
+        if (!one_register || from < wram.size()) return 0;
+        for (uint32_t left = n; left;) {
+            uint32_t chunk = std::min(left, (uint32_t)wram.size() - wram_port);
+            memcpy(&wram[wram_port], src, chunk);
+            host_written(&wram[wram_port], chunk);
+            wram_port = (wram_port + chunk) & 0x1FFFF;
+            src += chunk;
+            left -= chunk;
+        }
+        break;
+    }
+    default:
+        return 0;
+    }
+    ch.a_address += n;
+    return n;
+}
+
+// Next table entry: the line count byte, then for indirect channels the
+// address of the data. A zero count ends the channel for the frame.
+void Bus::hdma_load_entry(DmaChannel& ch) {
+    uint32_t bank = (uint32_t)ch.a_bank << 16;
+    ch.line_counter = dma_read_a(bank | ch.table_address++);
+    ch.hdma_done = ch.line_counter == 0;
+    ch.hdma_transfer = !ch.hdma_done;
+    if (!ch.hdma_done && (ch.control & 0x40)) {
+        uint8_t low = dma_read_a(bank | ch.table_address++);
+        uint8_t high = dma_read_a(bank | ch.table_address++);
+        ch.count = low | (high << 8);
+    }
+}
+
+uint64_t Bus::hdma_init() {
+    if (!hdmaen) {
+        return 0;
+    }
+    uint64_t clocks = kOverheadClocks;
+    for (int i = 0; i < kDmaChannels; ++i) {
+        DmaChannel& ch = dma[i];
+        ch.hdma_done = false;
+        ch.hdma_transfer = false;
+        if (!(hdmaen & (1 << i))) {
+            continue;
+        }
+        ch.table_address = ch.a_address;
+        hdma_load_entry(ch);
+        clocks += kChannelClocks + ((ch.control & 0x40) ? 3 : 1) * kByteClocks;
+    }
+    return clocks;
+}
+
+// One unit per channel whose entry says so, then the line count steps down.
+// Counts with bit 7 set transfer every line, others only on the first.
+uint64_t Bus::hdma_line() {
+    uint64_t clocks = 0;
+    for (int i = 0; i < kDmaChannels; ++i) {
+        DmaChannel& ch = dma[i];
+        if (!(hdmaen & (1 << i)) || ch.hdma_done) {
+            continue;
+        }
+        clocks += kChannelClocks;
+        bool indirect = (ch.control & 0x40) != 0;
+        if (ch.hdma_transfer) {
+            uint8_t mode = ch.control & 0x07;
+            for (int k = 0; k < kUnitLength[mode]; ++k) {
+                uint32_t a = indirect ? ((uint32_t)ch.indirect_bank << 16) | ch.count++
+                                      : ((uint32_t)ch.a_bank << 16) | ch.table_address++;
+                uint8_t b = ch.b_address + kPatterns[mode][k];
+                if (ch.control & 0x80) {
+                    dma_write_a(a, read_b(b));
+                } else {
+                    write_b(b, dma_read_a(a));
+                }
+            }
+            clocks += kUnitLength[mode] * kByteClocks;
+        }
+        ch.line_counter--;
+        ch.hdma_transfer = (ch.line_counter & 0x80) != 0;
+        if ((ch.line_counter & 0x7F) == 0) {
+            hdma_load_entry(ch);
+            clocks += (indirect ? 3 : 1) * kByteClocks;
+        }
+    }
+    return clocks ? clocks + kOverheadClocks : 0;
+}
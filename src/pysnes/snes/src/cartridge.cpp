@@ -1,6 +1,59 @@
 #include <fstream>
 #include "cartridge.hpp"
 
+namespace {
+
+// How much the bytes at offset look like an internal header for mapper.
+// Checks the checksum pair, the map mode byte, plausible field ranges and
+// the first instruction at the reset vector. Negative if out of range.
+int score_header(const std::vector<uint8_t>& rom, uint32_t offset, Cartridge::Mapper mapper) {
+    if (rom.size() < (size_t)offset + 0x40) {
+        return -1;
+    }
+    const uint8_t* h = rom.data() + offset;
+    int score = 0;
+
+    uint16_t reset = h[0x3C] | (h[0x3D] << 8);
+    if (reset < 0x8000) {
+        return 0;   // The reset vector must point into ROM
+    }
+    uint32_t base = offset & (mapper == Cartridge::Mapper::LoROM ? ~0x7FFFu : ~0xFFFFu);
+    uint32_t entry = base | (reset & (mapper == Cartridge::Mapper::LoROM ? 0x7FFF : 0xFFFF));
+    uint8_t op = entry < rom.size() ? rom[entry] : 0x00;
+    switch (op) {
+    case 0x78: case 0x18: case 0x38: case 0x9C: case 0x4C: case 0x5C:  // SEI CLC SEC STZ JMP JML
+        score += 8;
+        break;
+    case 0xC2: case 0xE2: case 0xAD: case 0xAE: case 0xAC: case 0xAF:  // REP SEP LDA LDX LDY
+    case 0xA9: case 0xA2: case 0xA0: case 0x20: case 0x22:             // LDA# LDX# LDY# JSR JSL
+        score += 4;
+        break;
+    case 0x40: case 0x60: case 0x6B: case 0xCD: case 0xEC: case 0xCC:  // RTI RTS RTL CMP CPX CPY
+        score -= 4;
+        break;
+    case 0x00: case 0x02: case 0xDB: case 0x42: case 0xFF:             // BRK COP STP WDM SBC long
+        score -= 8;
+        break;
+    }
+
+    uint16_t complement = h[0x1C] | (h[0x1D] << 8);
+    uint16_t checksum = h[0x1E] | (h[0x1F] << 8);
+    if ((uint16_t)(checksum + complement) == 0xFFFF) score += 4;
+
+    uint8_t map_mode = h[0x15] & ~0x10;
+    if (mapper == Cartridge::Mapper::LoROM && map_mode == 0x20) score += 2;
+    if (mapper == Cartridge::Mapper::HiROM && map_mode == 0x21) score += 2;
+    if (mapper == Cartridge::Mapper::ExHiROM && map_mode == 0x25) score += 2;
+    if (h[0x1A] == 0x33) score += 2;    // Extended header marker
+    if (h[0x16] < 0x08) score++;        // Cartridge type
+    if (h[0x17] < 0x10) score++;        // ROM size
+    if (h[0x18] < 0x08) score++;        // SRAM size
+    if (h[0x19] < 0x0E) score++;        // Region
+    return score < 0 ? 0 : score;
+}
+
+} // namespace
+
 Cartridge::Cartridge(const std::string &rom_path) {
     std::ifstream rom_file(rom_path, std::ios::binary | std::ios::ate);
     if (rom_file.is_open()) {
@@ -11,6 +64,12 @@ Cartridge::Cartridge(const std::string &rom_path) {
         rom_file.close();
         loaded = true;
     }
+    // Copier dumps carry a 512-byte header in front of the image
+    if ((rom_data.size() & 0x7FFF) == 512) {
+        rom_data.erase(rom_data.begin(), rom_data.begin() + 512);
+    }
+    detect_header();
+    build_page_map();
 }
 
 Cartridge::~Cartridge() {}
@@ -19,18 +78,144 @@ bool Cartridge::is_loaded() {
     return loaded;
 }
 
+// Ties go to LoROM, then HiROM
+void Cartridge::detect_header() {
+    int lo = score_header(rom_data, 0x007FC0, Mapper::LoROM);
+    int hi = score_header(rom_data, 0x00FFC0, Mapper::HiROM);
+    int ex = score_header(rom_data, 0x40FFC0, Mapper::ExHiROM);
+
+    Header header;
+    if (ex > lo && ex > hi) {
+        header.mapper = Mapper::ExHiROM;
+        header.offset = 0x40FFC0;
+        header.score = ex;
+    } else if (hi > lo) {
+        header.mapper = Mapper::HiROM;
+        header.offset = 0x00FFC0;
+        header.score = hi;
+    } else {
+        header.score = lo < 0 ? 0 : lo;
+    }
+
+    if (rom_data.size() >= (size_t)header.offset + 0x40) {
+        const uint8_t* h = rom_data.data() + header.offset;
+        for (int i = 0; i < 21 && h[i] >= 0x20 && h[i] < 0x7F; ++i) {
+            header.title += (char)h[i];
+        }
+        header.title.erase(header.title.find_last_not_of(' ') + 1);
+        header.map_mode = h[0x15];
+        header.cart_type = h[0x16];
+        header.rom_size = h[0x17];
+        header.sram_size = h[0x18];
+        header.region = h[0x19];
+        header.version = h[0x1B];
+        header.complement = h[0x1C] | (h[0x1D] << 8);
+        header.checksum = h[0x1E] | (h[0x1F] << 8);
+        header.fast_rom = (header.map_mode & 0x10) != 0;
+    }
+    header_ = header;
+
+    // Types $x1/$x2 (RAM, RAM + battery) and $x4/$x5 (coprocessor + RAM)
+    // have SRAM; sizes above 256KB are not real boards
+    uint8_t board = header_.cart_type & 0x0F;
+    bool has_ram = board == 0x01 || board == 0x02 || board == 0x04 || board == 0x05;
+    sram_data.assign(has_ram && header_.sram_size > 0 && header_.sram_size <= 8
+                         ? (size_t)1024 << header_.sram_size : 0, 0xFF);
+}
+
+// ROM images that aren't a power of two repeat their last part the way
+// the boards decode them: the largest power of two, then the remainder
+// mirrored up to the same size.
+uint32_t Cartridge::mirror_rom(uint32_t offset) const {
+    uint32_t size = (uint32_t)rom_data.size();
+    if (size == 0) {
+        return 0;
+    }
+    uint32_t base = 0;
+    uint32_t mask = 1u << 23;
+    while (offset >= size) {
+        while (!(offset & mask)) mask >>= 1;
+        offset -= mask;
+        if (size > mask) {
+            size -= mask;
+            base += mask;
+        }
+        mask >>= 1;
+    }
+    return base + offset;
+}
+
+// Per bank, by 8KB page:
+//   LoROM    $00-$7D,$80-$FF:$8000-$FFFF ROM, 32KB per bank
+//            $40-$6F,$C0-$EF:$0000-$7FFF mirror of the upper half
+//            $70-$7D,$F0-$FF:$0000-$7FFF SRAM (ROM mirror without)
+//   HiROM    $40-$7D,$C0-$FF:$0000-$FFFF ROM, 64KB per bank
+//            $00-$3F,$80-$BF:$8000-$FFFF mirror of the same
+//            $20-$3F,$A0-$BF:$6000-$7FFF SRAM, 8KB per bank
+//   ExHiROM  as HiROM, with banks $C0-$FF/$80-$BF the first 4MB and
+//            $40-$7D/$00-$3F the rest
+// The bus keeps WRAM and the registers in front of these.
+void Cartridge::build_page_map() {
+    pages.fill(PageMapping{});
+    if (rom_data.empty()) {
+        return;
+    }
+    bool has_sram = !sram_data.empty();
+    for (int page = 0; page < kPageCount; ++page) {
+        uint32_t addr = (uint32_t)page << kPageBits;
+        uint8_t bank = addr >> 16;
+        uint16_t offset = addr & 0xFFFF;
+        bool system_bank = (bank & 0x40) == 0;      // $00-$3F, $80-$BF
+        PageMapping& m = pages[page];
+
+        switch (header_.mapper) {
+        case Mapper::LoROM:
+            if (has_sram && (bank & 0x7F) >= 0x70 && (bank & 0x7F) < 0x7E && offset < 0x8000) {
+                m = PageMapping{Area::Sram, (uint32_t)((bank & 0x0F) << 15) | offset};
+            } else if (offset >= 0x8000 || !system_bank) {
+                m = PageMapping{Area::Rom, mirror_rom(((uint32_t)(bank & 0x7F) << 15) | (offset & 0x7FFF))};
+            }
+            break;
+        case Mapper::HiROM:
+        case Mapper::ExHiROM:
+            if (has_sram && system_bank && (bank & 0x20) && offset >= 0x6000 && offset < 0x8000) {
+                m = PageMapping{Area::Sram, (uint32_t)((bank & 0x1F) << 13) | (offset - 0x6000)};
+            } else if (offset >= 0x8000 || !system_bank) {
+                uint32_t rom_offset = ((uint32_t)(bank & 0x3F) << 16) | offset;
+                if (header_.mapper == Mapper::ExHiROM && !(bank & 0x80)) {
+                    rom_offset += 0x400000;
+                }
+                m = PageMapping{Area::Rom, mirror_rom(rom_offset)};
+            }
+            break;
+        }
+    }
+}
+
 // The CPU is asking to read from the cartridge
-uint8_t Cartridge::cpu_read(uint16_t addr, bool bReadOnly) {
-    // Basic LoROM mapping for now
-    if (addr >= 0x8000 && addr <= 0xFFFF) {
-        // The address is masked to wrap around the ROM size
-        return rom_data[addr & (rom_data.size() - 1)];
+uint8_t Cartridge::cpu_read(uint32_t addr, bool bReadOnly) {
+    (void)bReadOnly;
+    const PageMapping& m = pages[(addr & 0xFFFFFF) >> kPageBits];
+    uint32_t offset = m.offset + (addr & ((1u << kPageBits) - 1));
+    switch (m.area) {
+    case Area::Rom:
+        // Only the last page of an image that isn't a multiple of 8KB
+        // can run past the end
+        return rom_data[offset < rom_data.size() ? offset : mirror_rom(offset)];
+    case Area::Sram:
+        return sram_data[offset & (sram_data.size() - 1)];
+    case Area::None:
+    default:
+        return 0;
     }
-    return 0; // Return 0 for addresses outside the ROM range
 }
 
-void Cartridge::cpu_write(uint16_t addr, uint8_t data) {
-    // For now, we don't support writing to the cartridge (SRAM, etc.)
+void Cartridge::cpu_write(uint32_t addr, uint8_t data) {
+    const PageMapping& m = pages[(addr & 0xFFFFFF) >> kPageBits];
+    if (m.area == Area::Sram) {
+        uint32_t offset = m.offset + (addr & ((1u << kPageBits) - 1));
+        sram_data[offset & (sram_data.size() - 1)] = data;
+    }
 }
 
 bool Cartridge::ppu_read(uint16_t addr, uint8_t &data) {
@@ -44,3 +229,12 @@ bool Cartridge::ppu_write(uint16_t addr, uint8_t data) {
 }
 
 void Cartridge::reset() {}
+
+const char* Cartridge::mapper_name(Mapper mapper) {
+    switch (mapper) {
+    case Mapper::HiROM: return "HiROM";
+    case Mapper::ExHiROM: return "ExHiROM";
+    case Mapper::LoROM:
+    default: return "LoROM";
+    }
+}
@@ -0,0 +1,226 @@
+#include "../include/color.hpp"
+#include "../include/palette.hpp"
+#include "../include/simd.hpp"
+#include <utility>
+#if defined(PYSNES_SIMD)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Brightness b scales an 8-bit channel x to (x * kScale[b]) >> 16, about
+// x * b / 15; full brightness skips the multiply
+constexpr int kFullBrightness = 15;
+constexpr uint16_t brightness_scale(int b) { return (uint16_t)((b * 65536 + 14) / 15); }
+
+// Luma weights, summing to 256
+constexpr int kLumaR = 77;
+constexpr int kLumaG = 150;
+constexpr int kLumaB = 29;
+
+// 5-bit channel to its scaled 8-bit value, per brightness
+struct ChannelTable {
+    uint8_t value[kFullBrightness + 1][32];
+    ChannelTable() {
+        for (int b = 0; b <= kFullBrightness; ++b) {
+            for (int c = 0; c < 32; ++c) {
+                uint32_t x = Palette::expand(c);
+                value[b][c] = (uint8_t)(b == kFullBrightness ? x : (x * brightness_scale(b)) >> 16);
+            }
+        }
+    }
+};
+const ChannelTable kChannels;
+
+void convert_scalar(const uint16_t* src, size_t count, PixelFormat format, int brightness, uint8_t* dst) {
+    const uint8_t* channel = kChannels.value[brightness];
+    for (size_t i = 0; i < count; ++i) {
+        uint16_t c = src[i];
+        uint8_t r = channel[c & 0x1F];
+        uint8_t g = channel[(c >> 5) & 0x1F];
+        uint8_t b = channel[(c >> 10) & 0x1F];
+        switch (format) {
+        case PixelFormat::kRgba8888:
+            dst[0] = r; dst[1] = g; dst[2] = b; dst[3] = 0xFF;
+            dst += 4;
+            break;
+        case PixelFormat::kRgb888:
+            dst[0] = r; dst[1] = g; dst[2] = b;
+            dst += 3;
+            break;
+        case PixelFormat::kBgr888:
+            dst[0] = b; dst[1] = g; dst[2] = r;
+            dst += 3;
+            break;
+        case PixelFormat::kGray8:
+            *dst++ = (uint8_t)((kLumaR * r + kLumaG * g + kLumaB * b + 128) >> 8);
+            break;
+        }
+    }
+}
+
+#if defined(PYSNES_SIMD)
+
+// Both kernels keep one channel per 16-bit lane: mask, widen, scale, then
+// interleave R|G<<8 with B|A<<8 into 32-bit RGBA pixels. The 24-bit
+// formats drop the alpha byte from those pixels, SSE2 by closing up each
+// pair of pixels in a 64-bit lane and AVX2 with in-lane byte shuffles; both
+// store past the end of their group into bytes the next pixels overwrite.
+// Tails go through the scalar loop.
+__attribute__((target("sse2")))
+void convert_sse2(const uint16_t* src, size_t count, PixelFormat format, int brightness, uint8_t* dst) {
+    const __m128i mask = _mm_set1_epi16(0x1F);
+    const __m128i alpha = _mm_set1_epi16((short)0xFF00);
+    const __m128i scale = _mm_set1_epi16((short)brightness_scale(brightness));
+    const __m128i first = _mm_set1_epi64x(0x0000000000FFFFFFLL);
+    const __m128i second = _mm_set1_epi64x(0x0000FFFFFF000000LL);
+    const bool full = brightness == kFullBrightness;
+    size_t bytes = pixel_format_bytes(format);
+    size_t slack = bytes == 3 ? 1 : 0;
+    size_t i = 0;
+    for (; i + 8 + slack <= count; i += 8) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i r = _mm_and_si128(c, mask);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(c, 5), mask);
+        __m128i b = _mm_and_si128(_mm_srli_epi16(c, 10), mask);
+        r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+        g = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
+        b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+        if (!full) {
+            r = _mm_mulhi_epu16(r, scale);
+            g = _mm_mulhi_epu16(g, scale);
+            b = _mm_mulhi_epu16(b, scale);
+        }
+        uint8_t* out = dst + i * bytes;
+        if (format == PixelFormat::kGray8) {
+            __m128i y = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(kLumaR)),
+                                      _mm_mullo_epi16(g, _mm_set1_epi16(kLumaG)));
+            y = _mm_add_epi16(y, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(kLumaB)), _mm_set1_epi16(128)));
+            y = _mm_srli_epi16(y, 8);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(y, y));
+            continue;
+        }
+        if (format == PixelFormat::kBgr888) {
+            std::swap(r, b);
+        }
+        __m128i lo = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        __m128i hi = _mm_or_si128(b, alpha);
+        __m128i p0 = _mm_unpacklo_epi16(lo, hi);
+        __m128i p1 = _mm_unpackhi_epi16(lo, hi);
+        if (format == PixelFormat::kRgba8888) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), p0);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16), p1);
+            continue;
+        }
+        p0 = _mm_or_si128(_mm_and_si128(p0, first), _mm_and_si128(_mm_srli_epi64(p0, 8), second));
+        p1 = _mm_or_si128(_mm_and_si128(p1, first), _mm_and_si128(_mm_srli_epi64(p1, 8), second));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), p0);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 6), _mm_srli_si128(p0, 8));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 12), p1);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 18), _mm_srli_si128(p1, 8));
+    }
+    convert_scalar(src + i, count - i, format, brightness, dst + i * bytes);
+}
+
+__attribute__((target("avx2")))
+void convert_avx2(const uint16_t* src, size_t count, PixelFormat format, int brightness, uint8_t* dst) {
+    const __m256i mask = _mm256_set1_epi16(0x1F);
+    const __m256i alpha = _mm256_set1_epi16((short)0xFF00);
+    const __m256i scale = _mm256_set1_epi16((short)brightness_scale(brightness));
+    // Four pixels of a lane to their first 12 bytes
+    const __m256i drop_alpha = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                                0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const bool full = brightness == kFullBrightness;
+    size_t bytes = pixel_format_bytes(format);
+    size_t slack = bytes == 3 ? 2 : 0;
+    size_t i = 0;
+    for (; i + 16 + slack <= count; i += 16) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i r = _mm256_and_si256(c, mask);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi16(c, 5), mask);
+        __m256i b = _mm256_and_si256(_mm256_srli_epi16(c, 10), mask);
+        r = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2));
+        g = _mm256_or_si256(_mm256_slli_epi16(g, 3), _mm256_srli_epi16(g, 2));
+        b = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2));
+        if (!full) {
+            r = _mm256_mulhi_epu16(r, scale);
+            g = _mm256_mulhi_epu16(g, scale);
+            b = _mm256_mulhi_epu16(b, scale);
+        }
+        uint8_t* out = dst + i * bytes;
+        if (format == PixelFormat::kGray8) {
+            __m256i y = _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(kLumaR)),
+                                         _mm256_mullo_epi16(g, _mm256_set1_epi16(kLumaG)));
+            y = _mm256_add_epi16(y, _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(kLumaB)),
+                                                     _mm256_set1_epi16(128)));
+            y = _mm256_srli_epi16(y, 8);
+            // Packing works per lane: keep the low half of each
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(y, y), 0x08);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(packed));
+            continue;
+        }
+        if (format == PixelFormat::kBgr888) {
+            std::swap(r, b);
+        }
+        __m256i lo = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+        __m256i hi = _mm256_or_si256(b, alpha);
+        __m256i u0 = _mm256_unpacklo_epi16(lo, hi);     // Pixels 0-3, 8-11
+        __m256i u1 = _mm256_unpackhi_epi16(lo, hi);     // Pixels 4-7, 12-15
+        __m256i p0 = _mm256_permute2x128_si256(u0, u1, 0x20);
+        __m256i p1 = _mm256_permute2x128_si256(u0, u1, 0x31);
+        if (format == PixelFormat::kRgba8888) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), p0);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32), p1);
+            continue;
+        }
+        p0 = _mm256_shuffle_epi8(p0, drop_alpha);
+        p1 = _mm256_shuffle_epi8(p1, drop_alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(p0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm256_extracti128_si256(p0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 24), _mm256_castsi256_si128(p1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 36), _mm256_extracti128_si256(p1, 1));
+    }
+    convert_scalar(src + i, count - i, format, brightness, dst + i * bytes);
+}
+
+#endif
+
+} // namespace
+
+size_t pixel_format_bytes(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::kRgba8888: return 4;
+    case PixelFormat::kGray8: return 1;
+    case PixelFormat::kRgb888:
+    case PixelFormat::kBgr888:
+    default: return 3;
+    }
+}
+
+const char* pixel_format_name(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::kRgba8888: return "rgba";
+    case PixelFormat::kRgb888: return "rgb";
+    case PixelFormat::kBgr888: return "bgr";
+    case PixelFormat::kGray8: return "gray";
+    default: return "?";
+    }
+}
+
+void convert_bgr555(const uint16_t* src, size_t count, PixelFormat format, int brightness, uint8_t* dst) {
+    if (brightness < 0) brightness = 0;
+    if (brightness > kFullBrightness) brightness = kFullBrightness;
+    switch (simd_level()) {
+#if defined(PYSNES_SIMD)
+    case SimdLevel::kAvx2:
+        convert_avx2(src, count, format, brightness, dst);
+        return;
+    case SimdLevel::kSse2:
+        convert_sse2(src, count, format, brightness, dst);
+        return;
+#endif
+    default:
+        convert_scalar(src, count, format, brightness, dst);
+        return;
+    }
+}
@@ -2,22 +2,60 @@
 #include "../include/cpu_addressing.hpp"
 #include "../include/cpu_instructions.hpp"
 #include "../include/cpu_helpers.hpp"
+#include "../include/cpu_opcodes.hpp"
 #include "../include/bus.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <cstdio>
 
 // Constructor
-CPU::CPU() {
+CPU::CPU() : block_cache(std::make_unique<CPUBlockCache>()) {
+#ifdef PYSNES_JIT
+    // Native blocks address members relative to the CPU pointer
+    auto offset = [this](const void* member) {
+        return (int32_t)(static_cast<const char*>(member) - reinterpret_cast<const char*>(this));
+    };
+    CPUJit::Layout layout;
+    layout.pc = offset(&pc);
+    layout.p = offset(&p);
+    layout.cycles = offset(&cycles);
+    layout.fetch_ptr = offset(&fetch_ptr);
+    layout.dispatch_mode = offset(&dispatch_mode);
+    layout.a = offset(&a);
+    layout.x = offset(&x);
+    layout.y = offset(&y);
+    layout.nz_result = offset(&nz_result);
+    layout.nz_pending = offset(&nz_pending);
+    jit = std::make_unique<CPUJit>(layout);
+#endif
     reset();
 }
 
 // Destructor
 CPU::~CPU() {
-    // Nothing to clean up
+    if (bus && bus->get_code_listener() == this) {
+        bus->set_code_listener(nullptr);
+    }
+    if (bus && bus->get_profile() == &profile) {
+        bus->set_profile(nullptr);
+    }
 }
 
 // Connect to bus
 void CPU::connect_bus(std::shared_ptr<Bus> b) {
+    if (bus && bus->get_code_listener() == this) {
+        bus->set_code_listener(nullptr);
+    }
+    if (bus && bus->get_profile() == &profile) {
+        bus->set_profile(nullptr);
+    }
     bus = b;
+    mem = b.get();
+    flush_code_cache();
+    if (bus) {
+        bus->set_code_listener(this);
+        bus->set_profile(&profile);
+    }
 }
 
 // Reset CPU state
@@ -39,6 +77,27 @@ void CPU::reset() {
     fetched = 0;
     opcode = 0;
     cycles = 0;
+    nz_pending = false;
+    cycle_count = 0;
+    instruction_count = 0;
+    current_block = nullptr;
+    recording = false;
+    halted = Halt::None;
+    update_dispatch();
+}
+
+void CPU::save_state(CPUState& state) {
+    sync_flags();
+    state = *this;
+}
+
+void CPU::load_state(const CPUState& state) {
+    static_cast<CPUState&>(*this) = state;
+    nz_pending = false;
+    current_block = nullptr;
+    recording = false;
+    idle_block = nullptr;
+    update_dispatch();
 }
 
 // Execute one instruction
@@ -47,708 +106,493 @@ void CPU::step() {
         printf("ERROR: No bus connected to CPU\n");
         return;
     }
+    if (halted != Halt::None) {
+        return;
+    }
 
-    // Fetch opcode
-    uint32_t full_addr = ((uint32_t)pb << 16) | pc;
-    uint8_t opcode = bus->read(full_addr);
-    pc++;
+    // The dispatch table is swapped by REP/SEP/XCE/PLP/RTI; the check below
+    // also catches direct writes to p from outside the instruction stream.
+    if (dispatch_mode != CPUInstructions::width_mode(p)) {
+        update_dispatch();
+    }
+    execute_instruction();
+    PYSNES_PROFILE_RETIRE(this, 1, cycles);
+    sync_flags();
+    cycle_count += cycles;
+    instruction_count++;
+}
 
-    // Reset cycles for this instruction
+// Run the instruction at PB:PC, replaying it from the block cache when the
+// current block continues here, or looking up / recording a block otherwise
+void CPU::execute_instruction() {
+    uint32_t addr = ((uint32_t)pb << 16) | pc;
     cycles = 0;
+    if (!block_cache_enabled) {
+        interpret(addr);
+        return;
+    }
 
-    // Dispatch to appropriate instruction
-    // This will be replaced with a function pointer table later
-    switch (opcode) {
-        // BRK - Break
-        case 0x00:
-            CPUInstructions::brk(this);
-            break;
-
-        // NOP - No Operation
-        case 0xEA:
-            CPUInstructions::nop(this);
-            break;
+    CPUBlockCache::Block* block = current_block;
+    CPUBlockCache::Block* previous = block;
+    if (block) {
+        if (block->valid && block->pb == pb && block->mode == dispatch_mode) {
+            if (block_index < block->instructions.size()) {
+                const CPUBlockCache::Instruction& insn = block->instructions[block_index];
+                if (insn.pc == pc) {
+                    PYSNES_TRACE_INSTRUCTION(this, insn.opcode);
+                    PYSNES_PROFILE_OPCODE(this, insn.opcode);
+                    block_index++;
+                    pc++;
+                    fetch_ptr = insn.operands;
+                    fetch_mode = FetchMode::Replay;
+                    insn.handler(this);
+                    fetch_mode = FetchMode::Direct;
+                    return;
+                }
+            } else if (recording && pc == block->end_pc) {
+                record(addr);
+                return;
+            }
+        }
+        current_block = nullptr;
+        recording = false;
+    }
 
-        // SEI - Set Interrupt Disable
-        case 0x78:
-            CPUInstructions::sei(this);
-            break;
+    block_cache->release_retired();
+    block = block_cache->find(pb, pc, dispatch_mode);
+    if (!block) {
+        if (mem->code_page(addr) == Bus::kNoCode) {
+            interpret(addr);
+            return;
+        }
+        block = block_cache->create(pb, pc, dispatch_mode);
+        current_block = block;
+        block_index = 0;
+        recording = true;
+        record(addr);
+        return;
+    }
+    // An empty block marks code that could not be cached
+    if (block->instructions.empty()) {
+        interpret(addr);
+        return;
+    }
+    // A block entered straight after running all of itself has looped
+    if (block->idle != CPUBlockCache::kIdleNo && active_run && idle_skip_enabled) {
+        skip_idle_loop(block, previous == block && block_index == block->instructions.size());
+    }
+    current_block = block;
+    block_index = 0;
+    if (jit_run && enter_native(block)) {
+        return;
+    }
+    execute_instruction();
+}
 
-        // CLI - Clear Interrupt Disable
-        case 0x58:
-            CPUInstructions::cli(this);
-            break;
+// Execute straight from the bus without touching the block cache
+void CPU::interpret(uint32_t addr) {
+    uint8_t op = mem->fetch(addr);
+    PYSNES_TRACE_INSTRUCTION(this, op);
+    PYSNES_PROFILE_OPCODE(this, op);
+    pc++;
+    dispatch[op](this);
+}
 
-        // CLC - Clear Carry
-        case 0x18:
-            CPUInstructions::clc(this);
-            break;
+// Execute the instruction at addr and append it to the current block.
+// Recording stops at the first instruction that doesn't fall through, that
+// changes the width mode, or whose bytes can't be cached.
+void CPU::record(uint32_t addr) {
+    CPUBlockCache::Block* block = current_block;
+    int page = mem->code_page(addr);
+    if (page == Bus::kNoCode || block->instructions.size() >= CPUBlockCache::kMaxBlockLength) {
+        recording = false;
+        interpret(addr);
+        return;
+    }
 
-        // SEC - Set Carry
-        case 0x38:
-            CPUInstructions::sec(this);
-            break;
+    CPUBlockCache::Instruction insn;
+    insn.pc = pc;
+    uint8_t op = mem->fetch(addr);
+    PYSNES_TRACE_INSTRUCTION(this, op);
+    PYSNES_PROFILE_OPCODE(this, op);
+    insn.opcode = op;
+    insn.handler = dispatch[op];
+    if (page >= 0) {
+        watch_code(page);
+    }
 
-        // CLD - Clear Decimal
-        case 0xD8:
-            CPUInstructions::cld(this);
-            break;
+    record_insn = &insn;
+    record_ok = true;
+    fetch_mode = FetchMode::Record;
+    pc++;
+    insn.handler(this);
+    fetch_mode = FetchMode::Direct;
+    record_insn = nullptr;
 
-        // SED - Set Decimal
-        case 0xF8:
-            CPUInstructions::sed(this);
-            break;
+    // A store into the block's own code invalidates it mid-recording
+    if (!record_ok || !block->valid || dispatch_mode != block->mode) {
+        recording = false;
+        return;
+    }
+    block->instructions.push_back(insn);
+    block->end_pc = insn.pc + 1 + insn.operand_count;
+    block_index = block->instructions.size();
+    if (pc != block->end_pc) {
+        recording = false;
+    }
+}
 
-        // CLV - Clear Overflow
-        case 0xB8:
-            CPUInstructions::clv(this);
-            break;
+// Operand fetch from the bus; while recording, also capture the byte
+uint8_t CPU::fetch8_bus() {
+    uint32_t addr = pc++;
+    uint8_t value = mem->fetch(addr);
+    if (fetch_mode == FetchMode::Record) {
+        int page = mem->code_page(addr);
+        if (page == Bus::kNoCode || record_insn->operand_count >= 3) {
+            record_ok = false;
+        } else {
+            record_insn->operands[record_insn->operand_count++] = value;
+            if (page >= 0) {
+                watch_code(page);
+            }
+        }
+    }
+    return value;
+}
 
-        // JMP - Jump Instructions
-        case 0x4C: // JMP Absolute
-            CPUInstructions::jmp_absolute(this);
-            break;
-        case 0x5C: // JMP Absolute Long
-            CPUInstructions::jmp_absolute_long(this);
-            break;
-        case 0x6C: // JMP Indirect
-            CPUInstructions::jmp_absolute_indirect(this);
-            break;
-        case 0xDC: // JMP Indirect Long
-            CPUInstructions::jmp_absolute_indirect_long(this);
-            break;
-        case 0x7C: // JMP Indexed Indirect
-            CPUInstructions::jmp_absolute_indirect_x(this);
-            break;
+// Register the block being recorded against a WRAM page it was fetched from
+void CPU::watch_code(int page) {
+    block_cache->add_page(current_block, page);
+    bus->watch_code_page(page);
+}
 
-        // JSR - Jump to Subroutine
-        case 0x20: // JSR Absolute
-            CPUInstructions::jsr(this);
-            break;
-        case 0x22: // JSR Absolute Long
-            CPUInstructions::jsr_absolute_long(this);
-            break;
+// Run a block through its JIT translation, translating it once it is hot.
+// Returns false if the block should be replayed by the interpreter.
+bool CPU::enter_native(CPUBlockCache::Block* block) {
+#if defined(PYSNES_JIT) && PYSNES_TRACE_LEVEL == 0 && !PYSNES_PROFILE
+    if (!block->native) {
+        if (!jit_enabled || block->instructions.size() < 2 || ++block->entry_count < jit_threshold) {
+            return false;
+        }
+        block->native = reinterpret_cast<void*>(jit->compile(*block, *mem));
+        if (!block->native) {
+            // Code buffers are full; start over with a fresh cache
+            flush_code_cache();
+            return false;
+        }
+    }
+    fetch_mode = FetchMode::Replay;
+    block_index = reinterpret_cast<CPUJit::NativeBlock>(block->native)(this, jit_run);
+    fetch_mode = FetchMode::Direct;
+    return true;
+#else
+    (void)block;
+    return false;
+#endif
+}
 
-        // RTS/RTL - Return from Subroutine
-        case 0x60: // RTS
-            CPUInstructions::rts(this);
+// Whether a block is a short loop that only reads memory and branches back
+// to its own start. Loads, compares and BIT have no side effects; immediate
+// AND/ORA/EOR are allowed once A has been reloaded in the same pass.
+static bool is_idle_loop_shape(const CPUBlockCache::Block& block) {
+    const auto& insns = block.instructions;
+    if (insns.empty() || insns.size() > CPU::kMaxIdleLoopLength) {
+        return false;
+    }
+    bool a_loaded = false;
+    for (size_t i = 0; i + 1 < insns.size(); ++i) {
+        switch (insns[i].opcode) {
+        case 0xA9: case 0xA5: case 0xAD: case 0xAF:    // LDA
+            a_loaded = true;
             break;
-        case 0x6B: // RTL
-            CPUInstructions::rtl(this);
+        case 0xC9: case 0xC5: case 0xCD: case 0xCF:    // CMP
+        case 0xE0: case 0xE4: case 0xEC:               // CPX
+        case 0xC0: case 0xC4: case 0xCC:               // CPY
+        case 0x89: case 0x24: case 0x2C:               // BIT
+        case 0xEA:                                     // NOP
             break;
-
-        // RTI - Return from Interrupt
-        case 0x40:
-            CPUInstructions::rti(this);
+        case 0x29: case 0x09: case 0x49:               // AND/ORA/EOR #imm
+            if (!a_loaded) return false;
             break;
+        default:
+            return false;
+        }
+    }
 
-        // LDA - Load Accumulator
-        case 0xA9: // Immediate
-            CPUInstructions::lda_immediate(this);
-            break;
-        case 0xA5: // Direct Page
-            CPUInstructions::lda_direct_page(this);
-            break;
-        case 0xB5: // Direct Page, X
-            CPUInstructions::lda_direct_page_x(this);
-            break;
-        case 0xAD: // Absolute
-            CPUInstructions::lda_absolute(this);
-            break;
-        case 0xBD: // Absolute, X
-            CPUInstructions::lda_absolute_x(this);
-            break;
-        case 0xB9: // Absolute, Y
-            CPUInstructions::lda_absolute_y(this);
-            break;
-        case 0xA1: // (Direct Page, X)
-            CPUInstructions::lda_dp_indirect_x(this);
-            break;
-        case 0xB1: // (Direct Page), Y
-            CPUInstructions::lda_dp_indirect_y(this);
-            break;
-        case 0xB2: // (Direct Page)
-            CPUInstructions::lda_dp_indirect(this);
-            break;
-        case 0xA7: // [Direct Page]
-            CPUInstructions::lda_dp_indirect_long(this);
-            break;
-        case 0xB7: // [Direct Page], Y
-            CPUInstructions::lda_dp_indirect_long_y(this);
-            break;
-        case 0xAF: // Absolute Long
-            CPUInstructions::lda_absolute_long(this);
-            break;
-        case 0xBF: // Absolute Long, X
-            CPUInstructions::lda_absolute_long_x(this);
-            break;
-        case 0xA3: // Stack Relative
-            CPUInstructions::lda_stack_relative(this);
-            break;
-        case 0xB3: // Stack Relative Indirect, Y
-            CPUInstructions::lda_stack_relative_indirect_y(this);
-            break;
+    const CPUBlockCache::Instruction& last = insns.back();
+    uint32_t target;
+    switch (last.opcode) {
+    case 0x10: case 0x30: case 0x50: case 0x70:        // Conditional branches
+    case 0x90: case 0xB0: case 0xD0: case 0xF0:
+    case 0x80:                                         // BRA
+        target = last.pc + 2 + (int8_t)last.operands[0];
+        break;
+    case 0x4C:                                         // JMP abs
+        target = last.operands[0] | (last.operands[1] << 8);
+        break;
+    default:
+        return false;
+    }
+    return target == block.pc;
+}
 
-        // STA - Store Accumulator
-        case 0x85: // Direct Page
-            CPUInstructions::sta_direct_page(this);
-            break;
-        case 0x95: // Direct Page, X
-            CPUInstructions::sta_direct_page_x(this);
-            break;
-        case 0x8D: // Absolute
-            CPUInstructions::sta_absolute(this);
-            break;
-        case 0x9D: // Absolute, X
-            CPUInstructions::sta_absolute_x(this);
-            break;
-        case 0x99: // Absolute, Y
-            CPUInstructions::sta_absolute_y(this);
-            break;
-        case 0x81: // (Direct Page, X)
-            CPUInstructions::sta_dp_indirect_x(this);
-            break;
-        case 0x91: // (Direct Page), Y
-            CPUInstructions::sta_dp_indirect_y(this);
-            break;
-        case 0x92: // (Direct Page)
-            CPUInstructions::sta_dp_indirect(this);
-            break;
-        case 0x87: // [Direct Page]
-            CPUInstructions::sta_dp_indirect_long(this);
-            break;
-        case 0x97: // [Direct Page], Y
-            CPUInstructions::sta_dp_indirect_long_y(this);
-            break;
-        case 0x8F: // Absolute Long
-            CPUInstructions::sta_absolute_long(this);
-            break;
-        case 0x9F: // Absolute Long, X
-            CPUInstructions::sta_absolute_long_x(this);
-            break;
-        case 0x83: // Stack Relative
-            CPUInstructions::sta_stack_relative(this);
-            break;
-        case 0x93: // Stack Relative Indirect, Y
-            CPUInstructions::sta_stack_relative_indirect_y(this);
-            break;
+// Polled memory must not change while the CPU spins: host-backed pages
+// (WRAM, ROM) only change through writes, and the interrupt/PPU status
+// registers only at scheduler events, which end the run anyway
+static bool is_idle_read_stable(const Bus& bus, uint32_t addr) {
+    if (bus.code_page(addr) != Bus::kNoCode) {
+        return true;
+    }
+    uint16_t offset = addr & 0xFFFF;
+    bool system_bank = (addr & 0x400000) == 0;
+    return system_bank && ((offset >= 0x4210 && offset <= 0x4212) || offset == 0x213E || offset == 0x213F);
+}
 
-        // Transfer Instructions
-        case 0xAA: // TAX - Transfer Accumulator to X
-            CPUInstructions::tax(this);
-            break;
-        case 0x8A: // TXA - Transfer X to Accumulator
-            CPUInstructions::txa(this);
-            break;
-        case 0xA8: // TAY - Transfer Accumulator to Y
-            CPUInstructions::tay(this);
-            break;
-        case 0x98: // TYA - Transfer Y to Accumulator
-            CPUInstructions::tya(this);
-            break;
-        case 0xBA: // TSX - Transfer Stack Pointer to X
-            CPUInstructions::tsx(this);
-            break;
-        case 0x9A: // TXS - Transfer X to Stack Pointer
-            CPUInstructions::txs(this);
-            break;
-        case 0x9B: // TXY - Transfer X to Y
-            CPUInstructions::txy(this);
-            break;
-        case 0xBB: // TYX - Transfer Y to X
-            CPUInstructions::tyx(this);
-            break;
-        case 0x5B: // TCD - Transfer Accumulator to Direct Page
-            CPUInstructions::tcd(this);
-            break;
-        case 0x7B: // TDC - Transfer Direct Page to Accumulator
-            CPUInstructions::tdc(this);
-            break;
-        case 0x3B: // TSC - Transfer Stack Pointer to Accumulator
-            CPUInstructions::tsc(this);
-            break;
-        case 0x1B: // TCS - Transfer Accumulator to Stack Pointer
-            CPUInstructions::tcs(this);
-            break;
-        case 0xEB: // XBA - Exchange B and A
-            CPUInstructions::xba(this);
-            break;
-        case 0xFB: // XCE - Exchange Carry and Emulation
-            CPUInstructions::xce(this);
+// Direct page operands are offset by D and absolute ones sit in the data
+// bank, while the handlers address bank 0 with the raw operand. A loop
+// that depends on either register could be polling something else than
+// it looks like, so it is only classified with both at zero. Indexed and
+// indirect reads depend on registers and are never stable.
+bool CPU::idle_reads_stable(const CPUBlockCache::Block& block) const {
+    const auto& insns = block.instructions;
+    // The last instruction branches back without reading memory
+    for (size_t i = 0; i + 1 < insns.size(); ++i) {
+        const CPUBlockCache::Instruction& insn = insns[i];
+        uint32_t addr;
+        switch (CPUOpcodes::kTable[insn.opcode].mode) {
+        case AddrMode::Implied:
+        case AddrMode::ImmediateM:
+        case AddrMode::ImmediateX:
+            continue;
+        case AddrMode::Direct:
+            if (d != 0) return false;
+            addr = insn.operands[0];
+            break;
+        case AddrMode::Absolute:
+            if (db != 0) return false;
+            addr = insn.operands[0] | (insn.operands[1] << 8);
+            break;
+        case AddrMode::AbsoluteLong:
+            addr = insn.operands[0] | (insn.operands[1] << 8) | (insn.operands[2] << 16);
             break;
+        default:
+            return false;
+        }
+        // 16-bit reads touch the next byte too
+        if (!is_idle_read_stable(*mem, addr) || !is_idle_read_stable(*mem, (addr + 1) & 0xFFFFFF)) {
+            return false;
+        }
+    }
+    return true;
+}
 
-        // Stack Instructions
-        case 0x48: // PHA - Push Accumulator
-            CPUInstructions::pha(this);
-            break;
-        case 0x68: // PLA - Pull Accumulator
-            CPUInstructions::pla(this);
-            break;
-        case 0xDA: // PHX - Push X
-            CPUInstructions::phx(this);
-            break;
-        case 0xFA: // PLX - Pull X
-            CPUInstructions::plx(this);
-            break;
-        case 0x5A: // PHY - Push Y
-            CPUInstructions::phy(this);
-            break;
-        case 0x7A: // PLY - Pull Y
-            CPUInstructions::ply(this);
-            break;
-        case 0x08: // PHP - Push Processor Status
-            CPUInstructions::php(this);
-            break;
-        case 0x28: // PLP - Pull Processor Status
-            CPUInstructions::plp(this);
-            break;
-        case 0x0B: // PHD - Push Direct Page
-            CPUInstructions::phd(this);
-            break;
-        case 0x2B: // PLD - Pull Direct Page
-            CPUInstructions::pld(this);
-            break;
-        case 0x4B: // PHK - Push Program Bank
-            CPUInstructions::phk(this);
-            break;
-        case 0xAB: // PLK - Pull Program Bank
-            CPUInstructions::plk(this);
-            break;
-        case 0xF4: // PEA - Push Effective Address
-            CPUInstructions::pea(this);
-            break;
-        case 0xD4: // PEI - Push Effective Indirect Address
-            CPUInstructions::pei(this);
-            break;
-        case 0x62: // PER - Push Effective PC Relative Address
-            CPUInstructions::per(this);
-            break;
+// Called when run_until() enters a block. If the block is an idle loop and
+// the CPU just made one straight pass through it, every further pass
+// takes the same cycles and leaves the same state, so as many passes as fit
+// in the run's targets are counted without executing them. The remainder
+// runs normally and reaches the target on the same instruction it would
+// have anyway.
+bool CPU::skip_idle_loop(CPUBlockCache::Block* block, bool looped) {
+    if (block->idle == CPUBlockCache::kIdleUnknown) {
+        block->idle = is_idle_loop_shape(*block) ? CPUBlockCache::kIdleLoop : CPUBlockCache::kIdleNo;
+        if (block->idle == CPUBlockCache::kIdleNo) {
+            return false;
+        }
+    }
 
-        // ADC - Add with Carry
-        case 0x69: // Immediate
-            CPUInstructions::adc_immediate(this);
-            break;
-        case 0x65: // Direct Page
-            CPUInstructions::adc_direct_page(this);
-            break;
-        case 0x75: // Direct Page, X
-            CPUInstructions::adc_direct_page_x(this);
-            break;
-        case 0x6D: // Absolute
-            CPUInstructions::adc_absolute(this);
-            break;
-        case 0x7D: // Absolute, X
-            CPUInstructions::adc_absolute_x(this);
-            break;
-        case 0x79: // Absolute, Y
-            CPUInstructions::adc_absolute_y(this);
-            break;
-        case 0x61: // (Direct Page, X)
-            CPUInstructions::adc_dp_indirect_x(this);
-            break;
-        case 0x71: // (Direct Page), Y
-            CPUInstructions::adc_dp_indirect_y(this);
-            break;
-        case 0x72: // (Direct Page)
-            CPUInstructions::adc_dp_indirect(this);
-            break;
-        case 0x67: // [Direct Page]
-            CPUInstructions::adc_dp_indirect_long(this);
-            break;
-        case 0x77: // [Direct Page], Y
-            CPUInstructions::adc_dp_indirect_long_y(this);
-            break;
+    CPURunState& run = *active_run;
+    uint64_t length = block->instructions.size();
+    looped = looped && idle_block == block && run.instructions - idle_entry_instructions == length;
+    uint64_t pass_cycles = run.cycles - idle_entry_cycles;
+    idle_block = block;
+    idle_entry_cycles = run.cycles;
+    idle_entry_instructions = run.instructions;
+    if (!looped || pass_cycles == 0 || !idle_reads_stable(*block)) {
+        return false;
+    }
 
-        // SBC - Subtract with Carry
-        case 0xE9: // Immediate
-            CPUInstructions::sbc_immediate(this);
-            break;
-        case 0xE5: // Direct Page
-            CPUInstructions::sbc_direct_page(this);
-            break;
-        case 0xF5: // Direct Page, X
-            CPUInstructions::sbc_direct_page_x(this);
-            break;
-        case 0xED: // Absolute
-            CPUInstructions::sbc_absolute(this);
-            break;
-        case 0xFD: // Absolute, X
-            CPUInstructions::sbc_absolute_x(this);
-            break;
-        case 0xF9: // Absolute, Y
-            CPUInstructions::sbc_absolute_y(this);
-            break;
-        case 0xE1: // (Direct Page, X)
-            CPUInstructions::sbc_dp_indirect_x(this);
-            break;
-        case 0xF1: // (Direct Page), Y
-            CPUInstructions::sbc_dp_indirect_y(this);
-            break;
-        case 0xF2: // (Direct Page)
-            CPUInstructions::sbc_dp_indirect(this);
-            break;
-        case 0xE7: // [Direct Page]
-            CPUInstructions::sbc_dp_indirect_long(this);
-            break;
-        case 0xF7: // [Direct Page], Y
-            CPUInstructions::sbc_dp_indirect_long_y(this);
-            break;
+    // The instruction being entered runs after the skip, so leave it room
+    // under both targets
+    uint64_t passes = std::min((run.cycle_target - run.cycles - 1) / pass_cycles,
+                               (run.instruction_target - run.instructions - 1) / length);
+    if (passes == 0) {
+        return false;
+    }
+    run.cycles += passes * pass_cycles;
+    run.instructions += passes * length;
+    idle_entry_cycles = run.cycles;
+    idle_entry_instructions = run.instructions;
+    idle_stats.skips++;
+    idle_stats.cycles += passes * pass_cycles;
+    idle_stats.instructions += passes * length;
+    return true;
+}
 
-        // INC - Increment
-        case 0x1A: // Accumulator
-            CPUInstructions::inc_accumulator(this);
-            break;
-        case 0xE6: // Direct Page
-            CPUInstructions::inc_direct_page(this);
-            break;
-        case 0xF6: // Direct Page, X
-            CPUInstructions::inc_direct_page_x(this);
-            break;
-        case 0xEE: // Absolute
-            CPUInstructions::inc_absolute(this);
-            break;
-        case 0xFE: // Absolute, X
-            CPUInstructions::inc_absolute_x(this);
-            break;
-        case 0xE8: // INX
-            CPUInstructions::inx(this);
-            break;
-        case 0xC8: // INY
-            CPUInstructions::iny(this);
-            break;
+void CPU::invalidate_code_page(int page) {
+    block_cache->invalidate_page(page);
+    idle_block = nullptr;
+}
 
-        // DEC - Decrement
-        case 0x3A: // Accumulator
-            CPUInstructions::dec_accumulator(this);
-            break;
-        case 0xC6: // Direct Page
-            CPUInstructions::dec_direct_page(this);
-            break;
-        case 0xD6: // Direct Page, X
-            CPUInstructions::dec_direct_page_x(this);
-            break;
-        case 0xCE: // Absolute
-            CPUInstructions::dec_absolute(this);
-            break;
-        case 0xDE: // Absolute, X
-            CPUInstructions::dec_absolute_x(this);
-            break;
-        case 0xCA: // DEX
-            CPUInstructions::dex(this);
-            break;
-        case 0x88: // DEY
-            CPUInstructions::dey(this);
-            break;
+void CPU::flush_code_cache() {
+    block_cache->flush();
+    idle_block = nullptr;
+#ifdef PYSNES_JIT
+    jit->reset();
+#endif
+    current_block = nullptr;
+    recording = false;
+    if (bus) {
+        for (int page = 0; page < CPUBlockCache::kWramPages; ++page) {
+            bus->unwatch_code_page(page);
+        }
+    }
+}
 
-        // CMP - Compare Accumulator
-        case 0xC9: // Immediate
-            CPUInstructions::cmp_immediate(this);
-            break;
-        case 0xC5: // Direct Page
-            CPUInstructions::cmp_direct_page(this);
-            break;
-        case 0xD5: // Direct Page, X
-            CPUInstructions::cmp_direct_page_x(this);
-            break;
-        case 0xCD: // Absolute
-            CPUInstructions::cmp_absolute(this);
-            break;
-        case 0xDD: // Absolute, X
-            CPUInstructions::cmp_absolute_x(this);
-            break;
-        case 0xD9: // Absolute, Y
-            CPUInstructions::cmp_absolute_y(this);
-            break;
-        case 0xC1: // (Direct Page, X)
-            CPUInstructions::cmp_dp_indirect_x(this);
-            break;
-        case 0xD1: // (Direct Page), Y
-            CPUInstructions::cmp_dp_indirect_y(this);
-            break;
-        case 0xD2: // (Direct Page)
-            CPUInstructions::cmp_dp_indirect(this);
-            break;
-        case 0xC7: // [Direct Page]
-            CPUInstructions::cmp_dp_indirect_long(this);
-            break;
-        case 0xD7: // [Direct Page], Y
-            CPUInstructions::cmp_dp_indirect_long_y(this);
-            break;
-        case 0xCF: // Absolute Long
-            CPUInstructions::cmp_absolute_long(this);
-            break;
-        case 0xDF: // Absolute Long, X
-            CPUInstructions::cmp_absolute_long_x(this);
-            break;
-        case 0xC3: // Stack Relative
-            CPUInstructions::cmp_stack_relative(this);
-            break;
-        case 0xD3: // Stack Relative Indirect, Y
-            CPUInstructions::cmp_stack_relative_indirect_y(this);
-            break;
+void CPU::set_block_cache_enabled(bool enabled) {
+    block_cache_enabled = enabled;
+    flush_code_cache();
+}
 
-        // CPX - Compare X Register
-        case 0xE0: // Immediate
-            CPUInstructions::cpx_immediate(this);
-            break;
-        case 0xE4: // Direct Page
-            CPUInstructions::cpx_direct_page(this);
-            break;
-        case 0xEC: // Absolute
-            CPUInstructions::cpx_absolute(this);
-            break;
+// Traced and profiled builds need every instruction to go through the
+// interpreter
+bool CPU::jit_available() {
+#if defined(PYSNES_JIT) && PYSNES_TRACE_LEVEL == 0 && !PYSNES_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
 
-        // CPY - Compare Y Register
-        case 0xC0: // Immediate
-            CPUInstructions::cpy_immediate(this);
-            break;
-        case 0xC4: // Direct Page
-            CPUInstructions::cpy_direct_page(this);
-            break;
-        case 0xCC: // Absolute
-            CPUInstructions::cpy_absolute(this);
-            break;
+void CPU::set_jit_enabled(bool enabled) {
+    jit_enabled = enabled && jit_available();
+    flush_code_cache();
+}
 
-        // AND - Logical AND
-        case 0x29: // Immediate
-            CPUInstructions::and_immediate(this);
-            break;
-        case 0x25: // Direct Page
-            CPUInstructions::and_direct_page(this);
-            break;
-        case 0x35: // Direct Page, X
-            CPUInstructions::and_direct_page_x(this);
-            break;
-        case 0x2D: // Absolute
-            CPUInstructions::and_absolute(this);
-            break;
-        case 0x3D: // Absolute, X
-            CPUInstructions::and_absolute_x(this);
-            break;
-        case 0x39: // Absolute, Y
-            CPUInstructions::and_absolute_y(this);
-            break;
-        case 0x21: // (Direct Page, X)
-            CPUInstructions::and_dp_indirect_x(this);
-            break;
-        case 0x31: // (Direct Page), Y
-            CPUInstructions::and_dp_indirect_y(this);
-            break;
-        case 0x32: // (Direct Page)
-            CPUInstructions::and_dp_indirect(this);
-            break;
-        case 0x27: // [Direct Page]
-            CPUInstructions::and_dp_indirect_long(this);
-            break;
-        case 0x37: // [Direct Page], Y
-            CPUInstructions::and_dp_indirect_long_y(this);
-            break;
+size_t CPU::jit_code_size() const {
+#ifdef PYSNES_JIT
+    return jit->code_size();
+#else
+    return 0;
+#endif
+}
 
-        // ORA - Logical OR
-        case 0x09: // Immediate
-            CPUInstructions::ora_immediate(this);
-            break;
-        case 0x05: // Direct Page
-            CPUInstructions::ora_direct_page(this);
-            break;
-        case 0x15: // Direct Page, X
-            CPUInstructions::ora_direct_page_x(this);
-            break;
-        case 0x0D: // Absolute
-            CPUInstructions::ora_absolute(this);
-            break;
-        case 0x1D: // Absolute, X
-            CPUInstructions::ora_absolute_x(this);
-            break;
-        case 0x19: // Absolute, Y
-            CPUInstructions::ora_absolute_y(this);
-            break;
-        case 0x01: // (Direct Page, X)
-            CPUInstructions::ora_dp_indirect_x(this);
-            break;
-        case 0x11: // (Direct Page), Y
-            CPUInstructions::ora_dp_indirect_y(this);
-            break;
-        case 0x12: // (Direct Page)
-            CPUInstructions::ora_dp_indirect(this);
-            break;
-        case 0x07: // [Direct Page]
-            CPUInstructions::ora_dp_indirect_long(this);
-            break;
-        case 0x17: // [Direct Page], Y
-            CPUInstructions::ora_dp_indirect_long_y(this);
-            break;
+// Target for a budget added to a running total, clamped instead of wrapping
+static uint64_t budget_target(uint64_t start, uint64_t budget) {
+    return (budget > UINT64_MAX - start) ? UINT64_MAX : start + budget;
+}
 
-        // EOR - Logical XOR
-        case 0x49: // Immediate
-            CPUInstructions::eor_immediate(this);
-            break;
-        case 0x45: // Direct Page
-            CPUInstructions::eor_direct_page(this);
-            break;
-        case 0x55: // Direct Page, X
-            CPUInstructions::eor_direct_page_x(this);
-            break;
-        case 0x4D: // Absolute
-            CPUInstructions::eor_absolute(this);
-            break;
-        case 0x5D: // Absolute, X
-            CPUInstructions::eor_absolute_x(this);
-            break;
-        case 0x59: // Absolute, Y
-            CPUInstructions::eor_absolute_y(this);
-            break;
-        case 0x41: // (Direct Page, X)
-            CPUInstructions::eor_dp_indirect_x(this);
-            break;
-        case 0x51: // (Direct Page), Y
-            CPUInstructions::eor_dp_indirect_y(this);
-            break;
-        case 0x52: // (Direct Page)
-            CPUInstructions::eor_dp_indirect(this);
-            break;
-        case 0x47: // [Direct Page]
-            CPUInstructions::eor_dp_indirect_long(this);
-            break;
-        case 0x57: // [Direct Page], Y
-            CPUInstructions::eor_dp_indirect_long_y(this);
-            break;
+uint64_t CPU::run(uint64_t cycle_budget) {
+    uint64_t start = cycle_count;
+    run_until(budget_target(start, cycle_budget), UINT64_MAX);
+    return cycle_count - start;
+}
 
-        // Branch Instructions
-        case 0x90: // BCC - Branch if Carry Clear
-            CPUInstructions::bcc(this);
-            break;
-        case 0xB0: // BCS - Branch if Carry Set
-            CPUInstructions::bcs(this);
-            break;
-        case 0xF0: // BEQ - Branch if Equal
-            CPUInstructions::beq(this);
-            break;
-        case 0xD0: // BNE - Branch if Not Equal
-            CPUInstructions::bne(this);
-            break;
-        case 0x30: // BMI - Branch if Minus
-            CPUInstructions::bmi(this);
-            break;
-        case 0x10: // BPL - Branch if Plus
-            CPUInstructions::bpl(this);
-            break;
-        case 0x50: // BVC - Branch if Overflow Clear
-            CPUInstructions::bvc(this);
-            break;
-        case 0x70: // BVS - Branch if Overflow Set
-            CPUInstructions::bvs(this);
-            break;
-        case 0x80: // BRA - Branch Always
-            CPUInstructions::bra(this);
-            break;
-        case 0x82: // BRL - Branch Always Long
-            CPUInstructions::brl(this);
-            break;
+uint64_t CPU::run_instructions(uint64_t count) {
+    uint64_t start = instruction_count;
+    run_until(UINT64_MAX, budget_target(start, count));
+    return instruction_count - start;
+}
 
-        // Shift and Rotate Instructions
-        // ASL - Arithmetic Shift Left
-        case 0x0A: // Accumulator
-            CPUInstructions::asl_accumulator(this);
-            break;
-        case 0x06: // Direct Page
-            CPUInstructions::asl_direct_page(this);
-            break;
-        case 0x16: // Direct Page, X
-            CPUInstructions::asl_direct_page_x(this);
-            break;
-        case 0x0E: // Absolute
-            CPUInstructions::asl_absolute(this);
-            break;
-        case 0x1E: // Absolute, X
-            CPUInstructions::asl_absolute_x(this);
-            break;
+// Execute instructions back to back without returning to the caller.
+// Handlers operate on the CPU object, so the registers stay in members;
+// the run counters are kept in a local CPURunState and written back on
+// exit. Every E/M/X change goes through update_dispatch(), so the width
+// mode only needs checking once on entry.
+void CPU::run_until(uint64_t cycle_target, uint64_t instruction_target) {
+    if (!bus) {
+        printf("ERROR: No bus connected to CPU\n");
+        return;
+    }
+    if (halted != Halt::None) {
+        return;
+    }
+    if (dispatch_mode != CPUInstructions::width_mode(p)) {
+        update_dispatch();
+    }
 
-        // LSR - Logical Shift Right
-        case 0x4A: // Accumulator
-            CPUInstructions::lsr_accumulator(this);
-            break;
-        case 0x46: // Direct Page
-            CPUInstructions::lsr_direct_page(this);
-            break;
-        case 0x56: // Direct Page, X
-            CPUInstructions::lsr_direct_page_x(this);
-            break;
-        case 0x4E: // Absolute
-            CPUInstructions::lsr_absolute(this);
-            break;
-        case 0x5E: // Absolute, X
-            CPUInstructions::lsr_absolute_x(this);
-            break;
+    CPURunState run;
+    run.cycles = cycle_count;
+    run.instructions = instruction_count;
+    run.cycle_target = cycle_target;
+    run.instruction_target = instruction_target;
+    active_run = &run;
+    // Memory may have changed between runs; measure a fresh pass first
+    idle_block = nullptr;
+    // Native blocks count all but their last instruction into run
+    if (jit_enabled && block_cache_enabled) {
+        jit_run = &run;
+    }
+    while (run.cycles < run.cycle_target && run.instructions < run.instruction_target) {
+#if PYSNES_TRACE_LEVEL >= 1
+        cycle_count = run.cycles;
+#endif
+        execute_instruction();
+        PYSNES_PROFILE_RETIRE(this, 1, cycles);
+        run.cycles += cycles;
+        run.instructions++;
+    }
+    jit_run = nullptr;
+    active_run = nullptr;
+    sync_flags();
+    cycle_count = run.cycles;
+    instruction_count = run.instructions;
+}
 
-        // ROL - Rotate Left
-        case 0x2A: // Accumulator
-            CPUInstructions::rol_accumulator(this);
-            break;
-        case 0x26: // Direct Page
-            CPUInstructions::rol_direct_page(this);
-            break;
-        case 0x36: // Direct Page, X
-            CPUInstructions::rol_direct_page_x(this);
-            break;
-        case 0x2E: // Absolute
-            CPUInstructions::rol_absolute(this);
-            break;
-        case 0x3E: // Absolute, X
-            CPUInstructions::rol_absolute_x(this);
-            break;
+uint64_t CPU::repeat_budget(uint8_t cycles_each) const {
+#if PYSNES_TRACE_LEVEL >= 1
+    // Every repetition gets its own trace record
+    (void)cycles_each;
+    return 1;
+#else
+    if (!active_run || active_run->cycles >= active_run->cycle_target ||
+        active_run->instructions >= active_run->instruction_target) {
+        return 1;
+    }
+    // A repetition starts whenever the run is still below its targets
+    uint64_t cycles_left = active_run->cycle_target - active_run->cycles;
+    uint64_t by_cycles = cycles_left / cycles_each + (cycles_left % cycles_each != 0);
+    return std::min(by_cycles, active_run->instruction_target - active_run->instructions);
+#endif
+}
 
-        // ROR - Rotate Right
-        case 0x6A: // Accumulator
-            CPUInstructions::ror_accumulator(this);
-            break;
-        case 0x66: // Direct Page
-            CPUInstructions::ror_direct_page(this);
-            break;
-        case 0x76: // Direct Page, X
-            CPUInstructions::ror_direct_page_x(this);
-            break;
-        case 0x6E: // Absolute
-            CPUInstructions::ror_absolute(this);
-            break;
-        case 0x7E: // Absolute, X
-            CPUInstructions::ror_absolute_x(this);
-            break;
+void CPU::charge_repeats(uint64_t count, uint8_t cycles_each) {
+    if (active_run && count) {
+        active_run->cycles += count * cycles_each;
+        active_run->instructions += count;
+        PYSNES_PROFILE_RETIRE(this, count, count * cycles_each);
+    }
+}
 
-        // Bit Instructions
-        case 0x89: // Immediate
-            CPUInstructions::bit_immediate(this);
-            break;
-        case 0x24: // Direct Page
-            CPUInstructions::bit_direct_page(this);
-            break;
-        case 0x2C: // Absolute
-            CPUInstructions::bit_absolute(this);
-            break;
-        case 0x3C: // Absolute, X
-            CPUInstructions::bit_absolute_x(this);
-            break;
+void CPU::stall(uint64_t stall_cycles) {
+    if (active_run) {
+        active_run->cycles += stall_cycles;
+    } else {
+        cycle_count += stall_cycles;
+    }
+}
 
-        // Block Move Instructions
-        case 0x44: // MVP - Move Positive
-            CPUInstructions::mvp(this);
-            break;
-        case 0x54: // MVN - Move Negative
-            CPUInstructions::mvn(this);
-            break;
+// Select the dispatch table matching the E, M and X flags
+void CPU::update_dispatch() {
+    dispatch_mode = CPUInstructions::width_mode(p);
+    dispatch = CPUInstructions::dispatch_table(dispatch_mode).data();
+}
 
-        // Default case for unimplemented instructions
-        default:
-            cycles = 2; // Default cycle count
-            // Don't increment PC for unimplemented instructions to avoid infinite loops
-            // Instead, increment PC by 1 to move to next instruction
-            pc++;
-            break;
+// Stop executing after the current instruction. Zeroing the cycle target
+// ends run_until() and any native block at the next instruction boundary.
+void CPU::halt(Halt state) {
+    halted = state;
+    if (active_run) {
+        active_run->cycle_target = 0;
     }
 }
 
-// Interrupt request
+// Interrupt request. An IRQ ends WAI even while masked; execution then
+// continues after the WAI without taking the interrupt.
 void CPU::irq() {
+    if (halted == Halt::Stop) {
+        return;
+    }
+    halted = Halt::None;
     if (!get_flag(I)) {
         CPUHelpers::handle_irq(this);
     }
@@ -756,28 +600,40 @@ void CPU::irq() {
 
 // Non-maskable interrupt
 void CPU::nmi() {
+    if (halted == Halt::Stop) {
+        return;
+    }
+    halted = Halt::None;
     CPUHelpers::handle_nmi(this);
 }
 
-// Flag management
-void CPU::set_flag(FLAGS f, bool v) {
-    if (v) {
-        p |= f;
-    } else {
-        p &= ~f;
+void CPU::trace_event(uint8_t kind, uint8_t op, uint32_t arg) {
+    sync_flags();
+    TraceRecord record;
+    record.pc = (((uint32_t)pb << 16) | pc) & 0xFFFFFF;
+    record.kind = kind;
+    record.opcode = op;
+    record.a = a;
+    record.x = x;
+    record.y = y;
+    record.sp = stkp;
+    record.p = p;
+    record.d = d;
+    record.db = db;
+    record.reserved = 0;
+    record.cycles = cycle_count;
+    if (kind == TraceRecord::kInstruction) {
+        // Operand bytes for the trace formatter, read without side effects
+        for (int i = 0; i < 3; ++i) {
+            const uint8_t* byte = mem->host_read(record.pc + 1 + i);
+            if (byte) arg |= (uint32_t)*byte << (8 * i);
+        }
     }
-}
-
-bool CPU::get_flag(FLAGS f) const {
-    return (p & f) != 0;
+    record.arg = arg;
+    trace.push(record);
 }
 
 // Helper functions
-void CPU::setZN(uint16_t value, bool is16) {
-    set_flag(Z, value == 0);
-    set_flag(N, is16 ? (value & 0x8000) : (value & 0x80));
-}
-
 void CPU::validate_stack_pointer() {
     CPUHelpers::validate_stack_pointer(this);
 }
@@ -0,0 +1,57 @@
+#include "../include/cpu_block_cache.hpp"
+
+CPUBlockCache::CPUBlockCache() : page_blocks(kWramPages) {}
+
+CPUBlockCache::Block* CPUBlockCache::find(uint8_t pb, uint32_t pc, uint8_t mode) {
+    auto it = blocks.find(key(pb, pc, mode));
+    return it == blocks.end() ? nullptr : it->second.get();
+}
+
+CPUBlockCache::Block* CPUBlockCache::create(uint8_t pb, uint32_t pc, uint8_t mode) {
+    auto block = std::make_unique<Block>();
+    block->pb = pb;
+    block->pc = pc;
+    block->mode = mode;
+    block->end_pc = pc;
+    Block* raw = block.get();
+    blocks[key(pb, pc, mode)] = std::move(block);
+    return raw;
+}
+
+void CPUBlockCache::add_page(Block* block, int page) {
+    std::vector<uint64_t>& keys = page_blocks[page];
+    uint64_t k = key(block->pb, block->pc, block->mode);
+    // Consecutive fetches usually hit the same page
+    if (keys.empty() || keys.back() != k) {
+        keys.push_back(k);
+    }
+}
+
+void CPUBlockCache::invalidate_page(int page) {
+    std::vector<uint64_t>& keys = page_blocks[page];
+    for (uint64_t k : keys) {
+        retire(k);
+    }
+    keys.clear();
+}
+
+void CPUBlockCache::flush() {
+    for (auto& entry : blocks) {
+        entry.second->valid = false;
+        retired.push_back(std::move(entry.second));
+    }
+    blocks.clear();
+    for (auto& keys : page_blocks) {
+        keys.clear();
+    }
+}
+
+// Blocks are kept alive until release_retired() since the CPU may be in
+// the middle of executing one when a store invalidates it.
+void CPUBlockCache::retire(uint64_t k) {
+    auto it = blocks.find(k);
+    if (it == blocks.end()) return;
+    it->second->valid = false;
+    retired.push_back(std::move(it->second));
+    blocks.erase(it);
+}
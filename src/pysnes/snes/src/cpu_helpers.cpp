@@ -5,8 +5,7 @@
 
 // Flag manipulation
 void CPUHelpers::setZN(CPU* cpu, uint16_t value, bool is16) {
-    cpu->set_flag(CPU::Z, value == 0);
-    cpu->set_flag(CPU::N, is16 ? (value & 0x8000) : (value & 0x80));
+    cpu->setZN(value, is16);
 }
 
 void CPUHelpers::set_flag(CPU* cpu, uint8_t flag, bool value) {
@@ -22,7 +21,7 @@ void CPUHelpers::push_8(CPU* cpu, uint8_t value) {
     cpu->stkp--;
     if (cpu->stkp < 0x0100) cpu->stkp = 0x01FF; // Wrap around if underflow
     uint32_t addr = 0x0100 + (cpu->stkp & 0xFF);
-    cpu->bus->write(addr, value);
+    cpu->mem->write(addr, value);
 }
 
 void CPUHelpers::push_16(CPU* cpu, uint16_t value) {
@@ -32,7 +31,7 @@ void CPUHelpers::push_16(CPU* cpu, uint16_t value) {
 
 uint8_t CPUHelpers::pop_8(CPU* cpu) {
     uint32_t addr = 0x0100 + (cpu->stkp & 0xFF);
-    uint8_t value = cpu->bus->read(addr);
+    uint8_t value = cpu->mem->read(addr);
     cpu->stkp++;
     if (cpu->stkp > 0x01FF) cpu->stkp = 0x0100; // Wrap around if overflow
     return value;
@@ -56,7 +55,7 @@ void CPUHelpers::validate_stack_pointer(CPU* cpu) {
 
 // Memory operations
 uint8_t CPUHelpers::read_8(CPU* cpu, uint32_t address) {
-    return cpu->bus->read(address & 0xFFFF);
+    return cpu->mem->read(address & 0xFFFF);
 }
 
 uint16_t CPUHelpers::read_16(CPU* cpu, uint32_t address) {
@@ -66,7 +65,7 @@ uint16_t CPUHelpers::read_16(CPU* cpu, uint32_t address) {
 }
 
 void CPUHelpers::write_8(CPU* cpu, uint32_t address, uint8_t value) {
-    cpu->bus->write(address & 0xFFFF, value);
+    cpu->mem->write(address & 0xFFFF, value);
 }
 
 void CPUHelpers::write_16(CPU* cpu, uint32_t address, uint16_t value) {
@@ -75,8 +74,12 @@ void CPUHelpers::write_16(CPU* cpu, uint32_t address, uint16_t value) {
 }
 
 // Utility functions
+// Recorded as a trace event; the name is not kept in the binary record
 void CPUHelpers::log_instruction(CPU* cpu, const char* instruction, uint32_t address) {
-    printf("DEBUG: %s at PC %06X, Address %04X\n", instruction, cpu->pc, address);
+    (void)cpu;
+    (void)instruction;
+    (void)address;
+    PYSNES_TRACE_EVENT(cpu, TraceRecord::kLog, address);
 }
 
 void CPUHelpers::validate_address(CPU* cpu, uint32_t address) {
@@ -101,15 +104,17 @@ bool CPUHelpers::is_16bit_index(CPU* cpu) {
 // Interrupt handling
 void CPUHelpers::handle_interrupt(CPU* cpu, uint16_t vector_low, uint16_t vector_high) {
     // Push processor status and return address
+    uint32_t site = ((uint32_t)cpu->pb << 16) | cpu->pc;
     push_16(cpu, cpu->pc);
+    cpu->sync_flags();
     push_8(cpu, cpu->p & 0xFF);
 
     // Set interrupt disable flag
     cpu->set_flag(CPU::I, true);
 
     // Jump to interrupt vector
-    uint16_t lo = cpu->bus->read(vector_low);
-    uint16_t hi = cpu->bus->read(vector_high);
+    uint16_t lo = cpu->mem->read(vector_low);
+    uint16_t hi = cpu->mem->read(vector_high);
     cpu->pc = (hi << 8) | lo;
 
     // Prevent infinite loops by checking if we're jumping to unmapped memory
@@ -117,6 +122,7 @@ void CPUHelpers::handle_interrupt(CPU* cpu, uint16_t vector_low, uint16_t vector
         // If interrupt vector is invalid, jump to a safe location
         cpu->pc = 0x8000; // Reset to ROM start
     }
+    cpu->note_call(site);
 }
 
 void CPUHelpers::handle_irq(CPU* cpu) {
@@ -128,8 +134,8 @@ void CPUHelpers::handle_nmi(CPU* cpu) {
 }
 
 void CPUHelpers::handle_reset(CPU* cpu) {
-    uint16_t lo = cpu->bus->read(0xFFFC);
-    uint16_t hi = cpu->bus->read(0xFFFD);
+    uint16_t lo = cpu->mem->read(0xFFFC);
+    uint16_t hi = cpu->mem->read(0xFFFD);
     cpu->pc = (hi << 8) | lo;
 
     // Prevent infinite loops
@@ -2,19 +2,278 @@
 #include "../include/cpu.hpp"
 #include "../include/cpu_helpers.hpp"
 #include "../include/cpu_addressing.hpp"
+#include "../include/cpu_opcodes.hpp"
 #include "../include/bus.hpp"
-#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace {
+
+// Addressing mode policies for the generic handlers. Memory modes resolve
+// the effective address through CPUAddressing; Wrap masks the address of
+// the high byte of a 16-bit operand.
+template <auto Resolve, uint32_t Wrap>
+struct MemoryMode {
+    static constexpr bool is_register = false;
+    static constexpr uint32_t wrap = Wrap;
+    static uint32_t address(CPU* cpu) { return Resolve(cpu); }
+};
+
+using DirectPage = MemoryMode<&CPUAddressing::direct_page, 0xFFFF>;
+using DirectPageX = MemoryMode<&CPUAddressing::direct_page_x, 0xFFFF>;
+using DirectPageY = MemoryMode<&CPUAddressing::direct_page_y, 0xFFFF>;
+using Absolute = MemoryMode<&CPUAddressing::absolute, 0xFFFF>;
+using AbsoluteX = MemoryMode<&CPUAddressing::absolute_x, 0xFFFF>;
+using AbsoluteY = MemoryMode<&CPUAddressing::absolute_y, 0xFFFF>;
+using DPIndirectX = MemoryMode<&CPUAddressing::direct_page_indexed_indirect_x, 0xFFFF>;
+using DPIndirectY = MemoryMode<&CPUAddressing::direct_page_indirect_y, 0xFFFF>;
+using DPIndirect = MemoryMode<&CPUAddressing::direct_page_indirect, 0xFFFF>;
+using DPIndirectLong = MemoryMode<&CPUAddressing::direct_page_indirect_long, 0xFFFFFF>;
+using DPIndirectLongY = MemoryMode<&CPUAddressing::direct_page_indirect_long_y, 0xFFFFFF>;
+using AbsoluteLong = MemoryMode<&CPUAddressing::absolute_long, 0xFFFFFF>;
+using AbsoluteLongX = MemoryMode<&CPUAddressing::absolute_long_x, 0xFFFFFF>;
+using StackRelative = MemoryMode<&CPUAddressing::stack_relative, 0xFFFF>;
+using SRIndirectY = MemoryMode<&CPUAddressing::stack_relative_indirect_y, 0xFFFF>;
+
+// Operand follows the opcode
+struct Immediate {};
+
+// Register targets for read-modify-write operations
+template <uint16_t CPUState::*Reg>
+struct RegisterMode {
+    static constexpr bool is_register = true;
+    static uint16_t& reg(CPU* cpu) { return cpu->*Reg; }
+};
+
+using Accumulator = RegisterMode<&CPU::a>;
+using IndexX = RegisterMode<&CPU::x>;
+using IndexY = RegisterMode<&CPU::y>;
+
+template <typename Mode, bool Wide>
+inline uint16_t read_memory(CPU* cpu, uint32_t addr) {
+    uint16_t value = cpu->mem->read(addr);
+    if constexpr (Wide) {
+        value |= cpu->mem->read((addr + 1) & Mode::wrap) << 8;
+    }
+    return value;
+}
+
+template <typename Mode, bool Wide>
+inline void write_memory(CPU* cpu, uint32_t addr, uint16_t value) {
+    cpu->mem->write(addr, value & 0xFF);
+    if constexpr (Wide) {
+        cpu->mem->write((addr + 1) & Mode::wrap, (value >> 8) & 0xFF);
+    }
+}
+
+template <typename Mode, bool Wide>
+inline uint16_t read_operand(CPU* cpu) {
+    if constexpr (std::is_same_v<Mode, Immediate>) {
+        uint16_t value = cpu->fetch8();
+        if constexpr (Wide) {
+            value |= cpu->fetch8() << 8;
+        }
+        return value;
+    } else {
+        return read_memory<Mode, Wide>(cpu, Mode::address(cpu));
+    }
+}
+
+// Operation policies for read_op: consume the operand and update registers/flags
+struct Lda {
+    template <bool Wide>
+    static void apply(CPU* cpu, uint16_t operand) {
+        cpu->a = operand;
+        cpu->setZN(cpu->a, Wide);
+    }
+};
+
+// With X set the index registers' high bytes are zero, so 8-bit loads
+// can replace the whole register
+template <uint16_t CPUState::*Reg>
+struct LoadIndex {
+    template <bool Wide>
+    static void apply(CPU* cpu, uint16_t operand) {
+        cpu->*Reg = operand;
+        cpu->setZN(operand, Wide);
+    }
+};
+
+using Ldx = LoadIndex<&CPU::x>;
+using Ldy = LoadIndex<&CPU::y>;
+
+// Value sources for store_op
+template <uint16_t CPUState::*Reg>
+struct RegisterSource {
+    static uint16_t value(CPU* cpu) { return cpu->*Reg; }
+};
+
+struct ZeroSource {
+    static uint16_t value(CPU*) { return 0; }
+};
+
+using Stx = RegisterSource<&CPU::x>;
+using Sty = RegisterSource<&CPU::y>;
+using Stz = ZeroSource;
+
+// Writes an ADC/SBC result back to the accumulator
+template <bool Wide>
+inline void set_accumulator(CPU* cpu, uint32_t result) {
+    if constexpr (Wide) {
+        cpu->a = result & 0xFFFF;
+        cpu->setZN(cpu->a, true);
+    } else {
+        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
+        cpu->setZN(cpu->a & 0xFF, false);
+    }
+}
+
+struct Adc {
+    template <bool Wide>
+    static void apply(CPU* cpu, uint16_t operand) {
+        uint32_t result = cpu->a + operand + (cpu->get_flag(CPU::C) ? 1 : 0);
+        cpu->set_flag(CPU::C, result > (Wide ? 0xFFFF : 0xFF));
+        cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (Wide ? 0x8000 : 0x80)) != 0);
+        set_accumulator<Wide>(cpu, result);
+    }
+};
+
+struct Sbc {
+    template <bool Wide>
+    static void apply(CPU* cpu, uint16_t operand) {
+        uint32_t result = cpu->a - operand - (cpu->get_flag(CPU::C) ? 0 : 1);
+        cpu->set_flag(CPU::C, result <= (Wide ? 0xFFFF : 0xFF));
+        cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (Wide ? 0x8000 : 0x80)) != 0);
+        set_accumulator<Wide>(cpu, result);
+    }
+};
+
+template <uint16_t CPUState::*Reg>
+struct Compare {
+    template <bool Wide>
+    static void apply(CPU* cpu, uint16_t operand) {
+        uint16_t result = cpu->*Reg - operand;
+        cpu->set_flag(CPU::C, cpu->*Reg >= operand);
+        cpu->setZN(result, Wide);
+    }
+};
+
+using Cmp = Compare<&CPU::a>;
+using Cpx = Compare<&CPU::x>;
+using Cpy = Compare<&CPU::y>;
+
+struct And {
+    template <bool Wide>
+    static void apply(CPU* cpu, uint16_t operand) {
+        cpu->a &= operand;
+        cpu->setZN(cpu->a, Wide);
+    }
+};
+
+struct Ora {
+    template <bool Wide>
+    static void apply(CPU* cpu, uint16_t operand) {
+        cpu->a |= operand;
+        cpu->setZN(cpu->a, Wide);
+    }
+};
+
+struct Eor {
+    template <bool Wide>
+    static void apply(CPU* cpu, uint16_t operand) {
+        cpu->a ^= operand;
+        cpu->setZN(cpu->a, Wide);
+    }
+};
+
+struct Bit {
+    template <bool Wide>
+    static void apply(CPU* cpu, uint16_t operand) {
+        constexpr uint16_t sign = Wide ? 0x8000 : 0x80;
+        cpu->set_flag(CPU::Z, (cpu->a & operand) == 0);
+        cpu->set_flag(CPU::N, (operand & sign) != 0);
+        cpu->set_flag(CPU::V, (operand & (sign >> 1)) != 0);
+    }
+};
+
+// Operation policies for modify_op: return the new value, Z/N are set by the caller
+struct Inc {
+    template <bool Wide>
+    static uint16_t apply(CPU*, uint16_t value) {
+        return (value + 1) & (Wide ? 0xFFFF : 0xFF);
+    }
+};
+
+struct Dec {
+    template <bool Wide>
+    static uint16_t apply(CPU*, uint16_t value) {
+        return (value - 1) & (Wide ? 0xFFFF : 0xFF);
+    }
+};
+
+struct Asl {
+    template <bool Wide>
+    static uint16_t apply(CPU* cpu, uint16_t value) {
+        cpu->set_flag(CPU::C, (value & (Wide ? 0x8000 : 0x80)) != 0);
+        return (value << 1) & (Wide ? 0xFFFF : 0xFF);
+    }
+};
+
+struct Lsr {
+    template <bool Wide>
+    static uint16_t apply(CPU* cpu, uint16_t value) {
+        cpu->set_flag(CPU::C, (value & 0x01) != 0);
+        return value >> 1;
+    }
+};
+
+struct Rol {
+    template <bool Wide>
+    static uint16_t apply(CPU* cpu, uint16_t value) {
+        bool old_carry = cpu->get_flag(CPU::C);
+        cpu->set_flag(CPU::C, (value & (Wide ? 0x8000 : 0x80)) != 0);
+        return ((value << 1) | (old_carry ? 1 : 0)) & (Wide ? 0xFFFF : 0xFF);
+    }
+};
+
+struct Ror {
+    template <bool Wide>
+    static uint16_t apply(CPU* cpu, uint16_t value) {
+        bool old_carry = cpu->get_flag(CPU::C);
+        cpu->set_flag(CPU::C, (value & 0x01) != 0);
+        return (value >> 1) | (old_carry ? (Wide ? 0x8000 : 0x80) : 0);
+    }
+};
+
+} // namespace
+
+template <uint8_t Opcode>
+void CPUInstructions::unimplemented(CPU* cpu) {
+    constexpr OpcodeInfo info = CPUOpcodes::kTable[Opcode];
+    // Step over the operands so decoding stays aligned with the code
+    bool m16 = !(cpu->p & (CPU::M | CPU::E));
+    bool x16 = !(cpu->p & (CPU::X | CPU::E));
+    int operands = CPUOpcodes::operand_length(info.mode, m16, x16);
+    for (int i = 0; i < operands; ++i) {
+        cpu->fetch8();
+    }
+    cpu->note_unimplemented(Opcode);
+    cpu->cycles = info.cycles;
+}
 
 // Control Instructions
 void CPUInstructions::brk(CPU* cpu) {
     // Push PC and P to stack (PC was already incremented after fetching opcode)
     CPUHelpers::push_16(cpu, cpu->pc);
+    cpu->sync_flags();
     CPUHelpers::push_8(cpu, (cpu->p | 0x10) & 0xFF); // Set B flag
 
     // Set I flag and jump to interrupt vector
     CPUHelpers::set_flag(cpu, CPU::I, true);
-    uint16_t lo = cpu->bus->read(0xFFFE);
-    uint16_t hi = cpu->bus->read(0xFFFF);
+    uint16_t lo = cpu->mem->read(0xFFFE);
+    uint16_t hi = cpu->mem->read(0xFFFF);
     cpu->pc = (hi << 8) | lo;
 
     // Prevent infinite BRK loops by checking if we're jumping to unmapped memory
@@ -31,81 +290,83 @@ void CPUInstructions::nop(CPU* cpu) {
 }
 
 void CPUInstructions::jmp_absolute(CPU* cpu) {
-    uint16_t lo = cpu->bus->read(cpu->pc++);
-    uint16_t hi = cpu->bus->read(cpu->pc++);
+    uint16_t lo = cpu->fetch8();
+    uint16_t hi = cpu->fetch8();
     cpu->pc = (hi << 8) | lo;
     cpu->cycles = 3;
 }
 
 void CPUInstructions::jmp_absolute_long(CPU* cpu) {
-    uint16_t lo = cpu->bus->read(cpu->pc++);
-    uint16_t hi = cpu->bus->read(cpu->pc++);
-    uint8_t bank = cpu->bus->read(cpu->pc++);
+    uint16_t lo = cpu->fetch8();
+    uint16_t hi = cpu->fetch8();
+    uint8_t bank = cpu->fetch8();
     cpu->pc = ((uint32_t)bank << 16) | (hi << 8) | lo;
     cpu->cycles = 4;
 }
 
 void CPUInstructions::jmp_absolute_indirect(CPU* cpu) {
-    uint16_t lo = cpu->bus->read(cpu->pc++);
-    uint16_t hi = cpu->bus->read(cpu->pc++);
+    uint16_t lo = cpu->fetch8();
+    uint16_t hi = cpu->fetch8();
     uint16_t ptr = (hi << 8) | lo;
-    uint16_t addr_lo = cpu->bus->read(ptr);
-    uint16_t addr_hi = cpu->bus->read((ptr + 1) & 0xFFFF);
+    uint16_t addr_lo = cpu->mem->read(ptr);
+    uint16_t addr_hi = cpu->mem->read((ptr + 1) & 0xFFFF);
     cpu->pc = (addr_hi << 8) | addr_lo;
     cpu->cycles = 5;
 }
 
 void CPUInstructions::jmp_absolute_indirect_long(CPU* cpu) {
-    uint16_t lo = cpu->bus->read(cpu->pc++);
-    uint16_t hi = cpu->bus->read(cpu->pc++);
+    uint16_t lo = cpu->fetch8();
+    uint16_t hi = cpu->fetch8();
     uint16_t ptr = (hi << 8) | lo;
-    uint16_t addr_lo = cpu->bus->read(ptr);
-    uint16_t addr_hi = cpu->bus->read((ptr + 1) & 0xFFFF);
-    uint8_t addr_bank = cpu->bus->read((ptr + 2) & 0xFFFF);
+    uint16_t addr_lo = cpu->mem->read(ptr);
+    uint16_t addr_hi = cpu->mem->read((ptr + 1) & 0xFFFF);
+    uint8_t addr_bank = cpu->mem->read((ptr + 2) & 0xFFFF);
     cpu->pc = ((uint32_t)addr_bank << 16) | (addr_hi << 8) | addr_lo;
     cpu->cycles = 6;
 }
 
 void CPUInstructions::jmp_absolute_indirect_x(CPU* cpu) {
-    uint16_t lo = cpu->bus->read(cpu->pc++);
-    uint16_t hi = cpu->bus->read(cpu->pc++);
+    uint16_t lo = cpu->fetch8();
+    uint16_t hi = cpu->fetch8();
     uint16_t ptr = ((hi << 8) | lo) + cpu->x;
-    uint16_t addr_lo = cpu->bus->read(ptr);
-    uint16_t addr_hi = cpu->bus->read((ptr + 1) & 0xFFFF);
+    uint16_t addr_lo = cpu->mem->read(ptr);
+    uint16_t addr_hi = cpu->mem->read((ptr + 1) & 0xFFFF);
     cpu->pc = (addr_hi << 8) | addr_lo;
     cpu->cycles = 6;
 }
 
 void CPUInstructions::jsr(CPU* cpu) {
-    uint16_t lo = cpu->bus->read(cpu->pc++);
-    uint16_t hi = cpu->bus->read(cpu->pc++);
+    uint16_t lo = cpu->fetch8();
+    uint16_t hi = cpu->fetch8();
     uint16_t ret_addr = cpu->pc - 1;
-    printf("[JSR] Pushing return address: %04X (PC before JSR: %06X, after fetch: %06X)\n", ret_addr, cpu->pc - 3, cpu->pc);
-    printf("[JSR] Stack pointer before push: %04X\n", cpu->stkp);
-    CPUHelpers::push_16(cpu, ret_addr);
-    printf("[JSR] Stack pointer after push: %04X\n", cpu->stkp);
     uint32_t target_addr = ((uint32_t)cpu->pb << 16) | (hi << 8) | lo;
+    PYSNES_TRACE_EVENT(cpu, TraceRecord::kCall, target_addr);
+    CPUHelpers::push_16(cpu, ret_addr);
     cpu->pc = target_addr;
-    printf("[JSR] Jumping to target address: %06X\n", cpu->pc);
+    cpu->note_call(((uint32_t)cpu->pb << 16) | ret_addr);
     cpu->cycles = 6;
 }
 
 void CPUInstructions::jsr_absolute_long(CPU* cpu) {
-    uint16_t lo = cpu->bus->read(cpu->pc++);
-    uint16_t hi = cpu->bus->read(cpu->pc++);
-    uint8_t bank = cpu->bus->read(cpu->pc++);
+    uint16_t lo = cpu->fetch8();
+    uint16_t hi = cpu->fetch8();
+    uint8_t bank = cpu->fetch8();
     uint16_t ret_addr = cpu->pc - 1;
     uint8_t ret_bank = cpu->pb;
+    PYSNES_TRACE_EVENT(cpu, TraceRecord::kCall, ((uint32_t)bank << 16) | (hi << 8) | lo);
     CPUHelpers::push_16(cpu, ret_addr);
     CPUHelpers::push_8(cpu, ret_bank);
     cpu->pb = bank;
     cpu->pc = ((uint32_t)bank << 16) | (hi << 8) | lo;
+    cpu->note_call(((uint32_t)ret_bank << 16) | ret_addr);
     cpu->cycles = 8;
 }
 
 void CPUInstructions::rts(CPU* cpu) {
     uint16_t return_addr = CPUHelpers::pop_16(cpu);
     cpu->pc = ((uint32_t)cpu->pb << 16) | ((return_addr + 1) & 0xFFFF);
+    cpu->note_return();
+    PYSNES_TRACE_EVENT(cpu, TraceRecord::kReturn, cpu->pc);
     cpu->cycles = 6;
 }
 
@@ -114,24 +375,31 @@ void CPUInstructions::rtl(CPU* cpu) {
     uint16_t return_addr = CPUHelpers::pop_16(cpu);
     cpu->pb = return_bank;
     cpu->pc = ((uint32_t)return_bank << 16) | (return_addr + 1);
+    cpu->note_return();
+    PYSNES_TRACE_EVENT(cpu, TraceRecord::kReturn, cpu->pc);
     cpu->cycles = 6;
 }
 
 void CPUInstructions::rti(CPU* cpu) {
     uint8_t status = CPUHelpers::pop_8(cpu);
     uint16_t return_addr = CPUHelpers::pop_16(cpu);
+    cpu->discard_flags();
     cpu->p = (cpu->p & 0xFF00) | status;
     cpu->pc = return_addr;
+    cpu->note_return();
+    cpu->update_dispatch();
     cpu->cycles = 6;
 }
 
 void CPUInstructions::wai(CPU* cpu) {
-    // Wait for interrupt - simplified implementation
+    // Wait for interrupt; pc already points past WAI, where execution resumes
+    cpu->halt(CPU::Halt::Wait);
     cpu->cycles = 3;
 }
 
 void CPUInstructions::stp(CPU* cpu) {
-    // Stop processor - simplified implementation
+    // Stop the clock until reset
+    cpu->halt(CPU::Halt::Stop);
     cpu->cycles = 3;
 }
 
@@ -177,421 +445,84 @@ void CPUInstructions::xce(CPU* cpu) {
     bool emulation = cpu->get_flag(CPU::E);
     cpu->set_flag(CPU::C, emulation);
     cpu->set_flag(CPU::E, carry);
+    cpu->update_dispatch();
     cpu->cycles = 2;
 }
 
-// Load Instructions
-void CPUInstructions::lda_immediate(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(cpu->pc++);
-        uint16_t hi = cpu->bus->read(cpu->pc++);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 3;
-    } else {
-        cpu->a = cpu->bus->read(cpu->pc++);
-        cpu->cycles = 2;
-    }
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::lda_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 4;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 3;
-    }
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::lda_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::lda_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::lda_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::lda_absolute_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::lda_dp_indirect_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indexed_indirect_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::lda_dp_indirect_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::lda_dp_indirect(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::lda_dp_indirect_long(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::lda_dp_indirect_long_y(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::lda_absolute_long(CPU* cpu) {
-    uint32_t addr = CPUAddressing::absolute_long(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::lda_absolute_long_x(CPU* cpu) {
-    uint32_t addr = CPUAddressing::absolute_long_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 5;
+void CPUInstructions::rep(CPU* cpu) {
+    uint8_t mask = cpu->fetch8();
+    // M and X are forced to 1 in emulation mode
+    if (cpu->get_flag(CPU::E)) {
+        mask &= ~(CPU::M | CPU::X);
     }
-    cpu->setZN(cpu->a, is16);
+    cpu->sync_flags();
+    cpu->p &= ~mask;
+    cpu->update_dispatch();
+    cpu->cycles = 3;
 }
 
-void CPUInstructions::lda_stack_relative(CPU* cpu) {
-    uint16_t addr = CPUAddressing::stack_relative(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 4;
+void CPUInstructions::sep(CPU* cpu) {
+    uint8_t mask = cpu->fetch8();
+    cpu->sync_flags();
+    cpu->p |= mask;
+    // Switching to 8-bit index registers clears their high bytes
+    if (mask & CPU::X) {
+        cpu->x &= 0xFF;
+        cpu->y &= 0xFF;
     }
-    cpu->setZN(cpu->a, is16);
+    cpu->update_dispatch();
+    cpu->cycles = 3;
 }
 
-void CPUInstructions::lda_stack_relative_indirect_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::stack_relative_indirect_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        cpu->a = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        cpu->a = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-    cpu->setZN(cpu->a, is16);
+// Load, ALU and Compare Instructions
+template <typename Op, typename Mode, bool Wide, uint8_t Opcode>
+void CPUInstructions::read_op(CPU* cpu) {
+    uint16_t operand = read_operand<Mode, Wide>(cpu);
+    Op::template apply<Wide>(cpu, operand);
+    cpu->cycles = Wide ? CPUOpcodes::kTable[Opcode].cycles_wide : CPUOpcodes::kTable[Opcode].cycles;
 }
 
 // Store Instructions
-void CPUInstructions::sta_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 4;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 3;
-    }
-}
-
-void CPUInstructions::sta_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 5;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 4;
-    }
-}
-
-void CPUInstructions::sta_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 5;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 4;
-    }
-}
-
-void CPUInstructions::sta_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 5;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 4;
-    }
-}
-
-void CPUInstructions::sta_absolute_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 5;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 4;
-    }
-}
-
-void CPUInstructions::sta_dp_indirect_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indexed_indirect_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 7;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 6;
-    }
-}
-
-void CPUInstructions::sta_dp_indirect_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 6;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 5;
-    }
-}
-
-void CPUInstructions::sta_dp_indirect(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 6;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 5;
-    }
-}
-
-void CPUInstructions::sta_dp_indirect_long(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 7;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 6;
-    }
-}
-
-void CPUInstructions::sta_dp_indirect_long_y(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 7;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 6;
-    }
-}
-
-void CPUInstructions::sta_absolute_long(CPU* cpu) {
-    uint32_t addr = CPUAddressing::absolute_long(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 6;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 5;
-    }
-}
-
-void CPUInstructions::sta_absolute_long_x(CPU* cpu) {
-    uint32_t addr = CPUAddressing::absolute_long_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 6;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 5;
-    }
-}
-
-void CPUInstructions::sta_stack_relative(CPU* cpu) {
-    uint16_t addr = CPUAddressing::stack_relative(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 5;
-    } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 4;
-    }
-}
-
-void CPUInstructions::sta_stack_relative_indirect_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::stack_relative_indirect_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (cpu->a >> 8) & 0xFF);
-        cpu->cycles = 7;
+template <typename Mode, bool Wide, uint8_t Opcode>
+void CPUInstructions::sta(CPU* cpu) {
+    write_memory<Mode, Wide>(cpu, Mode::address(cpu), cpu->a);
+    cpu->cycles = Wide ? CPUOpcodes::kTable[Opcode].cycles_wide : CPUOpcodes::kTable[Opcode].cycles;
+}
+
+template <typename Source, typename Mode, bool Wide, uint8_t Opcode>
+void CPUInstructions::store_op(CPU* cpu) {
+    write_memory<Mode, Wide>(cpu, Mode::address(cpu), Source::value(cpu));
+    cpu->cycles = Wide ? CPUOpcodes::kTable[Opcode].cycles_wide : CPUOpcodes::kTable[Opcode].cycles;
+}
+
+// Increment/Decrement, Shift and Rotate Instructions
+template <typename Op, typename Mode, bool Wide, uint8_t Opcode>
+void CPUInstructions::modify_op(CPU* cpu) {
+    uint16_t result;
+    if constexpr (Mode::is_register) {
+        // 8-bit operations leave the register's high byte untouched
+        uint16_t& reg = Mode::reg(cpu);
+        if constexpr (Wide) {
+            result = Op::template apply<true>(cpu, reg);
+            reg = result;
+        } else {
+            result = Op::template apply<false>(cpu, reg & 0xFF);
+            reg = (reg & 0xFF00) | result;
+        }
     } else {
-        cpu->bus->write(addr, cpu->a & 0xFF);
-        cpu->cycles = 6;
+        uint32_t addr = Mode::address(cpu);
+        result = Op::template apply<Wide>(cpu, read_memory<Mode, Wide>(cpu, addr));
+        write_memory<Mode, Wide>(cpu, addr, result);
     }
+    cpu->setZN(result, Wide);
+    cpu->cycles = Wide ? CPUOpcodes::kTable[Opcode].cycles_wide : CPUOpcodes::kTable[Opcode].cycles;
 }
 
 // Transfer Instructions
+template <bool Wide>
 void CPUInstructions::tax(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->x = cpu->a;
         cpu->setZN(cpu->x, true);
     } else {
@@ -601,9 +532,10 @@ void CPUInstructions::tax(CPU* cpu) {
     cpu->cycles = 2;
 }
 
+template <bool Wide>
 void CPUInstructions::txa(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->a = cpu->x;
         cpu->setZN(cpu->a, true);
     } else {
@@ -613,9 +545,10 @@ void CPUInstructions::txa(CPU* cpu) {
     cpu->cycles = 2;
 }
 
+template <bool Wide>
 void CPUInstructions::tay(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->y = cpu->a;
         cpu->setZN(cpu->y, true);
     } else {
@@ -625,9 +558,10 @@ void CPUInstructions::tay(CPU* cpu) {
     cpu->cycles = 2;
 }
 
+template <bool Wide>
 void CPUInstructions::tya(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->a = cpu->y;
         cpu->setZN(cpu->a, true);
     } else {
@@ -637,9 +571,10 @@ void CPUInstructions::tya(CPU* cpu) {
     cpu->cycles = 2;
 }
 
+template <bool Wide>
 void CPUInstructions::tsx(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->x = cpu->stkp;
         cpu->setZN(cpu->x, true);
     } else {
@@ -649,9 +584,10 @@ void CPUInstructions::tsx(CPU* cpu) {
     cpu->cycles = 2;
 }
 
+template <bool Wide>
 void CPUInstructions::txs(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->stkp = cpu->x;
     } else {
         cpu->stkp = (cpu->stkp & 0xFF00) | (cpu->x & 0xFF);
@@ -659,9 +595,10 @@ void CPUInstructions::txs(CPU* cpu) {
     cpu->cycles = 2;
 }
 
+template <bool Wide>
 void CPUInstructions::txy(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->y = cpu->x;
         cpu->setZN(cpu->y, true);
     } else {
@@ -671,9 +608,10 @@ void CPUInstructions::txy(CPU* cpu) {
     cpu->cycles = 2;
 }
 
+template <bool Wide>
 void CPUInstructions::tyx(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->x = cpu->y;
         cpu->setZN(cpu->x, true);
     } else {
@@ -689,9 +627,10 @@ void CPUInstructions::tcd(CPU* cpu) {
     cpu->cycles = 2;
 }
 
+template <bool Wide>
 void CPUInstructions::tdc(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->a = cpu->d;
         cpu->setZN(cpu->a, true);
     } else {
@@ -701,9 +640,10 @@ void CPUInstructions::tdc(CPU* cpu) {
     cpu->cycles = 2;
 }
 
+template <bool Wide>
 void CPUInstructions::tsc(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->a = cpu->stkp;
         cpu->setZN(cpu->a, true);
     } else {
@@ -713,9 +653,10 @@ void CPUInstructions::tsc(CPU* cpu) {
     cpu->cycles = 2;
 }
 
+template <bool Wide>
 void CPUInstructions::tcs(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->stkp = cpu->a;
     } else {
         cpu->stkp = (cpu->stkp & 0xFF00) | (cpu->a & 0xFF);
@@ -732,9 +673,10 @@ void CPUInstructions::xba(CPU* cpu) {
 }
 
 // Stack Instructions
+template <bool Wide>
 void CPUInstructions::pha(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         CPUHelpers::push_16(cpu, cpu->a);
         cpu->cycles = 4;
     } else {
@@ -743,9 +685,10 @@ void CPUInstructions::pha(CPU* cpu) {
     }
 }
 
+template <bool Wide>
 void CPUInstructions::pla(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->a = CPUHelpers::pop_16(cpu);
         cpu->setZN(cpu->a, true);
         cpu->cycles = 5;
@@ -756,9 +699,10 @@ void CPUInstructions::pla(CPU* cpu) {
     }
 }
 
+template <bool Wide>
 void CPUInstructions::phx(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         CPUHelpers::push_16(cpu, cpu->x);
         cpu->cycles = 4;
     } else {
@@ -767,9 +711,10 @@ void CPUInstructions::phx(CPU* cpu) {
     }
 }
 
+template <bool Wide>
 void CPUInstructions::plx(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->x = CPUHelpers::pop_16(cpu);
         cpu->setZN(cpu->x, true);
         cpu->cycles = 5;
@@ -780,9 +725,10 @@ void CPUInstructions::plx(CPU* cpu) {
     }
 }
 
+template <bool Wide>
 void CPUInstructions::phy(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         CPUHelpers::push_16(cpu, cpu->y);
         cpu->cycles = 4;
     } else {
@@ -791,9 +737,10 @@ void CPUInstructions::phy(CPU* cpu) {
     }
 }
 
+template <bool Wide>
 void CPUInstructions::ply(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
+    constexpr bool is16 = Wide;
+    if constexpr (is16) {
         cpu->y = CPUHelpers::pop_16(cpu);
         cpu->setZN(cpu->y, true);
         cpu->cycles = 5;
@@ -806,6 +753,7 @@ void CPUInstructions::ply(CPU* cpu) {
 
 void CPUInstructions::php(CPU* cpu) {
     // When pushing processor status, set B flag (bit 4) and clear E flag (bit 8)
+    cpu->sync_flags();
     uint8_t status = (cpu->p & 0xFF) | 0x10; // Set B flag
     CPUHelpers::push_8(cpu, status);
     cpu->cycles = 3;
@@ -813,7 +761,9 @@ void CPUInstructions::php(CPU* cpu) {
 
 void CPUInstructions::plp(CPU* cpu) {
     uint8_t status = CPUHelpers::pop_8(cpu);
+    cpu->discard_flags();
     cpu->p = (cpu->p & 0xFF00) | status;
+    cpu->update_dispatch();
     cpu->cycles = 4;
 }
 
@@ -839,16 +789,16 @@ void CPUInstructions::plk(CPU* cpu) {
 }
 
 void CPUInstructions::pea(CPU* cpu) {
-    uint16_t lo = cpu->bus->read(cpu->pc++);
-    uint16_t hi = cpu->bus->read(cpu->pc++);
+    uint16_t lo = cpu->fetch8();
+    uint16_t hi = cpu->fetch8();
     CPUHelpers::push_16(cpu, (hi << 8) | lo);
     cpu->cycles = 5;
 }
 
 void CPUInstructions::pei(CPU* cpu) {
     uint16_t addr = CPUAddressing::direct_page(cpu);
-    uint16_t lo = cpu->bus->read(addr);
-    uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
+    uint16_t lo = cpu->mem->read(addr);
+    uint16_t hi = cpu->mem->read((addr + 1) & 0xFFFF);
     CPUHelpers::push_16(cpu, (hi << 8) | lo);
     cpu->cycles = 6;
 }
@@ -860,1921 +810,42 @@ void CPUInstructions::per(CPU* cpu) {
     cpu->cycles = 6;
 }
 
-// ADC - Add with Carry
-void CPUInstructions::adc_immediate(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(cpu->pc++);
-        uint16_t hi = cpu->bus->read(cpu->pc++);
-        operand = (hi << 8) | lo;
+// Branch Instructions
+void CPUInstructions::bcc(CPU* cpu) {
+    int8_t offset = cpu->fetch8();
+    if (!cpu->get_flag(CPU::C)) {
+        uint32_t old_pc = cpu->pc;
+        cpu->pc += offset;
         cpu->cycles = 3;
+        // Add extra cycle if page boundary crossed
+        if ((old_pc & 0xFF00) != (cpu->pc & 0xFF00)) {
+            cpu->cycles++;
+        }
     } else {
-        operand = cpu->bus->read(cpu->pc++);
         cpu->cycles = 2;
     }
+}
 
-    uint32_t result = cpu->a + operand + (cpu->get_flag(CPU::C) ? 1 : 0);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result > (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
+void CPUInstructions::bcs(CPU* cpu) {
+    int8_t offset = cpu->fetch8();
+    if (cpu->get_flag(CPU::C)) {
+        uint32_t old_pc = cpu->pc;
+        cpu->pc += offset;
+        cpu->cycles = 3;
+        // Add extra cycle if page boundary crossed
+        if ((old_pc & 0xFF00) != (cpu->pc & 0xFF00)) {
+            cpu->cycles++;
+        }
     } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
+        cpu->cycles = 2;
     }
 }
 
-void CPUInstructions::adc_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 4;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 3;
-    }
-
-    uint32_t result = cpu->a + operand + (cpu->get_flag(CPU::C) ? 1 : 0);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result > (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::adc_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    uint32_t result = cpu->a + operand + (cpu->get_flag(CPU::C) ? 1 : 0);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result > (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::adc_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    uint32_t result = cpu->a + operand + (cpu->get_flag(CPU::C) ? 1 : 0);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result > (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::adc_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    uint32_t result = cpu->a + operand + (cpu->get_flag(CPU::C) ? 1 : 0);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result > (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::adc_absolute_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    uint32_t result = cpu->a + operand + (cpu->get_flag(CPU::C) ? 1 : 0);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result > (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::adc_dp_indirect_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indexed_indirect_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    uint32_t result = cpu->a + operand + (cpu->get_flag(CPU::C) ? 1 : 0);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result > (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::adc_dp_indirect_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    uint32_t result = cpu->a + operand + (cpu->get_flag(CPU::C) ? 1 : 0);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result > (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::adc_dp_indirect(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    uint32_t result = cpu->a + operand + (cpu->get_flag(CPU::C) ? 1 : 0);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result > (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::adc_dp_indirect_long(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    uint32_t result = cpu->a + operand + (cpu->get_flag(CPU::C) ? 1 : 0);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result > (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::adc_dp_indirect_long_y(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 8;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 7;
-    }
-
-    uint32_t result = cpu->a + operand + (cpu->get_flag(CPU::C) ? 1 : 0);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result > (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-// SBC - Subtract with Carry
-void CPUInstructions::sbc_immediate(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(cpu->pc++);
-        uint16_t hi = cpu->bus->read(cpu->pc++);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 3;
-    } else {
-        operand = cpu->bus->read(cpu->pc++);
-        cpu->cycles = 2;
-    }
-
-    uint32_t result = cpu->a - operand - (cpu->get_flag(CPU::C) ? 0 : 1);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result <= (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::sbc_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 4;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 3;
-    }
-
-    uint32_t result = cpu->a - operand - (cpu->get_flag(CPU::C) ? 0 : 1);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result <= (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::sbc_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    uint32_t result = cpu->a - operand - (cpu->get_flag(CPU::C) ? 0 : 1);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result <= (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::sbc_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    uint32_t result = cpu->a - operand - (cpu->get_flag(CPU::C) ? 0 : 1);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result <= (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::sbc_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    uint32_t result = cpu->a - operand - (cpu->get_flag(CPU::C) ? 0 : 1);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result <= (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::sbc_absolute_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    uint32_t result = cpu->a - operand - (cpu->get_flag(CPU::C) ? 0 : 1);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result <= (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::sbc_dp_indirect_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indexed_indirect_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    uint32_t result = cpu->a - operand - (cpu->get_flag(CPU::C) ? 0 : 1);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result <= (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::sbc_dp_indirect_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    uint32_t result = cpu->a - operand - (cpu->get_flag(CPU::C) ? 0 : 1);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result <= (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::sbc_dp_indirect(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    uint32_t result = cpu->a - operand - (cpu->get_flag(CPU::C) ? 0 : 1);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result <= (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::sbc_dp_indirect_long(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    uint32_t result = cpu->a - operand - (cpu->get_flag(CPU::C) ? 0 : 1);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result <= (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-void CPUInstructions::sbc_dp_indirect_long_y(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 8;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 7;
-    }
-
-    uint32_t result = cpu->a - operand - (cpu->get_flag(CPU::C) ? 0 : 1);
-
-    // Set flags
-    cpu->set_flag(CPU::C, result <= (is16 ? 0xFFFF : 0xFF));
-    cpu->set_flag(CPU::V, ((cpu->a ^ result) & (operand ^ result) & (is16 ? 0x8000 : 0x80)) != 0);
-
-    if (is16) {
-        cpu->a = result & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        cpu->a = (cpu->a & 0xFF00) | (result & 0xFF);
-        cpu->setZN(cpu->a & 0xFF, false);
-    }
-}
-
-// INC - Increment
-void CPUInstructions::inc_accumulator(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->a = (cpu->a + 1) & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        uint8_t low_byte = (cpu->a & 0xFF) + 1;
-        cpu->a = (cpu->a & 0xFF00) | low_byte;
-        cpu->setZN(low_byte, false);
-    }
-    cpu->cycles = 2;
-}
-
-void CPUInstructions::inc_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        uint16_t value = (hi << 8) | lo;
-        value = (value + 1) & 0xFFFF;
-        cpu->bus->write(addr, value & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (value >> 8) & 0xFF);
-        cpu->setZN(value, true);
-        cpu->cycles = 6;
-    } else {
-        uint8_t value = cpu->bus->read(addr);
-        value = (value + 1) & 0xFF;
-        cpu->bus->write(addr, value);
-        cpu->setZN(value, false);
-        cpu->cycles = 5;
-    }
-}
-
-void CPUInstructions::inc_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        uint16_t value = (hi << 8) | lo;
-        value = (value + 1) & 0xFFFF;
-        cpu->bus->write(addr, value & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (value >> 8) & 0xFF);
-        cpu->setZN(value, true);
-        cpu->cycles = 7;
-    } else {
-        uint8_t value = cpu->bus->read(addr);
-        value = (value + 1) & 0xFF;
-        cpu->bus->write(addr, value);
-        cpu->setZN(value, false);
-        cpu->cycles = 6;
-    }
-}
-
-void CPUInstructions::inc_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        uint16_t value = (hi << 8) | lo;
-        value = (value + 1) & 0xFFFF;
-        cpu->bus->write(addr, value & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (value >> 8) & 0xFF);
-        cpu->setZN(value, true);
-        cpu->cycles = 7;
-    } else {
-        uint8_t value = cpu->bus->read(addr);
-        value = (value + 1) & 0xFF;
-        cpu->bus->write(addr, value);
-        cpu->setZN(value, false);
-        cpu->cycles = 6;
-    }
-}
-
-void CPUInstructions::inc_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        uint16_t value = (hi << 8) | lo;
-        value = (value + 1) & 0xFFFF;
-        cpu->bus->write(addr, value & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (value >> 8) & 0xFF);
-        cpu->setZN(value, true);
-        cpu->cycles = 8;
-    } else {
-        uint8_t value = cpu->bus->read(addr);
-        value = (value + 1) & 0xFF;
-        cpu->bus->write(addr, value);
-        cpu->setZN(value, false);
-        cpu->cycles = 7;
-    }
-}
-
-void CPUInstructions::inx(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
-        cpu->x = (cpu->x + 1) & 0xFFFF;
-        cpu->setZN(cpu->x, true);
-    } else {
-        uint8_t low_byte = (cpu->x & 0xFF) + 1;
-        cpu->x = (cpu->x & 0xFF00) | low_byte;
-        cpu->setZN(low_byte, false);
-    }
-    cpu->cycles = 2;
-}
-
-void CPUInstructions::iny(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
-        cpu->y = (cpu->y + 1) & 0xFFFF;
-        cpu->setZN(cpu->y, true);
-    } else {
-        uint8_t low_byte = (cpu->y & 0xFF) + 1;
-        cpu->y = (cpu->y & 0xFF00) | low_byte;
-        cpu->setZN(low_byte, false);
-    }
-    cpu->cycles = 2;
-}
-
-// DEC - Decrement
-void CPUInstructions::dec_accumulator(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->a = (cpu->a - 1) & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        uint8_t low_byte = (cpu->a & 0xFF) - 1;
-        cpu->a = (cpu->a & 0xFF00) | low_byte;
-        cpu->setZN(low_byte, false);
-    }
-    cpu->cycles = 2;
-}
-
-void CPUInstructions::dec_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        uint16_t value = (hi << 8) | lo;
-        value = (value - 1) & 0xFFFF;
-        cpu->bus->write(addr, value & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (value >> 8) & 0xFF);
-        cpu->setZN(value, true);
-        cpu->cycles = 6;
-    } else {
-        uint8_t value = cpu->bus->read(addr);
-        value = (value - 1) & 0xFF;
-        cpu->bus->write(addr, value);
-        cpu->setZN(value, false);
-        cpu->cycles = 5;
-    }
-}
-
-void CPUInstructions::dec_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        uint16_t value = (hi << 8) | lo;
-        value = (value - 1) & 0xFFFF;
-        cpu->bus->write(addr, value & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (value >> 8) & 0xFF);
-        cpu->setZN(value, true);
-        cpu->cycles = 7;
-    } else {
-        uint8_t value = cpu->bus->read(addr);
-        value = (value - 1) & 0xFF;
-        cpu->bus->write(addr, value);
-        cpu->setZN(value, false);
-        cpu->cycles = 6;
-    }
-}
-
-void CPUInstructions::dec_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        uint16_t value = (hi << 8) | lo;
-        value = (value - 1) & 0xFFFF;
-        cpu->bus->write(addr, value & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (value >> 8) & 0xFF);
-        cpu->setZN(value, true);
-        cpu->cycles = 7;
-    } else {
-        uint8_t value = cpu->bus->read(addr);
-        value = (value - 1) & 0xFF;
-        cpu->bus->write(addr, value);
-        cpu->setZN(value, false);
-        cpu->cycles = 6;
-    }
-}
-
-void CPUInstructions::dec_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        uint16_t value = (hi << 8) | lo;
-        value = (value - 1) & 0xFFFF;
-        cpu->bus->write(addr, value & 0xFF);
-        cpu->bus->write((addr + 1) & 0xFFFF, (value >> 8) & 0xFF);
-        cpu->setZN(value, true);
-        cpu->cycles = 8;
-    } else {
-        uint8_t value = cpu->bus->read(addr);
-        value = (value - 1) & 0xFF;
-        cpu->bus->write(addr, value);
-        cpu->setZN(value, false);
-        cpu->cycles = 7;
-    }
-}
-
-void CPUInstructions::dex(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
-        cpu->x = (cpu->x - 1) & 0xFFFF;
-        cpu->setZN(cpu->x, true);
-    } else {
-        uint8_t low_byte = (cpu->x & 0xFF) - 1;
-        cpu->x = (cpu->x & 0xFF00) | low_byte;
-        cpu->setZN(low_byte, false);
-    }
-    cpu->cycles = 2;
-}
-
-void CPUInstructions::dey(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    if (is16) {
-        cpu->y = (cpu->y - 1) & 0xFFFF;
-        cpu->setZN(cpu->y, true);
-    } else {
-        uint8_t low_byte = (cpu->y & 0xFF) - 1;
-        cpu->y = (cpu->y & 0xFF00) | low_byte;
-        cpu->setZN(low_byte, false);
-    }
-    cpu->cycles = 2;
-}
-
-// CMP - Compare Accumulator
-void CPUInstructions::cmp_immediate(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(cpu->pc++);
-        uint16_t hi = cpu->bus->read(cpu->pc++);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 3;
-    } else {
-        operand = cpu->bus->read(cpu->pc++);
-        cpu->cycles = 2;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 4;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 3;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_absolute_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_dp_indirect_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indexed_indirect_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_dp_indirect_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_dp_indirect(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_dp_indirect_long(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_dp_indirect_long_y(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 8;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 7;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_absolute_long(CPU* cpu) {
-    uint32_t addr = CPUAddressing::absolute_long(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_absolute_long_x(CPU* cpu) {
-    uint32_t addr = CPUAddressing::absolute_long_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_stack_relative(CPU* cpu) {
-    uint16_t addr = CPUAddressing::stack_relative(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 4;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cmp_stack_relative_indirect_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::stack_relative_indirect_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 7;
-    }
-
-    uint16_t result = cpu->a - operand;
-    cpu->set_flag(CPU::C, cpu->a >= operand);
-    cpu->setZN(result, is16);
-}
-
-// CPX - Compare X Register
-void CPUInstructions::cpx_immediate(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(cpu->pc++);
-        uint16_t hi = cpu->bus->read(cpu->pc++);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 3;
-    } else {
-        operand = cpu->bus->read(cpu->pc++);
-        cpu->cycles = 2;
-    }
-
-    uint16_t result = cpu->x - operand;
-    cpu->set_flag(CPU::C, cpu->x >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cpx_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    bool is16 = !cpu->get_flag(CPU::X);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 4;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 3;
-    }
-
-    uint16_t result = cpu->x - operand;
-    cpu->set_flag(CPU::C, cpu->x >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cpx_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    bool is16 = !cpu->get_flag(CPU::X);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    uint16_t result = cpu->x - operand;
-    cpu->set_flag(CPU::C, cpu->x >= operand);
-    cpu->setZN(result, is16);
-}
-
-// CPY - Compare Y Register
-void CPUInstructions::cpy_immediate(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::X);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(cpu->pc++);
-        uint16_t hi = cpu->bus->read(cpu->pc++);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 3;
-    } else {
-        operand = cpu->bus->read(cpu->pc++);
-        cpu->cycles = 2;
-    }
-
-    uint16_t result = cpu->y - operand;
-    cpu->set_flag(CPU::C, cpu->y >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cpy_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    bool is16 = !cpu->get_flag(CPU::X);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 4;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 3;
-    }
-
-    uint16_t result = cpu->y - operand;
-    cpu->set_flag(CPU::C, cpu->y >= operand);
-    cpu->setZN(result, is16);
-}
-
-void CPUInstructions::cpy_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    bool is16 = !cpu->get_flag(CPU::X);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    uint16_t result = cpu->y - operand;
-    cpu->set_flag(CPU::C, cpu->y >= operand);
-    cpu->setZN(result, is16);
-}
-
-// AND - Logical AND
-void CPUInstructions::and_immediate(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(cpu->pc++);
-        uint16_t hi = cpu->bus->read(cpu->pc++);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 3;
-    } else {
-        operand = cpu->bus->read(cpu->pc++);
-        cpu->cycles = 2;
-    }
-
-    cpu->a &= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::and_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 4;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 3;
-    }
-
-    cpu->a &= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::and_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    cpu->a &= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::and_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    cpu->a &= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::and_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    cpu->a &= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::and_absolute_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    cpu->a &= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::and_dp_indirect_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indexed_indirect_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    cpu->a &= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::and_dp_indirect_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    cpu->a &= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::and_dp_indirect(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    cpu->a &= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::and_dp_indirect_long(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    cpu->a &= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::and_dp_indirect_long_y(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 8;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 7;
-    }
-
-    cpu->a &= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-// ORA - Logical OR
-void CPUInstructions::ora_immediate(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(cpu->pc++);
-        uint16_t hi = cpu->bus->read(cpu->pc++);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 3;
-    } else {
-        operand = cpu->bus->read(cpu->pc++);
-        cpu->cycles = 2;
-    }
-
-    cpu->a |= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::ora_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 4;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 3;
-    }
-
-    cpu->a |= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::ora_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    cpu->a |= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::ora_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    cpu->a |= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::ora_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    cpu->a |= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::ora_absolute_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    cpu->a |= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::ora_dp_indirect_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indexed_indirect_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    cpu->a |= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::ora_dp_indirect_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    cpu->a |= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::ora_dp_indirect(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    cpu->a |= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::ora_dp_indirect_long(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    cpu->a |= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::ora_dp_indirect_long_y(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 8;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 7;
-    }
-
-    cpu->a |= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-// EOR - Logical XOR
-void CPUInstructions::eor_immediate(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(cpu->pc++);
-        uint16_t hi = cpu->bus->read(cpu->pc++);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 3;
-    } else {
-        operand = cpu->bus->read(cpu->pc++);
-        cpu->cycles = 2;
-    }
-
-    cpu->a ^= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::eor_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 4;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 3;
-    }
-
-    cpu->a ^= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::eor_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    cpu->a ^= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::eor_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 5;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 4;
-    }
-
-    cpu->a ^= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::eor_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    cpu->a ^= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::eor_absolute_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    cpu->a ^= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::eor_dp_indirect_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indexed_indirect_x(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    cpu->a ^= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::eor_dp_indirect_y(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    cpu->a ^= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::eor_dp_indirect(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_indirect(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 6;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 5;
-    }
-
-    cpu->a ^= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::eor_dp_indirect_long(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 7;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 6;
-    }
-
-    cpu->a ^= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-void CPUInstructions::eor_dp_indirect_long_y(CPU* cpu) {
-    uint32_t addr = CPUAddressing::direct_page_indirect_long_y(cpu);
-    bool is16 = !cpu->get_flag(CPU::M);
-    uint16_t operand;
-    if (is16) {
-        uint16_t lo = cpu->bus->read(addr);
-        uint16_t hi = cpu->bus->read((addr + 1) & 0xFFFFFF);
-        operand = (hi << 8) | lo;
-        cpu->cycles = 8;
-    } else {
-        operand = cpu->bus->read(addr);
-        cpu->cycles = 7;
-    }
-
-    cpu->a ^= operand;
-    cpu->setZN(cpu->a, is16);
-}
-
-// Branch Instructions
-void CPUInstructions::bcc(CPU* cpu) {
-    int8_t offset = cpu->bus->read(cpu->pc++);
-    if (!cpu->get_flag(CPU::C)) {
-        uint32_t old_pc = cpu->pc;
-        cpu->pc += offset;
-        cpu->cycles = 3;
-        // Add extra cycle if page boundary crossed
-        if ((old_pc & 0xFF00) != (cpu->pc & 0xFF00)) {
-            cpu->cycles++;
-        }
-    } else {
-        cpu->cycles = 2;
-    }
-}
-
-void CPUInstructions::bcs(CPU* cpu) {
-    int8_t offset = cpu->bus->read(cpu->pc++);
-    if (cpu->get_flag(CPU::C)) {
-        uint32_t old_pc = cpu->pc;
-        cpu->pc += offset;
-        cpu->cycles = 3;
-        // Add extra cycle if page boundary crossed
-        if ((old_pc & 0xFF00) != (cpu->pc & 0xFF00)) {
-            cpu->cycles++;
-        }
-    } else {
-        cpu->cycles = 2;
-    }
-}
-
-void CPUInstructions::beq(CPU* cpu) {
-    int8_t offset = cpu->bus->read(cpu->pc++);
-    if (cpu->get_flag(CPU::Z)) {
-        uint32_t old_pc = cpu->pc;
-        cpu->pc += offset;
+void CPUInstructions::beq(CPU* cpu) {
+    int8_t offset = cpu->fetch8();
+    if (cpu->get_flag(CPU::Z)) {
+        uint32_t old_pc = cpu->pc;
+        cpu->pc += offset;
         cpu->cycles = 3;
         // Add extra cycle if page boundary crossed
         if ((old_pc & 0xFF00) != (cpu->pc & 0xFF00)) {
@@ -2786,7 +857,7 @@ void CPUInstructions::beq(CPU* cpu) {
 }
 
 void CPUInstructions::bne(CPU* cpu) {
-    int8_t offset = cpu->bus->read(cpu->pc++);
+    int8_t offset = cpu->fetch8();
     if (!cpu->get_flag(CPU::Z)) {
         uint32_t old_pc = cpu->pc;
         cpu->pc += offset;
@@ -2801,7 +872,7 @@ void CPUInstructions::bne(CPU* cpu) {
 }
 
 void CPUInstructions::bmi(CPU* cpu) {
-    int8_t offset = cpu->bus->read(cpu->pc++);
+    int8_t offset = cpu->fetch8();
     if (cpu->get_flag(CPU::N)) {
         uint32_t old_pc = cpu->pc;
         cpu->pc += offset;
@@ -2816,7 +887,7 @@ void CPUInstructions::bmi(CPU* cpu) {
 }
 
 void CPUInstructions::bpl(CPU* cpu) {
-    int8_t offset = cpu->bus->read(cpu->pc++);
+    int8_t offset = cpu->fetch8();
     if (!cpu->get_flag(CPU::N)) {
         uint32_t old_pc = cpu->pc;
         cpu->pc += offset;
@@ -2831,7 +902,7 @@ void CPUInstructions::bpl(CPU* cpu) {
 }
 
 void CPUInstructions::bvc(CPU* cpu) {
-    int8_t offset = cpu->bus->read(cpu->pc++);
+    int8_t offset = cpu->fetch8();
     if (!cpu->get_flag(CPU::V)) {
         uint32_t old_pc = cpu->pc;
         cpu->pc += offset;
@@ -2846,7 +917,7 @@ void CPUInstructions::bvc(CPU* cpu) {
 }
 
 void CPUInstructions::bvs(CPU* cpu) {
-    int8_t offset = cpu->bus->read(cpu->pc++);
+    int8_t offset = cpu->fetch8();
     if (cpu->get_flag(CPU::V)) {
         uint32_t old_pc = cpu->pc;
         cpu->pc += offset;
@@ -2861,7 +932,7 @@ void CPUInstructions::bvs(CPU* cpu) {
 }
 
 void CPUInstructions::bra(CPU* cpu) {
-    int8_t offset = cpu->bus->read(cpu->pc++);
+    int8_t offset = cpu->fetch8();
     uint32_t old_pc = cpu->pc;
     cpu->pc += offset;
     cpu->cycles = 3;
@@ -2872,349 +943,407 @@ void CPUInstructions::bra(CPU* cpu) {
 }
 
 void CPUInstructions::brl(CPU* cpu) {
-    int16_t offset = cpu->bus->read(cpu->pc++);
-    offset |= (cpu->bus->read(cpu->pc++) << 8);
+    int16_t offset = cpu->fetch8();
+    offset |= (cpu->fetch8() << 8);
     cpu->pc += offset;
     cpu->cycles = 4;
 }
 
-// Shift and Rotate Instructions
-void CPUInstructions::asl_accumulator(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->set_flag(CPU::C, (cpu->a & 0x8000) != 0);
-        cpu->a = (cpu->a << 1) & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        uint8_t low_byte = cpu->a & 0xFF;
-        cpu->set_flag(CPU::C, (low_byte & 0x80) != 0);
-        low_byte = (low_byte << 1) & 0xFF;
-        cpu->a = (cpu->a & 0xFF00) | low_byte;
-        cpu->setZN(low_byte, false);
-    }
-    cpu->cycles = 2;
-}
-
-void CPUInstructions::asl_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    cpu->set_flag(CPU::C, (value & 0x80) != 0);
-    value = (value << 1) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 5;
-}
-
-void CPUInstructions::asl_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    cpu->set_flag(CPU::C, (value & 0x80) != 0);
-    value = (value << 1) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 6;
-}
-
-void CPUInstructions::asl_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    cpu->set_flag(CPU::C, (value & 0x80) != 0);
-    value = (value << 1) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 6;
-}
-
-void CPUInstructions::asl_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    cpu->set_flag(CPU::C, (value & 0x80) != 0);
-    value = (value << 1) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 7;
-}
-
-void CPUInstructions::lsr_accumulator(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        cpu->set_flag(CPU::C, (cpu->a & 0x0001) != 0);
-        cpu->a = (cpu->a >> 1) & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        uint8_t low_byte = cpu->a & 0xFF;
-        cpu->set_flag(CPU::C, (low_byte & 0x01) != 0);
-        low_byte = (low_byte >> 1) & 0xFF;
-        cpu->a = (cpu->a & 0xFF00) | low_byte;
-        cpu->setZN(low_byte, false);
-    }
-    cpu->cycles = 2;
-}
-
-void CPUInstructions::lsr_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    cpu->set_flag(CPU::C, (value & 0x01) != 0);
-    value = (value >> 1) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 5;
-}
-
-void CPUInstructions::lsr_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    cpu->set_flag(CPU::C, (value & 0x01) != 0);
-    value = (value >> 1) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 6;
-}
-
-void CPUInstructions::lsr_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    cpu->set_flag(CPU::C, (value & 0x01) != 0);
-    value = (value >> 1) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 6;
-}
-
-void CPUInstructions::lsr_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    cpu->set_flag(CPU::C, (value & 0x01) != 0);
-    value = (value >> 1) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 7;
-}
-
-void CPUInstructions::rol_accumulator(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        bool old_carry = cpu->get_flag(CPU::C);
-        cpu->set_flag(CPU::C, (cpu->a & 0x8000) != 0);
-        cpu->a = ((cpu->a << 1) | (old_carry ? 1 : 0)) & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        uint8_t low_byte = cpu->a & 0xFF;
-        bool old_carry = cpu->get_flag(CPU::C);
-        cpu->set_flag(CPU::C, (low_byte & 0x80) != 0);
-        low_byte = ((low_byte << 1) | (old_carry ? 1 : 0)) & 0xFF;
-        cpu->a = (cpu->a & 0xFF00) | low_byte;
-        cpu->setZN(low_byte, false);
-    }
-    cpu->cycles = 2;
-}
-
-void CPUInstructions::rol_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    bool old_carry = cpu->get_flag(CPU::C);
-    cpu->set_flag(CPU::C, (value & 0x80) != 0);
-    value = ((value << 1) | (old_carry ? 1 : 0)) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 5;
-}
-
-void CPUInstructions::rol_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    bool old_carry = cpu->get_flag(CPU::C);
-    cpu->set_flag(CPU::C, (value & 0x80) != 0);
-    value = ((value << 1) | (old_carry ? 1 : 0)) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 6;
-}
-
-void CPUInstructions::rol_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    bool old_carry = cpu->get_flag(CPU::C);
-    cpu->set_flag(CPU::C, (value & 0x80) != 0);
-    value = ((value << 1) | (old_carry ? 1 : 0)) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 6;
-}
-
-void CPUInstructions::rol_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    bool old_carry = cpu->get_flag(CPU::C);
-    cpu->set_flag(CPU::C, (value & 0x80) != 0);
-    value = ((value << 1) | (old_carry ? 1 : 0)) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 7;
-}
-
-void CPUInstructions::ror_accumulator(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        bool old_carry = cpu->get_flag(CPU::C);
-        cpu->set_flag(CPU::C, (cpu->a & 0x0001) != 0);
-        cpu->a = ((cpu->a >> 1) | (old_carry ? 0x8000 : 0)) & 0xFFFF;
-        cpu->setZN(cpu->a, true);
-    } else {
-        uint8_t low_byte = cpu->a & 0xFF;
-        bool old_carry = cpu->get_flag(CPU::C);
-        cpu->set_flag(CPU::C, (low_byte & 0x01) != 0);
-        low_byte = ((low_byte >> 1) | (old_carry ? 0x80 : 0)) & 0xFF;
-        cpu->a = (cpu->a & 0xFF00) | low_byte;
-        cpu->setZN(low_byte, false);
-    }
-    cpu->cycles = 2;
-}
-
-void CPUInstructions::ror_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    bool old_carry = cpu->get_flag(CPU::C);
-    cpu->set_flag(CPU::C, (value & 0x01) != 0);
-    value = ((value >> 1) | (old_carry ? 0x80 : 0)) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 5;
-}
-
-void CPUInstructions::ror_direct_page_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page_x(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    bool old_carry = cpu->get_flag(CPU::C);
-    cpu->set_flag(CPU::C, (value & 0x01) != 0);
-    value = ((value >> 1) | (old_carry ? 0x80 : 0)) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 6;
-}
-
-void CPUInstructions::ror_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    bool old_carry = cpu->get_flag(CPU::C);
-    cpu->set_flag(CPU::C, (value & 0x01) != 0);
-    value = ((value >> 1) | (old_carry ? 0x80 : 0)) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 6;
-}
-
-void CPUInstructions::ror_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    uint8_t value = cpu->bus->read(addr);
-    bool old_carry = cpu->get_flag(CPU::C);
-    cpu->set_flag(CPU::C, (value & 0x01) != 0);
-    value = ((value >> 1) | (old_carry ? 0x80 : 0)) & 0xFF;
-    cpu->bus->write(addr, value);
-    cpu->setZN(value, false);
-    cpu->cycles = 7;
-}
-
-// Bit Instructions
-void CPUInstructions::bit_immediate(CPU* cpu) {
-    bool is16 = !cpu->get_flag(CPU::M);
-    if (is16) {
-        uint16_t operand;
-        uint16_t lo = cpu->bus->read(cpu->pc++);
-        uint16_t hi = cpu->bus->read(cpu->pc++);
-        operand = (hi << 8) | lo;
-        uint16_t result = cpu->a & operand;
-        cpu->set_flag(CPU::Z, result == 0);
-        cpu->set_flag(CPU::N, (operand & 0x8000) != 0);
-        cpu->set_flag(CPU::V, (operand & 0x4000) != 0);
-        cpu->cycles = 3;
-    } else {
-        uint8_t operand = cpu->bus->read(cpu->pc++);
-        uint8_t result = (cpu->a & 0xFF) & operand;
-        cpu->set_flag(CPU::Z, result == 0);
-        cpu->set_flag(CPU::N, (operand & 0x80) != 0);
-        cpu->set_flag(CPU::V, (operand & 0x40) != 0);
-        cpu->cycles = 2;
-    }
-}
-
-void CPUInstructions::bit_direct_page(CPU* cpu) {
-    uint16_t addr = CPUAddressing::direct_page(cpu);
-    uint8_t operand = cpu->bus->read(addr);
-    uint8_t result = (cpu->a & 0xFF) & operand;
-    cpu->set_flag(CPU::Z, result == 0);
-    cpu->set_flag(CPU::N, (operand & 0x80) != 0);
-    cpu->set_flag(CPU::V, (operand & 0x40) != 0);
-    cpu->cycles = 3;
-}
-
-void CPUInstructions::bit_absolute(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute(cpu);
-    uint8_t operand = cpu->bus->read(addr);
-    uint8_t result = (cpu->a & 0xFF) & operand;
-    cpu->set_flag(CPU::Z, result == 0);
-    cpu->set_flag(CPU::N, (operand & 0x80) != 0);
-    cpu->set_flag(CPU::V, (operand & 0x40) != 0);
-    cpu->cycles = 4;
-}
-
-void CPUInstructions::bit_absolute_x(CPU* cpu) {
-    uint16_t addr = CPUAddressing::absolute_x(cpu);
-    uint8_t operand = cpu->bus->read(addr);
-    uint8_t result = (cpu->a & 0xFF) & operand;
-    cpu->set_flag(CPU::Z, result == 0);
-    cpu->set_flag(CPU::N, (operand & 0x80) != 0);
-    cpu->set_flag(CPU::V, (operand & 0x40) != 0);
-    cpu->cycles = 4;
-}
-
 // Block Move Instructions
-void CPUInstructions::mvp(CPU* cpu) {
-    uint8_t src_bank = cpu->bus->read(cpu->pc++);
-    uint8_t dst_bank = cpu->bus->read(cpu->pc++);
-
-    // Move one byte from source to destination
-    uint32_t src_addr = ((uint32_t)src_bank << 16) | cpu->x;
-    uint32_t dst_addr = ((uint32_t)dst_bank << 16) | cpu->y;
+namespace {
+
+// One MVN (Step = +1) or MVP (Step = -1) call. Each byte is architecturally
+// a separate execution of the instruction (7 cycles, the last one 6), so
+// the call moves as many bytes as the current run has room for and leaves
+// pc on the instruction if any remain; interrupts due at the run's target
+// are then taken between bytes as usual. Spans that stay inside host
+// memory pages are copied directly instead of through the bus.
+template <int Step, bool Wide>
+void move_block(CPU* cpu) {
+    constexpr uint16_t index_mask = Wide ? 0xFFFF : 0x00FF;
+    constexpr uint32_t page_mask = Bus::kPageMask;
+    uint8_t dst_bank = cpu->fetch8();
+    uint8_t src_bank = cpu->fetch8();
+    cpu->db = dst_bank;
+
+    uint64_t count = std::min<uint64_t>((uint64_t)cpu->a + 1, cpu->repeat_budget(7));
+    uint64_t moved = 0;
+    while (moved < count) {
+        uint32_t src = ((uint32_t)src_bank << 16) | cpu->x;
+        uint32_t dst = ((uint32_t)dst_bank << 16) | cpu->y;
+        // Bytes until an address leaves its page or an index register wraps
+        uint64_t span = count - moved;
+        if constexpr (Step > 0) {
+            span = std::min<uint64_t>(span, std::min(page_mask + 1 - (src & page_mask), page_mask + 1 - (dst & page_mask)));
+            span = std::min<uint64_t>(span, std::min(index_mask + 1 - (cpu->x & index_mask), index_mask + 1 - (cpu->y & index_mask)));
+        } else {
+            span = std::min<uint64_t>(span, std::min((src & page_mask) + 1, (dst & page_mask) + 1));
+            span = std::min<uint64_t>(span, std::min((cpu->x & index_mask) + 1, (cpu->y & index_mask) + 1));
+        }
 
-    uint8_t value = cpu->bus->read(src_addr);
-    cpu->bus->write(dst_addr, value);
+        const uint8_t* from = cpu->mem->host_read(src);
+        uint8_t* to = cpu->mem->host_write(dst);
+        if (from && to && span > 1) {
+            // Byte order matters when the ranges overlap: a move towards
+            // the bytes not yet read repeats the leading pattern
+            if constexpr (Step > 0) {
+                if (to > from && to < from + span) {
+                    for (uint64_t i = 0; i < span; ++i) to[i] = from[i];
+                } else {
+                    std::memmove(to, from, span);
+                }
+                cpu->mem->host_written(to, span);
+            } else {
+                const uint8_t* first_from = from - (span - 1);
+                uint8_t* first_to = to - (span - 1);
+                if (to < from && to > first_from) {
+                    for (uint64_t i = 0; i < span; ++i) *(to - i) = *(from - i);
+                } else {
+                    std::memmove(first_to, first_from, span);
+                }
+                cpu->mem->host_written(first_to, span);
+            }
+        } else {
+            span = 1;
+            cpu->mem->write(dst, cpu->mem->read(src));
+        }
 
-    // Decrement counters
-    cpu->x--;
-    cpu->y--;
-    cpu->a--;
+        cpu->x = (cpu->x + Step * (int)span) & index_mask;
+        cpu->y = (cpu->y + Step * (int)span) & index_mask;
+        cpu->a -= (uint16_t)span;
+        moved += span;
+    }
 
+    cpu->charge_repeats(moved - 1, 7);
     // If A is not 0xFFFF, repeat the instruction
     if (cpu->a != 0xFFFF) {
-        cpu->pc -= 3; // Repeat instruction
+        cpu->pc -= 3;
         cpu->cycles = 7;
     } else {
         cpu->cycles = 6;
     }
 }
 
-void CPUInstructions::mvn(CPU* cpu) {
-    uint8_t src_bank = cpu->bus->read(cpu->pc++);
-    uint8_t dst_bank = cpu->bus->read(cpu->pc++);
-
-    // Move one byte from source to destination
-    uint32_t src_addr = ((uint32_t)src_bank << 16) | cpu->x;
-    uint32_t dst_addr = ((uint32_t)dst_bank << 16) | cpu->y;
+} // namespace
 
-    uint8_t value = cpu->bus->read(src_addr);
-    cpu->bus->write(dst_addr, value);
-
-    // Increment counters
-    cpu->x++;
-    cpu->y++;
-    cpu->a--;
+template <bool Wide>
+void CPUInstructions::mvp(CPU* cpu) {
+    move_block<-1, Wide>(cpu);
+}
 
-    // If A is not 0xFFFF, repeat the instruction
-    if (cpu->a != 0xFFFF) {
-        cpu->pc -= 3; // Repeat instruction
-        cpu->cycles = 7;
-    } else {
-        cpu->cycles = 6;
-    }
+template <bool Wide>
+void CPUInstructions::mvn(CPU* cpu) {
+    move_block<1, Wide>(cpu);
+}
+
+// Opcode dispatch tables
+namespace {
+
+// Builds the handler table for one accumulator/index width combination.
+// Width-dependent handlers are instantiated for the matching register size,
+// so they never test the M or X flag at run time.
+template <size_t... Opcodes>
+constexpr CPUInstructions::DispatchTable build_unimplemented_table(std::index_sequence<Opcodes...>) {
+    return {{&CPUInstructions::unimplemented<Opcodes>...}};
+}
+
+// Every opcode's fallback; entries left at these are not implemented
+constexpr CPUInstructions::DispatchTable kUnimplemented =
+    build_unimplemented_table(std::make_index_sequence<256>());
+
+template <bool M16, bool X16>
+constexpr CPUInstructions::DispatchTable build_dispatch_table() {
+    CPUInstructions::DispatchTable t = kUnimplemented;
+
+    // BRK - Break
+    t[0x00] = &CPUInstructions::brk;
+    // NOP - No Operation
+    t[0xEA] = &CPUInstructions::nop;
+    // SEI - Set Interrupt Disable
+    t[0x78] = &CPUInstructions::sei;
+    // CLI - Clear Interrupt Disable
+    t[0x58] = &CPUInstructions::cli;
+    // CLC - Clear Carry
+    t[0x18] = &CPUInstructions::clc;
+    // SEC - Set Carry
+    t[0x38] = &CPUInstructions::sec;
+    // CLD - Clear Decimal
+    t[0xD8] = &CPUInstructions::cld;
+    // SED - Set Decimal
+    t[0xF8] = &CPUInstructions::sed;
+    // CLV - Clear Overflow
+    t[0xB8] = &CPUInstructions::clv;
+    // JMP - Jump Instructions
+    t[0x4C] = &CPUInstructions::jmp_absolute;  // JMP Absolute
+    t[0x5C] = &CPUInstructions::jmp_absolute_long;  // JMP Absolute Long
+    t[0x6C] = &CPUInstructions::jmp_absolute_indirect;  // JMP Indirect
+    t[0xDC] = &CPUInstructions::jmp_absolute_indirect_long;  // JMP Indirect Long
+    t[0x7C] = &CPUInstructions::jmp_absolute_indirect_x;  // JMP Indexed Indirect
+    // JSR - Jump to Subroutine
+    t[0x20] = &CPUInstructions::jsr;  // JSR Absolute
+    t[0x22] = &CPUInstructions::jsr_absolute_long;  // JSR Absolute Long
+    // RTS/RTL - Return from Subroutine
+    t[0x60] = &CPUInstructions::rts;  // RTS
+    t[0x6B] = &CPUInstructions::rtl;  // RTL
+    // RTI - Return from Interrupt
+    t[0x40] = &CPUInstructions::rti;
+    // WAI/STP - Wait for Interrupt, Stop
+    t[0xCB] = &CPUInstructions::wai;
+    t[0xDB] = &CPUInstructions::stp;
+    // LDA - Load Accumulator
+    t[0xA9] = &CPUInstructions::read_op<Lda, Immediate, M16, 0xA9>;  // Immediate
+    t[0xA5] = &CPUInstructions::read_op<Lda, DirectPage, M16, 0xA5>;  // Direct Page
+    t[0xB5] = &CPUInstructions::read_op<Lda, DirectPageX, M16, 0xB5>;  // Direct Page, X
+    t[0xAD] = &CPUInstructions::read_op<Lda, Absolute, M16, 0xAD>;  // Absolute
+    t[0xBD] = &CPUInstructions::read_op<Lda, AbsoluteX, M16, 0xBD>;  // Absolute, X
+    t[0xB9] = &CPUInstructions::read_op<Lda, AbsoluteY, M16, 0xB9>;  // Absolute, Y
+    t[0xA1] = &CPUInstructions::read_op<Lda, DPIndirectX, M16, 0xA1>;  // (Direct Page, X)
+    t[0xB1] = &CPUInstructions::read_op<Lda, DPIndirectY, M16, 0xB1>;  // (Direct Page), Y
+    t[0xB2] = &CPUInstructions::read_op<Lda, DPIndirect, M16, 0xB2>;  // (Direct Page)
+    t[0xA7] = &CPUInstructions::read_op<Lda, DPIndirectLong, M16, 0xA7>;  // [Direct Page]
+    t[0xB7] = &CPUInstructions::read_op<Lda, DPIndirectLongY, M16, 0xB7>;  // [Direct Page], Y
+    t[0xAF] = &CPUInstructions::read_op<Lda, AbsoluteLong, M16, 0xAF>;  // Absolute Long
+    t[0xBF] = &CPUInstructions::read_op<Lda, AbsoluteLongX, M16, 0xBF>;  // Absolute Long, X
+    t[0xA3] = &CPUInstructions::read_op<Lda, StackRelative, M16, 0xA3>;  // Stack Relative
+    t[0xB3] = &CPUInstructions::read_op<Lda, SRIndirectY, M16, 0xB3>;  // Stack Relative Indirect, Y
+    // STA - Store Accumulator
+    t[0x85] = &CPUInstructions::sta<DirectPage, M16, 0x85>;  // Direct Page
+    t[0x95] = &CPUInstructions::sta<DirectPageX, M16, 0x95>;  // Direct Page, X
+    t[0x8D] = &CPUInstructions::sta<Absolute, M16, 0x8D>;  // Absolute
+    t[0x9D] = &CPUInstructions::sta<AbsoluteX, M16, 0x9D>;  // Absolute, X
+    t[0x99] = &CPUInstructions::sta<AbsoluteY, M16, 0x99>;  // Absolute, Y
+    t[0x81] = &CPUInstructions::sta<DPIndirectX, M16, 0x81>;  // (Direct Page, X)
+    t[0x91] = &CPUInstructions::sta<DPIndirectY, M16, 0x91>;  // (Direct Page), Y
+    t[0x92] = &CPUInstructions::sta<DPIndirect, M16, 0x92>;  // (Direct Page)
+    t[0x87] = &CPUInstructions::sta<DPIndirectLong, M16, 0x87>;  // [Direct Page]
+    t[0x97] = &CPUInstructions::sta<DPIndirectLongY, M16, 0x97>;  // [Direct Page], Y
+    t[0x8F] = &CPUInstructions::sta<AbsoluteLong, M16, 0x8F>;  // Absolute Long
+    t[0x9F] = &CPUInstructions::sta<AbsoluteLongX, M16, 0x9F>;  // Absolute Long, X
+    t[0x83] = &CPUInstructions::sta<StackRelative, M16, 0x83>;  // Stack Relative
+    t[0x93] = &CPUInstructions::sta<SRIndirectY, M16, 0x93>;  // Stack Relative Indirect, Y
+    // LDX/LDY - Load Index Registers
+    t[0xA2] = &CPUInstructions::read_op<Ldx, Immediate, X16, 0xA2>;  // Immediate
+    t[0xA6] = &CPUInstructions::read_op<Ldx, DirectPage, X16, 0xA6>;  // Direct Page
+    t[0xB6] = &CPUInstructions::read_op<Ldx, DirectPageY, X16, 0xB6>;  // Direct Page, Y
+    t[0xAE] = &CPUInstructions::read_op<Ldx, Absolute, X16, 0xAE>;  // Absolute
+    t[0xBE] = &CPUInstructions::read_op<Ldx, AbsoluteY, X16, 0xBE>;  // Absolute, Y
+    t[0xA0] = &CPUInstructions::read_op<Ldy, Immediate, X16, 0xA0>;  // Immediate
+    t[0xA4] = &CPUInstructions::read_op<Ldy, DirectPage, X16, 0xA4>;  // Direct Page
+    t[0xB4] = &CPUInstructions::read_op<Ldy, DirectPageX, X16, 0xB4>;  // Direct Page, X
+    t[0xAC] = &CPUInstructions::read_op<Ldy, Absolute, X16, 0xAC>;  // Absolute
+    t[0xBC] = &CPUInstructions::read_op<Ldy, AbsoluteX, X16, 0xBC>;  // Absolute, X
+    // STX/STY/STZ - Store Index Registers, Store Zero
+    t[0x86] = &CPUInstructions::store_op<Stx, DirectPage, X16, 0x86>;  // Direct Page
+    t[0x96] = &CPUInstructions::store_op<Stx, DirectPageY, X16, 0x96>;  // Direct Page, Y
+    t[0x8E] = &CPUInstructions::store_op<Stx, Absolute, X16, 0x8E>;  // Absolute
+    t[0x84] = &CPUInstructions::store_op<Sty, DirectPage, X16, 0x84>;  // Direct Page
+    t[0x94] = &CPUInstructions::store_op<Sty, DirectPageX, X16, 0x94>;  // Direct Page, X
+    t[0x8C] = &CPUInstructions::store_op<Sty, Absolute, X16, 0x8C>;  // Absolute
+    t[0x64] = &CPUInstructions::store_op<Stz, DirectPage, M16, 0x64>;  // Direct Page
+    t[0x74] = &CPUInstructions::store_op<Stz, DirectPageX, M16, 0x74>;  // Direct Page, X
+    t[0x9C] = &CPUInstructions::store_op<Stz, Absolute, M16, 0x9C>;  // Absolute
+    t[0x9E] = &CPUInstructions::store_op<Stz, AbsoluteX, M16, 0x9E>;  // Absolute, X
+    // Transfer Instructions
+    t[0xAA] = &CPUInstructions::tax<X16>;  // TAX - Transfer Accumulator to X
+    t[0x8A] = &CPUInstructions::txa<M16>;  // TXA - Transfer X to Accumulator
+    t[0xA8] = &CPUInstructions::tay<X16>;  // TAY - Transfer Accumulator to Y
+    t[0x98] = &CPUInstructions::tya<M16>;  // TYA - Transfer Y to Accumulator
+    t[0xBA] = &CPUInstructions::tsx<X16>;  // TSX - Transfer Stack Pointer to X
+    t[0x9A] = &CPUInstructions::txs<X16>;  // TXS - Transfer X to Stack Pointer
+    t[0x9B] = &CPUInstructions::txy<X16>;  // TXY - Transfer X to Y
+    t[0xBB] = &CPUInstructions::tyx<X16>;  // TYX - Transfer Y to X
+    t[0x5B] = &CPUInstructions::tcd;  // TCD - Transfer Accumulator to Direct Page
+    t[0x7B] = &CPUInstructions::tdc<M16>;  // TDC - Transfer Direct Page to Accumulator
+    t[0x3B] = &CPUInstructions::tsc<M16>;  // TSC - Transfer Stack Pointer to Accumulator
+    t[0x1B] = &CPUInstructions::tcs<X16>;  // TCS - Transfer Accumulator to Stack Pointer
+    t[0xEB] = &CPUInstructions::xba;  // XBA - Exchange B and A
+    t[0xFB] = &CPUInstructions::xce;  // XCE - Exchange Carry and Emulation
+    t[0xC2] = &CPUInstructions::rep;  // REP - Reset Status Bits
+    t[0xE2] = &CPUInstructions::sep;  // SEP - Set Status Bits
+    // Stack Instructions
+    t[0x48] = &CPUInstructions::pha<M16>;  // PHA - Push Accumulator
+    t[0x68] = &CPUInstructions::pla<M16>;  // PLA - Pull Accumulator
+    t[0xDA] = &CPUInstructions::phx<X16>;  // PHX - Push X
+    t[0xFA] = &CPUInstructions::plx<X16>;  // PLX - Pull X
+    t[0x5A] = &CPUInstructions::phy<X16>;  // PHY - Push Y
+    t[0x7A] = &CPUInstructions::ply<X16>;  // PLY - Pull Y
+    t[0x08] = &CPUInstructions::php;  // PHP - Push Processor Status
+    t[0x28] = &CPUInstructions::plp;  // PLP - Pull Processor Status
+    t[0x0B] = &CPUInstructions::phd;  // PHD - Push Direct Page
+    t[0x2B] = &CPUInstructions::pld;  // PLD - Pull Direct Page
+    t[0x4B] = &CPUInstructions::phk;  // PHK - Push Program Bank
+    t[0xAB] = &CPUInstructions::plk;  // PLK - Pull Program Bank
+    t[0xF4] = &CPUInstructions::pea;  // PEA - Push Effective Address
+    t[0xD4] = &CPUInstructions::pei;  // PEI - Push Effective Indirect Address
+    t[0x62] = &CPUInstructions::per;  // PER - Push Effective PC Relative Address
+    // ADC - Add with Carry
+    t[0x69] = &CPUInstructions::read_op<Adc, Immediate, M16, 0x69>;  // Immediate
+    t[0x65] = &CPUInstructions::read_op<Adc, DirectPage, M16, 0x65>;  // Direct Page
+    t[0x75] = &CPUInstructions::read_op<Adc, DirectPageX, M16, 0x75>;  // Direct Page, X
+    t[0x6D] = &CPUInstructions::read_op<Adc, Absolute, M16, 0x6D>;  // Absolute
+    t[0x7D] = &CPUInstructions::read_op<Adc, AbsoluteX, M16, 0x7D>;  // Absolute, X
+    t[0x79] = &CPUInstructions::read_op<Adc, AbsoluteY, M16, 0x79>;  // Absolute, Y
+    t[0x61] = &CPUInstructions::read_op<Adc, DPIndirectX, M16, 0x61>;  // (Direct Page, X)
+    t[0x71] = &CPUInstructions::read_op<Adc, DPIndirectY, M16, 0x71>;  // (Direct Page), Y
+    t[0x72] = &CPUInstructions::read_op<Adc, DPIndirect, M16, 0x72>;  // (Direct Page)
+    t[0x67] = &CPUInstructions::read_op<Adc, DPIndirectLong, M16, 0x67>;  // [Direct Page]
+    t[0x77] = &CPUInstructions::read_op<Adc, DPIndirectLongY, M16, 0x77>;  // [Direct Page], Y
+    // SBC - Subtract with Carry
+    t[0xE9] = &CPUInstructions::read_op<Sbc, Immediate, M16, 0xE9>;  // Immediate
+    t[0xE5] = &CPUInstructions::read_op<Sbc, DirectPage, M16, 0xE5>;  // Direct Page
+    t[0xF5] = &CPUInstructions::read_op<Sbc, DirectPageX, M16, 0xF5>;  // Direct Page, X
+    t[0xED] = &CPUInstructions::read_op<Sbc, Absolute, M16, 0xED>;  // Absolute
+    t[0xFD] = &CPUInstructions::read_op<Sbc, AbsoluteX, M16, 0xFD>;  // Absolute, X
+    t[0xF9] = &CPUInstructions::read_op<Sbc, AbsoluteY, M16, 0xF9>;  // Absolute, Y
+    t[0xE1] = &CPUInstructions::read_op<Sbc, DPIndirectX, M16, 0xE1>;  // (Direct Page, X)
+    t[0xF1] = &CPUInstructions::read_op<Sbc, DPIndirectY, M16, 0xF1>;  // (Direct Page), Y
+    t[0xF2] = &CPUInstructions::read_op<Sbc, DPIndirect, M16, 0xF2>;  // (Direct Page)
+    t[0xE7] = &CPUInstructions::read_op<Sbc, DPIndirectLong, M16, 0xE7>;  // [Direct Page]
+    t[0xF7] = &CPUInstructions::read_op<Sbc, DPIndirectLongY, M16, 0xF7>;  // [Direct Page], Y
+    // INC - Increment
+    t[0x1A] = &CPUInstructions::modify_op<Inc, Accumulator, M16, 0x1A>;  // Accumulator
+    t[0xE6] = &CPUInstructions::modify_op<Inc, DirectPage, M16, 0xE6>;  // Direct Page
+    t[0xF6] = &CPUInstructions::modify_op<Inc, DirectPageX, M16, 0xF6>;  // Direct Page, X
+    t[0xEE] = &CPUInstructions::modify_op<Inc, Absolute, M16, 0xEE>;  // Absolute
+    t[0xFE] = &CPUInstructions::modify_op<Inc, AbsoluteX, M16, 0xFE>;  // Absolute, X
+    t[0xE8] = &CPUInstructions::modify_op<Inc, IndexX, X16, 0xE8>;  // INX
+    t[0xC8] = &CPUInstructions::modify_op<Inc, IndexY, X16, 0xC8>;  // INY
+    // DEC - Decrement
+    t[0x3A] = &CPUInstructions::modify_op<Dec, Accumulator, M16, 0x3A>;  // Accumulator
+    t[0xC6] = &CPUInstructions::modify_op<Dec, DirectPage, M16, 0xC6>;  // Direct Page
+    t[0xD6] = &CPUInstructions::modify_op<Dec, DirectPageX, M16, 0xD6>;  // Direct Page, X
+    t[0xCE] = &CPUInstructions::modify_op<Dec, Absolute, M16, 0xCE>;  // Absolute
+    t[0xDE] = &CPUInstructions::modify_op<Dec, AbsoluteX, M16, 0xDE>;  // Absolute, X
+    t[0xCA] = &CPUInstructions::modify_op<Dec, IndexX, X16, 0xCA>;  // DEX
+    t[0x88] = &CPUInstructions::modify_op<Dec, IndexY, X16, 0x88>;  // DEY
+    // CMP - Compare Accumulator
+    t[0xC9] = &CPUInstructions::read_op<Cmp, Immediate, M16, 0xC9>;  // Immediate
+    t[0xC5] = &CPUInstructions::read_op<Cmp, DirectPage, M16, 0xC5>;  // Direct Page
+    t[0xD5] = &CPUInstructions::read_op<Cmp, DirectPageX, M16, 0xD5>;  // Direct Page, X
+    t[0xCD] = &CPUInstructions::read_op<Cmp, Absolute, M16, 0xCD>;  // Absolute
+    t[0xDD] = &CPUInstructions::read_op<Cmp, AbsoluteX, M16, 0xDD>;  // Absolute, X
+    t[0xD9] = &CPUInstructions::read_op<Cmp, AbsoluteY, M16, 0xD9>;  // Absolute, Y
+    t[0xC1] = &CPUInstructions::read_op<Cmp, DPIndirectX, M16, 0xC1>;  // (Direct Page, X)
+    t[0xD1] = &CPUInstructions::read_op<Cmp, DPIndirectY, M16, 0xD1>;  // (Direct Page), Y
+    t[0xD2] = &CPUInstructions::read_op<Cmp, DPIndirect, M16, 0xD2>;  // (Direct Page)
+    t[0xC7] = &CPUInstructions::read_op<Cmp, DPIndirectLong, M16, 0xC7>;  // [Direct Page]
+    t[0xD7] = &CPUInstructions::read_op<Cmp, DPIndirectLongY, M16, 0xD7>;  // [Direct Page], Y
+    t[0xCF] = &CPUInstructions::read_op<Cmp, AbsoluteLong, M16, 0xCF>;  // Absolute Long
+    t[0xDF] = &CPUInstructions::read_op<Cmp, AbsoluteLongX, M16, 0xDF>;  // Absolute Long, X
+    t[0xC3] = &CPUInstructions::read_op<Cmp, StackRelative, M16, 0xC3>;  // Stack Relative
+    t[0xD3] = &CPUInstructions::read_op<Cmp, SRIndirectY, M16, 0xD3>;  // Stack Relative Indirect, Y
+    // CPX - Compare X Register
+    t[0xE0] = &CPUInstructions::read_op<Cpx, Immediate, X16, 0xE0>;  // Immediate
+    t[0xE4] = &CPUInstructions::read_op<Cpx, DirectPage, X16, 0xE4>;  // Direct Page
+    t[0xEC] = &CPUInstructions::read_op<Cpx, Absolute, X16, 0xEC>;  // Absolute
+    // CPY - Compare Y Register
+    t[0xC0] = &CPUInstructions::read_op<Cpy, Immediate, X16, 0xC0>;  // Immediate
+    t[0xC4] = &CPUInstructions::read_op<Cpy, DirectPage, X16, 0xC4>;  // Direct Page
+    t[0xCC] = &CPUInstructions::read_op<Cpy, Absolute, X16, 0xCC>;  // Absolute
+    // AND - Logical AND
+    t[0x29] = &CPUInstructions::read_op<And, Immediate, M16, 0x29>;  // Immediate
+    t[0x25] = &CPUInstructions::read_op<And, DirectPage, M16, 0x25>;  // Direct Page
+    t[0x35] = &CPUInstructions::read_op<And, DirectPageX, M16, 0x35>;  // Direct Page, X
+    t[0x2D] = &CPUInstructions::read_op<And, Absolute, M16, 0x2D>;  // Absolute
+    t[0x3D] = &CPUInstructions::read_op<And, AbsoluteX, M16, 0x3D>;  // Absolute, X
+    t[0x39] = &CPUInstructions::read_op<And, AbsoluteY, M16, 0x39>;  // Absolute, Y
+    t[0x21] = &CPUInstructions::read_op<And, DPIndirectX, M16, 0x21>;  // (Direct Page, X)
+    t[0x31] = &CPUInstructions::read_op<And, DPIndirectY, M16, 0x31>;  // (Direct Page), Y
+    t[0x32] = &CPUInstructions::read_op<And, DPIndirect, M16, 0x32>;  // (Direct Page)
+    t[0x27] = &CPUInstructions::read_op<And, DPIndirectLong, M16, 0x27>;  // [Direct Page]
+    t[0x37] = &CPUInstructions::read_op<And, DPIndirectLongY, M16, 0x37>;  // [Direct Page], Y
+    // ORA - Logical OR
+    t[0x09] = &CPUInstructions::read_op<Ora, Immediate, M16, 0x09>;  // Immediate
+    t[0x05] = &CPUInstructions::read_op<Ora, DirectPage, M16, 0x05>;  // Direct Page
+    t[0x15] = &CPUInstructions::read_op<Ora, DirectPageX, M16, 0x15>;  // Direct Page, X
+    t[0x0D] = &CPUInstructions::read_op<Ora, Absolute, M16, 0x0D>;  // Absolute
+    t[0x1D] = &CPUInstructions::read_op<Ora, AbsoluteX, M16, 0x1D>;  // Absolute, X
+    t[0x19] = &CPUInstructions::read_op<Ora, AbsoluteY, M16, 0x19>;  // Absolute, Y
+    t[0x01] = &CPUInstructions::read_op<Ora, DPIndirectX, M16, 0x01>;  // (Direct Page, X)
+    t[0x11] = &CPUInstructions::read_op<Ora, DPIndirectY, M16, 0x11>;  // (Direct Page), Y
+    t[0x12] = &CPUInstructions::read_op<Ora, DPIndirect, M16, 0x12>;  // (Direct Page)
+    t[0x07] = &CPUInstructions::read_op<Ora, DPIndirectLong, M16, 0x07>;  // [Direct Page]
+    t[0x17] = &CPUInstructions::read_op<Ora, DPIndirectLongY, M16, 0x17>;  // [Direct Page], Y
+    // EOR - Logical XOR
+    t[0x49] = &CPUInstructions::read_op<Eor, Immediate, M16, 0x49>;  // Immediate
+    t[0x45] = &CPUInstructions::read_op<Eor, DirectPage, M16, 0x45>;  // Direct Page
+    t[0x55] = &CPUInstructions::read_op<Eor, DirectPageX, M16, 0x55>;  // Direct Page, X
+    t[0x4D] = &CPUInstructions::read_op<Eor, Absolute, M16, 0x4D>;  // Absolute
+    t[0x5D] = &CPUInstructions::read_op<Eor, AbsoluteX, M16, 0x5D>;  // Absolute, X
+    t[0x59] = &CPUInstructions::read_op<Eor, AbsoluteY, M16, 0x59>;  // Absolute, Y
+    t[0x41] = &CPUInstructions::read_op<Eor, DPIndirectX, M16, 0x41>;  // (Direct Page, X)
+    t[0x51] = &CPUInstructions::read_op<Eor, DPIndirectY, M16, 0x51>;  // (Direct Page), Y
+    t[0x52] = &CPUInstructions::read_op<Eor, DPIndirect, M16, 0x52>;  // (Direct Page)
+    t[0x47] = &CPUInstructions::read_op<Eor, DPIndirectLong, M16, 0x47>;  // [Direct Page]
+    t[0x57] = &CPUInstructions::read_op<Eor, DPIndirectLongY, M16, 0x57>;  // [Direct Page], Y
+    // Branch Instructions
+    t[0x90] = &CPUInstructions::bcc;  // BCC - Branch if Carry Clear
+    t[0xB0] = &CPUInstructions::bcs;  // BCS - Branch if Carry Set
+    t[0xF0] = &CPUInstructions::beq;  // BEQ - Branch if Equal
+    t[0xD0] = &CPUInstructions::bne;  // BNE - Branch if Not Equal
+    t[0x30] = &CPUInstructions::bmi;  // BMI - Branch if Minus
+    t[0x10] = &CPUInstructions::bpl;  // BPL - Branch if Plus
+    t[0x50] = &CPUInstructions::bvc;  // BVC - Branch if Overflow Clear
+    t[0x70] = &CPUInstructions::bvs;  // BVS - Branch if Overflow Set
+    t[0x80] = &CPUInstructions::bra;  // BRA - Branch Always
+    t[0x82] = &CPUInstructions::brl;  // BRL - Branch Always Long
+    // Shift and Rotate Instructions
+    // ASL - Arithmetic Shift Left
+    t[0x0A] = &CPUInstructions::modify_op<Asl, Accumulator, M16, 0x0A>;  // Accumulator
+    t[0x06] = &CPUInstructions::modify_op<Asl, DirectPage, false, 0x06>;  // Direct Page
+    t[0x16] = &CPUInstructions::modify_op<Asl, DirectPageX, false, 0x16>;  // Direct Page, X
+    t[0x0E] = &CPUInstructions::modify_op<Asl, Absolute, false, 0x0E>;  // Absolute
+    t[0x1E] = &CPUInstructions::modify_op<Asl, AbsoluteX, false, 0x1E>;  // Absolute, X
+    // LSR - Logical Shift Right
+    t[0x4A] = &CPUInstructions::modify_op<Lsr, Accumulator, M16, 0x4A>;  // Accumulator
+    t[0x46] = &CPUInstructions::modify_op<Lsr, DirectPage, false, 0x46>;  // Direct Page
+    t[0x56] = &CPUInstructions::modify_op<Lsr, DirectPageX, false, 0x56>;  // Direct Page, X
+    t[0x4E] = &CPUInstructions::modify_op<Lsr, Absolute, false, 0x4E>;  // Absolute
+    t[0x5E] = &CPUInstructions::modify_op<Lsr, AbsoluteX, false, 0x5E>;  // Absolute, X
+    // ROL - Rotate Left
+    t[0x2A] = &CPUInstructions::modify_op<Rol, Accumulator, M16, 0x2A>;  // Accumulator
+    t[0x26] = &CPUInstructions::modify_op<Rol, DirectPage, false, 0x26>;  // Direct Page
+    t[0x36] = &CPUInstructions::modify_op<Rol, DirectPageX, false, 0x36>;  // Direct Page, X
+    t[0x2E] = &CPUInstructions::modify_op<Rol, Absolute, false, 0x2E>;  // Absolute
+    t[0x3E] = &CPUInstructions::modify_op<Rol, AbsoluteX, false, 0x3E>;  // Absolute, X
+    // ROR - Rotate Right
+    t[0x6A] = &CPUInstructions::modify_op<Ror, Accumulator, M16, 0x6A>;  // Accumulator
+    t[0x66] = &CPUInstructions::modify_op<Ror, DirectPage, false, 0x66>;  // Direct Page
+    t[0x76] = &CPUInstructions::modify_op<Ror, DirectPageX, false, 0x76>;  // Direct Page, X
+    t[0x6E] = &CPUInstructions::modify_op<Ror, Absolute, false, 0x6E>;  // Absolute
+    t[0x7E] = &CPUInstructions::modify_op<Ror, AbsoluteX, false, 0x7E>;  // Absolute, X
+    // Bit Instructions
+    t[0x89] = &CPUInstructions::read_op<Bit, Immediate, M16, 0x89>;  // Immediate
+    t[0x24] = &CPUInstructions::read_op<Bit, DirectPage, false, 0x24>;  // Direct Page
+    t[0x2C] = &CPUInstructions::read_op<Bit, Absolute, false, 0x2C>;  // Absolute
+    t[0x3C] = &CPUInstructions::read_op<Bit, AbsoluteX, false, 0x3C>;  // Absolute, X
+    // Block Move Instructions
+    t[0x44] = &CPUInstructions::mvp<X16>;  // MVP - Move Positive
+    t[0x54] = &CPUInstructions::mvn<X16>;  // MVN - Move Negative
+
+    return t;
+}
+
+// Indexed by CPUInstructions::width_mode(); emulation mode always runs
+// with 8-bit accumulator and index registers.
+constexpr std::array<CPUInstructions::DispatchTable, CPUInstructions::kWidthModes> kDispatchTables = {
+    build_dispatch_table<true, true>(),   // E=0 M=0 X=0
+    build_dispatch_table<true, false>(),  // E=0 M=0 X=1
+    build_dispatch_table<false, true>(),  // E=0 M=1 X=0
+    build_dispatch_table<false, false>(), // E=0 M=1 X=1
+    build_dispatch_table<false, false>(), // E=1
+    build_dispatch_table<false, false>(), // E=1
+    build_dispatch_table<false, false>(), // E=1
+    build_dispatch_table<false, false>(), // E=1
+};
+
+} // namespace
+
+const CPUInstructions::DispatchTable& CPUInstructions::dispatch_table(uint8_t mode) {
+    return kDispatchTables[mode & (kWidthModes - 1)];
+}
+
+// Every width mode has a handler for the same opcodes
+bool CPUInstructions::is_implemented(uint8_t opcode) {
+    return kDispatchTables[0][opcode] != kUnimplemented[opcode];
 }
@@ -0,0 +1,330 @@
+#include "../include/cpu_jit.hpp"
+
+#ifdef PYSNES_JIT
+
+#include <cstring>
+#include <sys/mman.h>
+#include "../include/bus.hpp"
+#include "../include/cpu.hpp"
+#include "../include/cpu_instructions.hpp"
+#include "../include/cpu_opcodes.hpp"
+
+static_assert(offsetof(CPURunState, cycles) == 0, "native blocks address CPURunState fields directly");
+static_assert(offsetof(CPURunState, instructions) == 8, "native blocks address CPURunState fields directly");
+static_assert(offsetof(CPURunState, cycle_target) == 16, "native blocks address CPURunState fields directly");
+static_assert(offsetof(CPURunState, instruction_target) == 24, "native blocks address CPURunState fields directly");
+
+namespace {
+
+// Minimal x86-64 emitter for the handful of encodings blocks use.
+// Register use: rbx = CPU*, r12 = CPURunState*, eax = return index.
+struct Emitter {
+    std::vector<uint8_t> code;
+    std::vector<size_t> exits;      // rel32 fields to patch to the epilogue
+
+    void bytes(std::initializer_list<uint8_t> b) { code.insert(code.end(), b); }
+    void u16(uint16_t v) { for (int i = 0; i < 2; ++i) code.push_back(v >> (8 * i)); }
+    void u32(uint32_t v) { for (int i = 0; i < 4; ++i) code.push_back(v >> (8 * i)); }
+    void u64(uint64_t v) { for (int i = 0; i < 8; ++i) code.push_back(v >> (8 * i)); }
+
+    // jcc rel32 to the epilogue
+    void exit_if(uint8_t cc) {
+        bytes({0x0F, cc});
+        exits.push_back(code.size());
+        u32(0);
+    }
+
+    // jcc (or jmp with cc 0) rel32 to a label bound later
+    size_t jump(uint8_t cc) {
+        if (cc) {
+            bytes({0x0F, cc});
+        } else {
+            bytes({0xE9});
+        }
+        u32(0);
+        return code.size() - 4;
+    }
+    void bind(size_t at) {
+        uint32_t rel = (uint32_t)(code.size() - (at + 4));
+        std::memcpy(&code[at], &rel, 4);
+    }
+};
+
+constexpr uint8_t kJae = 0x83;
+constexpr uint8_t kJe = 0x84;
+constexpr uint8_t kJne = 0x85;
+
+// Instructions that only set or clear a status flag are emitted inline
+struct FlagOp {
+    CPUInstructions::Handler handler;
+    uint16_t flag;
+    bool set;
+};
+
+const FlagOp kFlagOps[] = {
+    {&CPUInstructions::sec, CPU::C, true},  {&CPUInstructions::clc, CPU::C, false},
+    {&CPUInstructions::sei, CPU::I, true},  {&CPUInstructions::cli, CPU::I, false},
+    {&CPUInstructions::sed, CPU::D, true},  {&CPUInstructions::cld, CPU::D, false},
+    {&CPUInstructions::clv, CPU::V, false},
+};
+
+const FlagOp* find_flag_op(CPUInstructions::Handler handler) {
+    for (const FlagOp& op : kFlagOps) {
+        if (op.handler == handler) return &op;
+    }
+    return nullptr;
+}
+
+// Direct page and absolute loads and stores. Their handlers address bank 0
+// with the raw operand, so the page is known when the block is compiled.
+struct MemoryOp {
+    uint8_t opcode;
+    int32_t CPUJit::Layout::*reg;   // Null for STZ
+    bool load;
+    bool index;                     // Width follows X rather than M
+};
+
+using L = CPUJit::Layout;
+const MemoryOp kMemoryOps[] = {
+    {0xA5, &L::a, true, false},  {0xAD, &L::a, true, false},
+    {0xA6, &L::x, true, true},   {0xAE, &L::x, true, true},
+    {0xA4, &L::y, true, true},   {0xAC, &L::y, true, true},
+    {0x85, &L::a, false, false}, {0x8D, &L::a, false, false},
+    {0x86, &L::x, false, true},  {0x8E, &L::x, false, true},
+    {0x84, &L::y, false, true},  {0x8C, &L::y, false, true},
+    {0x64, nullptr, false, false}, {0x9C, nullptr, false, false},
+};
+
+const MemoryOp* find_memory_op(uint8_t opcode) {
+    for (const MemoryOp& op : kMemoryOps) {
+        if (op.opcode == opcode) return &op;
+    }
+    return nullptr;
+}
+
+// Set PC and the operand pointer, then call the handler
+void emit_call(Emitter& e, const CPUJit::Layout& l, const CPUBlockCache::Instruction& insn) {
+    e.bytes({0xC7, 0x83}); e.u32(l.pc); e.u32(insn.pc + 1);     // mov dword [rbx+pc], pc + 1
+    e.bytes({0xC6, 0x83}); e.u32(l.cycles); e.bytes({0});       // mov byte [rbx+cycles], 0
+    e.bytes({0x48, 0xB8}); e.u64((uint64_t)insn.operands);      // mov rax, operands
+    e.bytes({0x48, 0x89, 0x83}); e.u32(l.fetch_ptr);            // mov [rbx+fetch_ptr], rax
+    e.bytes({0x48, 0x89, 0xDF});                                // mov rdi, rbx
+    e.bytes({0x48, 0xB8}); e.u64((uint64_t)insn.handler);       // mov rax, handler
+    e.bytes({0xFF, 0xD0});                                      // call rax
+}
+
+// Checks that the next instruction can run: the block is still valid, the
+// width mode is unchanged and execution fell through to pc
+void emit_checks(Emitter& e, const CPUJit::Layout& l, const CPUBlockCache::Block& block, uint32_t pc) {
+    e.bytes({0x48, 0xBE}); e.u64((uint64_t)&block.valid);       // mov rsi, &block.valid
+    e.bytes({0x80, 0x3E, 0x00});                                // cmp byte [rsi], 0
+    e.exit_if(kJe);
+    e.bytes({0x80, 0xBB}); e.u32(l.dispatch_mode); e.bytes({block.mode});  // cmp byte [rbx+dispatch_mode], mode
+    e.exit_if(kJne);
+    e.bytes({0x81, 0xBB}); e.u32(l.pc); e.u32(pc);             // cmp dword [rbx+pc], pc
+    e.exit_if(kJne);
+}
+
+// Bus memory that native code reads in place: the data pointers of the
+// page tables, and WRAM with its cached-code flags
+struct HostMemory {
+    const char* read_slots;
+    const char* write_slots;
+    size_t read_stride;
+    size_t write_stride;
+    const uint8_t* wram;
+    size_t wram_size;
+    const bool* code_pages;
+};
+
+// The host page backing the address is looked up when the block runs, so
+// remapping the bus needs no recompile; a null page means MMIO and takes
+// the handler. Stores also take it when the WRAM they hit holds cached
+// code, which notifies the block cache. A 16-bit access whose bytes fall
+// in different pages, or a store split across code pages, always uses the
+// handler.
+bool emit_memory_op(Emitter& e, const CPUJit::Layout& l, const MemoryOp& op, const CPUBlockCache::Block& block,
+                    size_t index, const HostMemory& host) {
+    const CPUBlockCache::Instruction& insn = block.instructions[index];
+    const OpcodeInfo& info = CPUOpcodes::kTable[op.opcode];
+    bool absolute = info.mode == AddrMode::Absolute;
+    uint16_t addr = absolute ? (uint16_t)(insn.operands[0] | (insn.operands[1] << 8)) : insn.operands[0];
+    // Width mode bits: X = 1, M = 2, E = 4
+    bool wide = block.mode < 4 && (block.mode & (op.index ? 1 : 2)) == 0;
+    uint32_t offset = addr & Bus::kPageMask;
+    if (wide && (offset == Bus::kPageMask || (!op.load && (addr & 0xFF) == 0xFF))) {
+        return false;
+    }
+    uint8_t cycles = wide ? info.cycles_wide : info.cycles;
+    uint32_t next_pc = insn.pc + (absolute ? 3 : 2);
+
+    int page = addr >> Bus::kPageBits;
+    const void* slot = op.load ? host.read_slots + page * host.read_stride
+                               : host.write_slots + page * host.write_stride;
+    e.bytes({0x48, 0xBE}); e.u64((uint64_t)slot);               // mov rsi, &page.data
+    e.bytes({0x48, 0x8B, 0x36});                                // mov rsi, [rsi]
+    e.bytes({0x48, 0x85, 0xF6});                                // test rsi, rsi
+    size_t to_handler = e.jump(kJe);
+    size_t to_handler_code = 0;
+
+    if (op.load) {
+        e.bytes({0x0F, (uint8_t)(wide ? 0xB7 : 0xB6), 0x86}); e.u32(offset);  // movzx eax, [rsi+offset]
+        e.bytes({0x66, 0x89, 0x83}); e.u32(l.*op.reg);          // mov [rbx+reg], ax
+        if (!wide) {
+            e.bytes({0xC1, 0xE0, 0x08});                        // shl eax, 8
+        }
+        e.bytes({0x66, 0x89, 0x83}); e.u32(l.nz_result);        // mov [rbx+nz_result], ax
+        e.bytes({0xC6, 0x83}); e.u32(l.nz_pending); e.bytes({1});   // mov byte [rbx+nz_pending], 1
+    } else {
+        e.bytes({0x48, 0x8D, 0xB6}); e.u32(offset);             // lea rsi, [rsi+offset]
+        // Into WRAM holding cached code: let the handler notify the cache
+        e.bytes({0x48, 0x89, 0xF2});                            // mov rdx, rsi
+        e.bytes({0x48, 0xB9}); e.u64((uint64_t)host.wram);   // mov rcx, wram
+        e.bytes({0x48, 0x29, 0xCA});                            // sub rdx, rcx
+        e.bytes({0x48, 0x81, 0xFA}); e.u32((uint32_t)host.wram_size);  // cmp rdx, wram size
+        size_t to_store = e.jump(kJae);
+        e.bytes({0x48, 0xC1, 0xEA, 0x08});                      // shr rdx, 8
+        e.bytes({0x48, 0xB9}); e.u64((uint64_t)host.code_pages);  // mov rcx, code_pages
+        e.bytes({0x80, 0x3C, 0x11, 0x00});                      // cmp byte [rcx+rdx], 0
+        to_handler_code = e.jump(kJne);
+        e.bind(to_store);
+        if (op.reg) {
+            e.bytes({0x0F, 0xB7, 0x83}); e.u32(l.*op.reg);      // movzx eax, word [rbx+reg]
+            if (wide) {
+                e.bytes({0x66, 0x89, 0x06});                    // mov [rsi], ax
+            } else {
+                e.bytes({0x88, 0x06});                          // mov [rsi], al
+            }
+        } else if (wide) {
+            e.bytes({0x66, 0xC7, 0x06, 0x00, 0x00});            // mov word [rsi], 0
+        } else {
+            e.bytes({0xC6, 0x06, 0x00});                        // mov byte [rsi], 0
+        }
+    }
+    e.bytes({0xC7, 0x83}); e.u32(l.pc); e.u32(next_pc);         // mov dword [rbx+pc], next pc
+    e.bytes({0xC6, 0x83}); e.u32(l.cycles); e.bytes({cycles});  // mov byte [rbx+cycles], cycles
+    size_t done = e.jump(0);
+
+    // The handler may have run DMA or rewritten code, so check as after any
+    // other call; the instruction counts as the last one executed
+    e.bind(to_handler);
+    if (to_handler_code) {
+        e.bind(to_handler_code);
+    }
+    emit_call(e, l, insn);
+    e.bytes({0xB8}); e.u32((uint32_t)index + 1);  // mov eax, i + 1
+    emit_checks(e, l, block, next_pc);
+    e.bind(done);
+    return true;
+}
+
+} // namespace
+
+CPUJit::CPUJit(const Layout& layout) : layout(layout) {}
+
+CPUJit::~CPUJit() {
+    reset();
+}
+
+CPUJit::NativeBlock CPUJit::compile(const CPUBlockCache::Block& block, const Bus& bus) {
+    const Layout& l = layout;
+    Emitter e;
+    const HostMemory host = {
+        reinterpret_cast<const char*>(&bus.read_map[0].data),
+        reinterpret_cast<const char*>(&bus.write_map[0].data),
+        sizeof(bus.read_map[0]), sizeof(bus.write_map[0]),
+        bus.wram.data(), bus.wram.size(), bus.code_pages.data(),
+    };
+
+    // push rbx; push r12; push r13 (keeps rsp 16-byte aligned for calls)
+    e.bytes({0x53, 0x41, 0x54, 0x41, 0x55});
+    e.bytes({0x48, 0x89, 0xFB});    // mov rbx, rdi
+    e.bytes({0x49, 0x89, 0xF4});    // mov r12, rsi
+
+    bool checked = false;           // Previous instruction can't leave the block
+    for (size_t i = 0; i < block.instructions.size(); ++i) {
+        const CPUBlockCache::Instruction& insn = block.instructions[i];
+
+        if (i > 0) {
+            e.bytes({0xB8}); e.u32((uint32_t)i);                // mov eax, i
+            // Count the previous instruction unless that spends the budget
+            e.bytes({0x0F, 0xB6, 0x8B}); e.u32(l.cycles);       // movzx ecx, byte [rbx+cycles]
+            e.bytes({0x49, 0x03, 0x0C, 0x24});                  // add rcx, [r12]
+            e.bytes({0x49, 0x3B, 0x4C, 0x24, 0x10});            // cmp rcx, [r12+cycle_target]
+            e.exit_if(kJae);
+            e.bytes({0x49, 0x8B, 0x54, 0x24, 0x08});            // mov rdx, [r12+instructions]
+            e.bytes({0x48, 0xFF, 0xC2});                        // inc rdx
+            e.bytes({0x49, 0x3B, 0x54, 0x24, 0x18});            // cmp rdx, [r12+instruction_target]
+            e.exit_if(kJae);
+            if (!checked) {
+                emit_checks(e, l, block, insn.pc);
+            }
+            e.bytes({0x49, 0x89, 0x0C, 0x24});                  // mov [r12], rcx
+            e.bytes({0x49, 0x89, 0x54, 0x24, 0x08});            // mov [r12+8], rdx
+        }
+
+        const FlagOp* flag_op = find_flag_op(insn.handler);
+        const MemoryOp* memory_op = find_memory_op(insn.opcode);
+        if (insn.handler == &CPUInstructions::nop || flag_op) {
+            e.bytes({0xC7, 0x83}); e.u32(l.pc); e.u32(insn.pc + 1);    // mov dword [rbx+pc], pc + 1
+            if (flag_op && flag_op->set) {
+                e.bytes({0x66, 0x81, 0x8B}); e.u32(l.p); e.u16(flag_op->flag);            // or word [rbx+p], flag
+            } else if (flag_op) {
+                e.bytes({0x66, 0x81, 0xA3}); e.u32(l.p); e.u16((uint16_t)~flag_op->flag); // and word [rbx+p], ~flag
+            }
+            e.bytes({0xC6, 0x83}); e.u32(l.cycles); e.bytes({2});   // mov byte [rbx+cycles], 2
+            checked = true;
+        } else if (memory_op && emit_memory_op(e, l, *memory_op, block, i, host)) {
+            checked = true;
+        } else {
+            emit_call(e, l, insn);
+            checked = false;
+        }
+    }
+
+    e.bytes({0xB8}); e.u32((uint32_t)block.instructions.size());   // mov eax, size
+    size_t epilogue = e.code.size();
+    e.bytes({0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3});  // pop r13; pop r12; pop rbx; ret
+    for (size_t at : e.exits) {
+        uint32_t rel = (uint32_t)(epilogue - (at + 4));
+        std::memcpy(&e.code[at], &rel, 4);
+    }
+
+    return reinterpret_cast<NativeBlock>(allocate(e.code));
+}
+
+// Code is written through a writable mapping that is flipped to
+// read/execute afterwards, so no page is ever writable and executable.
+uint8_t* CPUJit::allocate(const std::vector<uint8_t>& code) {
+    if (code.size() > kChunkSize || code_bytes + code.size() > kMaxCodeSize) {
+        return nullptr;
+    }
+    if (chunks.empty() || chunks.back().used + code.size() > kChunkSize) {
+        void* mem = mmap(nullptr, kChunkSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) return nullptr;
+        chunks.push_back({static_cast<uint8_t*>(mem), 0});
+    } else if (mprotect(chunks.back().base, kChunkSize, PROT_READ | PROT_WRITE) != 0) {
+        return nullptr;
+    }
+
+    Chunk& chunk = chunks.back();
+    uint8_t* out = chunk.base + chunk.used;
+    std::memcpy(out, code.data(), code.size());
+    // Keep entry points 16-byte aligned
+    chunk.used = (chunk.used + code.size() + 15) & ~(size_t)15;
+    code_bytes += code.size();
+    if (mprotect(chunk.base, kChunkSize, PROT_READ | PROT_EXEC) != 0) {
+        return nullptr;
+    }
+    return out;
+}
+
+void CPUJit::reset() {
+    for (Chunk& chunk : chunks) {
+        munmap(chunk.base, kChunkSize);
+    }
+    chunks.clear();
+    code_bytes = 0;
+}
+
+#endif // PYSNES_JIT
@@ -0,0 +1,93 @@
+#include "../include/cpu_opcodes.hpp"
+#include "../include/cpu.hpp"
+#include "../include/cpu_trace.hpp"
+#include <cinttypes>
+#include <cstdio>
+
+std::string CPUOpcodes::disassemble(const uint8_t* bytes, uint32_t pc, bool m16, bool x16) {
+    const OpcodeInfo& info = kTable[bytes[0]];
+    int length = operand_length(info.mode, m16, x16);
+    uint32_t operand = 0;
+    for (int i = 0; i < length; ++i) {
+        operand |= (uint32_t)bytes[1 + i] << (8 * i);
+    }
+
+    // Branch targets stay in the bank of the branch
+    uint16_t target = 0;
+    if (info.mode == AddrMode::Relative) {
+        target = (uint16_t)(pc + 2 + (int8_t)operand);
+    } else if (info.mode == AddrMode::RelativeLong) {
+        target = (uint16_t)(pc + 3 + (int16_t)operand);
+    }
+
+    const char* m = info.mnemonic;
+    char text[32];
+    switch (info.mode) {
+    case AddrMode::Implied: snprintf(text, sizeof(text), "%s", m); break;
+    case AddrMode::Accumulator: snprintf(text, sizeof(text), "%s A", m); break;
+    case AddrMode::ImmediateM:
+    case AddrMode::ImmediateX:
+    case AddrMode::Immediate8: snprintf(text, sizeof(text), "%s #$%0*X", m, length * 2, operand); break;
+    case AddrMode::Relative:
+    case AddrMode::RelativeLong: snprintf(text, sizeof(text), "%s $%04X", m, target); break;
+    case AddrMode::Direct: snprintf(text, sizeof(text), "%s $%02X", m, operand); break;
+    case AddrMode::DirectX: snprintf(text, sizeof(text), "%s $%02X,X", m, operand); break;
+    case AddrMode::DirectY: snprintf(text, sizeof(text), "%s $%02X,Y", m, operand); break;
+    case AddrMode::DirectIndirect: snprintf(text, sizeof(text), "%s ($%02X)", m, operand); break;
+    case AddrMode::DirectIndirectX: snprintf(text, sizeof(text), "%s ($%02X,X)", m, operand); break;
+    case AddrMode::DirectIndirectY: snprintf(text, sizeof(text), "%s ($%02X),Y", m, operand); break;
+    case AddrMode::DirectIndirectLong: snprintf(text, sizeof(text), "%s [$%02X]", m, operand); break;
+    case AddrMode::DirectIndirectLongY: snprintf(text, sizeof(text), "%s [$%02X],Y", m, operand); break;
+    case AddrMode::Absolute: snprintf(text, sizeof(text), "%s $%04X", m, operand); break;
+    case AddrMode::AbsoluteX: snprintf(text, sizeof(text), "%s $%04X,X", m, operand); break;
+    case AddrMode::AbsoluteY: snprintf(text, sizeof(text), "%s $%04X,Y", m, operand); break;
+    case AddrMode::AbsoluteLong: snprintf(text, sizeof(text), "%s $%06X", m, operand); break;
+    case AddrMode::AbsoluteLongX: snprintf(text, sizeof(text), "%s $%06X,X", m, operand); break;
+    case AddrMode::AbsoluteIndirect: snprintf(text, sizeof(text), "%s ($%04X)", m, operand); break;
+    case AddrMode::AbsoluteIndirectX: snprintf(text, sizeof(text), "%s ($%04X,X)", m, operand); break;
+    case AddrMode::AbsoluteIndirectLong: snprintf(text, sizeof(text), "%s [$%04X]", m, operand); break;
+    case AddrMode::StackRelative: snprintf(text, sizeof(text), "%s $%02X,S", m, operand); break;
+    case AddrMode::StackRelativeIndirectY: snprintf(text, sizeof(text), "%s ($%02X,S),Y", m, operand); break;
+    // Operand bytes are destination then source; assembly lists the source first
+    case AddrMode::BlockMove: snprintf(text, sizeof(text), "%s $%02X,$%02X", m, bytes[2], bytes[1]); break;
+    }
+    return text;
+}
+
+// e.g. "7E:8000  A9 34     LDA #$34      A:0000 X:0000 Y:0000 S:01FD D:0000 DB:00 P:34 E:0 CYC:0"
+std::string CPUOpcodes::format_trace(const TraceRecord& record) {
+    char line[160];
+    uint8_t bank = record.pc >> 16;
+    uint16_t addr = record.pc & 0xFFFF;
+    switch (record.kind) {
+    case TraceRecord::kInstruction: {
+        // Operand bytes are stored in arg, little endian
+        bool emulation = (record.p & CPU::E) != 0;
+        bool m16 = !(record.p & (CPU::M | CPU::E));
+        bool x16 = !(record.p & (CPU::X | CPU::E));
+        uint8_t bytes[4] = {record.opcode, (uint8_t)record.arg, (uint8_t)(record.arg >> 8), (uint8_t)(record.arg >> 16)};
+        int length = CPUOpcodes::length(record.opcode, m16, x16);
+        std::string hex;
+        for (int i = 0; i < length; ++i) {
+            char byte[4];
+            snprintf(byte, sizeof(byte), i ? " %02X" : "%02X", bytes[i]);
+            hex += byte;
+        }
+        snprintf(line, sizeof(line),
+                 "%02X:%04X  %-11s  %-14s A:%04X X:%04X Y:%04X S:%04X D:%04X DB:%02X P:%02X E:%d CYC:%" PRIu64,
+                 bank, addr, hex.c_str(), disassemble(bytes, record.pc, m16, x16).c_str(), record.a, record.x,
+                 record.y, record.sp, record.d, record.db, record.p & 0xFF, emulation ? 1 : 0, record.cycles);
+        break;
+    }
+    case TraceRecord::kCall:
+        snprintf(line, sizeof(line), "%02X:%04X  call $%06X  CYC:%" PRIu64, bank, addr, record.arg, record.cycles);
+        break;
+    case TraceRecord::kReturn:
+        snprintf(line, sizeof(line), "%02X:%04X  return $%06X  CYC:%" PRIu64, bank, addr, record.arg, record.cycles);
+        break;
+    default:
+        snprintf(line, sizeof(line), "%02X:%04X  log $%06X  CYC:%" PRIu64, bank, addr, record.arg, record.cycles);
+        break;
+    }
+    return line;
+}
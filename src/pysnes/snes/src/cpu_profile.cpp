@@ -0,0 +1,28 @@
+#include "../include/cpu_profile.hpp"
+
+std::array<uint64_t, CPUProfile::kModeCount> CPUProfile::by_mode(const std::array<uint64_t, 256>& per_opcode) {
+    std::array<uint64_t, kModeCount> totals{};
+    for (int op = 0; op < 256; ++op) {
+        totals[(int)CPUOpcodes::kTable[op].mode] += per_opcode[op];
+    }
+    return totals;
+}
+
+// Names in AddrMode order
+const char* CPUProfile::mode_name(int mode) {
+    static const char* const kNames[kModeCount] = {
+        "implied", "accumulator", "immediate_m", "immediate_x", "immediate8",
+        "relative", "relative_long", "direct", "direct_x", "direct_y",
+        "direct_indirect", "direct_indirect_x", "direct_indirect_y",
+        "direct_indirect_long", "direct_indirect_long_y", "absolute",
+        "absolute_x", "absolute_y", "absolute_long", "absolute_long_x",
+        "absolute_indirect", "absolute_indirect_x", "absolute_indirect_long",
+        "stack_relative", "stack_relative_indirect_y", "block_move",
+    };
+    return (mode >= 0 && mode < kModeCount) ? kNames[mode] : "";
+}
+
+const char* CPUProfile::region_name(int region) {
+    static const char* const kNames[kRegionCount] = {"wram", "rom", "mmio", "open_bus"};
+    return (region >= 0 && region < kRegionCount) ? kNames[region] : "";
+}
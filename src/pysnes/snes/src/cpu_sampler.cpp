@@ -0,0 +1,131 @@
+#include "../include/cpu_sampler.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+bool parse_hex(const std::string& text, uint32_t& value) {
+    if (text.empty() || text.size() > 8) return false;
+    char* end = nullptr;
+    value = (uint32_t)strtoul(text.c_str(), &end, 16);
+    return *end == '\0';
+}
+
+// ca65: "name  008294  LF" triples, several per line, until a blank line
+void load_ca65(std::istream& in, std::vector<std::pair<uint32_t, std::string>>& out) {
+    std::string line;
+    while (std::getline(in, line) && line.find_first_not_of(" \t\r") != std::string::npos) {
+        std::istringstream fields(line);
+        std::string name, addr, flags;
+        while (fields >> name >> addr >> flags) {
+            uint32_t value;
+            if (parse_hex(addr, value)) out.emplace_back(value & 0xFFFFFF, name);
+        }
+    }
+}
+
+// WLA-DX: "bb:aaaa name" lines until the next section
+void load_wla(std::istream& in, std::vector<std::pair<uint32_t, std::string>>& out) {
+    std::string line;
+    while (std::getline(in, line) && (line.empty() || line[0] != '[')) {
+        std::istringstream fields(line);
+        std::string location, name;
+        if (!(fields >> location >> name) || location[0] == ';') continue;
+        size_t colon = location.find(':');
+        uint32_t bank, addr;
+        if (colon != std::string::npos && parse_hex(location.substr(0, colon), bank) &&
+            parse_hex(location.substr(colon + 1), addr)) {
+            out.emplace_back(((bank << 16) | (addr & 0xFFFF)) & 0xFFFFFF, name);
+        }
+    }
+}
+
+} // namespace
+
+bool SymbolTable::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in.is_open()) return false;
+
+    size_t before = symbols.size();
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("Exports list by name:", 0) == 0) {
+            std::getline(in, line);     // Underline
+            load_ca65(in, symbols);
+        } else if (line.rfind("[labels]", 0) == 0) {
+            load_wla(in, symbols);
+        }
+    }
+    std::sort(symbols.begin(), symbols.end());
+    return symbols.size() > before;
+}
+
+const std::pair<uint32_t, std::string>* SymbolTable::find(uint32_t addr) const {
+    auto it = std::upper_bound(symbols.begin(), symbols.end(), addr,
+                               [](uint32_t a, const std::pair<uint32_t, std::string>& s) { return a < s.first; });
+    if (it == symbols.begin()) return nullptr;
+    --it;
+    return (it->first >> 16) == (addr >> 16) ? &*it : nullptr;
+}
+
+std::string SymbolTable::resolve(uint32_t addr, bool with_offset) const {
+    addr &= 0xFFFFFF;
+    const std::pair<uint32_t, std::string>* symbol = find(addr);
+    uint32_t base = addr;
+    if (!symbol && (addr & 0x800000)) {
+        base = addr & 0x7FFFFF;
+        symbol = find(base);
+    }
+    char text[16];
+    if (!symbol) {
+        snprintf(text, sizeof(text), "$%02X:%04X", addr >> 16, addr & 0xFFFF);
+        return text;
+    }
+    if (!with_offset || symbol->first == base) {
+        return symbol->second;
+    }
+    snprintf(text, sizeof(text), "+$%X", base - symbol->first);
+    return symbol->second + text;
+}
+
+void CPUSampler::sample(uint32_t pc, uint16_t sp) {
+    unwind(sp);
+    samples++;
+    histogram[pc]++;
+    std::vector<uint32_t> key;
+    key.reserve(stack.size() + 1);
+    for (const Frame& frame : stack) {
+        key.push_back(frame.site);
+    }
+    key.push_back(pc);
+    stacks[key]++;
+}
+
+void CPUSampler::reset() {
+    samples = 0;
+    histogram.clear();
+    stacks.clear();
+}
+
+std::map<std::string, uint64_t> CPUSampler::flat_profile(const SymbolTable& symbols) const {
+    std::map<std::string, uint64_t> profile;
+    for (const auto& entry : histogram) {
+        profile[symbols.resolve(entry.first, false)] += entry.second;
+    }
+    return profile;
+}
+
+std::map<std::string, uint64_t> CPUSampler::stack_profile(const SymbolTable& symbols) const {
+    std::map<std::string, uint64_t> profile;
+    for (const auto& entry : stacks) {
+        std::string folded;
+        for (uint32_t addr : entry.first) {
+            if (!folded.empty()) folded += ';';
+            folded += symbols.resolve(addr, false);
+        }
+        profile[folded] += entry.second;
+    }
+    return profile;
+}
@@ -0,0 +1,39 @@
+#include "../include/cpu_trace.hpp"
+#include <fstream>
+
+CPUTrace::CPUTrace(size_t capacity) : buffer(capacity ? capacity : 1) {}
+
+void CPUTrace::set_capacity(size_t capacity) {
+    buffer.assign(capacity ? capacity : 1, TraceRecord{});
+    clear();
+}
+
+void CPUTrace::clear() {
+    head = 0;
+    count = 0;
+    total = 0;
+}
+
+std::vector<TraceRecord> CPUTrace::records() const {
+    std::vector<TraceRecord> out;
+    out.reserve(count);
+    size_t start = (head + buffer.size() - count) % buffer.size();
+    for (size_t i = 0; i < count; ++i) {
+        out.push_back(buffer[(start + i) % buffer.size()]);
+    }
+    return out;
+}
+
+std::vector<uint8_t> CPUTrace::dump() const {
+    std::vector<TraceRecord> ordered = records();
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(ordered.data());
+    return std::vector<uint8_t>(bytes, bytes + ordered.size() * sizeof(TraceRecord));
+}
+
+bool CPUTrace::dump(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) return false;
+    std::vector<uint8_t> bytes = dump();
+    out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    return out.good();
+}
@@ -0,0 +1,125 @@
+#include "../include/planar.hpp"
+#include "../include/simd.hpp"
+#include <cstring>
+#if defined(PYSNES_SIMD)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Bit masks selecting pixel x of a plane byte, by byte lane (x = lane)
+constexpr uint64_t kPixelBits = 0x0102040810204080ULL;         // Bit 7 - x
+constexpr uint64_t kPixelBitsFlipped = 0x8040201008040201ULL;  // Bit x
+
+// The 8 pixels of one plane byte as 0/1 bytes: repeat the byte into every
+// lane, keep each lane's bit, then turn non-zero lanes into 1 without
+// carries crossing lanes
+inline uint64_t spread_plane(uint8_t plane, uint64_t bits) {
+    uint64_t m = (plane * 0x0101010101010101ULL) & bits;
+    return ((m | ((m & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL)) >> 7) & 0x0101010101010101ULL;
+}
+
+inline uint64_t chunky_row(const uint8_t* tile, int planes, int y, uint64_t bits) {
+    uint64_t row = 0;
+    for (int p = 0; p < planes; ++p) {
+        row |= spread_plane(tile[16 * (p >> 1) + 2 * y + (p & 1)], bits) << p;
+    }
+    return row;
+}
+
+void tile_scalar(const uint8_t* tile, int planes, bool hflip, uint8_t* out) {
+    uint64_t bits = hflip ? kPixelBitsFlipped : kPixelBits;
+    for (int y = 0; y < 8; ++y) {
+        uint64_t row = chunky_row(tile, planes, y, bits);
+        memcpy(out + 8 * y, &row, 8);
+    }
+}
+
+#if defined(PYSNES_SIMD)
+
+// Each 16-byte plane pair is split into its two planes' 8 row bytes. These
+// are repeated across the 8 lanes of their row, tested against the lane's
+// bit and merged into the index bytes. SSE2 handles two rows per register,
+// AVX2 four.
+__attribute__((target("sse2")))
+inline __m128i plane_rows_sse2(__m128i pair, bool odd) {
+    __m128i plane = odd ? _mm_srli_epi16(pair, 8) : _mm_and_si128(pair, _mm_set1_epi16(0x00FF));
+    return _mm_packus_epi16(plane, plane);
+}
+
+__attribute__((target("sse2")))
+void tile_sse2(const uint8_t* tile, int planes, bool hflip, uint8_t* out) {
+    uint64_t mask = hflip ? kPixelBitsFlipped : kPixelBits;
+    const __m128i bits = _mm_set1_epi64x((long long)mask);
+    __m128i rows[4] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+    for (int p = 0; p < planes; ++p) {
+        __m128i pair = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tile + 16 * (p >> 1)));
+        __m128i v = plane_rows_sse2(pair, p & 1);
+        v = _mm_unpacklo_epi8(v, v);
+        __m128i lo = _mm_unpacklo_epi16(v, v);  // Rows 0-3, 4 lanes each
+        __m128i hi = _mm_unpackhi_epi16(v, v);  // Rows 4-7
+        const __m128i split[4] = {_mm_unpacklo_epi32(lo, lo), _mm_unpackhi_epi32(lo, lo),
+                                  _mm_unpacklo_epi32(hi, hi), _mm_unpackhi_epi32(hi, hi)};
+        const __m128i plane_bit = _mm_set1_epi8((char)(1 << p));
+        for (int i = 0; i < 4; ++i) {
+            __m128i set = _mm_cmpeq_epi8(_mm_and_si128(split[i], bits), bits);
+            rows[i] = _mm_or_si128(rows[i], _mm_and_si128(set, plane_bit));
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16 * i), rows[i]);
+    }
+}
+
+__attribute__((target("avx2")))
+void tile_avx2(const uint8_t* tile, int planes, bool hflip, uint8_t* out) {
+    uint64_t mask = hflip ? kPixelBitsFlipped : kPixelBits;
+    const __m256i bits = _mm256_set1_epi64x((long long)mask);
+    // In-lane shuffles of the broadcast plane pair: rows 0-3, then rows 4-7,
+    // of the even plane; the odd plane's bytes are one further on
+    const __m256i rows_0_3 = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2,
+                                              4, 4, 4, 4, 4, 4, 4, 4, 6, 6, 6, 6, 6, 6, 6, 6);
+    const __m256i rows_4_7 = _mm256_add_epi8(rows_0_3, _mm256_set1_epi8(8));
+    const __m256i odd = _mm256_set1_epi8(1);
+    __m256i top = _mm256_setzero_si256();
+    __m256i bottom = _mm256_setzero_si256();
+    for (int p = 0; p < planes; ++p) {
+        __m128i pair = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tile + 16 * (p >> 1)));
+        __m256i v = _mm256_broadcastsi128_si256(pair);
+        __m256i first = (p & 1) ? _mm256_add_epi8(rows_0_3, odd) : rows_0_3;
+        __m256i second = (p & 1) ? _mm256_add_epi8(rows_4_7, odd) : rows_4_7;
+        const __m256i plane_bit = _mm256_set1_epi8((char)(1 << p));
+        __m256i set = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_shuffle_epi8(v, first), bits), bits);
+        top = _mm256_or_si256(top, _mm256_and_si256(set, plane_bit));
+        set = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_shuffle_epi8(v, second), bits), bits);
+        bottom = _mm256_or_si256(bottom, _mm256_and_si256(set, plane_bit));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), top);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32), bottom);
+}
+
+#endif
+
+} // namespace
+
+// A single row is one 64-bit word, already 8 pixels at a time at every level
+void planar_to_chunky_row(const uint8_t* tile, int planes, int y, bool hflip, uint8_t* out) {
+    uint64_t row = chunky_row(tile, planes, y, hflip ? kPixelBitsFlipped : kPixelBits);
+    memcpy(out, &row, 8);
+}
+
+void planar_to_chunky_tile(const uint8_t* tile, int planes, bool hflip, uint8_t* out) {
+    switch (simd_level()) {
+#if defined(PYSNES_SIMD)
+    case SimdLevel::kAvx2:
+        tile_avx2(tile, planes, hflip, out);
+        return;
+    case SimdLevel::kSse2:
+        tile_sse2(tile, planes, hflip, out);
+        return;
+#endif
+    default:
+        tile_scalar(tile, planes, hflip, out);
+        return;
+    }
+}
@@ -1,4 +1,5 @@
 #include "ppu.hpp"
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <vector>
@@ -17,7 +18,9 @@ PPU::~PPU() {
 void PPU::reset() {
     // Clear all PPU memory regions
     vram_.fill(0);
+    tile_cache_.invalidate_all();
     cgram_.fill(0);
+    palette_.load(cgram_.data());
     oam_.fill(0);
     // Reset VRAM and CGRAM read buffers
     vram_read_buffer_ = 0;
@@ -55,6 +58,7 @@ uint8_t PPU::read_vram(uint16_t addr) const {
 
 void PPU::write_vram(uint16_t addr, uint8_t value) {
     vram_[addr % vram_.size()] = value;
+    tile_cache_.invalidate(addr);
 }
 
 // CGRAM access
@@ -63,7 +67,13 @@ uint8_t PPU::read_cgram(uint16_t addr) const {
 }
 
 void PPU::write_cgram(uint16_t addr, uint8_t value) {
-    cgram_[addr % cgram_.size()] = value;
+    addr %= cgram_.size();
+    cgram_[addr] = value;
+    update_palette(addr >> 1);
+}
+
+void PPU::update_palette(int index) {
+    palette_.set(index, cgram_[2 * index] | (cgram_[2 * index + 1] << 8));
 }
 
 // OAM access
@@ -75,283 +85,243 @@ void PPU::write_oam(uint16_t addr, uint8_t value) {
     oam_[addr % oam_.size()] = value;
 }
 
-// Register access stubs
-uint8_t PPU::read_register(uint16_t addr) {
-    switch (addr) {
-        // $2100–$213F: PPU registers
-        // $2100: INIDISP (Display Control)
-        case 0x2100:
-            // Write-only register - return 0 (open bus)
-            return 0;
-        // $2101: OBSEL (Object Size and Data Area Designation)
-        case 0x2101:
-            // Write-only register - return 0 (open bus)
-            return 0;
-        // $2102/$2103: OAM Address (write-only)
-        case 0x2102:
-        case 0x2103:
-            return 0;
-        // $2104: OAM Data Write (write-only)
-        case 0x2104:
-            return 0;
-        // $2105: BG mode/char size
-        case 0x2105:
-            // Write-only register - return 0 (open bus)
-            return 0;
-        // $2106: Mosaic
-        case 0x2106:
-            // Write-only register - return 0 (open bus)
-            return 0;
-        // $2107–$210A: BGnSC tilemap base (write-only)
-        case 0x2107: case 0x2108: case 0x2109: case 0x210A:
-            return 0;
-        // $210B–$210C: BGnNBA tile data base (write-only)
-        case 0x210B: case 0x210C:
-            return 0;
-        // $210D–$2114: BG scroll registers (write-only)
-        case 0x210D: case 0x210E: case 0x210F: case 0x2110:
-        case 0x2111: case 0x2112: case 0x2113: case 0x2114:
-            return 0;
-        // $2115: VMAIN (VRAM Address Increment Mode)
-        case 0x2115:
-            // Write-only register - return 0 (open bus)
-            return 0;
-        // $2116/$2117: VRAM Address (write-only)
-        case 0x2116: case 0x2117:
-            return 0;
-        // $2118/$2119: VRAM Data Write (write-only)
-        case 0x2118: case 0x2119:
-            return 0;
-        // $211A–$2120: Misc (write-only)
-        case 0x211A: case 0x211B: case 0x211C: case 0x211D:
-        case 0x211E: case 0x211F: case 0x2120:
-            return 0;
-        // $2121: CGRAM Address (write-only)
-        case 0x2121:
-            return 0;
-        // $2122: CGRAM Data Write (write-only)
-        case 0x2122:
-            return 0;
-        // $2123–$2136: Windowing, color math, etc. (mostly write-only)
-        case 0x2123: case 0x2124: case 0x2125: case 0x2126:
-        case 0x2127: case 0x2128: case 0x2129: case 0x212A:
-        case 0x212B: case 0x212C: case 0x212D: case 0x212E:
-        case 0x212F: case 0x2130: case 0x2131: case 0x2132:
-        case 0x2133: case 0x2134: case 0x2135: case 0x2136:
-            return 0;
-        // $2137: Latch H/V counter
-        case 0x2137:
-            // TODO: Implement H/V counter latch
-            return 0;
-        // $2138: OAM Data Read
-        case 0x2138:
-            if (oam_latch_low_) {
-                return oam_[oam_addr_ % oam_.size()];
-            } else {
-                return oam_[(oam_addr_ % oam_.size()) + 1];
-            }
-        case 0x2139: { // VRAM Data Read (low byte)
-            uint8_t result = vram_read_buffer_ & 0xFF;
-            // Load buffer with word at current VRAM address
-            vram_read_buffer_ = read_vram(vram_addr_) | (read_vram(vram_addr_ + 1) << 8);
-            // Increment VRAM address based on VMAIN
-            if (vmain_ & 0x80) {
-                // Fixed increment
-                vram_addr_ += (1 << ((vmain_ >> 4) & 0x07));
-            } else {
-                // Increment by 1
-                vram_addr_ += 1;
-            }
-            return result;
-        }
-        case 0x213A: { // VRAM Data Read (high byte)
-            uint8_t result = (vram_read_buffer_ >> 8) & 0xFF;
-            // Load buffer with word at current VRAM address
-            vram_read_buffer_ = read_vram(vram_addr_) | (read_vram(vram_addr_ + 1) << 8);
-            // Increment VRAM address based on VMAIN
-            if (vmain_ & 0x80) {
-                // Fixed increment
-                vram_addr_ += (1 << ((vmain_ >> 4) & 0x07));
-            } else {
-                // Increment by 1
-                vram_addr_ += 1;
-            }
-            return result;
-        }
-        case 0x213B: { // CGRAM Data Read
-            uint8_t result = cgram_read_buffer_;
-            // Load buffer with byte at current CGRAM address
-            cgram_read_buffer_ = read_cgram(cgram_addr_);
-            // Increment CGRAM address
-            cgram_addr_ = (cgram_addr_ + 1) & 0x1FF; // 9-bit address
-            return result;
+// --- Registers ---
+
+namespace {
+
+PPU& ppu_of(void* device) { return *static_cast<PPU*>(device); }
+
+constexpr uint8_t kWriteOnly = MmioRegister::kOpenBus;
+constexpr uint8_t kPeekable = MmioRegister::kNoSideEffects;
+
+} // namespace
+
+// $2100-$213F by address. Mode 7, window, color math and the H/V counter
+// latch are left out until they are implemented, so they read as open bus.
+const MmioRegister PPU::kRegisters[PPU::kRegisterCount] = {
+    {0x2100, "INIDISP", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).inidisp_ = v; }, kWriteOnly},
+    {0x2101, "OBSEL", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).obsel_ = v; }, kWriteOnly},
+    {0x2102, "OAMADDL", nullptr, [](void* d, uint16_t, uint8_t v) {
+        PPU& p = ppu_of(d);
+        p.oam_addr_ = (p.oam_addr_ & 0x100) | v;
+        p.oam_priority_rotation_ = (v & 0x80) != 0;
+        p.oam_addr_msb_ = (v & 0x01) != 0;
+        p.oam_latch_low_ = true;    // Reset latch on address set
+    }, kWriteOnly},
+    {0x2103, "OAMADDH", nullptr, [](void* d, uint16_t, uint8_t v) {
+        PPU& p = ppu_of(d);
+        p.oam_addr_ = (p.oam_addr_ & 0xFF) | ((v & 0x01) << 8);
+        p.oam_latch_low_ = true;
+    }, kWriteOnly},
+    {0x2104, "OAMDATA", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).oam_port_write(v); }, kWriteOnly},
+    {0x2105, "BGMODE", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).bgmode_ = v; }, kWriteOnly},
+    {0x2106, "MOSAIC", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).mosaic_ = v; }, kWriteOnly},
+    {0x2107, "BG1SC", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).bg_sc_[0] = v; }, kWriteOnly},
+    {0x2108, "BG2SC", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).bg_sc_[1] = v; }, kWriteOnly},
+    {0x2109, "BG3SC", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).bg_sc_[2] = v; }, kWriteOnly},
+    {0x210A, "BG4SC", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).bg_sc_[3] = v; }, kWriteOnly},
+    {0x210B, "BG12NBA", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).bg_nba_[0] = v; }, kWriteOnly},
+    {0x210C, "BG34NBA", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).bg_nba_[1] = v; }, kWriteOnly},
+    {0x210D, "BG1HOFS", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).write_hofs(0, v); }, kWriteOnly},
+    {0x210E, "BG2HOFS", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).write_hofs(1, v); }, kWriteOnly},
+    {0x210F, "BG3HOFS", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).write_hofs(2, v); }, kWriteOnly},
+    {0x2110, "BG4HOFS", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).write_hofs(3, v); }, kWriteOnly},
+    {0x2111, "BG1VOFS", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).bg_vofs_[0] = v; }, kWriteOnly},
+    {0x2112, "BG2VOFS", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).bg_vofs_[1] = v; }, kWriteOnly},
+    {0x2113, "BG3VOFS", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).bg_vofs_[2] = v; }, kWriteOnly},
+    {0x2114, "BG4VOFS", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).bg_vofs_[3] = v; }, kWriteOnly},
+    {0x2115, "VMAIN", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).vmain_ = v; }, kWriteOnly},
+    {0x2116, "VMADDL", nullptr, [](void* d, uint16_t, uint8_t v) {
+        PPU& p = ppu_of(d);
+        p.vram_addr_ = (p.vram_addr_ & 0xFF00) | v;
+        p.vram_prefetch();
+    }, kWriteOnly},
+    {0x2117, "VMADDH", nullptr, [](void* d, uint16_t, uint8_t v) {
+        PPU& p = ppu_of(d);
+        p.vram_addr_ = (p.vram_addr_ & 0x00FF) | (v << 8);
+        p.vram_prefetch();
+    }, kWriteOnly},
+    {0x2118, "VMDATAL", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).vram_port_write(false, v); }, kWriteOnly},
+    {0x2119, "VMDATAH", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).vram_port_write(true, v); }, kWriteOnly},
+    {0x2121, "CGADD", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).cgram_addr_ = v << 1; }, kWriteOnly},
+    {0x2122, "CGDATA", nullptr, [](void* d, uint16_t, uint8_t v) {
+        PPU& p = ppu_of(d);
+        p.write_cgram(p.cgram_addr_, v);
+        p.cgram_addr_ = (p.cgram_addr_ + 1) & 0x1FF;    // 9-bit address
+    }, kWriteOnly},
+    {0x212C, "TM", nullptr, [](void* d, uint16_t, uint8_t v) { ppu_of(d).tm_ = v; }, kWriteOnly},
+    {0x2138, "RDOAM", [](void* d, uint16_t) -> uint8_t {
+        const PPU& p = ppu_of(d);
+        uint16_t addr = p.oam_addr_ % p.oam_.size();
+        return p.oam_latch_low_ ? p.oam_[addr] : p.oam_[addr + 1];
+    }, nullptr, kPeekable},
+    {0x2139, "RDVRAML", [](void* d, uint16_t) -> uint8_t {
+        PPU& p = ppu_of(d);
+        uint8_t result = p.vram_read_buffer_ & 0xFF;
+        // The prefetched word is reloaded before the address moves on
+        if (!(p.vmain_ & 0x80)) {
+            p.vram_prefetch();
+            p.vram_addr_ += p.vram_increment();
         }
-        // $213C–$213F: Status registers
-        case 0x213C: case 0x213D: case 0x213E: case 0x213F: {
-            // Bit 7: VBLANK, Bit 6: HBLANK (simplified)
-            uint8_t status = 0;
-            if (vblank_) status |= 0x80;
-            if (hblank_) status |= 0x40;
-            return status;
+        return result;
+    }, nullptr, 0},
+    {0x213A, "RDVRAMH", [](void* d, uint16_t) -> uint8_t {
+        PPU& p = ppu_of(d);
+        uint8_t result = p.vram_read_buffer_ >> 8;
+        if (p.vmain_ & 0x80) {
+            p.vram_prefetch();
+            p.vram_addr_ += p.vram_increment();
         }
-        default:
-            // Unmapped or open bus
-            return 0;
+        return result;
+    }, nullptr, 0},
+    {0x213B, "RDCGRAM", [](void* d, uint16_t) -> uint8_t {
+        PPU& p = ppu_of(d);
+        uint8_t result = p.cgram_read_buffer_;
+        p.cgram_read_buffer_ = p.read_cgram(p.cgram_addr_);
+        p.cgram_addr_ = (p.cgram_addr_ + 1) & 0x1FF;
+        return result;
+    }, nullptr, 0},
+    // Status: bit 7 V-blank, bit 6 H-blank (simplified)
+    {0x213C, "OPHCT", &PPU::read_status, nullptr, kPeekable},
+    {0x213D, "OPVCT", &PPU::read_status, nullptr, kPeekable},
+    {0x213E, "STAT77", &PPU::read_status, nullptr, kPeekable},
+    {0x213F, "STAT78", &PPU::read_status, nullptr, kPeekable},
+};
+
+uint8_t PPU::read_status(void* device, uint16_t) {
+    const PPU& p = ppu_of(device);
+    return (p.vblank_ ? 0x80 : 0x00) | (p.hblank_ ? 0x40 : 0x00);
+}
+
+// First write: low byte; second write: bit 8
+void PPU::write_hofs(int bg, uint8_t value) {
+    if (bg_hofs_latch_state_[bg]) {
+        bg_hofs_latch_[bg] = value;
+    } else {
+        bg_hofs_[bg] = bg_hofs_latch_[bg] | ((value & 0x01) << 8);
     }
+    bg_hofs_latch_state_[bg] = !bg_hofs_latch_state_[bg];
+}
+
+// Direct access for callers without a bus; the bus dispatches through
+// registers() itself
+uint8_t PPU::read_register(uint16_t addr) {
+    const MmioRegister* reg = find_register(addr);
+    return reg && reg->read ? reg->read(this, addr) : 0;
 }
 
 void PPU::write_register(uint16_t addr, uint8_t value) {
-    switch (addr) {
-        case 0x2100: // INIDISP (Display control)
-            inidisp_ = value;
-            break;
-        case 0x2101: // OBSEL (Object size/data area)
-            obsel_ = value;
-            break;
-        case 0x2102: // OAM Address low byte
-            oam_addr_ = (oam_addr_ & 0x100) | (value & 0xFF);
-            oam_priority_rotation_ = (value & 0x80) != 0;
-            oam_addr_msb_ = (value & 0x01) != 0;
-            oam_latch_low_ = true; // Reset latch on address set
-            break;
-        case 0x2103: // OAM Address high bit
-            oam_addr_ = (oam_addr_ & 0xFF) | ((value & 0x01) << 8);
-            oam_latch_low_ = true; // Reset latch on address set
-            break;
-        case 0x2104: // OAM Data Write
-            if (oam_latch_low_) {
-                // Write low byte
-                oam_[oam_addr_ % oam_.size()] = value;
-            } else {
-                // Write high byte (SNES OAM is 16-bit word addressed)
-                oam_[(oam_addr_ % oam_.size()) + 1] = value;
-                // Increment OAM address after high byte
-                oam_addr_ = (oam_addr_ + 2) & 0x1FF;
-            }
-            oam_latch_low_ = !oam_latch_low_;
-            break;
-        case 0x2105: // BG mode/char size
-            bgmode_ = value;
-            break;
-        case 0x2106: // Mosaic
-            mosaic_ = value;
-            break;
-        case 0x2107: case 0x2108: case 0x2109: case 0x210A: // BGnSC tilemap base
-            bg_sc_[addr - 0x2107] = value;
-            break;
-        case 0x210B: // BG1NBA/BG2NBA
-            bg_nba_[0] = value;
-            break;
-        case 0x210C: // BG3NBA/BG4NBA
-            bg_nba_[1] = value;
-            break;
-        case 0x210D: { // BG1HOFS (horizontal scroll)
-            int bg = 0;
-            if (bg_hofs_latch_state_[bg]) {
-                // First write: low byte
-                bg_hofs_latch_[bg] = value;
-            } else {
-                // Second write: high bit (bit 0), latch value
-                bg_hofs_[bg] = (bg_hofs_latch_[bg] | ((value & 0x01) << 8));
-            }
-            bg_hofs_latch_state_[bg] = !bg_hofs_latch_state_[bg];
-            break;
-        }
-        case 0x210E: { // BG2HOFS (horizontal scroll)
-            int bg = 1;
-            if (bg_hofs_latch_state_[bg]) {
-                bg_hofs_latch_[bg] = value;
-            } else {
-                bg_hofs_[bg] = (bg_hofs_latch_[bg] | ((value & 0x01) << 8));
-            }
-            bg_hofs_latch_state_[bg] = !bg_hofs_latch_state_[bg];
-            break;
+    const MmioRegister* reg = find_register(addr);
+    if (reg && reg->write) reg->write(this, addr, value);
+}
+
+const MmioRegister* PPU::find_register(uint16_t addr) {
+    const MmioRegister* end = kRegisters + kRegisterCount;
+    const MmioRegister* reg = std::lower_bound(kRegisters, end, addr,
+        [](const MmioRegister& r, uint16_t a) { return r.addr < a; });
+    return reg != end && reg->addr == addr ? reg : nullptr;
+}
+
+// --- Data ports ---
+
+// VMAIN bits 2-3 rotate the low 8/9/10 bits of the word address, so that
+// 2/4/8bpp tiles can be written one bitplane row per word
+uint16_t PPU::vram_word_address() const {
+    uint16_t a = vram_addr_;
+    switch ((vmain_ >> 2) & 0x03) {
+    case 1: return (a & 0xFF00) | ((a & 0x001F) << 3) | ((a >> 5) & 0x07);
+    case 2: return (a & 0xFE00) | ((a & 0x003F) << 3) | ((a >> 6) & 0x07);
+    case 3: return (a & 0xFC00) | ((a & 0x007F) << 3) | ((a >> 7) & 0x07);
+    default: return a;
+    }
+}
+
+// VMAIN bits 0-1: 1, 32 or 128 words
+uint16_t PPU::vram_increment() const {
+    static constexpr uint16_t kSteps[4] = {1, 32, 128, 128};
+    return kSteps[vmain_ & 0x03];
+}
+
+void PPU::vram_prefetch() {
+    uint32_t addr = (vram_word_address() & 0x7FFF) * 2;
+    vram_read_buffer_ = vram_[addr] | (vram_[addr + 1] << 8);
+}
+
+// $2118 writes the low byte of the word, $2119 the high byte; VMAIN bit 7
+// picks which of the two moves the address on
+void PPU::vram_port_write(bool high, uint8_t value) {
+    uint32_t addr = (vram_word_address() & 0x7FFF) * 2 + high;
+    vram_[addr] = value;
+    tile_cache_.invalidate(addr);
+    if (high == ((vmain_ & 0x80) != 0)) {
+        vram_addr_ += vram_increment();
+    }
+}
+
+// Bytes go in pairs, and the address moves on after the second of a pair
+void PPU::oam_port_write(uint8_t value) {
+    if (oam_latch_low_) {
+        oam_[oam_addr_ % oam_.size()] = value;
+    } else {
+        oam_[(oam_addr_ % oam_.size()) + 1] = value;
+        oam_addr_ = (oam_addr_ + 2) & 0x1FF;
+    }
+    oam_latch_low_ = !oam_latch_low_;
+}
+
+void PPU::write_vram_port(bool high, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        vram_port_write(high, data[i]);
+    }
+}
+
+// The usual upload (VMAIN = $80: word steps after the high byte, no
+// remapping) is a straight copy, split where the address wraps
+void PPU::write_vram_words(const uint8_t* data, size_t length) {
+    if ((vmain_ & 0x8F) == 0x80) {
+        size_t words = length / 2;
+        while (words) {
+            uint16_t word = vram_addr_ & 0x7FFF;
+            size_t n = std::min<size_t>(words, 0x8000 - word);
+            memcpy(&vram_[word * 2], data, n * 2);
+            tile_cache_.invalidate(word * 2, n * 2);
+            vram_addr_ += (uint16_t)n;
+            data += n * 2;
+            words -= n;
         }
-        case 0x210F: { // BG3HOFS (horizontal scroll)
-            int bg = 2;
-            if (bg_hofs_latch_state_[bg]) {
-                bg_hofs_latch_[bg] = value;
-            } else {
-                bg_hofs_[bg] = (bg_hofs_latch_[bg] | ((value & 0x01) << 8));
-            }
-            bg_hofs_latch_state_[bg] = !bg_hofs_latch_state_[bg];
-            break;
+        if (length & 1) {
+            vram_port_write(false, *data);
         }
-        case 0x2110: { // BG4HOFS (horizontal scroll)
-            int bg = 3;
-            if (bg_hofs_latch_state_[bg]) {
-                bg_hofs_latch_[bg] = value;
-            } else {
-                bg_hofs_[bg] = (bg_hofs_latch_[bg] | ((value & 0x01) << 8));
-            }
-            bg_hofs_latch_state_[bg] = !bg_hofs_latch_state_[bg];
-            break;
+        return;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        vram_port_write(i & 1, data[i]);
+    }
+}
+
+void PPU::write_cgram_port(const uint8_t* data, size_t length) {
+    while (length) {
+        size_t n = std::min<size_t>(length, cgram_.size() - cgram_addr_);
+        memcpy(&cgram_[cgram_addr_], data, n);
+        for (size_t i = cgram_addr_ >> 1; i <= (cgram_addr_ + n - 1) >> 1; ++i) {
+            update_palette((int)i);
         }
-        case 0x2111: // BG1VOFS (vertical scroll)
-            bg_vofs_[0] = value;
-            break;
-        case 0x2112: // BG2VOFS (vertical scroll)
-            bg_vofs_[1] = value;
-            break;
-        case 0x2113: // BG3VOFS (vertical scroll)
-            bg_vofs_[2] = value;
-            break;
-        case 0x2114: // BG4VOFS (vertical scroll)
-            bg_vofs_[3] = value;
-            break;
-        case 0x2115: // VMAIN (VRAM Address Increment Mode)
-            vmain_ = value;
-            break;
-        case 0x2116: // VMADDL (VRAM Address low byte)
-            vram_addr_ = (vram_addr_ & 0xFF00) | value;
-            break;
-        case 0x2117: // VMADDH (VRAM Address high byte)
-            vram_addr_ = (vram_addr_ & 0x00FF) | (value << 8);
-            break;
-        case 0x2118: // VMDATAL (VRAM Data Write low byte)
-            write_vram(vram_addr_, value);
-            // Increment VRAM address based on VMAIN
-            if (vmain_ & 0x80) {
-                // Fixed increment
-                vram_addr_ += (1 << ((vmain_ >> 4) & 0x07));
-            } else {
-                // Increment by 1
-                vram_addr_ += 1;
-            }
-            break;
-        case 0x2119: // VMDATAH (VRAM Data Write high byte)
-            write_vram(vram_addr_, value);
-            // Increment VRAM address based on VMAIN
-            if (vmain_ & 0x80) {
-                // Fixed increment
-                vram_addr_ += (1 << ((vmain_ >> 4) & 0x07));
-            } else {
-                // Increment by 1
-                vram_addr_ += 1;
-            }
-            break;
-        case 0x2121: // CGADD (CGRAM Address)
-            cgram_addr_ = value;
-            break;
-        case 0x2122: // CGDATA (CGRAM Data Write)
-            write_cgram(cgram_addr_, value);
-            cgram_addr_ = (cgram_addr_ + 1) & 0x1FF; // 9-bit address
-            break;
-        case 0x212C: // Main screen designation (OBJ enable)
-            tm_ = value;
-            break;
-        // TODO: Add more register logic as needed for $2100–$213F
-        default:
-            // Unimplemented registers: do nothing (open bus on read)
-            break;
+        cgram_addr_ = (cgram_addr_ + n) & 0x1FF;
+        data += n;
+        length -= n;
+    }
+}
+
+void PPU::write_oam_port(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        oam_port_write(data[i]);
     }
 }
 
 // --- BG tilemap/tile data base helpers ---
 uint32_t PPU::get_bg_tilemap_base(int bg) const {
     // BGnSC: bits 0-5 = tilemap base address (in VRAM, 2KB units)
-    //         bit 6 = size (0=32x32, 1=64x32/32x64/64x64)
-    //         bit 7 = unused
+    //         bit 6 = 64 tiles wide, bit 7 = 64 tiles tall (see render_bg_line)
     if (bg < 0 || bg > 3) return 0;
     return (bg_sc_[bg] & 0x3F) * 0x800; // 2KB units
 }
@@ -393,9 +363,7 @@ PPU::SpriteAttr PPU::parse_sprite_attr(int index) const {
 uint16_t PPU::get_cgram_color(int index) const {
     // Each color is 2 bytes (little endian), 15-bit SNES BGR
     if (index < 0 || index >= 256) return 0;
-    int addr = index * 2;
-    uint16_t color = cgram_[addr] | (cgram_[addr + 1] << 8);
-    return color & 0x7FFF; // 15-bit color
+    return palette_.bgr555(index);
 }
 
 // --- Scanline/frame timing and rendering stubs ---
@@ -412,6 +380,12 @@ void PPU::step_dot() {
     }
 }
 
+// Jump to a dot within the current scanline (used by the scheduler)
+void PPU::set_dot(int dot) {
+    dot_ = dot;
+    hblank_ = (dot_ >= (kDotsPerScanline - 40));
+}
+
 void PPU::step_scanline() {
     scanline_++;
     hblank_ = false;
@@ -420,10 +394,7 @@ void PPU::step_scanline() {
     if (scanline_ == kScreenHeight) {
         // Start of VBlank
         render_sprite_stub();
-        // Trigger NMI on CPU at start of VBLANK
-        if (bus_ && bus_->get_cpu()) {
-            bus_->get_cpu()->nmi();
-        }
+        // NMI is raised by the scheduler, gated by NMITIMEN
     }
     if (scanline_ >= kTotalScanlines) {
         scanline_ = 0;
@@ -451,29 +422,74 @@ void PPU::render_scanline_stub() {
 }
 
 void PPU::render_bg_scanline_stub(int scanline) {
-    // Mode 0: BG1, 2bpp, 32x32 tilemap, 8x8 tiles
+    // Mode 0: BG1, 2bpp, color index only
     if (scanline < 0 || scanline >= kScreenHeight) return;
-    int bg = 0; // BG1
-    int tilemap_base = get_bg_tilemap_base(bg); // 0x0000
-    int tiledata_base = get_bg_tiledata_base(bg); // 0x1000
-    int hscroll = bg_hofs_[bg] & 0x1FF;
-    int vscroll = bg_vofs_[bg] & 0x1FF;
-    int tile_y = ((scanline + vscroll) / 8) % 32;
+    uint8_t line[kScreenWidth];
+    render_bg_line(0, scanline, TileCache::k2bpp, line);
     for (int x = 0; x < kScreenWidth; ++x) {
-        int tile_x = ((x + hscroll) >> 3) % 32;
-        int map_addr = tilemap_base + 2 * (tile_y * 32 + tile_x);
-        uint8_t tile_lo = vram_[map_addr % vram_.size()];
-        uint8_t tile_hi = vram_[(map_addr + 1) % vram_.size()];
-        uint16_t tile_index = tile_lo | ((tile_hi & 0x03) << 8); // 10 bits
-        int palette = (tile_hi >> 2) & 0x07; // 3 bits (not used here)
-        int tile_addr = tiledata_base + tile_index * 16;
-        int y_in_tile = (scanline + vscroll) % 8;
-        // 2bpp: fetch bitplane 0 and 1
-        uint8_t bp0 = vram_[(tile_addr + y_in_tile) % vram_.size()];
-        uint8_t bp1 = vram_[(tile_addr + y_in_tile + 8) % vram_.size()];
-        int x_in_tile = 7 - ((x + hscroll) & 7);
-        int color = ((bp1 >> x_in_tile) & 1) << 1 | ((bp0 >> x_in_tile) & 1);
-        framebuffer_[scanline][x] = color;
+        framebuffer_[scanline][x] = line[x] & 0x03;
+    }
+}
+
+// Walks the visible tilemap entries of the line (33 for 8x8 tiles), each
+// fetched once, and copies 8 pixels at a time from the tile cache.
+// The map is one to four 32x32 screens of 2KB, laid out left to right then
+// top to bottom: 32x32, 64x32 (bit 6), 32x64 (bit 7) or 64x64. BGMODE bits
+// 4-7 select 16x16 tiles per BG, made of tiles n, n+1, n+16 and n+17.
+void PPU::render_bg_line(int bg, int scanline, TileCache::Depth depth, uint8_t* out) {
+    int tile_size = (bgmode_ & (0x10 << bg)) ? 16 : 8;
+    int tile_shift = tile_size == 16 ? 4 : 3;
+    int map_width = (bg_sc_[bg] & 0x40) ? 64 : 32;
+    int map_height = (bg_sc_[bg] & 0x80) ? 64 : 32;
+    uint32_t map_base = get_bg_tilemap_base(bg);
+    // Tile numbers count from the start of VRAM in units of the tile size
+    uint32_t tile_base = get_bg_tiledata_base(bg) >> (4 + depth);
+    int bpp = 2 << depth;
+
+    int y = (scanline + bg_vofs_[bg]) & ((map_height << tile_shift) - 1);
+    int tile_y = y >> tile_shift;
+    int fine_y = y & (tile_size - 1);
+    uint32_t row_base = map_base + ((tile_y & 32) ? (map_width == 64 ? 0x1000 : 0x800) : 0) + (tile_y & 31) * 64;
+
+    int x_mask = (map_width << tile_shift) - 1;
+    int sx = bg_hofs_[bg] & x_mask;
+    for (int x = 0; x < kScreenWidth;) {
+        int tile_x = sx >> tile_shift;
+        uint32_t map_addr = row_base + ((tile_x & 32) ? 0x800 : 0) + (tile_x & 31) * 2;
+        uint16_t entry = vram_[map_addr & 0xFFFF] | (vram_[(map_addr + 1) & 0xFFFF] << 8);
+        bool hflip = entry & 0x4000;
+        bool vflip = entry & 0x8000;
+        uint8_t palette = bpp < 8 ? ((entry >> 10) & 0x07) << bpp : 0;
+
+        int ty = vflip ? tile_size - 1 - fine_y : fine_y;
+        int tx = sx & (tile_size - 1);
+        int half = tx >> 3;
+        if (hflip && tile_size == 16) half ^= 1;
+        uint32_t tile = tile_base + (entry & 0x3FF) + (ty >> 3) * 16 + half;
+        const uint8_t* row = tile_cache_.tile(vram_, depth, tile) + (ty & 7) * 8;
+
+        // Whole tiles except at the ends of the line
+        int fx = tx & 7;
+        int count = std::min(8 - fx, kScreenWidth - x);
+        uint8_t* dst = out + x;
+        if (count == 8 && !hflip && !palette) {
+            memcpy(dst, row, 8);
+        } else if (count == 8) {
+            uint8_t pixels[8];
+            if (hflip) {
+                for (int i = 0; i < 8; ++i) pixels[i] = row[7 - i];
+            } else {
+                memcpy(pixels, row, 8);
+            }
+            for (int i = 0; i < 8; ++i) dst[i] = pixels[i] | (palette & -(uint8_t)(pixels[i] != 0));
+        } else {
+            for (int i = 0; i < count; ++i) {
+                uint8_t index = row[hflip ? 7 - fx - i : fx + i];
+                dst[i] = index | (index ? palette : 0);
+            }
+        }
+        x += count;
+        sx = (sx + count) & x_mask;
     }
 }
 
@@ -526,20 +542,19 @@ std::vector<int> PPU::get_sprites_on_scanline(int scanline) const {
 void PPU::export_framebuffer_ppm(const std::string& filename) const {
     std::ofstream ofs(filename, std::ios::binary);
     ofs << "P6\n" << kScreenWidth << " " << kScreenHeight << "\n255\n";
-    for (int y = 0; y < kScreenHeight; ++y) {
-        for (int x = 0; x < kScreenWidth; ++x) {
-            uint16_t color = framebuffer_[y][x] & 0x7FFF; // 15-bit BGR
-            uint8_t r = (color & 0x1F) << 3;      // 5 bits red
-            uint8_t g = ((color >> 5) & 0x1F) << 3; // 5 bits green
-            uint8_t b = ((color >> 10) & 0x1F) << 3; // 5 bits blue
-            ofs.put(r); ofs.put(g); ofs.put(b);
-        }
-    }
+    std::vector<uint8_t> rgb = get_framebuffer_rgb();
+    ofs.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
     ofs.close();
 }
 
 // Commented out methods not declared in PPU.hpp and not needed for Phase 1
 /*
+// Jump to a dot within the current scanline (used by the scheduler)
+void PPU::set_dot(int dot) {
+    dot_ = dot;
+    hblank_ = (dot_ >= (kDotsPerScanline - 40));
+}
+
 void PPU::step_scanline() {
     // Advance dot/cycle counter (not used in this stub)
     dot = 0;
@@ -605,38 +620,15 @@ void PPU::render_full_scanline(int scanline) {
     // TODO: Add other BG modes
 }
 
-// Modified render_mode0_background: fills PixelInfo array instead of framebuffer
+// Mode 0: four 2bpp BGs, fills PixelInfo instead of the framebuffer
 void PPU::render_mode0_background(int bg, int scanline, PixelInfo* out) {
-    int tilemap_base = get_bg_tilemap_base(bg);
-    int tiledata_base = get_bg_tiledata_base(bg);
-    int hscroll = bg_hofs_[bg] & 0x1FF;
-    int vscroll = bg_vofs_[bg] & 0x1FF;
-    int tile_y = ((scanline + vscroll) / 8) % 32;
+    uint8_t line[kScreenWidth];
+    render_bg_line(bg, scanline, TileCache::k2bpp, line);
     for (int x = 0; x < kScreenWidth; ++x) {
-        int tile_x = ((x + hscroll) >> 3) % 32;
-        int map_addr = tilemap_base + 2 * (tile_y * 32 + tile_x);
-        uint8_t tile_lo = vram_[map_addr % vram_.size()];
-        uint8_t tile_hi = vram_[(map_addr + 1) % vram_.size()];
-        uint16_t tile_index = tile_lo | ((tile_hi & 0x03) << 8);
-        int palette = (tile_hi >> 2) & 0x07;
-        int tile_addr = tiledata_base + tile_index * 16;
-        int y_in_tile = (scanline + vscroll) % 8;
-        uint8_t bp0 = vram_[(tile_addr + y_in_tile) % vram_.size()];
-        uint8_t bp1 = vram_[(tile_addr + y_in_tile + 8) % vram_.size()];
-        int x_in_tile = 7 - ((x + hscroll) & 7);
-        int color_index = ((bp1 >> x_in_tile) & 1) << 1 | ((bp0 >> x_in_tile) & 1);
-        if (color_index > 0) {
-            int cgram_index = palette * 4 + color_index;
-            out[x].color = get_cgram_color(cgram_index);
-            out[x].priority = bg;
-            out[x].transparent = false;
-            out[x].bg_layer = bg;
-        } else {
-            out[x].color = 0;
-            out[x].priority = bg;
-            out[x].transparent = true;
-            out[x].bg_layer = bg;
-        }
+        out[x].priority = bg;
+        out[x].bg_layer = bg;
+        out[x].transparent = line[x] == 0;
+        out[x].color = line[x] ? palette_.bgr555(line[x]) : 0;
     }
 }
 
@@ -646,18 +638,11 @@ void PPU::render_mode7_background(int scanline) {
 }
 
 std::vector<uint8_t> PPU::get_framebuffer_rgb() const {
-    std::vector<uint8_t> rgb;
-    rgb.reserve(kScreenHeight * kScreenWidth * 3);
-    for (int y = 0; y < kScreenHeight; ++y) {
-        for (int x = 0; x < kScreenWidth; ++x) {
-            uint16_t color = framebuffer_[y][x] & 0x7FFF; // 15-bit BGR
-            uint8_t r = (color & 0x1F) << 3;      // 5 bits red
-            uint8_t g = ((color >> 5) & 0x1F) << 3; // 5 bits green
-            uint8_t b = ((color >> 10) & 0x1F) << 3; // 5 bits blue
-            rgb.push_back(r);
-            rgb.push_back(g);
-            rgb.push_back(b);
-        }
-    }
+    std::vector<uint8_t> rgb(kScreenHeight * kScreenWidth * 3);
+    convert_framebuffer(PixelFormat::kRgb888, rgb.data());
     return rgb;
 }
+
+void PPU::convert_framebuffer(PixelFormat format, uint8_t* out) const {
+    convert_bgr555(&framebuffer_[0][0], kScreenHeight * kScreenWidth, format, display_brightness(), out);
+}
@@ -0,0 +1,279 @@
+#include "../include/scheduler.hpp"
+#include "../include/bus.hpp"
+#include "../include/cpu.hpp"
+#include "../include/cpu_sampler.hpp"
+#include "../include/ppu.hpp"
+#include <algorithm>
+
+Scheduler::Scheduler(CPU& cpu_, PPU& ppu_) : cpu(cpu_), ppu(ppu_) {
+    reset();
+}
+
+void Scheduler::reset() {
+    clock = 0;
+    line_start = 0;
+    nmitimen = 0;
+    htime = 0x1FF;
+    vtime = 0x1FF;
+    nmi_flag = false;
+    irq_flag = false;
+    queue.clear();
+    schedule(kRenderDot * kClocksPerDot, Event::kRenderScanline);
+    schedule(kHBlankDot * kClocksPerDot, Event::kHBlank);
+    schedule(kClocksPerScanline, Event::kScanlineEnd);
+    if (sampler) {
+        next_sample = sample_interval;
+        schedule(next_sample, Event::kSample);
+    }
+}
+
+void Scheduler::set_sampler(CPUSampler* sampler_, uint64_t interval_cycles) {
+    cancel(Event::kSample);
+    sampler = sampler_;
+    sample_interval = std::max<uint64_t>(interval_cycles, 1) * kClocksPerCpuCycle;
+    if (sampler) {
+        next_sample = clock + sample_interval;
+        schedule(next_sample, Event::kSample);
+    }
+}
+
+void Scheduler::save_state(SchedulerState& state) const {
+    state = SchedulerState{};
+    state.clock = clock;
+    state.line_start = line_start;
+    for (const Entry& entry : queue) {
+        if (entry.event != Event::kSample && state.event_count < SchedulerState::kMaxEvents) {
+            state.event_time[state.event_count] = entry.time;
+            state.event[state.event_count] = (uint8_t)entry.event;
+            state.event_count++;
+        }
+    }
+    state.nmitimen = nmitimen;
+    state.htime = htime;
+    state.vtime = vtime;
+    state.nmi_flag = nmi_flag;
+    state.irq_flag = irq_flag;
+}
+
+void Scheduler::load_state(const SchedulerState& state) {
+    clock = state.clock;
+    line_start = state.line_start;
+    queue.clear();
+    for (int i = 0; i < state.event_count && i < SchedulerState::kMaxEvents; ++i) {
+        queue.push_back(Entry{state.event_time[i], (Event)state.event[i]});
+    }
+    nmitimen = state.nmitimen;
+    htime = state.htime;
+    vtime = state.vtime;
+    nmi_flag = state.nmi_flag;
+    irq_flag = state.irq_flag;
+    if (sampler) {
+        next_sample = clock + sample_interval;
+        schedule(next_sample, Event::kSample);
+    }
+}
+
+// Events at the same time are dispatched in the order they were queued
+void Scheduler::schedule(uint64_t time, Event event) {
+    auto pos = std::find_if(queue.begin(), queue.end(),
+                            [time](const Entry& e) { return e.time <= time; });
+    queue.insert(pos, Entry{time, event});
+}
+
+void Scheduler::cancel(Event event) {
+    queue.erase(std::remove_if(queue.begin(), queue.end(),
+                               [event](const Entry& e) { return e.event == event; }),
+                queue.end());
+}
+
+// The CPU runs until the instruction that reaches the next event, so events
+// are seen at most one instruction late and PPU state is only touched when
+// something actually changes. A halted CPU (WAI/STP) skips straight to the
+// next event instead.
+void Scheduler::run_until(uint64_t cycle_target, uint64_t instruction_target) {
+    while (cpu.cycle_count < cycle_target && cpu.instruction_count < instruction_target) {
+        uint64_t start = cpu.cycle_count;
+        uint64_t to_event = (queue.back().time - clock + kClocksPerCpuCycle - 1) / kClocksPerCpuCycle;
+        if (to_event > cycle_target - start) to_event = cycle_target - start;
+
+        if (cpu.is_halted()) {
+            // With no cycle limit, only wait for an interrupt that can come
+            if (cycle_target == UINT64_MAX && !can_wake()) {
+                break;
+            }
+            cpu.cycle_count += to_event;
+        } else {
+            uint64_t start_instructions = cpu.instruction_count;
+            cpu.run_until(start + to_event, instruction_target);
+            if (cpu.instruction_count == start_instructions) {
+                break; // CPU not connected to the bus yet
+            }
+        }
+
+        clock += (cpu.cycle_count - start) * kClocksPerCpuCycle;
+        while (queue.back().time <= clock) {
+            Event event = queue.back().event;
+            queue.pop_back();
+            dispatch(event);
+        }
+        // /IRQ stays asserted until TIMEUP is read, so an IRQ masked by I
+        // is taken at the first boundary after it is unmasked
+        if (irq_flag) {
+            cpu.irq();
+        }
+    }
+    ppu.set_dot((int)((clock - line_start) / kClocksPerDot));
+}
+
+// Whether a halted CPU will ever resume: STP needs a reset, WAI an NMI or IRQ
+bool Scheduler::can_wake() const {
+    if (cpu.get_halt() == CPU::Halt::Stop) {
+        return false;
+    }
+    if ((nmitimen & 0x80) || irq_flag) {
+        return true;
+    }
+    return std::any_of(queue.begin(), queue.end(),
+                       [](const Entry& e) { return e.event == Event::kIrqTimer; });
+}
+
+void Scheduler::dispatch(Event event) {
+    switch (event) {
+    case Event::kRenderScanline:
+        ppu.render_full_scanline(ppu.get_scanline());
+        break;
+    case Event::kHBlank:
+        ppu.set_dot(kHBlankDot);
+        if (bus && ppu.get_scanline() < PPU::kScreenHeight) {
+            stall_cpu(bus->hdma_line());
+        }
+        schedule(line_start + kClocksPerScanline + kHBlankDot * kClocksPerDot, Event::kHBlank);
+        break;
+    case Event::kScanlineEnd:
+        line_start += kClocksPerScanline;
+        ppu.set_dot(0);
+        ppu.step_scanline();
+        if (ppu.get_scanline() == PPU::kScreenHeight) {
+            // Start of V-blank
+            nmi_flag = true;
+            if (nmitimen & 0x80) {
+                cpu.nmi();
+            }
+        } else if (ppu.get_scanline() == 0) {
+            nmi_flag = false;
+            // Lines are drawn from 0 here where the hardware starts at 1,
+            // so the transfer it makes in line 0's H-blank comes with the init
+            if (bus) {
+                stall_cpu(bus->hdma_init());
+                stall_cpu(bus->hdma_line());
+            }
+        }
+        if (ppu.get_scanline() < PPU::kScreenHeight) {
+            schedule(line_start + kRenderDot * kClocksPerDot, Event::kRenderScanline);
+        }
+        schedule(line_start + kClocksPerScanline, Event::kScanlineEnd);
+        break;
+    case Event::kIrqTimer:
+        irq_flag = true;
+        schedule_irq_timer();
+        break;
+    case Event::kSample:
+        sampler->sample((((uint32_t)cpu.pb << 16) | cpu.pc) & 0xFFFFFF, cpu.stkp);
+        // One sample per due time; intervals the CPU ran past in a single
+        // instruction (block moves, skipped idle loops) are dropped
+        while (next_sample <= clock) next_sample += sample_interval;
+        schedule(next_sample, Event::kSample);
+        break;
+    }
+}
+
+// HDMA holds the CPU between instructions; the time passes for the PPU too
+void Scheduler::stall_cpu(uint64_t clocks) {
+    uint64_t cycles = (clocks + kClocksPerCpuCycle - 1) / kClocksPerCpuCycle;
+    cpu.cycle_count += cycles;
+    clock += cycles * kClocksPerCpuCycle;
+}
+
+// NMITIMEN bits 4-5 select the IRQ: H fires at dot HTIME of every line,
+// V at the start of line VTIME, HV at dot HTIME of line VTIME
+void Scheduler::schedule_irq_timer() {
+    cancel(Event::kIrqTimer);
+    int mode = (nmitimen >> 4) & 0x03;
+    int dot = (mode & 0x01) ? htime : 0;
+    if (mode == 0 || dot >= PPU::kDotsPerScanline) {
+        return;
+    }
+
+    uint64_t time = line_start + (uint64_t)dot * kClocksPerDot;
+    if (mode & 0x02) {
+        if (vtime >= PPU::kTotalScanlines) {
+            return;
+        }
+        int lines = (vtime - ppu.get_scanline() + PPU::kTotalScanlines) % PPU::kTotalScanlines;
+        time += (uint64_t)lines * kClocksPerScanline;
+        if (time <= clock) time += kClocksPerFrame;
+    } else if (time <= clock) {
+        time += kClocksPerScanline;
+    }
+    schedule(time, Event::kIrqTimer);
+}
+
+void Scheduler::write_nmitimen(uint8_t value) {
+    nmitimen = value;
+    if (!(value & 0x30)) {
+        irq_flag = false;
+    }
+    schedule_irq_timer();
+}
+
+void Scheduler::write_timer(uint16_t addr, uint8_t value) {
+    switch (addr) {
+    case 0x4207: htime = (htime & 0x100) | value; break;
+    case 0x4208: htime = (htime & 0x0FF) | ((value & 0x01) << 8); break;
+    case 0x4209: vtime = (vtime & 0x100) | value; break;
+    case 0x420A: vtime = (vtime & 0x0FF) | ((value & 0x01) << 8); break;
+    default: return;
+    }
+    schedule_irq_timer();
+}
+
+// Bit 7 is set at the start of V-blank and cleared by reading; the low
+// bits are the CPU version
+uint8_t Scheduler::read_rdnmi() {
+    uint8_t value = (nmi_flag ? 0x80 : 0x00) | 0x02;
+    nmi_flag = false;
+    return value;
+}
+
+uint8_t Scheduler::read_timeup() {
+    uint8_t value = irq_flag ? 0x80 : 0x00;
+    irq_flag = false;
+    return value;
+}
+
+uint8_t Scheduler::read_hvbjoy() const {
+    return (ppu.get_vblank() ? 0x80 : 0x00) | (ppu.get_hblank() ? 0x40 : 0x00);
+}
+
+namespace {
+
+Scheduler& scheduler_of(void* device) { return *static_cast<Scheduler*>(device); }
+
+void write_timer_register(void* device, uint16_t addr, uint8_t data) {
+    scheduler_of(device).write_timer(addr, data);
+}
+
+} // namespace
+
+const MmioRegister Scheduler::kRegisters[Scheduler::kRegisterCount] = {
+    {0x4200, "NMITIMEN", nullptr,
+     [](void* d, uint16_t, uint8_t v) { scheduler_of(d).write_nmitimen(v); }, MmioRegister::kOpenBus},
+    {0x4207, "HTIMEL", nullptr, write_timer_register, MmioRegister::kOpenBus},
+    {0x4208, "HTIMEH", nullptr, write_timer_register, MmioRegister::kOpenBus},
+    {0x4209, "VTIMEL", nullptr, write_timer_register, MmioRegister::kOpenBus},
+    {0x420A, "VTIMEH", nullptr, write_timer_register, MmioRegister::kOpenBus},
+    {0x4210, "RDNMI", [](void* d, uint16_t) { return scheduler_of(d).read_rdnmi(); }, nullptr, 0},
+    {0x4211, "TIMEUP", [](void* d, uint16_t) { return scheduler_of(d).read_timeup(); }, nullptr, 0},
+    {0x4212, "HVBJOY", [](void* d, uint16_t) { return scheduler_of(d).read_hvbjoy(); }, nullptr,
+     MmioRegister::kNoSideEffects},
+};
@@ -0,0 +1,52 @@
+#include "../include/simd.hpp"
+
+namespace {
+
+SimdLevel& current_level() {
+    static SimdLevel level = simd_best_level();
+    return level;
+}
+
+} // namespace
+
+bool simd_supported(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::kScalar:
+        return true;
+#if defined(PYSNES_SIMD)
+    case SimdLevel::kSse2:
+        return true;    // Part of x86-64
+    case SimdLevel::kAvx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+SimdLevel simd_best_level() {
+    if (simd_supported(SimdLevel::kAvx2)) return SimdLevel::kAvx2;
+    if (simd_supported(SimdLevel::kSse2)) return SimdLevel::kSse2;
+    return SimdLevel::kScalar;
+}
+
+SimdLevel simd_level() {
+    return current_level();
+}
+
+bool set_simd_level(SimdLevel level) {
+    if (!simd_supported(level)) {
+        return false;
+    }
+    current_level() = level;
+    return true;
+}
+
+const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::kSse2: return "sse2";
+    case SimdLevel::kAvx2: return "avx2";
+    case SimdLevel::kScalar:
+    default: return "scalar";
+    }
+}
@@ -2,8 +2,39 @@
 #include "bus.hpp"
 #include "cartridge.hpp"
 #include "cpu.hpp"
+#include "cpu_instructions.hpp"
+#include "cpu_opcodes.hpp"
+#include "cpu_sampler.hpp"
 #include "ppu.hpp"       // <-- Add PPU include
 #include "controller.hpp" // <-- Add Controller include
+#include "scheduler.hpp"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+constexpr char kStateMagic[4] = {'P', 'S', 'N', 'S'};
+// Bump whenever a state struct changes layout
+constexpr uint32_t kStateVersion = 5;
+
+struct StateHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t size;          // Whole state, header and SRAM included
+    uint32_t sram_size;     // Cartridge SRAM bytes following MachineState
+};
+
+struct MachineState {
+    StateHeader header;
+    CPUState cpu;
+    BusState bus;
+    PPUState ppu;
+    SchedulerState scheduler;
+    ControllerState controllers[2];
+};
+static_assert(std::is_trivially_copyable<MachineState>::value, "save states are copied as bytes");
+
+} // namespace
 
 struct SNES::Impl {
     std::shared_ptr<Bus> bus;
@@ -11,6 +42,14 @@ struct SNES::Impl {
     std::shared_ptr<Cartridge> cartridge;
     std::shared_ptr<PPU> ppu;
     std::array<std::shared_ptr<Controller>, 2> controllers;
+    std::unique_ptr<Scheduler> scheduler;
+    CPUSampler sampler;
+    SymbolTable symbols;
+    std::string rom_path;
+    // Aligned copy for loading states from unaligned buffers
+    std::unique_ptr<MachineState> load_buffer;
+
+    size_t sram_size() const { return cartridge ? cartridge->sram_size() : 0; }
 
     Impl() {
         bus = std::make_shared<Bus>();
@@ -22,6 +61,8 @@ struct SNES::Impl {
         }
         bus->connect_cpu(cpu);
         bus->connect_ppu(ppu);
+        scheduler = std::make_unique<Scheduler>(*cpu, *ppu);
+        bus->connect_scheduler(scheduler.get());
     }
 };
 
@@ -30,6 +71,7 @@ SNES::~SNES() = default;
 
 void SNES::insert_cartridge(const std::string &rom_path) {
     pimpl->cartridge = std::make_shared<Cartridge>(rom_path);
+    pimpl->rom_path = rom_path;
     pimpl->bus->connect_cartridge(pimpl->cartridge);
 }
 
@@ -38,6 +80,8 @@ void SNES::power_on() {
     // No power_on() method in CPU/PPU, so just reset
     pimpl->cpu->reset();
     pimpl->ppu->reset();
+    pimpl->scheduler->reset();
+    pimpl->sampler.clear_call_stack();
 }
 
 void SNES::reset() {
@@ -45,32 +89,123 @@ void SNES::reset() {
     pimpl->ppu->reset();
     if (pimpl->cartridge) pimpl->cartridge->reset();
     pimpl->bus->reset();
+    pimpl->scheduler->reset();
+    pimpl->sampler.clear_call_stack();
 }
 
 void SNES::step() {
-    pimpl->cpu->step();
-    for (int i = 0; i < 4; ++i) {
-        pimpl->ppu->step_dot();
+    CPU& cpu = *pimpl->cpu;
+    pimpl->scheduler->run_until(UINT64_MAX, cpu.instruction_count + 1);
+}
+
+uint64_t SNES::run(uint64_t cycles) {
+    CPU& cpu = *pimpl->cpu;
+    uint64_t start = cpu.cycle_count;
+    uint64_t target = (cycles > UINT64_MAX - start) ? UINT64_MAX : start + cycles;
+    pimpl->scheduler->run_until(target, UINT64_MAX);
+    return cpu.cycle_count - start;
+}
+
+uint64_t SNES::run_instructions(uint64_t count) {
+    CPU& cpu = *pimpl->cpu;
+    uint64_t start = cpu.instruction_count;
+    uint64_t target = (count > UINT64_MAX - start) ? UINT64_MAX : start + count;
+    pimpl->scheduler->run_until(UINT64_MAX, target);
+    return cpu.instruction_count - start;
+}
+
+size_t SNES::state_size() const {
+    return sizeof(MachineState) + pimpl->sram_size();
+}
+
+void SNES::save_state(std::vector<uint8_t> &buffer) {
+    size_t sram_size = pimpl->sram_size();
+    buffer.resize(sizeof(MachineState) + sram_size);
+    MachineState& state = *reinterpret_cast<MachineState*>(buffer.data());
+    memcpy(state.header.magic, kStateMagic, sizeof(kStateMagic));
+    state.header.version = kStateVersion;
+    state.header.size = (uint32_t)buffer.size();
+    state.header.sram_size = (uint32_t)sram_size;
+    pimpl->cpu->save_state(state.cpu);
+    pimpl->bus->save_state(state.bus);
+    pimpl->ppu->save_state(state.ppu);
+    pimpl->scheduler->save_state(state.scheduler);
+    for (int i = 0; i < 2; ++i) {
+        pimpl->controllers[i]->save_state(state.controllers[i]);
+    }
+    if (sram_size) {
+        memcpy(buffer.data() + sizeof(MachineState), pimpl->cartridge->sram(), sram_size);
+    }
+}
+
+bool SNES::load_state(const uint8_t *data, size_t size) {
+    size_t sram_size = pimpl->sram_size();
+    if (size != sizeof(MachineState) + sram_size) {
+        return false;
+    }
+    const MachineState* state = reinterpret_cast<const MachineState*>(data);
+    if ((uintptr_t)data % alignof(MachineState) != 0) {
+        if (!pimpl->load_buffer) pimpl->load_buffer = std::make_unique<MachineState>();
+        memcpy(pimpl->load_buffer.get(), data, sizeof(MachineState));
+        state = pimpl->load_buffer.get();
+    }
+    if (memcmp(state->header.magic, kStateMagic, sizeof(kStateMagic)) != 0 ||
+        state->header.version != kStateVersion || state->header.size != size || state->header.sram_size != sram_size ||
+        state->scheduler.event_count == 0 || state->scheduler.event_count > SchedulerState::kMaxEvents) {
+        return false;
+    }
+
+    if (!pimpl->cpu->bus) pimpl->cpu->connect_bus(pimpl->bus);
+    pimpl->cpu->load_state(state->cpu);
+    pimpl->bus->load_state(state->bus);
+    pimpl->ppu->load_state(state->ppu);
+    pimpl->scheduler->load_state(state->scheduler);
+    for (int i = 0; i < 2; ++i) {
+        pimpl->controllers[i]->load_state(state->controllers[i]);
+    }
+    if (sram_size) {
+        memcpy(pimpl->cartridge->sram(), data + sizeof(MachineState), sram_size);
     }
+    pimpl->sampler.clear_call_stack();
+    return true;
+}
+
+const std::string &SNES::get_rom_path() const {
+    return pimpl->rom_path;
+}
+
+std::map<std::string, std::string> SNES::get_cartridge_info() const {
+    std::map<std::string, std::string> info;
+    if (!pimpl->cartridge || !pimpl->cartridge->is_loaded()) {
+        return info;
+    }
+    const Cartridge& cart = *pimpl->cartridge;
+    const Cartridge::Header& header = cart.header();
+    info["title"] = header.title;
+    info["mapper"] = Cartridge::mapper_name(header.mapper);
+    info["speed"] = header.fast_rom ? "FastROM" : "SlowROM";
+    info["rom_size"] = std::to_string(cart.rom_size());
+    info["sram_size"] = std::to_string(cart.sram_size());
+    info["checksum"] = (uint16_t)(header.checksum + header.complement) == 0xFFFF ? "valid" : "invalid";
+    return info;
+}
+
+std::map<uint16_t, std::tuple<std::string, bool, bool, bool>> SNES::get_io_registers() const {
+    std::map<uint16_t, std::tuple<std::string, bool, bool, bool>> registers;
+    for (const auto& entry : pimpl->bus->io_registers()) {
+        const MmioRegister& reg = *entry.second;
+        registers[entry.first] = std::make_tuple(std::string(reg.name), !(reg.flags & MmioRegister::kOpenBus),
+                                                 reg.write != nullptr,
+                                                 (reg.flags & MmioRegister::kNoSideEffects) != 0);
+    }
+    return registers;
 }
 
 std::vector<uint32_t>& SNES::get_screen() {
     // Convert PPU framebuffer (uint16_t) to uint32_t RGBA8888
     static std::vector<uint32_t> framebuffer32;
-    constexpr int height = PPU::kScreenHeight;
-    constexpr int width = PPU::kScreenWidth;
-    framebuffer32.resize(height * width);
-    for (int y = 0; y < height; ++y) {
-        const uint16_t* row = pimpl->ppu->get_framebuffer_row(y);
-        for (int x = 0; x < width; ++x) {
-            uint16_t color = row[x];
-            // SNES color: 15-bit BGR (0bbbbbgggggrrrrr)
-            uint8_t r = (color & 0x1F) << 3;
-            uint8_t g = ((color >> 5) & 0x1F) << 3;
-            uint8_t b = ((color >> 10) & 0x1F) << 3;
-            framebuffer32[y * width + x] = (0xFF << 24) | (b << 16) | (g << 8) | r; // ARGB
-        }
-    }
+    framebuffer32.resize(PPU::kScreenHeight * PPU::kScreenWidth);
+    pimpl->ppu->convert_framebuffer(PixelFormat::kRgba8888, reinterpret_cast<uint8_t*>(framebuffer32.data()));
     return framebuffer32;
 }
 
@@ -78,9 +213,181 @@ std::vector<uint8_t> SNES::get_framebuffer_rgb() {
     return pimpl->ppu->get_framebuffer_rgb();
 }
 
+void SNES::get_framebuffer(PixelFormat format, uint8_t* out) {
+    pimpl->ppu->convert_framebuffer(format, out);
+}
+
 void SNES::set_controller_state(int controller_num, uint8_t state) {
     if (controller_num >= 1 && controller_num <= 2) {
         auto ctrl = pimpl->controllers[controller_num - 1];
         if (ctrl) ctrl->buttons = state;
     }
 }
+
+void SNES::set_idle_loop_skipping(bool enabled) {
+    pimpl->cpu->set_idle_skip_enabled(enabled);
+}
+
+bool SNES::get_idle_loop_skipping() {
+    return pimpl->cpu->get_idle_skip_enabled();
+}
+
+std::map<std::string, uint64_t> SNES::get_idle_loop_stats() {
+    const CPU::IdleLoopStats& stats = pimpl->cpu->get_idle_stats();
+    return {{"skips", stats.skips}, {"cycles", stats.cycles}, {"instructions", stats.instructions}};
+}
+
+void SNES::reset_idle_loop_stats() {
+    pimpl->cpu->reset_idle_stats();
+}
+
+int SNES::trace_level() {
+    return PYSNES_TRACE_LEVEL;
+}
+
+std::vector<uint8_t> SNES::get_trace() {
+    return pimpl->cpu->get_trace().dump();
+}
+
+bool SNES::dump_trace(const std::string &path) {
+    return pimpl->cpu->get_trace().dump(path);
+}
+
+void SNES::clear_trace() {
+    pimpl->cpu->get_trace().clear();
+}
+
+void SNES::set_trace_capacity(size_t records) {
+    pimpl->cpu->get_trace().set_capacity(records);
+}
+
+std::vector<std::string> SNES::format_trace() {
+    std::vector<std::string> lines;
+    for (const TraceRecord& record : pimpl->cpu->get_trace().records()) {
+        lines.push_back(CPUOpcodes::format_trace(record));
+    }
+    return lines;
+}
+
+std::vector<std::string> SNES::disassemble(uint32_t addr, size_t count) {
+    const Bus& bus = *pimpl->bus;
+    uint16_t p = pimpl->cpu->p;
+    bool emulation = (p & CPU::E) != 0;
+    bool m16 = !(p & (CPU::M | CPU::E));
+    bool x16 = !(p & (CPU::X | CPU::E));
+    std::vector<std::string> lines;
+    for (size_t n = 0; n < count; ++n) {
+        // Only host-backed memory is read, so I/O registers keep their state
+        uint8_t bytes[4];
+        for (int i = 0; i < 4; ++i) {
+            const uint8_t* byte = bus.host_read(addr + i);
+            bytes[i] = byte ? *byte : 0;
+        }
+        char prefix[10];
+        snprintf(prefix, sizeof(prefix), "%02X:%04X  ", (addr >> 16) & 0xFF, addr & 0xFFFF);
+        lines.push_back(prefix + CPUOpcodes::disassemble(bytes, addr, m16, x16));
+
+        if (!emulation && bytes[0] == 0xC2) {          // REP
+            m16 |= (bytes[1] & CPU::M) != 0;
+            x16 |= (bytes[1] & CPU::X) != 0;
+        } else if (!emulation && bytes[0] == 0xE2) {   // SEP
+            m16 &= !(bytes[1] & CPU::M);
+            x16 &= !(bytes[1] & CPU::X);
+        }
+        // PC wraps within the bank
+        addr = (addr & 0xFF0000) | ((addr + CPUOpcodes::length(bytes[0], m16, x16)) & 0xFFFF);
+    }
+    return lines;
+}
+
+std::map<std::string, uint64_t> SNES::get_unimplemented_opcodes() {
+    const auto& counts = pimpl->cpu->get_unimplemented_counts();
+    std::map<std::string, uint64_t> report;
+    for (int op = 0; op < 256; ++op) {
+        if (!CPUInstructions::is_implemented(op)) {
+            char key[16];
+            snprintf(key, sizeof(key), "$%02X %s", op, CPUOpcodes::kTable[op].mnemonic);
+            report[key] = counts[op];
+        }
+    }
+    return report;
+}
+
+bool SNES::profiling_available() {
+    return PYSNES_PROFILE != 0;
+}
+
+std::map<std::string, std::vector<uint64_t>> SNES::get_profile() {
+    const CPUProfile& profile = pimpl->cpu->get_profile();
+    auto values = [](const auto& counters) {
+        return std::vector<uint64_t>(counters.begin(), counters.end());
+    };
+    return {
+        {"opcode_count", values(profile.opcode_count)},
+        {"opcode_cycles", values(profile.opcode_cycles)},
+        {"mode_count", values(profile.mode_count())},
+        {"mode_cycles", values(profile.mode_cycles())},
+        {"bus_reads", values(profile.bus_reads)},
+        {"bus_writes", values(profile.bus_writes)},
+    };
+}
+
+void SNES::reset_profile() {
+    pimpl->cpu->get_profile().reset();
+}
+
+std::vector<std::string> SNES::profile_mode_names() {
+    std::vector<std::string> names;
+    for (int mode = 0; mode < CPUProfile::kModeCount; ++mode) {
+        names.push_back(CPUProfile::mode_name(mode));
+    }
+    return names;
+}
+
+std::vector<std::string> SNES::profile_region_names() {
+    std::vector<std::string> names;
+    for (int region = 0; region < CPUProfile::kRegionCount; ++region) {
+        names.push_back(CPUProfile::region_name(region));
+    }
+    return names;
+}
+
+void SNES::start_sampling(uint64_t interval_cycles) {
+    pimpl->cpu->set_sampler(&pimpl->sampler);
+    pimpl->scheduler->set_sampler(&pimpl->sampler, interval_cycles);
+}
+
+void SNES::stop_sampling() {
+    pimpl->cpu->set_sampler(nullptr);
+    pimpl->scheduler->set_sampler(nullptr, 0);
+    pimpl->sampler.clear_call_stack();
+}
+
+void SNES::reset_samples() {
+    pimpl->sampler.reset();
+}
+
+bool SNES::load_symbols(const std::string &path) {
+    return pimpl->symbols.load(path);
+}
+
+void SNES::clear_symbols() {
+    pimpl->symbols.clear();
+}
+
+std::string SNES::resolve_symbol(uint32_t addr) {
+    return pimpl->symbols.resolve(addr);
+}
+
+std::map<uint32_t, uint64_t> SNES::get_pc_samples() {
+    const auto& histogram = pimpl->sampler.pc_histogram();
+    return std::map<uint32_t, uint64_t>(histogram.begin(), histogram.end());
+}
+
+std::map<std::string, uint64_t> SNES::get_flat_profile() {
+    return pimpl->sampler.flat_profile(pimpl->symbols);
+}
+
+std::map<std::string, uint64_t> SNES::get_call_stack_profile() {
+    return pimpl->sampler.stack_profile(pimpl->symbols);
+}
@@ -0,0 +1,40 @@
+#include "../include/tile_cache.hpp"
+#include "../include/planar.hpp"
+#include <algorithm>
+
+TileCache::TileCache() {
+    for (int depth = 0; depth < kDepths; ++depth) {
+        size_t tiles = kVramSize >> (4 + depth);
+        pixels[depth].assign(tiles * kTileBytes, 0);
+        dirty[depth].assign(tiles, 1);
+    }
+}
+
+void TileCache::invalidate(uint32_t addr, size_t length) {
+    if (length >= kVramSize) {
+        invalidate_all();
+        return;
+    }
+    addr &= kVramSize - 1;
+    for (int depth = 0; depth < kDepths; ++depth) {
+        int shift = 4 + depth;
+        uint32_t mask = (uint32_t)(kVramSize >> shift) - 1;
+        uint32_t first = addr >> shift;
+        uint32_t last = (uint32_t)((addr + length - 1) >> shift);
+        for (uint32_t tile = first; tile <= last; ++tile) {
+            dirty[depth][tile & mask] = 1;
+        }
+    }
+}
+
+void TileCache::invalidate_all() {
+    for (auto& flags : dirty) {
+        std::fill(flags.begin(), flags.end(), 1);
+    }
+}
+
+void TileCache::decode(const std::array<uint8_t, kVramSize>& vram, Depth depth, uint32_t tile) {
+    int planes = 2 << depth;
+    planar_to_chunky_tile(&vram[tile * (8 * planes)], planes, false, &pixels[depth][tile * kTileBytes]);
+    dirty[depth][tile] = 0;
+}
@@ -0,0 +1,94 @@
+// CPU interpreter microbenchmark: instructions per second by opcode family.
+// Build with `cmake --build build --target bench_cpu` and run ./build/bench_cpu.
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "cpu.hpp"
+#include "bus.hpp"
+
+namespace {
+
+struct Family {
+    const char* name;
+    uint8_t opcode;
+    uint8_t operand_bytes;  // Operand size with 8-bit registers
+    bool grows_with_width;  // Immediate operand gains a byte in 16-bit mode
+    bool index_width;       // Width follows X rather than M
+};
+
+const Family kFamilies[] = {
+    {"LDA #imm",  0xA9, 1, true,  false},
+    {"LDA abs",   0xAD, 2, false, false},
+    {"LDA [dp],Y",0xB7, 1, false, false},
+    {"STA abs",   0x8D, 2, false, false},
+    {"ADC dp",    0x65, 1, false, false},
+    {"SBC #imm",  0xE9, 1, true,  false},
+    {"CMP abs",   0xCD, 2, false, false},
+    {"AND #imm",  0x29, 1, true,  false},
+    {"EOR dp,X",  0x55, 1, false, false},
+    {"BIT abs",   0x2C, 2, false, false},
+    {"INC dp",    0xE6, 1, false, false},
+    {"ASL A",     0x0A, 0, false, false},
+    {"ROL abs",   0x2E, 2, false, false},
+    {"CPX #imm",  0xE0, 1, true,  true},
+    {"INX",       0xE8, 0, false, true},
+};
+
+constexpr uint32_t kCodeBase = 0x7E1000;
+constexpr int kBlockInstructions = 256;
+constexpr int kPasses = 8000;
+
+// step() goes through the interpreter one instruction at a time; batched
+// runs use run_instructions(), which enters JIT-translated blocks when built
+double run_family(const Family& f, bool wide, bool batched) {
+    auto bus = std::make_shared<Bus>();
+    auto cpu = std::make_shared<CPU>();
+    cpu->connect_bus(bus);
+
+    // Block of identical instructions; operands point at $0020/$0220 in WRAM
+    int length = 1 + f.operand_bytes + ((wide && f.grows_with_width) ? 1 : 0);
+    uint32_t addr = kCodeBase;
+    for (int i = 0; i < kBlockInstructions; ++i) {
+        bus->write(addr++, f.opcode);
+        for (int b = 1; b < length; ++b) {
+            bus->write(addr++, b == 1 ? 0x20 : 0x02);
+        }
+    }
+
+    uint16_t width_flag = f.index_width ? CPU::X : CPU::M;
+    cpu->p = wide ? (cpu->p & ~width_flag) : (cpu->p | width_flag);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < kPasses; ++pass) {
+        cpu->pc = kCodeBase;
+        cpu->x = 0;
+        if (batched) {
+            cpu->run_instructions(kBlockInstructions);
+        } else {
+            for (int i = 0; i < kBlockInstructions; ++i) {
+                cpu->step();
+            }
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return (double)kPasses * kBlockInstructions / elapsed.count();
+}
+
+} // namespace
+
+int main() {
+    for (bool batched : {false, true}) {
+        std::printf("%s\n", batched ? (CPU::jit_available() ? "run_instructions() + JIT" : "run_instructions()")
+                                    : "step()");
+        std::printf("%-12s %14s %14s\n", "family", "8-bit MIPS", "16-bit MIPS");
+        for (const Family& f : kFamilies) {
+            double narrow = run_family(f, false, batched);
+            double wide = run_family(f, true, batched);
+            std::printf("%-12s %14.2f %14.2f\n", f.name, narrow / 1e6, wide / 1e6);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
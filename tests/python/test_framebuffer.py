@@ -22,5 +22,22 @@ def test_framebuffer_rgb_shape_and_type():
 def test_input_handling_stub():
     pytest.skip("Not yet implemented: input handling test stub.")
 
-def test_state_save_load_stub():
-    pytest.skip("Not yet implemented: state save/load test stub.") 
\ No newline at end of file
+def test_state_save_load():
+    import copy
+    import pickle
+    snes = SNES()
+    snes.power_on()
+    snes.run(10000)
+    state = snes.save_state()
+    assert isinstance(state, bytes)
+    assert len(state) == snes.state_size
+    snes.run(50000)
+    after = snes.save_state()
+    snes.load_state(state)
+    snes.run(50000)
+    assert snes.save_state() == after
+    # pickle and deepcopy go through the same snapshot
+    assert pickle.loads(pickle.dumps(snes)).save_state() == after
+    assert copy.deepcopy(snes).save_state() == after
+    with pytest.raises(ValueError):
+        snes.load_state(state[:-1]) 
\ No newline at end of file
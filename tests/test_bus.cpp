@@ -0,0 +1,337 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "bus.hpp"
+#include "cartridge.hpp"
+#include "cpu.hpp"
+#include "ppu.hpp"
+
+// Base Bus Test Class
+class BusTest : public ::testing::Test {
+protected:
+    std::shared_ptr<Bus> bus;
+    void SetUp() override {
+        bus = std::make_shared<Bus>();
+    }
+
+    // Write a ROM image to a temporary file and insert it
+    void insert_rom(const std::vector<uint8_t>& image) {
+        std::string path = ::testing::TempDir() + "bus_test.sfc";
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(image.data()), image.size());
+        out.close();
+        bus->connect_cartridge(std::make_shared<Cartridge>(path));
+        std::remove(path.c_str());
+    }
+};
+
+TEST_F(BusTest, WramMirrorsIntoSystemBanks) {
+    bus->write(0x7E0123, 0x42);
+    EXPECT_EQ(bus->read(0x000123), 0x42);
+    bus->write(0x001FFF, 0x99);
+    EXPECT_EQ(bus->read(0x7E1FFF), 0x99);
+    // Every bank in $00-$3F and $80-$BF sees the low 8KB
+    bus->write(0x7E0100, 0x5A);
+    EXPECT_EQ(bus->read(0x800100), 0x5A);
+    EXPECT_EQ(bus->read(0x3F1FFF), 0x99);
+    bus->write(0xBF0100, 0xA5);
+    EXPECT_EQ(bus->read(0x7E0100), 0xA5);
+    EXPECT_EQ(bus->code_page(0x800100), 1);
+    // but not the banks above $40
+    EXPECT_EQ(bus->read(0x400123), 0x00);
+    EXPECT_EQ(bus->read(0xC00123), 0x00);
+    bus->write(0x7F0000, 0x17);
+    EXPECT_EQ(bus->read(0x7F0000), 0x17);
+    EXPECT_EQ(bus->read(0x000000), 0x00);
+}
+
+TEST_F(BusTest, UnmappedReadsZeroAndIgnoresWrites) {
+    bus->write(0x006000, 0x55);
+    EXPECT_EQ(bus->read(0x006000), 0x00);
+    bus->write(0x808000, 0x55);
+    EXPECT_EQ(bus->read(0x808000), 0x00);
+}
+
+TEST_F(BusTest, VectorsWithoutCartridge) {
+    bus->set_interrupt_vector(0x34, 0x12);
+    EXPECT_EQ(bus->read(0x00FFFE), 0x34);
+    EXPECT_EQ(bus->read(0x00FFFF), 0x12);
+    EXPECT_EQ(bus->read(0x00FFFD), 0x00);
+}
+
+TEST_F(BusTest, CartridgeRomMappedIntoEveryBank) {
+    std::vector<uint8_t> image(0x10000);
+    for (size_t i = 0; i < image.size(); ++i) image[i] = (uint8_t)(i ^ (i >> 8));
+    // HiROM header: map mode, checksum pair, reset vector to a SEI
+    image[0xFFD5] = 0x21;
+    image[0xFFDC] = 0x00; image[0xFFDD] = 0x00;
+    image[0xFFDE] = 0xFF; image[0xFFDF] = 0xFF;
+    image[0xFFFC] = 0x00; image[0xFFFD] = 0x80;
+    image[0x8000] = 0x78;
+    insert_rom(image);
+    EXPECT_EQ(bus->read(0x008000), image[0x8000]);
+    EXPECT_EQ(bus->read(0xC01234), image[0x1234]);
+    EXPECT_EQ(bus->read(0x418000), image[0x8000]);
+    EXPECT_EQ(bus->read(0x00FFFF), image[0xFFFF]);
+    EXPECT_EQ(bus->read(0x80C123), image[0xC123]);
+    // ROM is read only
+    bus->write(0x009000, ~image[0x9000]);
+    EXPECT_EQ(bus->read(0x009000), image[0x9000]);
+    // WRAM banks take priority
+    EXPECT_EQ(bus->read(0x7E8000), 0x00);
+}
+
+TEST_F(BusTest, CodePageClassification) {
+    EXPECT_EQ(bus->code_page(0x000100), 1);
+    EXPECT_EQ(bus->code_page(0x7F0000), 0x100);
+    EXPECT_EQ(bus->code_page(0x002100), Bus::kNoCode);
+    EXPECT_EQ(bus->code_page(0x00FFFE), Bus::kNoCode);
+    insert_rom(std::vector<uint8_t>(0x8000, 0xEA));
+    EXPECT_EQ(bus->code_page(0x018000), Bus::kRomCode);
+}
+
+// Set up DMA channel 0 and start it
+void start_dma(Bus& bus, uint8_t control, uint8_t b_address, uint32_t source, uint16_t count) {
+    bus.write(0x004300, control);
+    bus.write(0x004301, b_address);
+    bus.write(0x004302, source & 0xFF);
+    bus.write(0x004303, (source >> 8) & 0xFF);
+    bus.write(0x004304, source >> 16);
+    bus.write(0x004305, count & 0xFF);
+    bus.write(0x004306, count >> 8);
+    bus.write(0x00420B, 0x01);
+}
+
+TEST_F(BusTest, DmaBulkCopiesMatchPortWrites) {
+    auto ppu = std::make_shared<PPU>();
+    bus->connect_ppu(ppu);
+    PPU reference;
+    // Source straddles the WRAM page boundary at $4000 from an odd address
+    const uint32_t source = 0x7E3FE1;
+    std::vector<uint8_t> data(0x60);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = (uint8_t)(i * 37 + 5);
+        bus->write(source + (uint32_t)i, data[i]);
+    }
+    auto both = [&](uint16_t reg, uint8_t value) {
+        bus->write(reg, value);
+        reference.write_register(reg, value);
+    };
+
+    // VRAM words, wrapping at the end of VRAM, then with other VMAIN modes
+    for (uint8_t vmain : {0x80, 0x00, 0x81, 0x84, 0x8C}) {
+        both(0x2115, vmain);
+        both(0x2116, 0xF0);
+        both(0x2117, 0x7F);
+        start_dma(*bus, 0x01, 0x18, source, (uint16_t)data.size());
+        for (size_t i = 0; i < data.size(); ++i) {
+            reference.write_register(i & 1 ? 0x2119 : 0x2118, data[i]);
+        }
+        EXPECT_EQ(bus->get_dma_channel(0).count, 0);
+        EXPECT_EQ(bus->get_dma_channel(0).a_address, (source + data.size()) & 0xFFFF);
+    }
+    // One VRAM port only
+    both(0x2115, 0x00);
+    start_dma(*bus, 0x00, 0x18, source, 0x21);
+    for (int i = 0; i < 0x21; ++i) reference.write_register(0x2118, data[i]);
+    for (uint32_t addr = 0; addr < 0x10000; ++addr) {
+        ASSERT_EQ(ppu->read_vram(addr), reference.read_vram(addr)) << std::hex << addr;
+    }
+
+    // CGRAM wraps after 256 colours
+    both(0x2121, 0xF8);
+    start_dma(*bus, 0x02, 0x22, source, 0x20);
+    for (int i = 0; i < 0x20; ++i) reference.write_register(0x2122, data[i]);
+    // OAM from an odd byte of a pair
+    both(0x2102, 0xFE);
+    both(0x2103, 0x01);
+    reference.write_register(0x2104, 0xEE);
+    bus->write(0x2104, 0xEE);
+    start_dma(*bus, 0x00, 0x04, source, 0x30);
+    for (int i = 0; i < 0x30; ++i) reference.write_register(0x2104, data[i]);
+    for (uint32_t addr = 0; addr < 512; ++addr) {
+        ASSERT_EQ(ppu->read_cgram(addr), reference.read_cgram(addr)) << std::hex << addr;
+    }
+    for (uint32_t addr = 0; addr < 544; ++addr) {
+        ASSERT_EQ(ppu->read_oam(addr), reference.read_oam(addr)) << std::hex << addr;
+    }
+}
+
+TEST_F(BusTest, DmaAddressStepsAndDirection) {
+    auto ppu = std::make_shared<PPU>();
+    bus->connect_ppu(ppu);
+    for (int i = 0; i < 8; ++i) bus->write(0x7E0100 + i, (uint8_t)(0xA0 + i));
+
+    // Fixed source: every byte the same
+    bus->write(0x2121, 0x00);
+    start_dma(*bus, 0x08, 0x22, 0x7E0100, 4);
+    EXPECT_EQ(ppu->read_cgram(3), 0xA0);
+    EXPECT_EQ(bus->get_dma_channel(0).a_address, 0x0100);
+    // Decrementing source
+    bus->write(0x2121, 0x00);
+    start_dma(*bus, 0x10, 0x22, 0x7E0107, 4);
+    EXPECT_EQ(ppu->read_cgram(0), 0xA7);
+    EXPECT_EQ(ppu->read_cgram(3), 0xA4);
+
+    // B to A: read VRAM back into WRAM through $2139/$213A
+    bus->write(0x2115, 0x80);
+    bus->write(0x2116, 0x00);
+    bus->write(0x2117, 0x10);
+    start_dma(*bus, 0x01, 0x18, 0x7E0100, 8);
+    bus->write(0x2116, 0x00);
+    bus->write(0x2117, 0x10);
+    start_dma(*bus, 0x81, 0x39, 0x7E0200, 8);
+    EXPECT_EQ(bus->read(0x7E0200), 0xA0);
+    EXPECT_EQ(bus->read(0x7E0201), 0xA1);
+
+    // A count of 0 moves 64KB; the WRAM port address wraps at 128KB
+    bus->write(0x2181, 0xF0);
+    bus->write(0x2182, 0xFF);
+    bus->write(0x2183, 0x01);
+    start_dma(*bus, 0x08, 0x80, 0x7E0100, 0);
+    EXPECT_EQ(bus->read(0x7FFFFF), 0xA0);
+    EXPECT_EQ(bus->read(0x7EFFEF), 0xA0);
+    EXPECT_EQ(bus->read(0x7EFFF0), 0x00);
+    // The DMA registers read back
+    EXPECT_EQ(bus->read(0x004301), 0x80);
+    EXPECT_EQ(bus->read(0x004305), 0x00);
+    EXPECT_EQ(bus->read(0x004306), 0x00);
+}
+
+TEST_F(BusTest, DmaStallsTheCpu) {
+    auto cpu = std::make_shared<CPU>();
+    bus->connect_cpu(cpu);
+    cpu->connect_bus(bus);
+    // LDA #$01; STA $420B with channel 0 set for 256 bytes
+    const uint8_t code[] = {0xA9, 0x01, 0x8D, 0x0B, 0x42};
+    for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+    bus->write(0x004300, 0x00);
+    bus->write(0x004301, 0x18);
+    bus->write(0x004305, 0x00);
+    bus->write(0x004306, 0x01);
+    cpu->pc = 0x7E0000;
+    cpu->run_instructions(2);
+    // 2 + 4 cycles, then 16 clocks overhead + 8 per channel + 8 per byte
+    EXPECT_EQ(cpu->cycle_count, 2u + 4u + (16 + 8 + 256 * 8) / 8);
+}
+
+TEST_F(BusTest, DmaIntoWramInvalidatesCachedCode) {
+    std::vector<uint8_t> image(0x8000, 0x00);
+    image[0] = 0xA9;    // LDA #$22
+    image[1] = 0x22;
+    insert_rom(image);
+    auto cpu = std::make_shared<CPU>();
+    bus->connect_cpu(cpu);
+    cpu->connect_bus(bus);
+
+    // loop: LDA #$11; BRA loop
+    const uint8_t loop[] = {0xA9, 0x11, 0x80, 0xFC};
+    for (int i = 0; i < 4; ++i) bus->write(0x7E0000 + i, loop[i]);
+    cpu->pc = 0x7E0000;
+    cpu->run(1000);
+    EXPECT_EQ(cpu->a & 0xFF, 0x11);
+
+    // Patch the cached loop from ROM through the WRAM port
+    bus->write(0x2181, 0x00);
+    bus->write(0x2182, 0x00);
+    bus->write(0x2183, 0x00);
+    start_dma(*bus, 0x00, 0x80, 0x008000, 2);
+    cpu->run(1000);
+    EXPECT_EQ(cpu->a & 0xFF, 0x22);
+}
+
+TEST_F(BusTest, RegisterTablesFollowConnectedDevices) {
+    // The bus's own registers and the DMA channels are always mapped
+    ASSERT_NE(bus->io_register(0x420B), nullptr);
+    EXPECT_STREQ(bus->io_register(0x420B)->name, "MDMAEN");
+    ASSERT_NE(bus->io_register(0x4375), nullptr);
+    EXPECT_STREQ(bus->io_register(0x4375)->name, "DASxL");
+    EXPECT_EQ(bus->io_register(0x437C), nullptr);
+    EXPECT_EQ(bus->io_register(0x2100), nullptr);
+    EXPECT_EQ(bus->io_register(0x8000), nullptr);
+
+    auto ppu = std::make_shared<PPU>();
+    bus->connect_ppu(ppu);
+    const MmioRegister* inidisp = bus->io_register(0x2100);
+    ASSERT_NE(inidisp, nullptr);
+    EXPECT_STREQ(inidisp->name, "INIDISP");
+    EXPECT_TRUE(inidisp->flags & MmioRegister::kOpenBus);
+    // Registers the PPU doesn't implement yet are not listed
+    EXPECT_EQ(bus->io_register(0x211B), nullptr);   // M7A
+    EXPECT_EQ(bus->io_register(0x2137), nullptr);   // SLHV
+    ASSERT_NE(bus->io_register(0x2138), nullptr);
+    EXPECT_STREQ(bus->io_register(0x2138)->name, "RDOAM");
+    const MmioRegister* stat78 = bus->io_register(0x213F);
+    ASSERT_NE(stat78, nullptr);
+    EXPECT_TRUE(stat78->flags & MmioRegister::kNoSideEffects);
+    EXPECT_FALSE(bus->io_register(0x2139)->flags & MmioRegister::kNoSideEffects);
+
+    auto registers = bus->io_registers();
+    ASSERT_FALSE(registers.empty());
+    for (size_t i = 1; i < registers.size(); ++i) {
+        EXPECT_LT(registers[i - 1].first, registers[i].first);
+    }
+    EXPECT_EQ(registers.size(), 18u + 8 * 13 + PPU::kRegisterCount);
+
+    bus->connect_ppu(nullptr);
+    EXPECT_EQ(bus->io_register(0x2100), nullptr);
+    bus->write(0x002118, 0x55);
+    EXPECT_EQ(ppu->read_vram(0), 0x00);
+}
+
+TEST_F(BusTest, RegistersDispatchInEveryMirror) {
+    auto ppu = std::make_shared<PPU>();
+    bus->connect_ppu(ppu);
+    // VMADD then VMDATAL, through bank $80 and bank $3F
+    bus->write(0x802116, 0x10);
+    bus->write(0x802117, 0x00);
+    bus->write(0x3F2118, 0xAB);
+    EXPECT_EQ(ppu->read_vram(0x20), 0xAB);
+
+    // WRAM port
+    bus->write(0x002181, 0x00);
+    bus->write(0x002182, 0x01);
+    bus->write(0x002183, 0x01);
+    bus->write(0x802180, 0x5A);
+    EXPECT_EQ(bus->read(0x7F0100), 0x5A);
+
+    // $2000-$20FF and $4400-$5FFF stay open bus
+    EXPECT_EQ(bus->read(0x002080), 0x00);
+    bus->write(0x004400, 0x12);
+    EXPECT_EQ(bus->read(0x004400), 0x00);
+}
+
+TEST_F(BusTest, ReadonlyReadsSkipSideEffects) {
+    bus->write(0x002181, 0x00);
+    bus->write(0x002182, 0x00);
+    bus->write(0x002183, 0x00);
+    bus->write(0x7E0000, 0x11);
+    bus->write(0x7E0001, 0x22);
+    // WMDATA advances the port, so a debugger read doesn't reach it
+    EXPECT_EQ(bus->read(0x002180, true), 0x00);
+    EXPECT_EQ(bus->read(0x002180), 0x11);
+    EXPECT_EQ(bus->read(0x002180), 0x22);
+
+    bus->write(0x004302, 0x34);
+    EXPECT_EQ(bus->read(0x004302, true), 0x34);
+}
+
+TEST_F(BusTest, MultiplierAndDivider) {
+    bus->write(0x004202, 200);
+    bus->write(0x004203, 150);
+    EXPECT_EQ(bus->read(0x004216) | (bus->read(0x004217) << 8), 30000);
+    EXPECT_EQ(bus->read(0x004214) | (bus->read(0x004215) << 8), 150);
+
+    bus->write(0x004204, 0x39);     // 12345
+    bus->write(0x004205, 0x30);
+    bus->write(0x004206, 100);
+    EXPECT_EQ(bus->read(0x004214) | (bus->read(0x004215) << 8), 123);
+    EXPECT_EQ(bus->read(0x004216) | (bus->read(0x004217) << 8), 45);
+
+    bus->write(0x004206, 0);
+    EXPECT_EQ(bus->read(0x004214) | (bus->read(0x004215) << 8), 0xFFFF);
+    EXPECT_EQ(bus->read(0x004216) | (bus->read(0x004217) << 8), 12345);
+}
@@ -0,0 +1,101 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "color.hpp"
+#include "ppu.hpp"
+#include "simd.hpp"
+
+namespace {
+
+const SimdLevel kLevels[] = {SimdLevel::kScalar, SimdLevel::kSse2, SimdLevel::kAvx2};
+const PixelFormat kFormats[] = {PixelFormat::kRgba8888, PixelFormat::kRgb888, PixelFormat::kBgr888,
+                                PixelFormat::kGray8};
+
+// Runs fn once per level this CPU supports, then goes back to the best
+template <typename Fn>
+void for_each_level(Fn fn) {
+    for (SimdLevel level : kLevels) {
+        if (!set_simd_level(level)) continue;
+        SCOPED_TRACE(simd_level_name(level));
+        fn(level);
+    }
+    set_simd_level(simd_best_level());
+}
+
+} // namespace
+
+TEST(ColorTest, ExpandsAndScalesChannels) {
+    const uint16_t pixels[3] = {0x7FFF, 0x0210, 0x801F};    // White, mid gray-green, red with bit 15
+    uint8_t rgba[12];
+    convert_bgr555(pixels, 3, PixelFormat::kRgba8888, 15, rgba);
+    EXPECT_EQ(std::vector<uint8_t>(rgba, rgba + 12),
+              std::vector<uint8_t>({0xFF, 0xFF, 0xFF, 0xFF, 0x84, 0x84, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0xFF}));
+
+    uint8_t bgr[9];
+    convert_bgr555(pixels, 3, PixelFormat::kBgr888, 15, bgr);
+    EXPECT_EQ(bgr[6], 0x00);
+    EXPECT_EQ(bgr[8], 0xFF);
+
+    uint8_t gray[3];
+    convert_bgr555(pixels, 3, PixelFormat::kGray8, 15, gray);
+    EXPECT_EQ(gray[0], 0xFF);
+    EXPECT_EQ(gray[2], (77 * 255 + 128) >> 8);
+
+    // Brightness 0 is black with opaque alpha; out-of-range values clamp
+    convert_bgr555(pixels, 1, PixelFormat::kRgba8888, 0, rgba);
+    EXPECT_EQ(std::vector<uint8_t>(rgba, rgba + 4), std::vector<uint8_t>({0, 0, 0, 0xFF}));
+    convert_bgr555(pixels, 1, PixelFormat::kRgb888, 99, rgba);
+    EXPECT_EQ(rgba[0], 0xFF);
+    convert_bgr555(pixels, 1, PixelFormat::kRgb888, 7, rgba);
+    EXPECT_EQ(rgba[0], 255 * 7 / 15);
+}
+
+// Every level must produce the scalar bytes for every format and
+// brightness, at lengths that leave tails, without writing past the end
+TEST(ColorTest, KernelsMatchScalar) {
+    std::mt19937 rng(555);
+    std::vector<uint16_t> pixels(PPU::kScreenWidth + 37);
+    for (auto& p : pixels) p = (uint16_t)rng();
+    for (PixelFormat format : kFormats) {
+        size_t bytes = pixel_format_bytes(format);
+        for (int brightness = 0; brightness <= 15; ++brightness) {
+            for (size_t count : {(size_t)0, (size_t)1, (size_t)7, (size_t)17, (size_t)18, pixels.size()}) {
+                set_simd_level(SimdLevel::kScalar);
+                std::vector<uint8_t> expected(count * bytes + 8, 0xAA);
+                convert_bgr555(pixels.data(), count, format, brightness, expected.data());
+                for_each_level([&](SimdLevel) {
+                    std::vector<uint8_t> out(count * bytes + 8, 0xAA);
+                    convert_bgr555(pixels.data(), count, format, brightness, out.data());
+                    EXPECT_EQ(out, expected) << pixel_format_name(format) << " brightness " << brightness
+                                             << " count " << count;
+                });
+            }
+        }
+    }
+}
+
+TEST(ColorTest, PPUOutputFollowsINIDISP) {
+    PPU ppu;
+    ppu.render_scanline_stub();                 // Line 0: blue 0 ...
+    ppu.step_scanline();
+    ppu.render_scanline_stub();                 // ... line 1: blue 1
+    std::vector<uint8_t> rgb;
+    auto blue = [&]() {
+        rgb = ppu.get_framebuffer_rgb();
+        return rgb[PPU::kScreenWidth * 3 + 2];
+    };
+
+    ppu.write_register(0x2100, 0x0F);
+    EXPECT_EQ(ppu.display_brightness(), 15);
+    EXPECT_EQ(blue(), 0x08);
+    ppu.write_register(0x2100, 0x8F);           // Forced blank
+    EXPECT_EQ(ppu.display_brightness(), 0);
+    EXPECT_EQ(blue(), 0x00);
+
+    ppu.write_register(0x2100, 0x0F);
+    std::vector<uint8_t> rgba(PPU::kScreenHeight * PPU::kScreenWidth * 4);
+    ppu.convert_framebuffer(PixelFormat::kRgba8888, rgba.data());
+    EXPECT_EQ(rgba[PPU::kScreenWidth * 4 + 2], 0x08);
+    EXPECT_EQ(rgba[PPU::kScreenWidth * 4 + 3], 0xFF);
+}
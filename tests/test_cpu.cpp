@@ -3,7 +3,9 @@
 #include "gtest/gtest.h"
 #include "cpu.hpp"
 #include "bus.hpp"
+#include "cpu_opcodes.hpp"
 #include <tuple>
+#include <vector>
 
 struct LDAParams {
     uint8_t opcode;
@@ -722,7 +724,33 @@ TEST_F(LDATest, InterruptHandlingRESET) {
 }
 
 TEST_F(LDATest, WAI_STP_Instruction) {
-    GTEST_SKIP() << "Not yet implemented: WAI/STP instruction test stub.";
+    cpu->reset();
+    cpu->pc = 0x7E0000;
+    // WAI; NOP; STP; NOP
+    const uint8_t code[] = {0xCB, 0xEA, 0xDB, 0xEA};
+    for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+    cpu->step();
+    EXPECT_EQ(cpu->get_halt(), CPU::Halt::Wait);
+    EXPECT_EQ(cpu->pc, 0x7E0001u);
+    // Halted: nothing executes
+    EXPECT_EQ(cpu->run_instructions(10), 0u);
+    cpu->step();
+    EXPECT_EQ(cpu->pc, 0x7E0001u);
+    // A masked IRQ still ends WAI, without taking the vector
+    ASSERT_TRUE(cpu->get_flag(CPU::I));
+    cpu->irq();
+    EXPECT_FALSE(cpu->is_halted());
+    EXPECT_EQ(cpu->stkp, 0x01FD);
+    EXPECT_EQ(cpu->run_instructions(10), 2u);
+    EXPECT_EQ(cpu->get_halt(), CPU::Halt::Stop);
+    EXPECT_EQ(cpu->pc, 0x7E0003u);
+    // STP ignores interrupts until reset
+    cpu->irq();
+    cpu->nmi();
+    EXPECT_EQ(cpu->get_halt(), CPU::Halt::Stop);
+    EXPECT_EQ(cpu->stkp, 0x01FD);
+    cpu->reset();
+    EXPECT_FALSE(cpu->is_halted());
 }
 
 TEST_F(LDATest, XCE_EmulationNativeTransition) {
@@ -732,3 +760,371 @@ TEST_F(LDATest, XCE_EmulationNativeTransition) {
 TEST_F(LDATest, EmulationModeEdgeCases) {
     GTEST_SKIP() << "Not yet implemented: emulation mode edge case test stub.";
 }
+
+TEST_F(LDATest, RunInstructionsExecutesRequestedCount) {
+    cpu->reset();
+    cpu->pc = 0x7E0000;
+    cpu->p |= CPU::M;
+    // LDA #$42; NOP; NOP
+    bus->write(0x7E0000, 0xA9); bus->write(0x7E0001, 0x42);
+    bus->write(0x7E0002, 0xEA); bus->write(0x7E0003, 0xEA);
+    EXPECT_EQ(cpu->run_instructions(2), 2u);
+    EXPECT_EQ(cpu->a, 0x42);
+    EXPECT_EQ(cpu->pc, 0x7E0003u);
+    EXPECT_EQ(cpu->instruction_count, 2u);
+    EXPECT_EQ(cpu->cycle_count, 4u);
+}
+
+TEST_F(LDATest, RunStopsOnceCycleBudgetIsSpent) {
+    cpu->reset();
+    cpu->pc = 0x7E0000;
+    for (uint32_t i = 0; i < 16; ++i) bus->write(0x7E0000 + i, 0xEA); // NOP, 2 cycles
+    // The instruction that crosses the budget completes
+    EXPECT_EQ(cpu->run(7), 8u);
+    EXPECT_EQ(cpu->pc, 0x7E0004u);
+    EXPECT_EQ(cpu->instruction_count, 4u);
+}
+
+TEST_F(LDATest, RunPicksUpWidthChangesMadeBetweenCalls) {
+    cpu->reset();
+    cpu->pc = 0x7E0000;
+    cpu->p |= CPU::M;
+    bus->write(0x7E0000, 0xA9); bus->write(0x7E0001, 0x34); bus->write(0x7E0002, 0x12);
+    cpu->p &= ~CPU::M;
+    cpu->run_instructions(1);
+    EXPECT_EQ(cpu->a, 0x1234);
+    EXPECT_EQ(cpu->pc, 0x7E0003u);
+}
+
+TEST_F(LDATest, BlockCacheSeesWramCodeRewrittenBetweenRuns) {
+    cpu->reset();
+    cpu->pc = 0x7E0000;
+    cpu->p |= CPU::M;
+    // LDA #$11; NOP
+    bus->write(0x7E0000, 0xA9); bus->write(0x7E0001, 0x11); bus->write(0x7E0002, 0xEA);
+    cpu->run_instructions(2);
+    EXPECT_EQ(cpu->a & 0xFF, 0x11);
+    bus->write(0x7E0001, 0x22);
+    cpu->pc = 0x7E0000;
+    cpu->run_instructions(2);
+    EXPECT_EQ(cpu->a & 0xFF, 0x22);
+}
+
+TEST_F(LDATest, BlockCacheSeesStoreIntoCachedCode) {
+    cpu->reset();
+    cpu->p |= CPU::M;
+    // STA $0008; NOP x4; LDA #$00 -- the store rewrites the LDA operand
+    const uint8_t code[] = {0x8D, 0x08, 0x00, 0xEA, 0xEA, 0xEA, 0xEA, 0xA9, 0x00};
+    for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+    for (uint8_t value : {0x11, 0x33, 0x55}) {
+        cpu->pc = 0x7E0000;
+        cpu->a = value;
+        cpu->run_instructions(6);
+        EXPECT_EQ(cpu->a & 0xFF, value);
+        EXPECT_EQ(cpu->pc, 0x7E0009u);
+    }
+}
+
+TEST_F(LDATest, BlockCacheMatchesInterpreter) {
+    // INC A; INX; BNE -4; NOP
+    const uint8_t code[] = {0x1A, 0xE8, 0xD0, 0xFC, 0xEA};
+    auto run = [&](bool cached) {
+        cpu->reset();
+        cpu->set_block_cache_enabled(cached);
+        cpu->p |= CPU::M | CPU::X;
+        for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+        cpu->pc = 0x7E0000;
+        cpu->run_instructions(600);
+        return std::make_tuple(cpu->a, cpu->x, cpu->p, cpu->pc, cpu->cycle_count);
+    };
+    auto interpreted = run(false);
+    auto cached = run(true);
+    EXPECT_EQ(interpreted, cached);
+    EXPECT_EQ(std::get<0>(cached) & 0xFF, 200);
+    EXPECT_EQ(std::get<3>(cached), 0x7E0000u);
+}
+
+TEST_F(LDATest, JitMatchesInterpreterOnLoop) {
+    if (!CPU::jit_available()) GTEST_SKIP() << "JIT not built";
+    // CLC; INC A; NOP; SEC; INX; STA $0300; BNE -10; NOP
+    const uint8_t code[] = {0x18, 0x1A, 0xEA, 0x38, 0xE8, 0x8D, 0x00, 0x03, 0xD0, 0xF6, 0xEA};
+    auto run = [&](bool jit, uint64_t budget) {
+        cpu->reset();
+        cpu->set_jit_enabled(jit);
+        cpu->set_jit_threshold(1);
+        cpu->p |= CPU::M | CPU::X;
+        for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+        cpu->pc = 0x7E0000;
+        // Odd budgets stop the run part way through a block
+        while (cpu->cycle_count < budget) cpu->run(37);
+        return std::make_tuple(cpu->a, cpu->x, cpu->p, cpu->pc, cpu->cycle_count,
+                               cpu->instruction_count, bus->read(0x0300));
+    };
+    for (uint64_t budget : {100u, 1001u, 4000u}) {
+        auto interpreted = run(false, budget);
+        auto native = run(true, budget);
+        EXPECT_EQ(interpreted, native) << "budget " << budget;
+    }
+    EXPECT_GT(cpu->jit_code_size(), 0u);
+}
+
+TEST_F(LDATest, JitLeavesBlockInvalidatedByItsOwnStore) {
+    if (!CPU::jit_available()) GTEST_SKIP() << "JIT not built";
+    // At $0220: INX; TXA; STA $01F0,X; INC A; BNE -8. Once X reaches $10
+    // the store lands in the code page and drops the running block.
+    const uint8_t code[] = {0xE8, 0x8A, 0x9D, 0xF0, 0x01, 0x1A, 0xD0, 0xF8};
+    auto run = [&](bool jit) {
+        cpu->reset();
+        cpu->set_jit_enabled(jit);
+        cpu->set_jit_threshold(1);
+        cpu->p |= CPU::M | CPU::X;
+        for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0220 + i, code[i]);
+        cpu->pc = 0x7E0220;
+        cpu->run_instructions(5 * 0x28);
+        return std::make_tuple(cpu->a, cpu->x, cpu->p, cpu->pc, cpu->cycle_count, bus->read(0x0200));
+    };
+    auto interpreted = run(false);
+    auto native = run(true);
+    EXPECT_EQ(interpreted, native);
+    EXPECT_EQ(std::get<1>(native), 0x28);
+    EXPECT_GT(cpu->jit_code_size(), 0u);
+}
+
+TEST_F(LDATest, JitInlineLoadsAndStoresMatchInterpreter) {
+    if (!CPU::jit_available()) GTEST_SKIP() << "JIT not built";
+    // At $0400: LDA $10; INC A; STA $10; STA $0312; LDX $0312; STX $20;
+    // LDY $20; STY $0330; STZ $22; STA $05F0; STA $4202; LDA $4214;
+    // LDA $1FFF; JMP $0500. At $0500: NOP; NOP; JMP $0400. The store to
+    // $05F0 hits cached code and the $42xx accesses are MMIO, so those
+    // take the handlers; $1FFF is split across pages when 16-bit.
+    const uint8_t code[] = {0xA5, 0x10, 0x1A, 0x85, 0x10, 0x8D, 0x12, 0x03, 0xAE, 0x12, 0x03,
+                            0x86, 0x20, 0xA4, 0x20, 0x8C, 0x30, 0x03, 0x64, 0x22, 0x8D, 0xF0,
+                            0x05, 0x8D, 0x02, 0x42, 0xAD, 0x14, 0x42, 0xAD, 0xFF, 0x1F, 0x4C,
+                            0x00, 0x05};
+    const uint8_t back[] = {0xEA, 0xEA, 0x4C, 0x00, 0x04};
+    auto run = [&](bool jit, uint16_t widths) {
+        cpu->reset();
+        cpu->set_jit_enabled(jit);
+        cpu->set_jit_threshold(1);
+        cpu->p = (cpu->p & ~(CPU::M | CPU::X)) | widths;
+        for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0400 + i, code[i]);
+        for (uint32_t i = 0; i < sizeof(back); ++i) bus->write(0x7E0500 + i, back[i]);
+        for (uint32_t addr : {0x10, 0x11, 0x20, 0x21, 0x22, 0x23, 0x312, 0x313, 0x330, 0x331}) {
+            bus->write(addr, 0xA5);
+        }
+        bus->write(0x1FFF, 0x5A);
+        cpu->pc = 0x7E0400;
+        while (cpu->cycle_count < 3000) cpu->run(37);
+        std::vector<uint8_t> ram;
+        for (uint32_t addr : {0x10, 0x11, 0x20, 0x21, 0x22, 0x23, 0x312, 0x313, 0x330, 0x331, 0x5F0, 0x5F1}) {
+            ram.push_back(bus->read(addr));
+        }
+        return std::make_tuple(cpu->a, cpu->x, cpu->y, cpu->p, cpu->pc, cpu->cycle_count,
+                               cpu->instruction_count, ram);
+    };
+    const uint16_t kWidths[] = {CPU::M | CPU::X, 0, CPU::M, CPU::X};
+    for (uint16_t widths : kWidths) {
+        auto interpreted = run(false, widths);
+        auto native = run(true, widths);
+        EXPECT_EQ(interpreted, native) << "widths " << widths;
+        EXPECT_GT(std::get<6>(native), 400u);
+    }
+    EXPECT_GT(cpu->jit_code_size(), 0u);
+}
+
+TEST(CPUTraceTest, RingBufferKeepsNewestRecordsInOrder) {
+    CPUTrace trace(4);
+    for (uint32_t i = 0; i < 6; ++i) {
+        TraceRecord record{};
+        record.pc = i;
+        trace.push(record);
+    }
+    EXPECT_EQ(trace.size(), 4u);
+    EXPECT_EQ(trace.total_records(), 6u);
+    std::vector<TraceRecord> records = trace.records();
+    ASSERT_EQ(records.size(), 4u);
+    for (uint32_t i = 0; i < 4; ++i) EXPECT_EQ(records[i].pc, i + 2);
+    std::vector<uint8_t> bytes = trace.dump();
+    ASSERT_EQ(bytes.size(), 4 * sizeof(TraceRecord));
+    EXPECT_EQ(bytes[offsetof(TraceRecord, pc)], 2);
+    trace.clear();
+    EXPECT_EQ(trace.size(), 0u);
+    EXPECT_TRUE(trace.records().empty());
+}
+
+TEST_F(LDATest, TraceRecordsExecutedInstructions) {
+    if (PYSNES_TRACE_LEVEL < 1) GTEST_SKIP() << "Tracing compiled out";
+    cpu->reset();
+    cpu->get_trace().clear();
+    cpu->pc = 0x7E0000;
+    cpu->p |= CPU::M;
+    // LDA #$42; JSR $0010; ... $0010: NOP
+    const uint8_t code[] = {0xA9, 0x42, 0x20, 0x10, 0x00};
+    for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+    bus->write(0x000010, 0xEA);
+    cpu->run_instructions(3);
+    std::vector<TraceRecord> records = cpu->get_trace().records();
+    std::vector<TraceRecord> instructions;
+    for (const TraceRecord& r : records) {
+        if (r.kind == TraceRecord::kInstruction) instructions.push_back(r);
+    }
+    ASSERT_EQ(instructions.size(), 3u);
+    EXPECT_EQ(instructions[0].pc, 0x7E0000u);
+    EXPECT_EQ(instructions[0].opcode, 0xA9);
+    EXPECT_EQ(instructions[1].opcode, 0x20);
+    EXPECT_EQ(instructions[1].a & 0xFF, 0x42);
+    EXPECT_EQ(instructions[1].cycles, 2u);
+    EXPECT_EQ(instructions[2].pc, 0x000010u);
+    // Operand bytes ride along for the formatter
+    EXPECT_EQ(instructions[1].arg & 0xFFFF, 0x0010u);
+    EXPECT_NE(CPUOpcodes::format_trace(instructions[0]).find("LDA #$42"), std::string::npos);
+    if (PYSNES_TRACE_LEVEL >= 2) {
+        ASSERT_EQ(records.size(), 4u);
+        EXPECT_EQ(records[2].kind, TraceRecord::kCall);
+        EXPECT_EQ(records[2].arg, 0x000010u);
+    }
+}
+
+TEST_F(LDATest, ProfileCountsOpcodesAndRegions) {
+    if (!PYSNES_PROFILE) GTEST_SKIP() << "Profiling compiled out";
+    cpu->reset();
+    cpu->get_profile().reset();
+    cpu->pc = 0x7E0000;
+    cpu->p |= CPU::M;
+    // LDA $10; STA $2100; LDA #$01; LDA #$02
+    const uint8_t code[] = {0xA5, 0x10, 0x8D, 0x00, 0x21, 0xA9, 0x01, 0xA9, 0x02};
+    for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+    cpu->run_instructions(4);
+    const CPUProfile& profile = cpu->get_profile();
+    EXPECT_EQ(profile.opcode_count[0xA9], 2u);
+    EXPECT_EQ(profile.opcode_cycles[0xA9], 4u);
+    EXPECT_EQ(profile.opcode_cycles[0xA5], 3u);
+    EXPECT_EQ(profile.mode_count()[(int)AddrMode::ImmediateM], 2u);
+    EXPECT_EQ(profile.mode_count()[(int)AddrMode::Absolute], 1u);
+    // Fetches are not bus data accesses
+    EXPECT_EQ(profile.bus_reads[CPUProfile::kWram], 1u);
+    EXPECT_EQ(profile.bus_writes[CPUProfile::kMmio], 1u);
+    cpu->get_profile().reset();
+    EXPECT_EQ(cpu->get_profile().opcode_count[0xA9], 0u);
+}
+
+TEST_F(LDATest, LazyFlagsKeepStatusExact) {
+    cpu->reset();
+    cpu->pc = 0x7E0000;
+    // LDA #$00; PHP; LDA #$80; BMI +1; NOP; NOP
+    const uint8_t code[] = {0xA9, 0x00, 0x08, 0xA9, 0x80, 0x30, 0x01, 0xEA, 0xEA};
+    for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+    cpu->step();
+    EXPECT_EQ(cpu->p, 0x36);
+    cpu->run_instructions(1);
+    EXPECT_EQ(bus->read(0x0001FC), 0x36 | 0x10);
+    cpu->run_instructions(2);
+    EXPECT_EQ(cpu->p, 0xB4);
+    EXPECT_EQ(cpu->pc, 0x7E0008u);
+}
+
+TEST_F(LDATest, BlockMoveBulkMatchesSingleSteps) {
+    auto setup = [&](std::shared_ptr<Bus> b, std::shared_ptr<CPU> c) {
+        c->reset();
+        c->pc = 0x7E0000;
+        // MVN $7E,$7F (destination bank first); NOP
+        const uint8_t code[] = {0x54, 0x7E, 0x7F, 0xEA};
+        for (uint32_t i = 0; i < sizeof(code); ++i) b->write(0x7E0000 + i, code[i]);
+        for (uint32_t i = 0; i < 0x3000; ++i) b->write(0x7F1000 + i, (uint8_t)(i * 7 + (i >> 8)));
+        c->p &= ~CPU::X;
+        c->a = 0x2FFF;
+        c->x = 0x1000;
+        c->y = 0x8000;
+    };
+    setup(bus, cpu);
+    auto ref_bus = std::make_shared<Bus>();
+    auto ref_cpu = std::make_shared<CPU>();
+    ref_cpu->connect_bus(ref_bus);
+    setup(ref_bus, ref_cpu);
+
+    // Stop part way: exactly as many bytes as start below the cycle target
+    cpu->run(70);
+    for (int i = 0; i < 10; ++i) ref_cpu->step();
+    EXPECT_EQ(cpu->cycle_count, ref_cpu->cycle_count);
+    EXPECT_EQ(cpu->instruction_count, 10u);
+    EXPECT_EQ(cpu->pc, 0x7E0000u);
+    EXPECT_EQ(cpu->a, 0x2FFF - 10);
+
+    cpu->run_instructions(0x3000 - 10 + 1);
+    while (ref_cpu->pc == 0x7E0000) ref_cpu->step();
+    ref_cpu->step();
+    EXPECT_EQ(cpu->cycle_count, ref_cpu->cycle_count);
+    EXPECT_EQ(cpu->cycle_count, 7u * 0x2FFF + 6 + 2);
+    EXPECT_EQ(cpu->instruction_count, ref_cpu->instruction_count);
+    EXPECT_EQ(cpu->a, 0xFFFF);
+    EXPECT_EQ(cpu->x, 0x4000);
+    EXPECT_EQ(cpu->y, 0xB000);
+    EXPECT_EQ(cpu->db, 0x7E);
+    for (uint32_t i = 0; i < 0x3000; i += 0x101) {
+        EXPECT_EQ(bus->read(0x7E8000 + i), ref_bus->read(0x7E8000 + i));
+        EXPECT_EQ(bus->read(0x7E8000 + i), (uint8_t)(i * 7 + (i >> 8)));
+    }
+}
+
+TEST_F(LDATest, BlockMoveOverlapRepeatsPattern) {
+    cpu->reset();
+    cpu->pc = 0x7E0000;
+    // MVN $7E,$7E with Y = X + 1 smears the first byte forwards
+    const uint8_t code[] = {0x54, 0x7E, 0x7E, 0x44, 0x7E, 0x7E};
+    for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+    bus->write(0x7E2000, 0xAB);
+    cpu->p &= ~CPU::X;
+    cpu->a = 0x00FF;
+    cpu->x = 0x2000;
+    cpu->y = 0x2001;
+    cpu->run_instructions(0x100);
+    EXPECT_EQ(cpu->pc, 0x7E0003u);
+    for (uint32_t i = 0; i <= 0x100; ++i) EXPECT_EQ(bus->read(0x7E2000 + i), 0xAB) << i;
+    EXPECT_EQ(bus->read(0x7E2101), 0x00);
+
+    // MVP $7E,$7E with Y = X - 1 smears the last byte backwards
+    bus->write(0x7E3000, 0xCD);
+    cpu->a = 0x007F;
+    cpu->x = 0x3000;
+    cpu->y = 0x2FFF;
+    cpu->run_instructions(0x80);
+    for (uint32_t i = 0; i <= 0x80; ++i) EXPECT_EQ(bus->read(0x7E3000 - i), 0xCD) << i;
+    EXPECT_EQ(cpu->x, 0x2F80);
+    EXPECT_EQ(cpu->y, 0x2F7F);
+}
+
+TEST_F(LDATest, IndexLoadsAndStores) {
+    cpu->reset();
+    cpu->pc = 0x7E0000;
+    cpu->p |= CPU::X | CPU::M;
+    bus->write(0x000010, 0x80);
+    // LDX #$12; LDY $10; STX $0200; STY $21; STZ $10; LDX $0010
+    const uint8_t code[] = {0xA2, 0x12, 0xA4, 0x10, 0x8E, 0x00, 0x02, 0x84, 0x21, 0x64, 0x10, 0xAE, 0x10, 0x00};
+    for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+    cpu->run_instructions(2);
+    EXPECT_EQ(cpu->x, 0x12);
+    EXPECT_EQ(cpu->y, 0x80);
+    EXPECT_TRUE(cpu->p & CPU::N);
+    cpu->run_instructions(4);
+    EXPECT_EQ(bus->read(0x000200), 0x12);
+    EXPECT_EQ(bus->read(0x000021), 0x80);
+    EXPECT_EQ(bus->read(0x000010), 0x00);
+    EXPECT_EQ(cpu->x, 0x00);
+    EXPECT_TRUE(cpu->p & CPU::Z);
+    EXPECT_EQ(cpu->cycles, CPUOpcodes::kTable[0xAE].cycles);
+
+    // 16-bit index registers move both bytes; STZ follows M
+    cpu->pc = 0x7E0100;
+    cpu->p &= ~(CPU::X | CPU::M);
+    // LDY #$ABCD; STY $30; STZ $30
+    const uint8_t wide[] = {0xA0, 0xCD, 0xAB, 0x84, 0x30, 0x64, 0x32};
+    for (uint32_t i = 0; i < sizeof(wide); ++i) bus->write(0x7E0100 + i, wide[i]);
+    bus->write(0x000032, 0xFF);
+    bus->write(0x000033, 0xFF);
+    cpu->run_instructions(3);
+    EXPECT_EQ(cpu->y, 0xABCD);
+    EXPECT_EQ(bus->read(0x000030), 0xCD);
+    EXPECT_EQ(bus->read(0x000031), 0xAB);
+    EXPECT_EQ(bus->read(0x000032), 0x00);
+    EXPECT_EQ(bus->read(0x000033), 0x00);
+}
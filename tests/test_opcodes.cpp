@@ -0,0 +1,76 @@
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "bus.hpp"
+#include "cpu.hpp"
+#include "cpu_instructions.hpp"
+#include "cpu_opcodes.hpp"
+
+TEST(OpcodeTableTest, LengthsFollowRegisterWidths) {
+    EXPECT_EQ(CPUOpcodes::length(0xEA, true, true), 1);    // NOP
+    EXPECT_EQ(CPUOpcodes::length(0xA9, false, true), 2);   // LDA #
+    EXPECT_EQ(CPUOpcodes::length(0xA9, true, false), 3);
+    EXPECT_EQ(CPUOpcodes::length(0xA2, true, false), 2);   // LDX #
+    EXPECT_EQ(CPUOpcodes::length(0xA2, false, true), 3);
+    EXPECT_EQ(CPUOpcodes::length(0xC2, true, true), 2);    // REP
+    EXPECT_EQ(CPUOpcodes::length(0xAF, false, false), 4);  // LDA long
+    EXPECT_EQ(CPUOpcodes::length(0x54, false, false), 3);  // MVN
+    for (int op = 0; op < 256; ++op) {
+        ASSERT_NE(CPUOpcodes::kTable[op].mnemonic, nullptr) << op;
+        EXPECT_GE(CPUOpcodes::kTable[op].cycles_wide, CPUOpcodes::kTable[op].cycles) << op;
+    }
+}
+
+TEST(OpcodeTableTest, Disassembles) {
+    auto dis = [](std::initializer_list<uint8_t> bytes, bool m16 = false, bool x16 = false) {
+        uint8_t buf[4] = {};
+        std::copy(bytes.begin(), bytes.end(), buf);
+        return CPUOpcodes::disassemble(buf, 0x018000, m16, x16);
+    };
+    EXPECT_EQ(dis({0xA9, 0x34}), "LDA #$34");
+    EXPECT_EQ(dis({0xA9, 0x34, 0x12}, true), "LDA #$1234");
+    EXPECT_EQ(dis({0xBD, 0x00, 0x20}), "LDA $2000,X");
+    EXPECT_EQ(dis({0xB7, 0x10}), "LDA [$10],Y");
+    EXPECT_EQ(dis({0xB3, 0x03}), "LDA ($03,S),Y");
+    EXPECT_EQ(dis({0x22, 0x56, 0x34, 0x12}), "JSL $123456");
+    EXPECT_EQ(dis({0xDC, 0x00, 0x30}), "JML [$3000]");
+    EXPECT_EQ(dis({0xD0, 0xFE}), "BNE $8000");
+    EXPECT_EQ(dis({0x82, 0xFD, 0xFF}), "BRL $8000");
+    EXPECT_EQ(dis({0x54, 0x7E, 0x7F}), "MVN $7F,$7E");
+    EXPECT_EQ(dis({0x0A}), "ASL A");
+}
+
+TEST(OpcodeTableTest, FormatsTraceRecords) {
+    TraceRecord record{};
+    record.kind = TraceRecord::kInstruction;
+    record.pc = 0x7E8000;
+    record.opcode = 0xA9;
+    record.arg = 0x1234;
+    record.sp = 0x01FD;
+    record.p = 0x10;        // M clear: 16-bit immediate
+    std::string line = CPUOpcodes::format_trace(record);
+    EXPECT_EQ(line.rfind("7E:8000  A9 34 12", 0), 0u) << line;
+    EXPECT_NE(line.find("LDA #$1234"), std::string::npos) << line;
+    EXPECT_NE(line.find("S:01FD"), std::string::npos) << line;
+}
+
+TEST(OpcodeTableTest, UnimplementedOpcodeSkipsOperandsAndIsCounted) {
+    ASSERT_FALSE(CPUInstructions::is_implemented(0x0F));    // ORA long
+    ASSERT_TRUE(CPUInstructions::is_implemented(0xA9));
+
+    auto bus = std::make_shared<Bus>();
+    auto cpu = std::make_shared<CPU>();
+    cpu->connect_bus(bus);
+    cpu->pc = 0x7E0000;
+    // ORA $123456; NOP
+    const uint8_t code[] = {0x0F, 0x56, 0x34, 0x12, 0xEA};
+    for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+    cpu->step();
+    EXPECT_EQ(cpu->pc, 0x7E0004u);
+    EXPECT_EQ(cpu->cycles, CPUOpcodes::kTable[0x0F].cycles);
+    EXPECT_EQ(cpu->get_unimplemented_counts()[0x0F], 1u);
+    cpu->step();
+    EXPECT_EQ(cpu->pc, 0x7E0005u);
+    EXPECT_EQ(cpu->get_unimplemented_counts()[0xEA], 0u);
+}
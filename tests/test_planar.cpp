@@ -0,0 +1,112 @@
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "planar.hpp"
+#include "ppu.hpp"
+#include "simd.hpp"
+
+namespace {
+
+const SimdLevel kLevels[] = {SimdLevel::kScalar, SimdLevel::kSse2, SimdLevel::kAvx2};
+
+// Runs fn once per level this CPU supports, then goes back to the best
+template <typename Fn>
+void for_each_level(Fn fn) {
+    for (SimdLevel level : kLevels) {
+        if (!set_simd_level(level)) continue;
+        SCOPED_TRACE(simd_level_name(level));
+        fn(level);
+    }
+    set_simd_level(simd_best_level());
+}
+
+// One bit at a time
+uint8_t reference_pixel(const uint8_t* tile, int planes, int x, int y, bool hflip) {
+    int bit = hflip ? x : 7 - x;
+    uint8_t index = 0;
+    for (int p = 0; p < planes; ++p) {
+        index |= ((tile[16 * (p >> 1) + 2 * y + (p & 1)] >> bit) & 1) << p;
+    }
+    return index;
+}
+
+} // namespace
+
+TEST(PlanarTest, LevelsReportSupport) {
+    EXPECT_TRUE(simd_supported(SimdLevel::kScalar));
+    EXPECT_TRUE(simd_supported(simd_best_level()));
+    EXPECT_EQ(simd_level(), simd_best_level());
+    if (!simd_supported(SimdLevel::kAvx2)) {
+        EXPECT_FALSE(set_simd_level(SimdLevel::kAvx2));
+        EXPECT_EQ(simd_level(), simd_best_level());
+    }
+}
+
+TEST(PlanarTest, KernelsMatchReference) {
+    std::mt19937 rng(1234);
+    std::vector<uint8_t> tile(64);
+    for_each_level([&](SimdLevel) {
+        for (int round = 0; round < 200; ++round) {
+            for (auto& b : tile) b = (uint8_t)rng();
+            // Edge patterns: all set, all clear, single bits
+            if (round == 0) std::fill(tile.begin(), tile.end(), 0xFF);
+            if (round == 1) std::fill(tile.begin(), tile.end(), 0x00);
+            if (round == 2) for (int i = 0; i < 64; ++i) tile[i] = (uint8_t)(1 << (i & 7));
+            for (int planes : {1, 2, 3, 4, 8}) {
+                for (bool hflip : {false, true}) {
+                    uint8_t out[64];
+                    planar_to_chunky_tile(tile.data(), planes, hflip, out);
+                    for (int y = 0; y < 8; ++y) {
+                        uint8_t row[8];
+                        planar_to_chunky_row(tile.data(), planes, y, hflip, row);
+                        for (int x = 0; x < 8; ++x) {
+                            uint8_t expected = reference_pixel(tile.data(), planes, x, y, hflip);
+                            ASSERT_EQ(out[y * 8 + x], expected) << planes << "bpp x=" << x << " y=" << y;
+                            ASSERT_EQ(row[x], expected) << planes << "bpp x=" << x << " y=" << y;
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+// The BG scenes of test_ppu.cpp (map sizes, 16x16 tiles, flips) over random
+// VRAM, at every depth: each level must draw the same lines
+TEST(PlanarTest, RenderedLinesMatchAcrossLevels) {
+    std::mt19937 rng(99);
+    std::vector<uint8_t> vram(64 * 1024);
+    for (auto& b : vram) b = (uint8_t)rng();
+
+    auto render = [&](uint8_t bgmode, uint8_t bgsc) {
+        auto ppu = std::make_unique<PPU>();
+        for (size_t i = 0; i < vram.size(); ++i) ppu->write_vram((uint16_t)i, vram[i]);
+        ppu->write_register(0x2105, bgmode);
+        ppu->write_register(0x2107, bgsc);
+        ppu->write_register(0x210B, 0x02);
+        ppu->write_register(0x210D, 0x23);
+        ppu->write_register(0x210D, 0x01);
+        ppu->write_register(0x2111, 0x45);
+        std::vector<uint8_t> lines;
+        uint8_t line[PPU::kScreenWidth];
+        for (int depth = 0; depth < TileCache::kDepths; ++depth) {
+            for (int y = 0; y < PPU::kScreenHeight; ++y) {
+                ppu->render_bg_line(0, y, (TileCache::Depth)depth, line);
+                lines.insert(lines.end(), line, line + PPU::kScreenWidth);
+            }
+        }
+        return lines;
+    };
+
+    for (uint8_t bgmode : {0x00, 0x10}) {
+        for (uint8_t bgsc : {0x00, 0x40, 0x80, 0xC0}) {
+            set_simd_level(SimdLevel::kScalar);
+            std::vector<uint8_t> expected = render(bgmode, bgsc);
+            for_each_level([&](SimdLevel) {
+                EXPECT_EQ(render(bgmode, bgsc), expected) << "BGMODE " << (int)bgmode << " BG1SC " << (int)bgsc;
+            });
+        }
+    }
+}
@@ -76,6 +76,36 @@ TEST_F(PPUTest, RegisterAccess) {
     EXPECT_EQ(ppu.read_register(0x213F), 0);
 }
 
+TEST_F(PPUTest, VRAMPortsUseWordAddresses) {
+    // Word $1234, stepping after the high byte
+    ppu.write_register(0x2115, 0x80);
+    ppu.write_register(0x2116, 0x34);
+    ppu.write_register(0x2117, 0x12);
+    ppu.write_register(0x2118, 0xAA);
+    ppu.write_register(0x2119, 0xBB);
+    ppu.write_register(0x2118, 0xCC);
+    EXPECT_EQ(ppu.read_vram(0x2468), 0xAA);
+    EXPECT_EQ(ppu.read_vram(0x2469), 0xBB);
+    EXPECT_EQ(ppu.read_vram(0x246A), 0xCC);
+    // Reads come from a buffer loaded when the address is set
+    ppu.write_register(0x2116, 0x34);
+    EXPECT_EQ(ppu.read_register(0x2139), 0xAA);
+    EXPECT_EQ(ppu.read_register(0x213A), 0xBB);
+    // Step of 32 words after the low byte
+    ppu.write_register(0x2115, 0x01);
+    ppu.write_register(0x2116, 0x00);
+    ppu.write_register(0x2117, 0x00);
+    ppu.write_register(0x2118, 0x01);
+    ppu.write_register(0x2118, 0x02);
+    EXPECT_EQ(ppu.read_vram(0x0000), 0x01);
+    EXPECT_EQ(ppu.read_vram(0x0040), 0x02);
+    // CGADD is a colour index
+    ppu.write_register(0x2121, 0x02);
+    ppu.write_register(0x2122, 0x1F);
+    ppu.write_register(0x2122, 0x7C);
+    EXPECT_EQ(ppu.get_cgram_color(2), 0x7C1F);
+}
+
 TEST_F(PPUTest, BGRegistersAccess) {
     // $2105: BGMODE
     ppu.write_register(0x2105, 0x03);
@@ -177,6 +207,63 @@ TEST_F(PPUTest, CGRAMColorFetch) {
     EXPECT_EQ(ppu.get_cgram_color(256), 0);
 }
 
+TEST_F(PPUTest, PaletteConvertsColors) {
+    EXPECT_EQ(Palette::to_rgba8888(0x0000), 0xFF000000u);
+    EXPECT_EQ(Palette::to_rgba8888(0x7FFF), 0xFFFFFFFFu);
+    EXPECT_EQ(Palette::to_rgba8888(0x001F), 0xFF0000FFu);    // Red in the low byte
+    EXPECT_EQ(Palette::to_rgba8888(0x7C00), 0xFFFF0000u);    // Blue
+    EXPECT_EQ(Palette::to_rgba8888(0x0210), 0xFF008484u);    // 16 widens to $84
+
+    ppu.write_cgram(2, 0xE0);
+    ppu.write_cgram(3, 0x83);   // Bit 15 is dropped: $03E0 green
+    const Palette& palette = ppu.get_palette();
+    EXPECT_EQ(palette.bgr555(1), 0x03E0);
+    EXPECT_EQ(palette.rgba8888(1), 0xFF00FF00u);
+    EXPECT_EQ(palette.rgb888(1)[0], 0x00);
+    EXPECT_EQ(palette.rgb888(1)[1], 0xFF);
+    EXPECT_EQ(palette.rgb888(1)[2], 0x00);
+
+    const uint8_t indices[3] = {0, 1, 0};
+    uint32_t rgba[3];
+    palette.resolve(indices, 3, rgba);
+    EXPECT_EQ(rgba[0], 0xFF000000u);
+    EXPECT_EQ(rgba[1], 0xFF00FF00u);
+    uint8_t rgb[9];
+    palette.resolve_rgb888(indices, 3, rgb);
+    EXPECT_EQ(rgb[4], 0xFF);
+}
+
+// Every way into CGRAM must reach the palette the renderers read from
+TEST_F(PPUTest, PaletteFollowsCGRAMWrites) {
+    const Palette& palette = ppu.get_palette();
+
+    ppu.write_register(0x2121, 0x05);
+    ppu.write_register(0x2122, 0x1F);
+    EXPECT_EQ(palette.bgr555(5), 0x001F);   // Low byte alone already shows
+    ppu.write_register(0x2122, 0x7C);
+    EXPECT_EQ(palette.bgr555(5), 0x7C1F);
+
+    // Bulk uploads wrap from the last color back to the first
+    const uint8_t colors[6] = {0x11, 0x11, 0x22, 0x22, 0x33, 0x33};
+    ppu.write_register(0x2121, 0xFF);
+    ppu.write_cgram_port(colors, sizeof(colors));
+    EXPECT_EQ(palette.bgr555(255), 0x1111);
+    EXPECT_EQ(palette.bgr555(0), 0x2222);
+    EXPECT_EQ(palette.bgr555(1), 0x3333);
+
+    // Restoring a state rebuilds it; reset clears it
+    PPUState state;
+    ppu.save_state(state);
+    ppu.reset();
+    EXPECT_EQ(palette.bgr555(5), 0);
+    ppu.load_state(state);
+    EXPECT_EQ(palette.bgr555(5), 0x7C1F);
+    EXPECT_EQ(palette.rgba8888(255), Palette::to_rgba8888(0x1111));
+    for (int i = 0; i < Palette::kColors; ++i) {
+        EXPECT_EQ(palette.bgr555(i), ppu.get_cgram_color(i));
+    }
+}
+
 // Helper for test: fill framebuffer with a pattern
 static void fill_framebuffer_for_test(PPU& ppu, uint16_t value) {
     for (int y = 0; y < PPU::kScreenHeight; ++y) {
@@ -242,10 +329,11 @@ TEST_F(PPUTest, BGMode0SimpleTileFetch) {
     ppu.write_register(0x2107, 0x00); // BG1SC: tilemap base 0x0000
     ppu.write_register(0x210B, 0x01); // BG1NBA: tiledata base 0x1000
     // Fill VRAM with a simple 8x8 tile: all pixels = 1 (2bpp, Mode 0)
-    // SNES 2bpp tile: 16 bytes per tile, each bitplane is 8 bytes
+    // SNES 2bpp tile: 16 bytes per tile, row y is bitplane 0 at byte 2y and
+    // bitplane 1 at byte 2y+1
     // For tile 0, set all bits in bitplane 0, clear bitplane 1
-    for (int i = 0; i < 8; ++i) ppu.write_vram(0x1000 + i, 0xFF); // bitplane 0
-    for (int i = 8; i < 16; ++i) ppu.write_vram(0x1000 + i, 0x00); // bitplane 1
+    for (int i = 0; i < 16; i += 2) ppu.write_vram(0x1000 + i, 0xFF); // bitplane 0
+    for (int i = 1; i < 16; i += 2) ppu.write_vram(0x1000 + i, 0x00); // bitplane 1
     // Set BG1 tilemap to use tile 0 for first 32 tiles of scanline 0
     for (int i = 0; i < 32; ++i) {
         ppu.write_vram(0x0000 + i * 2, 0x00); // tile index low
@@ -258,7 +346,7 @@ TEST_F(PPUTest, BGMode0SimpleTileFetch) {
     ppu.write_register(0x2111, 0x00); // BG1VOFS high
     // Debug: check VRAM contents for tile 0 data
     for (int i = 0; i < 16; ++i) {
-        EXPECT_EQ(ppu.read_vram(0x1000 + i), (i < 8) ? 0xFF : 0x00);
+        EXPECT_EQ(ppu.read_vram(0x1000 + i), (i % 2 == 0) ? 0xFF : 0x00);
     }
     // Debug: check VRAM contents for tilemap
     for (int i = 0; i < 32; ++i) {
@@ -280,10 +368,10 @@ TEST_F(PPUTest, BGMode0ScrollingAndWraparound) {
     ppu.write_register(0x2107, 0x00); // BG1SC: tilemap base 0x0000
     ppu.write_register(0x210B, 0x01); // BG1NBA: tiledata base 0x1000
     // Fill VRAM with two tiles: tile 0 = all 1s, tile 1 = all 2s
-    for (int i = 0; i < 8; ++i) ppu.write_vram(0x1000 + i, 0xFF); // tile 0, bitplane 0
-    for (int i = 8; i < 16; ++i) ppu.write_vram(0x1000 + i, 0x00); // tile 0, bitplane 1
-    for (int i = 0; i < 8; ++i) ppu.write_vram(0x1010 + i, 0x00); // tile 1, bitplane 0
-    for (int i = 8; i < 16; ++i) ppu.write_vram(0x1010 + i, 0xFF); // tile 1, bitplane 1
+    for (int i = 0; i < 16; i += 2) ppu.write_vram(0x1000 + i, 0xFF); // tile 0, bitplane 0
+    for (int i = 1; i < 16; i += 2) ppu.write_vram(0x1000 + i, 0x00); // tile 0, bitplane 1
+    for (int i = 0; i < 16; i += 2) ppu.write_vram(0x1010 + i, 0x00); // tile 1, bitplane 0
+    for (int i = 1; i < 16; i += 2) ppu.write_vram(0x1010 + i, 0xFF); // tile 1, bitplane 1
     // Set BG1 tilemap: first 16 tiles = tile 1, next 16 = tile 0
     for (int i = 0; i < 16; ++i) {
         ppu.write_vram(0x0000 + i * 2, 0x01); // tile 1
@@ -493,6 +581,7 @@ TEST_F(PPUTest, ExportFramebufferPPMWritesPPMFile) {
 }
 
 TEST_F(PPUTest, FramebufferNotAllZerosAfterRenderScanlineStub) {
+    ppu.write_register(0x2100, 0x0F);   // Display on, full brightness
     // Call render_scanline_stub for all visible scanlines
     for (int scanline = 0; scanline < PPU::kScreenHeight; ++scanline) {
         ppu.render_scanline_stub();
@@ -527,3 +616,75 @@ TEST_F(PPUTest, SpriteOverflowPriorityEdgeCases) {
 TEST_F(PPUTest, PPUPreciseTimingAccuracy) {
     GTEST_SKIP() << "Not yet implemented: PPU timing accuracy test stub.";
 }
+
+TEST_F(PPUTest, BGLineMapSizesAndFlips) {
+    auto set_entry = [&](uint32_t addr, uint16_t entry) {
+        ppu.write_vram(addr, entry & 0xFF);
+        ppu.write_vram(addr + 1, entry >> 8);
+    };
+    uint8_t line[PPU::kScreenWidth];
+    ppu.write_register(0x210B, 0x01);   // BG1 tiles at $1000
+    // Tile 1: pixel (0, 0) color 1, pixel (7, 7) color 2
+    ppu.write_vram(0x1010, 0x80);
+    ppu.write_vram(0x1010 + 2 * 7 + 1, 0x01);
+
+    // 64x32 map: columns 32-63 are the second screen at $0800
+    ppu.write_register(0x2107, 0x40);
+    set_entry(0x0800 + 2 * 1, 0x0C01);  // Column 33, palette 3
+    set_entry(0x0800 + 2 * 2, 0x4001);  // Column 34, H flip
+    set_entry(0x0800 + 2 * 3, 0x8001);  // Column 35, V flip
+    ppu.write_register(0x210D, 0x08);   // HOFS 264
+    ppu.write_register(0x210D, 0x01);
+    ppu.render_bg_line(0, 0, TileCache::k2bpp, line);
+    EXPECT_EQ(line[0], 12 | 1);
+    for (int x = 1; x < 15; ++x) EXPECT_EQ(line[x], 0) << "x=" << x;
+    EXPECT_EQ(line[15], 1);
+    EXPECT_EQ(line[16], 0);
+    ppu.render_bg_line(0, 7, TileCache::k2bpp, line);
+    EXPECT_EQ(line[7], 12 | 2);
+    EXPECT_EQ(line[8], 2);
+    EXPECT_EQ(line[16], 1);
+    EXPECT_EQ(line[23], 0);
+
+    // 32x64 map: rows 32-63 are the second screen; VOFS 255 puts row 32
+    // on line 1
+    ppu.write_register(0x2107, 0x80);
+    ppu.write_register(0x210D, 0x00);
+    ppu.write_register(0x210D, 0x00);
+    ppu.write_register(0x2111, 0xFF);
+    set_entry(0x0800, 0x0001);
+    ppu.render_bg_line(0, 1, TileCache::k2bpp, line);
+    EXPECT_EQ(line[0], 1);
+    // 64x64: rows 32-63 start at the third screen
+    ppu.write_register(0x2107, 0xC0);
+    set_entry(0x1000, 0x0401);
+    ppu.render_bg_line(0, 1, TileCache::k2bpp, line);
+    EXPECT_EQ(line[0], 4 | 1);
+    // 32x32 wraps back to row 0
+    ppu.write_register(0x2107, 0x00);
+    ppu.render_bg_line(0, 1, TileCache::k2bpp, line);
+    EXPECT_EQ(line[0], 0);
+}
+
+TEST_F(PPUTest, BGLine16x16TilesFlipAsOne) {
+    uint8_t line[PPU::kScreenWidth];
+    ppu.write_register(0x2105, 0x10);   // BG1 16x16 tiles
+    ppu.write_register(0x210B, 0x01);
+    // Tile 2 is made of tiles 2, 3 (right), 18 (below) and 19
+    ppu.write_vram(0x1000 + 3 * 16, 0x01);          // Pixel (15, 0) color 1
+    ppu.write_vram(0x1000 + 18 * 16 + 1, 0x80);     // Pixel (0, 8) color 2
+    ppu.write_vram(0x0000, 0x02);
+    ppu.render_bg_line(0, 0, TileCache::k2bpp, line);
+    EXPECT_EQ(line[15], 1);
+    EXPECT_EQ(line[16], 0);
+    ppu.render_bg_line(0, 8, TileCache::k2bpp, line);
+    EXPECT_EQ(line[0], 2);
+
+    ppu.write_vram(0x0001, 0xC0);       // H and V flip
+    ppu.render_bg_line(0, 15, TileCache::k2bpp, line);
+    EXPECT_EQ(line[0], 1);
+    ppu.render_bg_line(0, 7, TileCache::k2bpp, line);
+    EXPECT_EQ(line[15], 2);
+    // The next 16x16 tile starts at x = 16
+    EXPECT_EQ(line[16], 0);
+}
@@ -66,6 +66,35 @@ protected:
         return loaded;
     }
 
+    // Write a synthetic image to a temporary file and load it
+    bool load_image(const std::vector<uint8_t>& image) {
+        std::string path = ::testing::TempDir() + "rom_test.sfc";
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(image.data()), image.size());
+        out.close();
+        bool loaded = load_rom(path);
+        std::remove(path.c_str());
+        return loaded;
+    }
+
+    // Fill in a valid internal header at offset, with the reset vector
+    // pointing at a SEI at the given ROM offset
+    static void write_header(std::vector<uint8_t>& image, uint32_t offset, uint8_t map_mode,
+                             uint8_t cart_type, uint8_t sram_size, uint32_t reset_offset) {
+        const char title[] = "SYNTHETIC TEST ROM   ";
+        for (int i = 0; i < 21; ++i) image[offset + i] = title[i];
+        image[offset + 0x15] = map_mode;
+        image[offset + 0x16] = cart_type;
+        image[offset + 0x17] = 0x08;
+        image[offset + 0x18] = sram_size;
+        image[offset + 0x19] = 0x01;
+        image[offset + 0x1A] = 0x33;
+        image[offset + 0x1C] = 0x34; image[offset + 0x1D] = 0x12;
+        image[offset + 0x1E] = 0xCB; image[offset + 0x1F] = 0xED;
+        image[offset + 0x3C] = 0x00; image[offset + 0x3D] = 0x80;
+        image[reset_offset] = 0x78;
+    }
+
     // Helper to run CPU for specified cycles
     void run_cpu_cycles(uint32_t cycles) {
         for (uint32_t i = 0; i < cycles; i++) {
@@ -268,19 +297,123 @@ TEST_F(ROMTest, ROMSpecificTests) {
 
 // --- Coverage Gap Stubs ---
 TEST_F(ROMTest, LoROMMapping) {
-    GTEST_SKIP() << "Not yet implemented: LoROM mapping test stub.";
+    // 128KB: bank byte at the start of each 32KB half
+    std::vector<uint8_t> image(0x20000, 0xEA);
+    for (uint32_t i = 0; i < image.size(); i += 0x8000) image[i + 1] = (uint8_t)(i >> 15);
+    write_header(image, 0x7FC0, 0x20, 0x00, 0x00, 0x0000);
+    ASSERT_TRUE(load_image(image));
+    EXPECT_EQ(cart->mapper(), Cartridge::Mapper::LoROM);
+    EXPECT_EQ(cart->header().title, "SYNTHETIC TEST ROM");
+    EXPECT_FALSE(cart->header().fast_rom);
+    EXPECT_EQ(cart->sram_size(), 0u);
+
+    EXPECT_EQ(read_memory(0x008000), 0x78);
+    EXPECT_EQ(read_memory(0x008001), 0x00);
+    EXPECT_EQ(read_memory(0x018001), 0x01);
+    EXPECT_EQ(read_memory(0x038001), 0x03);
+    EXPECT_EQ(read_memory(0x838001), 0x03);
+    // 4 banks of image, mirrored above
+    EXPECT_EQ(read_memory(0x048001), 0x00);
+    // Banks $40+ also show ROM in the low half
+    EXPECT_EQ(read_memory(0x410001), 0x01);
+    // System banks keep WRAM and the registers below $8000
+    EXPECT_EQ(read_memory(0x010001), 0x00);
 }
 
 TEST_F(ROMTest, HiROMMapping) {
-    GTEST_SKIP() << "Not yet implemented: HiROM mapping test stub.";
+    // 256KB FastROM: bank byte at the start of each 64KB bank
+    std::vector<uint8_t> image(0x40000, 0xEA);
+    for (uint32_t i = 0; i < image.size(); i += 0x10000) image[i + 1] = (uint8_t)(i >> 16);
+    write_header(image, 0xFFC0, 0x31, 0x00, 0x00, 0x8000);
+    ASSERT_TRUE(load_image(image));
+    EXPECT_EQ(cart->mapper(), Cartridge::Mapper::HiROM);
+    EXPECT_TRUE(cart->header().fast_rom);
+
+    EXPECT_EQ(read_memory(0x008000), 0x78);
+    EXPECT_EQ(read_memory(0xC00001), 0x00);
+    EXPECT_EQ(read_memory(0xC20001), 0x02);
+    EXPECT_EQ(read_memory(0x420001), 0x02);
+    // Upper halves of the system banks mirror the same bank
+    EXPECT_EQ(read_memory(0x038000), read_memory(0xC38000));
+    EXPECT_EQ(read_memory(0xC40001), 0x00);
+
+    // MEMSEL only speeds up banks $80+
+    EXPECT_EQ(bus->access_clocks(0x808000), 8);
+    bus->write(0x00420D, 0x01);
+    EXPECT_EQ(bus->access_clocks(0x808000), 6);
+    EXPECT_EQ(bus->access_clocks(0x008000), 8);
+    EXPECT_EQ(bus->access_clocks(0x7E0000), 8);
+    EXPECT_EQ(bus->access_clocks(0x002100), 6);
+    EXPECT_EQ(bus->access_clocks(0x004016), 12);
 }
 
 TEST_F(ROMTest, CorruptedHeaderHandling) {
-    GTEST_SKIP() << "Not yet implemented: corrupted header handling test stub.";
+    // A LoROM image with a plausible header and a HiROM candidate that is
+    // all garbage: the better scoring candidate wins
+    std::vector<uint8_t> image(0x10000);
+    for (size_t i = 0; i < image.size(); ++i) image[i] = (uint8_t)(i * 7 + (i >> 8));
+    write_header(image, 0x7FC0, 0x20, 0x00, 0x00, 0x0000);
+    image[0xFFFC] = 0x00; image[0xFFFD] = 0x00;
+    ASSERT_TRUE(load_image(image));
+    EXPECT_EQ(cart->mapper(), Cartridge::Mapper::LoROM);
+    EXPECT_GT(cart->header().score, 0);
+
+    // No recognisable header at all still loads, as LoROM
+    std::vector<uint8_t> blank(0x8000, 0x00);
+    ASSERT_TRUE(load_image(blank));
+    EXPECT_EQ(cart->mapper(), Cartridge::Mapper::LoROM);
+    EXPECT_EQ(cart->header().score, 0);
+    EXPECT_EQ(cart->sram_size(), 0u);
+
+    // A 512-byte copier header in front is skipped
+    std::vector<uint8_t> copier(512, 0xFF);
+    copier.insert(copier.end(), image.begin(), image.end());
+    ASSERT_TRUE(load_image(copier));
+    EXPECT_EQ(cart->rom_size(), image.size());
+    EXPECT_EQ(read_memory(0x008000), 0x78);
+
+    // A truncated image (an odd size) mirrors its last page
+    std::vector<uint8_t> odd(0x8000 + 0x100, 0xEA);
+    write_header(odd, 0x7FC0, 0x20, 0x00, 0x00, 0x0000);
+    odd[0x8000] = 0x42;
+    ASSERT_TRUE(load_image(odd));
+    EXPECT_EQ(read_memory(0x018000), 0x42);
 }
 
 TEST_F(ROMTest, SRAMHandling) {
-    GTEST_SKIP() << "Not yet implemented: SRAM handling test stub.";
+    // LoROM with RAM + battery, 2KB of SRAM at $70-$7D:$0000-$7FFF
+    std::vector<uint8_t> image(0x20000, 0xEA);
+    write_header(image, 0x7FC0, 0x20, 0x02, 0x01, 0x0000);
+    ASSERT_TRUE(load_image(image));
+    ASSERT_EQ(cart->sram_size(), 0x800u);
+    EXPECT_EQ(read_memory(0x700000), 0xFF);
+    bus->write(0x700010, 0x5A);
+    EXPECT_EQ(read_memory(0x700010), 0x5A);
+    EXPECT_EQ(cart->sram()[0x10], 0x5A);
+    // Mirrored every 2KB and into $F0+
+    EXPECT_EQ(read_memory(0x700810), 0x5A);
+    EXPECT_EQ(read_memory(0xF00010), 0x5A);
+    // ROM is still read only
+    bus->write(0x008100, 0x00);
+    EXPECT_EQ(read_memory(0x008100), 0xEA);
+
+    // HiROM with 8KB at $20-$3F,$A0-$BF:$6000-$7FFF
+    std::vector<uint8_t> hi(0x20000, 0xEA);
+    write_header(hi, 0xFFC0, 0x21, 0x02, 0x03, 0x8000);
+    ASSERT_TRUE(load_image(hi));
+    ASSERT_EQ(cart->mapper(), Cartridge::Mapper::HiROM);
+    ASSERT_EQ(cart->sram_size(), 0x2000u);
+    bus->write(0x206001, 0xA5);
+    EXPECT_EQ(read_memory(0x206001), 0xA5);
+    EXPECT_EQ(read_memory(0xA06001), 0xA5);
+    EXPECT_EQ(read_memory(0x306001), 0xA5);
+    // Not in the low system banks
+    EXPECT_EQ(read_memory(0x006001), 0x00);
+
+    // A ROM-only board has none even if the size byte is set
+    write_header(hi, 0xFFC0, 0x21, 0x00, 0x03, 0x8000);
+    ASSERT_TRUE(load_image(hi));
+    EXPECT_EQ(cart->sram_size(), 0u);
 }
 
 // --- Automated cputest ROM fine-grained test ---
@@ -365,3 +498,55 @@ TEST(CPUTestROM, CPUTestBasic) {
 TEST(CPUTestROM, CPUTestFull) {
     run_cputest_rom("cputest-full.sfc", "tests/roms/cputest/tests-full.txt", 2000000);
 }
+
+// --- JIT differential runs against the interpreter ---
+
+// Runs the ROM on the plain interpreter and on the block cache + JIT in
+// lockstep, comparing CPU state after every batch and WRAM at the end.
+void run_cputest_differential(const std::string& rom_name, int batches) {
+    if (!CPU::jit_available()) GTEST_SKIP() << "JIT not built";
+    std::string path = find_rom_path(rom_name);
+    if (!std::filesystem::exists(path)) GTEST_SKIP() << rom_name << " not found";
+
+    CputestRunner reference;
+    CputestRunner native;
+    ASSERT_TRUE(reference.load_rom(path));
+    ASSERT_TRUE(native.load_rom(path));
+    reference.cpu->set_block_cache_enabled(false);
+    reference.cpu->set_jit_enabled(false);
+    native.cpu->set_jit_threshold(2);
+    reference.cpu->reset();
+    native.cpu->reset();
+
+    for (int batch = 0; batch < batches; ++batch) {
+        // Alternate cycle and instruction budgets so runs end mid-block
+        if (batch % 2) {
+            reference.cpu->run(97);
+            native.cpu->run(97);
+        } else {
+            reference.cpu->run_instructions(61);
+            native.cpu->run_instructions(61);
+        }
+        const CPU& r = *reference.cpu;
+        const CPU& n = *native.cpu;
+        auto state = [](const CPU& c) {
+            return std::make_tuple(c.a, c.x, c.y, c.stkp, c.pc, c.p, c.d, c.pb, c.db,
+                                   c.cycle_count, c.instruction_count);
+        };
+        ASSERT_EQ(state(r), state(n)) << rom_name << " diverged in batch " << batch
+                                      << " at PC 0x" << std::hex << r.pc;
+    }
+    for (uint32_t addr = 0x7E0000; addr < 0x800000; ++addr) {
+        ASSERT_EQ(reference.read_memory(addr), native.read_memory(addr))
+            << rom_name << " WRAM differs at 0x" << std::hex << addr;
+    }
+    EXPECT_GT(native.cpu->jit_code_size(), 0u);
+}
+
+TEST(CPUTestROM, JitMatchesInterpreterBasic) {
+    run_cputest_differential("cputest-basic.sfc", 20000);
+}
+
+TEST(CPUTestROM, JitMatchesInterpreterFull) {
+    run_cputest_differential("cputest-full.sfc", 20000);
+}
@@ -0,0 +1,153 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "bus.hpp"
+#include "cpu.hpp"
+#include "cpu_sampler.hpp"
+#include "ppu.hpp"
+#include "scheduler.hpp"
+
+namespace {
+
+std::string write_file(const std::string& name, const std::string& text) {
+    std::string path = ::testing::TempDir() + name;
+    std::ofstream out(path);
+    out << text;
+    return path;
+}
+
+} // namespace
+
+TEST(SymbolTableTest, LoadsCa65MapExports) {
+    std::string path = write_file("sampler_test.map",
+        "Modules list:\n"
+        "-------------\n"
+        "main.o:\n"
+        "    CODE              Offs=000000  Size=000100  Align=00001  Fill=0000\n"
+        "\n"
+        "Exports list by name:\n"
+        "---------------------\n"
+        "main                      008000 LA    nmi_handler               008200 LA    \n"
+        "update                    008100 LA    \n"
+        "\n"
+        "Exports list by value:\n"
+        "----------------------\n"
+        "main                      008000 LA    \n");
+    SymbolTable symbols;
+    ASSERT_TRUE(symbols.load(path));
+    std::remove(path.c_str());
+    EXPECT_EQ(symbols.size(), 3u);
+    EXPECT_EQ(symbols.resolve(0x008000), "main");
+    EXPECT_EQ(symbols.resolve(0x008012), "main+$12");
+    EXPECT_EQ(symbols.resolve(0x008150, false), "update");
+    // FastROM mirror of bank 0
+    EXPECT_EQ(symbols.resolve(0x808204), "nmi_handler+$4");
+    // Nothing at or below in the same bank
+    EXPECT_EQ(symbols.resolve(0x007FFF), "$00:7FFF");
+    EXPECT_EQ(symbols.resolve(0x018000), "$01:8000");
+}
+
+TEST(SymbolTableTest, LoadsWlaSymLabels) {
+    std::string path = write_file("sampler_test.sym",
+        "; wla symbolic information file\n"
+        "[labels]\n"
+        "00:8000 Reset\n"
+        "01:9000 DrawSprites\n"
+        "\n"
+        "[definitions]\n"
+        "00000010 SPRITE_COUNT\n");
+    SymbolTable symbols;
+    ASSERT_TRUE(symbols.load(path));
+    std::remove(path.c_str());
+    EXPECT_EQ(symbols.size(), 2u);
+    EXPECT_EQ(symbols.resolve(0x019003), "DrawSprites+$3");
+    EXPECT_EQ(symbols.resolve(0x00FFFF, false), "Reset");
+    EXPECT_FALSE(symbols.load(::testing::TempDir() + "missing.sym"));
+}
+
+// CPU looping over a JSR to a subroutine in bank 0 WRAM, sampled by the
+// scheduler
+class SamplerTest : public ::testing::Test {
+protected:
+    std::shared_ptr<Bus> bus;
+    std::shared_ptr<CPU> cpu;
+    std::shared_ptr<PPU> ppu;
+    std::unique_ptr<Scheduler> scheduler;
+    CPUSampler sampler;
+    SymbolTable symbols;
+
+    void SetUp() override {
+        bus = std::make_shared<Bus>();
+        cpu = std::make_shared<CPU>();
+        ppu = std::make_shared<PPU>();
+        bus->connect_cpu(cpu);
+        bus->connect_ppu(ppu);
+        cpu->connect_bus(bus);
+        scheduler = std::make_unique<Scheduler>(*cpu, *ppu);
+        bus->connect_scheduler(scheduler.get());
+
+        // $0400 main: JSR work; BRA main
+        // $0410 work: NOP x4; RTS
+        const uint8_t main[] = {0x20, 0x10, 0x04, 0x80, 0xFB};
+        const uint8_t work[] = {0xEA, 0xEA, 0xEA, 0xEA, 0x60};
+        for (int i = 0; i < 5; ++i) bus->write(0x7E0400 + i, main[i]);
+        for (int i = 0; i < 5; ++i) bus->write(0x7E0410 + i, work[i]);
+        cpu->pc = 0x0400;
+
+        std::string path = write_file("sampler_test.sym", "[labels]\n00:0400 main\n00:0410 work\n");
+        symbols.load(path);
+        std::remove(path.c_str());
+
+        cpu->set_sampler(&sampler);
+        scheduler->set_sampler(&sampler, 5);
+    }
+};
+
+TEST_F(SamplerTest, SamplesAtTheInterval) {
+    scheduler->run_until(5000, UINT64_MAX);
+    // One sample per 5 cycles, taken at the instruction boundary after
+    EXPECT_GE(sampler.sample_count(), 900u);
+    EXPECT_LE(sampler.sample_count(), 1000u);
+    uint64_t total = 0;
+    for (const auto& entry : sampler.pc_histogram()) {
+        EXPECT_TRUE((entry.first >= 0x0400 && entry.first < 0x0405) ||
+                    (entry.first >= 0x0410 && entry.first < 0x0415)) << std::hex << entry.first;
+        total += entry.second;
+    }
+    EXPECT_EQ(total, sampler.sample_count());
+
+    sampler.reset();
+    EXPECT_EQ(sampler.sample_count(), 0u);
+    EXPECT_TRUE(sampler.pc_histogram().empty());
+}
+
+TEST_F(SamplerTest, FoldsCallStacks) {
+    scheduler->run_until(5000, UINT64_MAX);
+    auto flat = sampler.flat_profile(symbols);
+    ASSERT_EQ(flat.size(), 2u);
+    // Most of each pass is spent in the subroutine
+    EXPECT_GT(flat["work"], flat["main"]);
+
+    auto stacks = sampler.stack_profile(symbols);
+    ASSERT_EQ(stacks.size(), 2u);
+    EXPECT_EQ(stacks["main;work"], flat["work"]);
+    EXPECT_EQ(stacks["main"], flat["main"]);
+}
+
+TEST_F(SamplerTest, StackSurvivesDiscardedReturnAddresses) {
+    // A subroutine that drops its return address (PLA; PLA) and jumps back
+    // instead of returning must not leave frames piling up
+    const uint8_t work[] = {0x68, 0x68, 0x4C, 0x00, 0x04};
+    for (int i = 0; i < 5; ++i) bus->write(0x7E0410 + i, work[i]);
+    scheduler->run_until(5000, UINT64_MAX);
+    auto stacks = sampler.stack_profile(symbols);
+    EXPECT_GT(stacks["main;work"], 0u);
+    for (const auto& entry : stacks) {
+        // Once the address is pulled, the rest of the subroutine is a root
+        EXPECT_TRUE(entry.first == "main" || entry.first == "main;work" || entry.first == "work")
+            << entry.first;
+    }
+}
@@ -0,0 +1,297 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "gtest/gtest.h"
+#include "bus.hpp"
+#include "cpu.hpp"
+#include "ppu.hpp"
+#include "scheduler.hpp"
+
+// CPU spinning in a NOP/BRA loop in WRAM, with the PPU on the same bus
+class SchedulerTest : public ::testing::Test {
+protected:
+    std::shared_ptr<Bus> bus;
+    std::shared_ptr<CPU> cpu;
+    std::shared_ptr<PPU> ppu;
+    std::unique_ptr<Scheduler> scheduler;
+
+    void SetUp() override {
+        bus = std::make_shared<Bus>();
+        cpu = std::make_shared<CPU>();
+        ppu = std::make_shared<PPU>();
+        bus->connect_cpu(cpu);
+        bus->connect_ppu(ppu);
+        cpu->connect_bus(bus);
+        scheduler = std::make_unique<Scheduler>(*cpu, *ppu);
+        bus->connect_scheduler(scheduler.get());
+
+        // loop: NOP; NOP; BRA loop
+        const uint8_t loop[] = {0xEA, 0xEA, 0x80, 0xFC};
+        for (int i = 0; i < 4; ++i) bus->write(0x7E0000 + i, loop[i]);
+        cpu->pc = 0x7E0000;
+    }
+
+    // Run until the master clock reaches at least clock
+    void run_to_clock(uint64_t clock) {
+        uint64_t cycles = (clock + Scheduler::kClocksPerCpuCycle - 1) / Scheduler::kClocksPerCpuCycle;
+        scheduler->run_until(cycles, UINT64_MAX);
+    }
+};
+
+TEST_F(SchedulerTest, FrameIs357368MasterClocks) {
+    EXPECT_EQ(Scheduler::kClocksPerFrame, 357368u);
+    run_to_clock(Scheduler::kClocksPerFrame - Scheduler::kClocksPerCpuCycle * 4);
+    EXPECT_EQ(ppu->get_frame(), 0);
+    EXPECT_EQ(ppu->get_scanline(), PPU::kTotalScanlines - 1);
+    run_to_clock(Scheduler::kClocksPerFrame);
+    EXPECT_EQ(ppu->get_frame(), 1);
+    EXPECT_EQ(ppu->get_scanline(), 0);
+    EXPECT_FALSE(ppu->get_vblank());
+    // The PPU dot follows the master clock
+    EXPECT_EQ(ppu->get_dot(), (int)((scheduler->get_clock() - Scheduler::kClocksPerFrame) / Scheduler::kClocksPerDot));
+}
+
+TEST_F(SchedulerTest, HBlankStartsAtDot301) {
+    run_to_clock(290 * Scheduler::kClocksPerDot);
+    EXPECT_FALSE(ppu->get_hblank());
+    EXPECT_EQ(bus->read(0x4212), 0x00);
+    run_to_clock(Scheduler::kHBlankDot * Scheduler::kClocksPerDot);
+    EXPECT_TRUE(ppu->get_hblank());
+    EXPECT_EQ(bus->read(0x4212), 0x40);
+    run_to_clock(Scheduler::kClocksPerScanline);
+    EXPECT_FALSE(ppu->get_hblank());
+    EXPECT_EQ(ppu->get_scanline(), 1);
+}
+
+TEST_F(SchedulerTest, VBlankSetsRdnmiWithoutNmiWhenDisabled) {
+    uint64_t vblank = (uint64_t)PPU::kScreenHeight * Scheduler::kClocksPerScanline;
+    run_to_clock(vblank);
+    EXPECT_TRUE(ppu->get_vblank());
+    EXPECT_EQ(cpu->stkp, 0x01FD);
+    EXPECT_EQ(bus->read(0x4212) & 0x80, 0x80);
+    // RDNMI bit 7 clears on read
+    EXPECT_EQ(bus->read(0x4210), 0x82);
+    EXPECT_EQ(bus->read(0x4210), 0x02);
+}
+
+TEST_F(SchedulerTest, VBlankRaisesNmiWhenEnabled) {
+    bus->write(0x4200, 0x80);
+    uint64_t vblank = (uint64_t)PPU::kScreenHeight * Scheduler::kClocksPerScanline;
+    run_to_clock(vblank - Scheduler::kClocksPerCpuCycle * 4);
+    EXPECT_EQ(cpu->stkp, 0x01FD);
+    run_to_clock(vblank);
+    // PC and P pushed, vector taken
+    EXPECT_EQ(cpu->stkp, 0x01FA);
+    EXPECT_EQ(cpu->pc, 0x8000);
+    EXPECT_TRUE(cpu->get_flag(CPU::I));
+}
+
+TEST_F(SchedulerTest, HIrqFiresAtHtime) {
+    bus->set_interrupt_vector(0x00, 0x90);
+    cpu->set_flag(CPU::I, false);
+    bus->write(0x4207, 100);
+    bus->write(0x4208, 0x00);
+    bus->write(0x4200, 0x10);
+    run_to_clock(96 * Scheduler::kClocksPerDot);
+    EXPECT_EQ(cpu->stkp, 0x01FD);
+    run_to_clock(100 * Scheduler::kClocksPerDot);
+    EXPECT_EQ(cpu->stkp, 0x01FA);
+    EXPECT_EQ(cpu->pc, 0x9000);
+    // TIMEUP acknowledges the IRQ
+    EXPECT_EQ(bus->read(0x4211), 0x80);
+    EXPECT_EQ(bus->read(0x4211), 0x00);
+}
+
+TEST_F(SchedulerTest, VIrqLatchesTimeupWhileMasked) {
+    bus->write(0x4209, 10);
+    bus->write(0x420A, 0x00);
+    bus->write(0x4200, 0x20);
+    run_to_clock(10 * Scheduler::kClocksPerScanline - Scheduler::kClocksPerCpuCycle * 4);
+    EXPECT_EQ(bus->read(0x4211), 0x00);
+    run_to_clock(10 * Scheduler::kClocksPerScanline);
+    // I is set after reset, so the IRQ is only flagged
+    EXPECT_EQ(cpu->stkp, 0x01FD);
+    EXPECT_EQ(bus->read(0x4211), 0x80);
+}
+
+TEST_F(SchedulerTest, WaiFastForwardsToNmi) {
+    bus->write(0x7E0000, 0xCB);     // WAI
+    bus->write(0x4200, 0x80);
+    run_to_clock((uint64_t)PPU::kScreenHeight * Scheduler::kClocksPerScanline);
+    // Only WAI ran; the NMI at V-blank woke the CPU and took the vector
+    EXPECT_EQ(cpu->instruction_count, 1u);
+    EXPECT_TRUE(ppu->get_vblank());
+    EXPECT_FALSE(cpu->is_halted());
+    EXPECT_EQ(cpu->stkp, 0x01FA);
+    EXPECT_EQ(bus->read(0x0001FC), 0x00);   // Return address $0001
+    EXPECT_EQ(bus->read(0x0001FB), 0x01);
+}
+
+TEST_F(SchedulerTest, HaltedCpuKeepsPpuTime) {
+    bus->write(0x7E0000, 0xDB);     // STP
+    run_to_clock(Scheduler::kClocksPerFrame);
+    EXPECT_EQ(cpu->instruction_count, 1u);
+    EXPECT_EQ(ppu->get_frame(), 1);
+    // Nothing can wake STP, so an instruction-bounded run returns
+    scheduler->run_until(UINT64_MAX, cpu->instruction_count + 1);
+    EXPECT_EQ(cpu->get_halt(), CPU::Halt::Stop);
+}
+
+TEST_F(SchedulerTest, IdleLoopSkipMatchesExecution) {
+    // wait: LDA $4210; BPL wait
+    const uint8_t code[] = {0xAD, 0x10, 0x42, 0x10, 0xFB};
+    uint64_t vblank = (uint64_t)PPU::kScreenHeight * Scheduler::kClocksPerScanline;
+    auto run = [&](bool skip) {
+        SetUp();
+        for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+        cpu->set_idle_skip_enabled(skip);
+        std::vector<uint64_t> state;
+        for (uint64_t clock : {vblank / 3, vblank - 8, vblank + 64}) {
+            run_to_clock(clock);
+            state.insert(state.end(), {cpu->cycle_count, cpu->instruction_count, cpu->pc, cpu->a, cpu->p});
+        }
+        return state;
+    };
+    std::vector<uint64_t> executed = run(false);
+    EXPECT_EQ(cpu->get_idle_stats().skips, 0u);
+    std::vector<uint64_t> skipped = run(true);
+    EXPECT_EQ(skipped, executed);
+    if (PYSNES_TRACE_LEVEL == 0) {
+        EXPECT_GT(cpu->get_idle_stats().skips, 0u);
+        EXPECT_GT(cpu->get_idle_stats().instructions, cpu->instruction_count / 2);
+    }
+}
+
+// Skipped passes must leave room for the instruction that enters the
+// loop again, so runs end exactly on their cycle or instruction budget
+TEST_F(SchedulerTest, IdleLoopSkipStopsAtTheBudget) {
+    // wait: LDA $10; BEQ wait
+    const uint8_t code[] = {0xA5, 0x10, 0xF0, 0xFC};
+    auto run = [&](bool skip, bool by_cycles, uint64_t budget) {
+        SetUp();
+        for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+        cpu->set_idle_skip_enabled(skip);
+        uint64_t done = by_cycles ? cpu->run(budget) : cpu->run_instructions(budget);
+        return std::vector<uint64_t>{done, cpu->cycle_count, cpu->instruction_count, cpu->pc};
+    };
+    uint64_t skips = 0;
+    for (bool by_cycles : {false, true}) {
+        for (uint64_t budget = 1; budget <= 40; ++budget) {
+            std::vector<uint64_t> executed = run(false, by_cycles, budget);
+            std::vector<uint64_t> skipped = run(true, by_cycles, budget);
+            skips += cpu->get_idle_stats().skips;
+            EXPECT_EQ(skipped, executed) << (by_cycles ? "cycles " : "instructions ") << budget;
+            if (!by_cycles) {
+                EXPECT_EQ(skipped[2], budget);
+            }
+        }
+    }
+    if (PYSNES_TRACE_LEVEL == 0) {
+        EXPECT_GT(skips, 0u);
+    }
+}
+
+TEST_F(SchedulerTest, LoopsWithSideEffectsAreNotSkipped) {
+    // INX; LDA $10; BEQ -4 changes X every pass
+    const uint8_t code[] = {0xE8, 0xA5, 0x10, 0xF0, 0xFB};
+    for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+    cpu->set_idle_skip_enabled(true);
+    run_to_clock(Scheduler::kClocksPerScanline * 10);
+    EXPECT_EQ(cpu->get_idle_stats().skips, 0u);
+    EXPECT_GT(cpu->x, 0u);
+}
+
+// With D = $2100, LDA $39 polls VMDATAHREAD on the hardware; with a data
+// bank set, absolute operands leave bank 0. Neither loop may be skipped.
+TEST_F(SchedulerTest, LoopsPollingThroughDirectPageOrDataBankAreNotSkipped) {
+    struct Case {
+        uint16_t d;
+        uint8_t db;
+        std::vector<uint8_t> code;
+    };
+    const Case cases[] = {
+        {0x0000, 0x00, {0xA5, 0x39, 0xF0, 0xFC}},          // wait: LDA $39; BEQ wait
+        {0x2100, 0x00, {0xA5, 0x39, 0xF0, 0xFC}},
+        {0x0000, 0x00, {0xAD, 0x39, 0x00, 0xF0, 0xFB}},    // wait: LDA $0039; BEQ wait
+        {0x0000, 0x7F, {0xAD, 0x39, 0x00, 0xF0, 0xFB}},
+        {0x0000, 0x00, {0xB5, 0x39, 0xF0, 0xFC}},          // wait: LDA $39,X; BEQ wait
+    };
+    for (const Case& c : cases) {
+        SetUp();
+        for (uint32_t i = 0; i < c.code.size(); ++i) bus->write(0x7E0000 + i, c.code[i]);
+        cpu->d = c.d;
+        cpu->db = c.db;
+        cpu->set_idle_skip_enabled(true);
+        run_to_clock(Scheduler::kClocksPerScanline * 10);
+        bool plain = c.d == 0 && c.db == 0 && c.code[0] != 0xB5;
+        if (PYSNES_TRACE_LEVEL == 0 && plain) {
+            EXPECT_GT(cpu->get_idle_stats().skips, 0u) << "opcode " << (int)c.code[0];
+        } else if (!plain) {
+            EXPECT_EQ(cpu->get_idle_stats().skips, 0u)
+                << "opcode " << (int)c.code[0] << " D " << c.d << " DB " << (int)c.db;
+        }
+    }
+}
+
+TEST_F(SchedulerTest, NmiLandsInsideBlockMove) {
+    // MVN $7E,$7F over 64KB outlasts the frame
+    const uint8_t code[] = {0x54, 0x7E, 0x7F};
+    for (uint32_t i = 0; i < sizeof(code); ++i) bus->write(0x7E0000 + i, code[i]);
+    cpu->p &= ~CPU::X;
+    cpu->a = 0xFFFF;
+    cpu->x = 0x0000;
+    cpu->y = 0x8000;
+    bus->write(0x4200, 0x80);
+    run_to_clock((uint64_t)PPU::kScreenHeight * Scheduler::kClocksPerScanline);
+    // Interrupted with pc on the MVN, one instruction per byte so far
+    EXPECT_EQ(cpu->stkp, 0x01FA);
+    EXPECT_EQ(bus->read(0x0001FC), 0x00);
+    EXPECT_EQ(bus->read(0x0001FB), 0x00);
+    EXPECT_EQ((uint64_t)(0xFFFF - cpu->a), cpu->instruction_count);
+    EXPECT_EQ(cpu->x, cpu->instruction_count);
+}
+
+TEST_F(SchedulerTest, HdmaTransfersPerLine) {
+    // Channel 0, direct, to the WRAM port: 3 lines one byte each (repeat),
+    // then one byte held for 2 lines
+    const uint8_t direct[] = {0x83, 0x10, 0x11, 0x12, 0x02, 0x20, 0x00};
+    for (uint32_t i = 0; i < sizeof(direct); ++i) bus->write(0x7E1000 + i, direct[i]);
+    bus->write(0x4300, 0x00);
+    bus->write(0x4301, 0x80);
+    bus->write(0x4302, 0x00);
+    bus->write(0x4303, 0x10);
+    bus->write(0x4304, 0x7E);
+    bus->write(0x2181, 0x00);
+    bus->write(0x2182, 0x20);
+    bus->write(0x2183, 0x00);
+    // Channel 1, indirect, to CGRAM: 2 lines of one byte from $7E:1200
+    const uint8_t indirect[] = {0x82, 0x00, 0x12, 0x00};
+    for (uint32_t i = 0; i < sizeof(indirect); ++i) bus->write(0x7E1100 + i, indirect[i]);
+    bus->write(0x7E1200, 0x55);
+    bus->write(0x7E1201, 0x66);
+    bus->write(0x4310, 0x40);
+    bus->write(0x4311, 0x22);
+    bus->write(0x4312, 0x00);
+    bus->write(0x4313, 0x11);
+    bus->write(0x4314, 0x7E);
+    bus->write(0x4317, 0x7E);
+    bus->write(0x2121, 0x00);
+    bus->write(0x420C, 0x03);
+
+    // Tables start with the next frame, along with the first line's transfer
+    run_to_clock(Scheduler::kClocksPerFrame + Scheduler::kClocksPerDot * 10);
+    EXPECT_EQ(bus->read(0x7E2000), 0x10);
+    EXPECT_EQ(bus->read(0x7E2001), 0x00);
+    EXPECT_EQ(ppu->read_cgram(0), 0x55);
+    run_to_clock(Scheduler::kClocksPerFrame + Scheduler::kClocksPerScanline * 4);
+    const uint8_t expected[] = {0x10, 0x11, 0x12, 0x20, 0x00};
+    for (uint32_t i = 0; i < sizeof(expected); ++i) EXPECT_EQ(bus->read(0x7E2000 + i), expected[i]) << i;
+    EXPECT_EQ(ppu->read_cgram(1), 0x66);
+    EXPECT_EQ(bus->get_dma_channel(0).table_address, 0x1007);
+    EXPECT_TRUE(bus->get_dma_channel(1).hdma_done);
+
+    // Every frame starts over
+    run_to_clock(Scheduler::kClocksPerFrame * 2 + Scheduler::kClocksPerScanline * 4);
+    EXPECT_EQ(bus->read(0x7E2004), 0x10);
+    EXPECT_EQ(bus->read(0x7E2007), 0x20);
+}
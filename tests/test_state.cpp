@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "bus.hpp"
+#include "cpu.hpp"
+#include "snes.hpp"
+
+namespace {
+
+// The basic CPU test ROM when PYSNES_ROM_DIR is set; without it the machine
+// runs from open bus, which is just as deterministic
+void insert_test_rom(SNES& snes) {
+    if (const char* dir = std::getenv("PYSNES_ROM_DIR")) {
+        std::string path = std::string(dir) + "/cputest-basic.sfc";
+        if (std::filesystem::exists(path)) snes.insert_cartridge(path);
+    }
+}
+
+// A LoROM image with 2KB of battery SRAM whose reset code loops on
+// LDA $700010; INC A; STA $700010; BRA loop
+std::string write_sram_rom() {
+    std::vector<uint8_t> image(0x20000, 0xEA);
+    const uint8_t code[] = {0xAF, 0x10, 0x00, 0x70, 0x1A, 0x8F, 0x10, 0x00, 0x70, 0x80, 0xF5};
+    std::copy(std::begin(code), std::end(code), image.begin());
+    const char title[] = "SRAM STATE TEST      ";
+    std::copy(title, title + 21, image.begin() + 0x7FC0);
+    image[0x7FD5] = 0x20;   // LoROM
+    image[0x7FD6] = 0x02;   // ROM + RAM + battery
+    image[0x7FD7] = 0x08;
+    image[0x7FD8] = 0x01;   // 2KB SRAM
+    image[0x7FFC] = 0x00;
+    image[0x7FFD] = 0x80;
+    std::string path = ::testing::TempDir() + "sram_state_test.sfc";
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(image.data()), image.size());
+    return path;
+}
+
+} // namespace
+
+TEST(SaveStateTest, RestoredMachineRunsTheSame) {
+    SNES snes;
+    insert_test_rom(snes);
+    snes.power_on();
+    snes.run(100000);
+
+    std::vector<uint8_t> saved;
+    snes.save_state(saved);
+    ASSERT_EQ(saved.size(), snes.state_size());
+
+    snes.run(300000);
+    std::vector<uint8_t> first;
+    snes.save_state(first);
+
+    ASSERT_TRUE(snes.load_state(saved));
+    std::vector<uint8_t> reloaded;
+    snes.save_state(reloaded);
+    EXPECT_EQ(reloaded, saved);
+    snes.run(300000);
+    std::vector<uint8_t> second;
+    snes.save_state(second);
+    EXPECT_EQ(second, first);
+
+    // Into a fresh machine, from an unaligned copy
+    SNES other;
+    insert_test_rom(other);
+    std::vector<uint8_t> unaligned(saved.size() + 1);
+    std::copy(saved.begin(), saved.end(), unaligned.begin() + 1);
+    ASSERT_TRUE(other.load_state(unaligned.data() + 1, saved.size()));
+    other.run(300000);
+    std::vector<uint8_t> third;
+    other.save_state(third);
+    EXPECT_EQ(third, first);
+}
+
+TEST(SaveStateTest, CartridgeSramIsSaved) {
+    std::string path = write_sram_rom();
+    SNES snes;
+    snes.insert_cartridge(path);
+    snes.power_on();
+    ASSERT_EQ(snes.state_size(), SNES().state_size() + 0x800);
+    snes.run(1000);
+
+    std::vector<uint8_t> saved;
+    snes.save_state(saved);
+    ASSERT_EQ(saved.size(), snes.state_size());
+    snes.run(5000);
+    std::vector<uint8_t> first;
+    snes.save_state(first);
+    // The counter in SRAM has moved on
+    std::vector<uint8_t> saved_sram(saved.end() - 0x800, saved.end());
+    std::vector<uint8_t> first_sram(first.end() - 0x800, first.end());
+    EXPECT_NE(saved_sram[0x10], first_sram[0x10]);
+
+    ASSERT_TRUE(snes.load_state(saved));
+    std::vector<uint8_t> reloaded;
+    snes.save_state(reloaded);
+    EXPECT_EQ(reloaded, saved);
+    snes.run(5000);
+    std::vector<uint8_t> second;
+    snes.save_state(second);
+    EXPECT_EQ(second, first);
+
+    // The SRAM block has to match the inserted cartridge
+    SNES no_cartridge;
+    no_cartridge.power_on();
+    EXPECT_FALSE(no_cartridge.load_state(saved));
+    std::vector<uint8_t> without_sram(saved.begin(), saved.end() - 0x800);
+    EXPECT_FALSE(snes.load_state(without_sram));
+    std::remove(path.c_str());
+}
+
+TEST(SaveStateTest, RejectsForeignBuffers) {
+    SNES snes;
+    snes.power_on();
+    std::vector<uint8_t> state;
+    snes.save_state(state);
+
+    std::vector<uint8_t> truncated(state.begin(), state.end() - 1);
+    EXPECT_FALSE(snes.load_state(truncated));
+    std::vector<uint8_t> wrong_magic = state;
+    wrong_magic[0] ^= 0xFF;
+    EXPECT_FALSE(snes.load_state(wrong_magic));
+    std::vector<uint8_t> wrong_version = state;
+    wrong_version[4] ^= 0xFF;
+    EXPECT_FALSE(snes.load_state(wrong_version));
+    EXPECT_TRUE(snes.load_state(state));
+}
+
+TEST(SaveStateTest, LoadInvalidatesChangedWramCode) {
+    auto bus = std::make_shared<Bus>();
+    auto cpu = std::make_shared<CPU>();
+    bus->connect_cpu(cpu);
+    cpu->connect_bus(bus);
+
+    // loop: LDA #$11; BRA loop
+    const uint8_t loop[] = {0xA9, 0x11, 0x80, 0xFC};
+    for (int i = 0; i < 4; ++i) bus->write(0x7E0000 + i, loop[i]);
+    cpu->pc = 0x7E0000;
+    cpu->run(1000);
+    EXPECT_EQ(cpu->a & 0xFF, 0x11);
+
+    BusState bus_state;
+    CPUState cpu_state;
+    bus->save_state(bus_state);
+    cpu->save_state(cpu_state);
+
+    // Patch the cached loop to load $22, then go back to the saved code
+    bus->write(0x7E0001, 0x22);
+    cpu->run(1000);
+    EXPECT_EQ(cpu->a & 0xFF, 0x22);
+    bus->load_state(bus_state);
+    cpu->load_state(cpu_state);
+    cpu->a = 0;
+    cpu->run(1000);
+    EXPECT_EQ(cpu->a & 0xFF, 0x11);
+}
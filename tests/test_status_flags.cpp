@@ -439,3 +439,44 @@ TEST_F(StatusFlagTest, CMP_EdgeCases) {
     EXPECT_TRUE(cpu->get_flag(CPU::N));
     EXPECT_EQ(cpu->cycles, 2);
 }
+
+// With an 8-bit accumulator Z reflects only the low byte of the result,
+// whatever is left in B
+TEST_F(StatusFlagTest, EightBitZeroIgnoresHighByte) {
+    struct Case {
+        uint16_t a;
+        uint8_t opcode;
+        uint8_t operand;
+        uint16_t result;
+    };
+    const Case cases[] = {
+        {0x3400, 0x09, 0x00, 0x3400},   // ORA #$00
+        {0x12F0, 0x49, 0xF0, 0x1200},   // EOR #$F0
+        {0x7810, 0xC9, 0x10, 0x7810},   // CMP #$10
+    };
+    for (const Case& c : cases) {
+        cpu->reset();
+        cpu->pc = 0x7E0000;
+        cpu->a = c.a;
+        bus->write(0x7E0000, c.opcode);
+        bus->write(0x7E0001, c.operand);
+        cpu->step();
+        EXPECT_EQ(cpu->a, c.result) << "opcode " << (int)c.opcode;
+        EXPECT_TRUE(cpu->get_flag(CPU::Z)) << "opcode " << (int)c.opcode;
+        EXPECT_FALSE(cpu->get_flag(CPU::N)) << "opcode " << (int)c.opcode;
+    }
+    EXPECT_TRUE(cpu->get_flag(CPU::C));     // CMP with equal low bytes
+
+    // INC A wraps the low byte only
+    cpu->reset();
+    cpu->pc = 0x7E0000;
+    cpu->a = 0x12FF;
+    bus->write(0x7E0000, 0x1A);
+    cpu->step();
+    EXPECT_EQ(cpu->a, 0x1200);
+    EXPECT_TRUE(cpu->get_flag(CPU::Z));
+
+    // The same holds once the flags are folded into P
+    cpu->run_instructions(0);
+    EXPECT_TRUE(cpu->p & CPU::Z);
+}
@@ -0,0 +1,89 @@
+#include <array>
+#include <cstdint>
+#include "gtest/gtest.h"
+#include "ppu.hpp"
+#include "tile_cache.hpp"
+
+namespace {
+
+// Pixel (x, y) of a tile in the hardware bitplane layout, read bit by bit
+int reference_pixel(const std::array<uint8_t, TileCache::kVramSize>& vram, uint32_t base, int planes, int x,
+                    int y) {
+    int index = 0;
+    for (int p = 0; p < planes; ++p) {
+        index |= ((vram[base + 16 * (p >> 1) + 2 * y + (p & 1)] >> (7 - x)) & 1) << p;
+    }
+    return index;
+}
+
+} // namespace
+
+TEST(TileCacheTest, DecodesEveryDepth) {
+    std::array<uint8_t, TileCache::kVramSize> vram;
+    for (size_t i = 0; i < vram.size(); ++i) {
+        vram[i] = (uint8_t)(i * 37 + (i >> 8) * 11);
+    }
+    TileCache cache;
+    for (int depth = 0; depth < TileCache::kDepths; ++depth) {
+        int planes = 2 << depth;
+        for (uint32_t tile : {0u, 1u, 5u, 100u, (uint32_t)(TileCache::kVramSize / (8 * planes)) - 1}) {
+            const uint8_t* pixels = cache.tile(vram, (TileCache::Depth)depth, tile);
+            for (int y = 0; y < 8; ++y) {
+                for (int x = 0; x < 8; ++x) {
+                    EXPECT_EQ(pixels[y * 8 + x], reference_pixel(vram, tile * 8 * planes, planes, x, y))
+                        << "depth " << depth << " tile " << tile << " x " << x << " y " << y;
+                }
+            }
+        }
+    }
+}
+
+TEST(TileCacheTest, InvalidationCoversEveryDepth) {
+    std::array<uint8_t, TileCache::kVramSize> vram{};
+    TileCache cache;
+    EXPECT_EQ(cache.tile(vram, TileCache::k2bpp, 3)[0], 0);
+    EXPECT_EQ(cache.tile(vram, TileCache::k8bpp, 0)[0], 0);
+
+    // Byte $30 is row 0, plane 0 of 2bpp tile 3 and row 0, plane 6 of 8bpp tile 0
+    vram[0x30] = 0x80;
+    EXPECT_EQ(cache.tile(vram, TileCache::k2bpp, 3)[0], 0);     // Stale until invalidated
+    cache.invalidate(0x30);
+    EXPECT_EQ(cache.tile(vram, TileCache::k2bpp, 3)[0], 1);
+    EXPECT_EQ(cache.tile(vram, TileCache::k8bpp, 0)[0], 0x40);
+
+    // Ranges wrap around the end of VRAM
+    vram[0xFFFF] = 0x01;
+    vram[0x0000] = 0x80;
+    cache.invalidate(0xFFFF, 2);
+    EXPECT_EQ(cache.tile(vram, TileCache::k4bpp, 0x7FF)[7 * 8 + 7], 0x08);
+    EXPECT_EQ(cache.tile(vram, TileCache::k2bpp, 0)[0], 1);
+}
+
+// Every way into VRAM must reach the cache the renderer reads from
+TEST(TileCacheTest, PPUWritesInvalidateRenderedTiles) {
+    PPU ppu;
+    ppu.write_register(0x210B, 0x01);   // BG1 tiles at $1000, map at $0000 (all tile 0)
+    ppu.render_bg_scanline_stub(0);
+    EXPECT_EQ(ppu.get_framebuffer_row(0)[0], 0);
+
+    ppu.write_vram(0x1000, 0xFF);       // Plane 0, row 0
+    ppu.render_bg_scanline_stub(0);
+    EXPECT_EQ(ppu.get_framebuffer_row(0)[0], 1);
+
+    // $2118/$2119 with word increments: the high byte of word $0800 is
+    // byte $1001, plane 1 of row 0
+    ppu.write_register(0x2115, 0x80);
+    ppu.write_register(0x2116, 0x00);
+    ppu.write_register(0x2117, 0x08);
+    ppu.write_register(0x2119, 0xFF);
+    ppu.render_bg_scanline_stub(0);
+    EXPECT_EQ(ppu.get_framebuffer_row(0)[0], 3);
+
+    // DMA-style bulk upload clears both planes again
+    const uint8_t zeros[16] = {};
+    ppu.write_register(0x2116, 0x00);
+    ppu.write_register(0x2117, 0x08);
+    ppu.write_vram_words(zeros, sizeof(zeros));
+    ppu.render_bg_scanline_stub(0);
+    EXPECT_EQ(ppu.get_framebuffer_row(0)[0], 0);
+}